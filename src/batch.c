@@ -0,0 +1,94 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include <stdio.h>
+#include "batch.h"
+#include "log.h"
+#include "log-load.h"
+#include "log-merge.h"
+
+typedef struct batch_context
+{
+    log_merge_t *merge;
+    gboolean merge_existing;
+} batch_ctx_t;
+
+static void batch_network_cb(network_t*, gpointer);
+
+
+gint
+batch_merge(GSList      *filenames,
+            const gchar *output_file,
+            gboolean     strip_samples,
+            gboolean     strip_gps,
+            gboolean     strip_azi)
+{
+    log_snapshot_t *snapshot;
+    log_save_error_t *error;
+    log_load_t *load;
+    batch_ctx_t ctx;
+    gint count;
+    guint i;
+
+    ctx.merge = log_merge_new();
+    load = log_load_new(filenames, strip_samples, NULL, NULL);
+    for(i=0; i<log_load_length(load); i++)
+    {
+        ctx.merge_existing = (i != 0);
+        count = log_load_read(load, i, batch_network_cb, &ctx);
+        if(count <= 0)
+        {
+            switch(count)
+            {
+                case LOG_READ_ERROR_OPEN:
+                    fprintf(stderr, "ERROR: Failed to open a file: %s\n", log_load_filename(load, i));
+                    break;
+
+                case LOG_READ_ERROR_READ:
+                    fprintf(stderr, "ERROR: Failed to read a file: %s\n", log_load_filename(load, i));
+                    break;
+
+                case LOG_READ_ERROR_PARSE:
+                case LOG_READ_ERROR_EMPTY:
+                default:
+                    fprintf(stderr, "ERROR: Failed to parse a file: %s\n", log_load_filename(load, i));
+                    break;
+            }
+        }
+    }
+    log_load_free(load);
+
+    snapshot = log_merge_snapshot(ctx.merge);
+    log_merge_free(ctx.merge);
+
+    error = log_save_snapshot(output_file, snapshot, strip_samples, strip_gps, strip_azi);
+    log_snapshot_free(snapshot);
+
+    if(error)
+    {
+        fprintf(stderr, "ERROR: Failed to save the log: %s\n", output_file);
+        g_free(error);
+        return -1;
+    }
+    return 0;
+}
+
+static void
+batch_network_cb(network_t *network,
+                 gpointer   user_data)
+{
+    batch_ctx_t *ctx = (batch_ctx_t*)user_data;
+    log_merge_add(ctx->merge, network, ctx->merge_existing);
+}
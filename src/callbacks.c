@@ -17,6 +17,7 @@
 #include "ui-callbacks.h"
 
 static void callback_mt_ssh_info(const mt_ssh_t *, const mt_ssh_info_t *);
+static void callback_mt_ssh_batch(const mt_ssh_t *, const mt_ssh_batch_t *);
 static void callback_mt_ssh_net(const mt_ssh_t *, const mt_ssh_net_t *);
 static void callback_mt_ssh_snf(const mt_ssh_t *, const mt_ssh_snf_t *);
 
@@ -90,8 +91,8 @@ callback_mt_ssh_msg(const mt_ssh_t    *context,
             callback_mt_ssh_info(context, data);
             break;
 
-        case MT_SSH_MSG_NET:
-            callback_mt_ssh_net(context, data);
+        case MT_SSH_MSG_BATCH:
+            callback_mt_ssh_batch(context, data);
             break;
 
         case MT_SSH_MSG_SNF:
@@ -171,6 +172,16 @@ callback_mt_ssh_info(const mt_ssh_t      *context,
     }
 }
 
+static void
+callback_mt_ssh_batch(const mt_ssh_t       *context,
+                      const mt_ssh_batch_t *data)
+{
+    guint i;
+
+    for(i=0; i<mt_ssh_batch_get_length(data); i++)
+        callback_mt_ssh_net(context, mt_ssh_batch_get_net(data, i));
+}
+
 static void
 callback_mt_ssh_net(const mt_ssh_t     *context,
                     const mt_ssh_net_t *data)
@@ -197,6 +208,7 @@ callback_mt_ssh_net(const mt_ssh_t     *context,
     }
     net->firstseen = mt_ssh_net_get_timestamp(data);
     net->lastseen = mt_ssh_net_get_timestamp(data);
+    net->source = mt_ssh_get_hwaddr(context);
 
     ui_callback_network(context, net);
 }
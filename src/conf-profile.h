@@ -24,11 +24,19 @@ typedef enum mtscan_conf_profile_mode
     MTSCAN_CONF_PROFILE_MODE_SNIFFER
 } mtscan_conf_profile_mode_t;
 
+typedef enum mtscan_conf_profile_transport
+{
+    MTSCAN_CONF_PROFILE_TRANSPORT_PTY,
+    MTSCAN_CONF_PROFILE_TRANSPORT_API,
+    MTSCAN_CONF_PROFILE_TRANSPORT_API_SSL
+} mtscan_conf_profile_transport_t;
+
 enum
 {
     CONF_PROFILE_COL_NAME,
     CONF_PROFILE_COL_HOST,
     CONF_PROFILE_COL_PORT,
+    CONF_PROFILE_COL_TRANSPORT,
     CONF_PROFILE_COL_LOGIN,
     CONF_PROFILE_COL_PASSWORD,
     CONF_PROFILE_COL_INTERFACE,
@@ -40,12 +48,13 @@ enum
     CONF_PROFILE_COLS
 };
 
-conf_profile_t* conf_profile_new(gchar*, gchar*, gint, gchar*, gchar*, gchar*, mtscan_conf_profile_mode_t, gint, gboolean, gboolean, gboolean);
+conf_profile_t* conf_profile_new(gchar*, gchar*, gint, mtscan_conf_profile_transport_t, gchar*, gchar*, gchar*, mtscan_conf_profile_mode_t, gint, gboolean, gboolean, gboolean);
 void conf_profile_free(conf_profile_t*);
 
 const gchar* conf_profile_get_name(const conf_profile_t*);
 const gchar* conf_profile_get_host(const conf_profile_t*);
 gint conf_profile_get_port(const conf_profile_t*);
+mtscan_conf_profile_transport_t conf_profile_get_transport(const conf_profile_t*);
 const gchar* conf_profile_get_login(const conf_profile_t*);
 const gchar* conf_profile_get_password(const conf_profile_t*);
 const gchar* conf_profile_get_interface(const conf_profile_t*);
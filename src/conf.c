@@ -43,6 +43,7 @@
 #define CONF_DEFAULT_PROFILE_NAME           "unnamed"
 #define CONF_DEFAULT_PROFILE_HOST           ""
 #define CONF_DEFAULT_PROFILE_PORT           22
+#define CONF_DEFAULT_PROFILE_TRANSPORT      MTSCAN_CONF_PROFILE_TRANSPORT_PTY
 #define CONF_DEFAULT_PROFILE_LOGIN          "admin"
 #define CONF_DEFAULT_PROFILE_PASSWORD       ""
 #define CONF_DEFAULT_PROFILE_INTERFACE      "wlan1"
@@ -63,6 +64,7 @@
 
 #define CONF_DEFAULT_PREFERENCES_ICON_SIZE              16
 #define CONF_DEFAULT_PREFERENCES_AUTOSAVE_INTERVAL      5
+#define CONF_DEFAULT_PREFERENCES_AUTOSAVE_JOURNAL       TRUE
 #define CONF_DEFAULT_PREFERENCES_SEARCH_COLUMN          1
 #define CONF_DEFAULT_PREFERENCES_FALLBACK_ENCODING      "ISO-8859-2"
 #define CONF_DEFAULT_PREFERENCES_NO_STYLE_OVERRIDE      FALSE
@@ -81,6 +83,8 @@
 #define CONF_DEFAULT_PREFERENCES_SOUNDS_NO_GNSS_DATA    TRUE
 #define CONF_DEFAULT_PREFERENCES_EVENTS_NEW_NETWORK     FALSE
 #define CONF_DEFAULT_PREFERENCES_TZSP_UDP_PORT          0x9090
+#define CONF_DEFAULT_PREFERENCES_TZSP_BUFFER            2048
+#define CONF_DEFAULT_PREFERENCES_TZSP_FILTER            TRUE
 #ifdef G_OS_WIN32
 #define CONF_DEFAULT_PREFERENCES_GNSS_SOURCE            CONF_PREFERENCES_GNSS_SOURCE_WSA
 #else
@@ -112,6 +116,8 @@
 #define CONF_DEFAULT_PREFERENCES_LOCATION_WIGLE         FALSE
 #define CONF_DEFAULT_PREFERENCES_LOCATION_WIGLE_API_URL "https://api.wigle.net/api/v2/network/detail?netid="
 #define CONF_DEFAULT_PREFERENCES_LOCATION_WIGLE_API_KEY ""
+#define CONF_DEFAULT_PREFERENCES_LOCATION_WIGLE_TTL     180
+#define CONF_DEFAULT_PREFERENCES_LOCATION_WIGLE_NEG_TTL 30
 #define CONF_DEFAULT_PREFERENCES_LOCATION_AZIMUTH_ERROR 5
 #define CONF_DEFAULT_PREFERENCES_LOCATION_MIN_DISTANCE  0
 #define CONF_DEFAULT_PREFERENCES_LOCATION_MAX_DISTANCE  999
@@ -182,6 +188,7 @@ typedef struct conf
     /* [preferences] */
     gint      preferences_icon_size;
     gint      preferences_autosave_interval;
+    gboolean  preferences_autosave_journal;
     gint      preferences_search_column;
     gchar    *preferences_fallback_encoding;
     gboolean  preferences_no_style_override;
@@ -206,6 +213,8 @@ typedef struct conf
     gchar    *preferences_events_new_network_exec;
 
     gint      preferences_tzsp_udp_port;
+    gint      preferences_tzsp_buffer;
+    gboolean  preferences_tzsp_filter;
 
     gint      preferences_gnss_source;
     gchar    *preferences_gnss_gpsd_hostname;
@@ -253,6 +262,8 @@ typedef struct conf
     gboolean   preferences_location_wigle;
     gchar     *preferences_location_wigle_api_url;
     gchar     *preferences_location_wigle_api_key;
+    gint       preferences_location_wigle_ttl;
+    gint       preferences_location_wigle_neg_ttl;
     gint       preferences_location_azimuth_error;
     gint       preferences_location_min_distance;
     gint       preferences_location_max_distance;
@@ -372,6 +383,7 @@ conf_read(void)
 
     conf.preferences_icon_size = conf_read_integer("preferences", "icon_size", CONF_DEFAULT_PREFERENCES_ICON_SIZE);
     conf.preferences_autosave_interval = conf_read_integer("preferences", "autosave_interval", CONF_DEFAULT_PREFERENCES_AUTOSAVE_INTERVAL);
+    conf.preferences_autosave_journal = conf_read_boolean("preferences", "autosave_journal", CONF_DEFAULT_PREFERENCES_AUTOSAVE_JOURNAL);
     conf.preferences_search_column = conf_read_integer("preferences", "search_column", CONF_DEFAULT_PREFERENCES_SEARCH_COLUMN);
     conf.preferences_fallback_encoding = conf_read_string("preferences", "fallback_encoding", CONF_DEFAULT_PREFERENCES_FALLBACK_ENCODING);
     conf.preferences_no_style_override = conf_read_boolean("preferences", "no_style_override", CONF_DEFAULT_PREFERENCES_NO_STYLE_OVERRIDE);
@@ -396,6 +408,8 @@ conf_read(void)
     conf.preferences_events_new_network_exec = conf_read_string("preferences", "events_new_network_exec", "");
 
     conf.preferences_tzsp_udp_port = conf_read_integer("preferences", "tzsp_udp_port", CONF_DEFAULT_PREFERENCES_TZSP_UDP_PORT);
+    conf.preferences_tzsp_buffer = conf_read_integer("preferences", "tzsp_buffer", CONF_DEFAULT_PREFERENCES_TZSP_BUFFER);
+    conf.preferences_tzsp_filter = conf_read_boolean("preferences", "tzsp_filter", CONF_DEFAULT_PREFERENCES_TZSP_FILTER);
 
     conf.preferences_gnss_source = conf_read_integer("preferences", "gnss_source", CONF_DEFAULT_PREFERENCES_GNSS_SOURCE);
     conf.preferences_gnss_gpsd_hostname = conf_read_string("preferences", "gnss_gpsd_hostname", CONF_DEFAULT_PREFERENCES_GNSS_GPSD_HOSTNAME);
@@ -439,6 +453,8 @@ conf_read(void)
     conf.preferences_location_wigle = conf_read_boolean("preferences", "location_wigle", CONF_DEFAULT_PREFERENCES_LOCATION_WIGLE);
     conf.preferences_location_wigle_api_url = conf_read_string("preferences", "location_wigle_api_url", CONF_DEFAULT_PREFERENCES_LOCATION_WIGLE_API_URL);
     conf.preferences_location_wigle_api_key = conf_read_string("preferences", "location_wigle_api_key", CONF_DEFAULT_PREFERENCES_LOCATION_WIGLE_API_KEY);
+    conf.preferences_location_wigle_ttl = conf_read_integer("preferences", "location_wigle_ttl", CONF_DEFAULT_PREFERENCES_LOCATION_WIGLE_TTL);
+    conf.preferences_location_wigle_neg_ttl = conf_read_integer("preferences", "location_wigle_neg_ttl", CONF_DEFAULT_PREFERENCES_LOCATION_WIGLE_NEG_TTL);
     conf.preferences_location_azimuth_error = conf_read_integer("preferences", "location_azimuth_error", CONF_DEFAULT_PREFERENCES_LOCATION_AZIMUTH_ERROR);
     conf.preferences_location_min_distance = conf_read_integer("preferences", "location_min_distance", CONF_DEFAULT_PREFERENCES_LOCATION_MIN_DISTANCE);
     conf.preferences_location_max_distance = conf_read_integer("preferences", "location_max_distance", CONF_DEFAULT_PREFERENCES_LOCATION_MAX_DISTANCE);
@@ -623,6 +639,7 @@ conf_read_profile(const gchar *group_name)
     p = conf_profile_new(conf_read_string(group_name, "name", CONF_DEFAULT_PROFILE_NAME),
                          conf_read_string(group_name, "host", CONF_DEFAULT_PROFILE_HOST),
                          conf_read_integer(group_name, "port", CONF_DEFAULT_PROFILE_PORT),
+                         (mtscan_conf_profile_transport_t)conf_read_integer(group_name, "transport", CONF_DEFAULT_PROFILE_TRANSPORT),
                          conf_read_string(group_name, "login", CONF_DEFAULT_PROFILE_LOGIN),
                          conf_read_string(group_name, "password", CONF_DEFAULT_PROFILE_PASSWORD),
                          conf_read_string(group_name, "interface", CONF_DEFAULT_PROFILE_INTERFACE),
@@ -713,6 +730,7 @@ conf_save(void)
 
     g_key_file_set_integer(conf.keyfile, "preferences", "icon_size", conf.preferences_icon_size);
     g_key_file_set_integer(conf.keyfile, "preferences", "autosave_interval", conf.preferences_autosave_interval);
+    g_key_file_set_boolean(conf.keyfile, "preferences", "autosave_journal", conf.preferences_autosave_journal);
     g_key_file_set_integer(conf.keyfile, "preferences", "search_column", conf.preferences_search_column);
     g_key_file_set_string(conf.keyfile, "preferences", "fallback_encoding", conf.preferences_fallback_encoding);
     g_key_file_set_boolean(conf.keyfile, "preferences", "no_style_override", conf.preferences_no_style_override);
@@ -739,6 +757,8 @@ conf_save(void)
     g_key_file_set_string(conf.keyfile, "preferences", "events_new_network_exec", conf.preferences_events_new_network_exec);
 
     g_key_file_set_integer(conf.keyfile, "preferences", "tzsp_udp_port", conf.preferences_tzsp_udp_port);
+    g_key_file_set_integer(conf.keyfile, "preferences", "tzsp_buffer", conf.preferences_tzsp_buffer);
+    g_key_file_set_boolean(conf.keyfile, "preferences", "tzsp_filter", conf.preferences_tzsp_filter);
 
     g_key_file_set_integer(conf.keyfile, "preferences", "gnss_source", conf.preferences_gnss_source);
     g_key_file_set_string(conf.keyfile, "preferences", "gnss_gpsd_hostname", conf.preferences_gnss_gpsd_hostname);
@@ -784,6 +804,8 @@ conf_save(void)
     g_key_file_set_boolean(conf.keyfile, "preferences", "location_wigle", conf.preferences_location_wigle);
     g_key_file_set_string(conf.keyfile, "preferences", "location_wigle_api_url", conf.preferences_location_wigle_api_url);
     g_key_file_set_string(conf.keyfile, "preferences", "location_wigle_api_key", conf.preferences_location_wigle_api_key);
+    g_key_file_set_integer(conf.keyfile, "preferences", "location_wigle_ttl", conf.preferences_location_wigle_ttl);
+    g_key_file_set_integer(conf.keyfile, "preferences", "location_wigle_neg_ttl", conf.preferences_location_wigle_neg_ttl);
     g_key_file_set_integer(conf.keyfile, "preferences", "location_azimuth_error", conf.preferences_location_azimuth_error);
     g_key_file_set_integer(conf.keyfile, "preferences", "location_min_distance", conf.preferences_location_min_distance);
     g_key_file_set_integer(conf.keyfile, "preferences", "location_max_distance", conf.preferences_location_max_distance);
@@ -858,6 +880,7 @@ conf_save_profile(GKeyFile             *keyfile,
     g_key_file_set_string(keyfile, group_name, "name", conf_profile_get_name(p));
     g_key_file_set_string(keyfile, group_name, "host", conf_profile_get_host(p));
     g_key_file_set_integer(keyfile, group_name, "port", conf_profile_get_port(p));
+    g_key_file_set_integer(keyfile, group_name, "transport", conf_profile_get_transport(p));
     g_key_file_set_string(keyfile, group_name, "login", conf_profile_get_login(p));
     g_key_file_set_string(keyfile, group_name, "password", conf_profile_get_password(p));
     g_key_file_set_string(keyfile, group_name, "interface", conf_profile_get_interface(p));
@@ -1192,6 +1215,18 @@ conf_set_preferences_autosave_interval(gint value)
     conf.preferences_autosave_interval = value;
 }
 
+gboolean
+conf_get_preferences_autosave_journal(void)
+{
+    return conf.preferences_autosave_journal;
+}
+
+void
+conf_set_preferences_autosave_journal(gboolean value)
+{
+    conf.preferences_autosave_journal = value;
+}
+
 gint
 conf_get_preferences_search_column(void)
 {
@@ -1434,6 +1469,30 @@ conf_set_preferences_tzsp_udp_port(gint value)
     conf.preferences_tzsp_udp_port = value;
 }
 
+gint
+conf_get_preferences_tzsp_buffer(void)
+{
+    return conf.preferences_tzsp_buffer;
+}
+
+void
+conf_set_preferences_tzsp_buffer(gint value)
+{
+    conf.preferences_tzsp_buffer = value;
+}
+
+gboolean
+conf_get_preferences_tzsp_filter(void)
+{
+    return conf.preferences_tzsp_filter;
+}
+
+void
+conf_set_preferences_tzsp_filter(gboolean value)
+{
+    conf.preferences_tzsp_filter = value;
+}
+
 gint
 conf_get_preferences_gnss_source(void)
 {
@@ -1989,6 +2048,30 @@ conf_set_preferences_location_wigle_api_key(const gchar *value)
     conf_change_string(&conf.preferences_location_wigle_api_key, value);
 }
 
+gint
+conf_get_preferences_location_wigle_ttl(void)
+{
+    return conf.preferences_location_wigle_ttl;
+}
+
+void
+conf_set_preferences_location_wigle_ttl(gint value)
+{
+    conf.preferences_location_wigle_ttl = value;
+}
+
+gint
+conf_get_preferences_location_wigle_neg_ttl(void)
+{
+    return conf.preferences_location_wigle_neg_ttl;
+}
+
+void
+conf_set_preferences_location_wigle_neg_ttl(gint value)
+{
+    conf.preferences_location_wigle_neg_ttl = value;
+}
+
 gint
 conf_get_preferences_location_azimuth_error(void)
 {
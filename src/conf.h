@@ -91,6 +91,9 @@ void conf_set_preferences_icon_size(gint);
 gint conf_get_preferences_autosave_interval(void);
 void conf_set_preferences_autosave_interval(gint);
 
+gboolean conf_get_preferences_autosave_journal(void);
+void conf_set_preferences_autosave_journal(gboolean);
+
 gint conf_get_preferences_search_column(void);
 void conf_set_preferences_search_column(gint);
 
@@ -151,6 +154,12 @@ void conf_set_preferences_events_new_network_exec(const gchar*);
 gint conf_get_preferences_tzsp_udp_port(void);
 void conf_set_preferences_tzsp_udp_port(gint);
 
+gint conf_get_preferences_tzsp_buffer(void);
+void conf_set_preferences_tzsp_buffer(gint);
+
+gboolean conf_get_preferences_tzsp_filter(void);
+void conf_set_preferences_tzsp_filter(gboolean);
+
 gint conf_get_preferences_gnss_source(void);
 void conf_set_preferences_gnss_source(gint);
 
@@ -277,6 +286,12 @@ void conf_set_preferences_location_wigle_api_url(const gchar*);
 const gchar* conf_get_preferences_location_wigle_api_key(void);
 void conf_set_preferences_location_wigle_api_key(const gchar*);
 
+gint conf_get_preferences_location_wigle_ttl(void);
+void conf_set_preferences_location_wigle_ttl(gint);
+
+gint conf_get_preferences_location_wigle_neg_ttl(void);
+void conf_set_preferences_location_wigle_neg_ttl(gint);
+
 gint conf_get_preferences_location_azimuth_error(void);
 void conf_set_preferences_location_azimuth_error(gint);
 
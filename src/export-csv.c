@@ -80,7 +80,6 @@ export_foreach(GtkTreeModel *store,
     GDateTime *date;
 
     mtscan_model_get(e->model, iter, &net);
-    net.signals = NULL;
 
     if (isnan(net.latitude) ||
         isnan(net.longitude) ||
@@ -88,7 +87,6 @@ export_foreach(GtkTreeModel *store,
         isnan(net.accuracy))
     {
         /* Skip entry with invalid location */
-        network_free(&net);
         return FALSE;
     }
 
@@ -112,7 +110,6 @@ export_foreach(GtkTreeModel *store,
 
     e->ret = export_write(e, entry);
     g_free(entry);
-    network_free(&net);
 
     return (e->ret == FALSE);
 }
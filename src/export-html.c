@@ -308,10 +308,5 @@ export_foreach(GtkTreeModel *store,
     export_write(e, cstr);
     g_free(cstr);
 
-    /* Signals are stored in GtkListStore just as pointer,
-       so set it to NULL before freeing the struct */
-    net.signals = NULL;
-    network_free(&net);
-
     return FALSE;
 }
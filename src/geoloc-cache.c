@@ -0,0 +1,307 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "geoloc-cache.h"
+
+#define UNIX_TIMESTAMP() (g_get_real_time() / 1000000)
+#define GEOLOC_CACHE_COMPACT_MIN 1024
+
+G_STATIC_ASSERT(sizeof(geoloc_cache_header_t) == 16);
+G_STATIC_ASSERT(sizeof(geoloc_cache_record_t) == 64);
+
+typedef struct geoloc_cache
+{
+    gchar *filename;
+    gboolean loaded;
+    GMappedFile *file;
+    GHashTable *map;
+    GSList *records;
+    gsize count;
+    FILE *fp;
+} geoloc_cache_t;
+
+static void geoloc_cache_load(geoloc_cache_t*);
+static gboolean geoloc_cache_superseded(const geoloc_cache_t*);
+static void geoloc_cache_compact(geoloc_cache_t*);
+static gint geoloc_cache_compact_sort(gconstpointer, gconstpointer);
+static gboolean geoloc_cache_create(geoloc_cache_t*);
+
+
+geoloc_cache_t*
+geoloc_cache_new(const gchar *filename)
+{
+    geoloc_cache_t *cache;
+
+    /* The file is not touched until the first lookup */
+    cache = g_malloc0(sizeof(geoloc_cache_t));
+    cache->filename = g_strdup(filename);
+    cache->map = g_hash_table_new_full(g_int64_hash, g_int64_equal, NULL, NULL);
+    return cache;
+}
+
+void
+geoloc_cache_free(geoloc_cache_t *cache)
+{
+    if(cache)
+    {
+        if(cache->fp)
+            fclose(cache->fp);
+        g_hash_table_destroy(cache->map);
+        g_slist_free_full(cache->records, g_free);
+        if(cache->file)
+            g_mapped_file_unref(cache->file);
+        g_free(cache->filename);
+        g_free(cache);
+    }
+}
+
+geoloc_cache_ret_t
+geoloc_cache_lookup(geoloc_cache_t  *cache,
+                    gint64           bssid,
+                    gint64           ttl,
+                    gint64           ttl_no_match,
+                    geoloc_data_t  **data)
+{
+    const geoloc_cache_record_t *record;
+    gchar ssid[GEOLOC_CACHE_SSID_LEN+1];
+    gint64 age;
+
+    if(!cache->loaded)
+        geoloc_cache_load(cache);
+
+    if(!(record = g_hash_table_lookup(cache->map, &bssid)))
+        return GEOLOC_CACHE_MISS;
+
+    age = UNIX_TIMESTAMP() - record->timestamp;
+
+    if(isnan(record->lat) || isnan(record->lon))
+        return (age < ttl_no_match ? GEOLOC_CACHE_NO_MATCH : GEOLOC_CACHE_MISS);
+
+    if(age >= ttl)
+        return GEOLOC_CACHE_MISS;
+
+    memcpy(ssid, record->ssid, GEOLOC_CACHE_SSID_LEN);
+    ssid[GEOLOC_CACHE_SSID_LEN] = '\0';
+    *data = geoloc_data_new(ssid, record->lat, record->lon);
+    return GEOLOC_CACHE_MATCH;
+}
+
+void
+geoloc_cache_store(geoloc_cache_t      *cache,
+                   gint64               bssid,
+                   const geoloc_data_t *data)
+{
+    geoloc_cache_record_t *record;
+
+    if(!cache->loaded)
+        geoloc_cache_load(cache);
+
+    record = g_malloc0(sizeof(geoloc_cache_record_t));
+    record->bssid = bssid;
+    record->timestamp = UNIX_TIMESTAMP();
+    record->lat = (data ? geoloc_data_get_lat(data) : NAN);
+    record->lon = (data ? geoloc_data_get_lon(data) : NAN);
+    if(data)
+        strncpy(record->ssid, geoloc_data_get_ssid(data), GEOLOC_CACHE_SSID_LEN);
+
+    cache->records = g_slist_prepend(cache->records, record);
+    g_hash_table_insert(cache->map, &record->bssid, record);
+    cache->count++;
+
+    /* A new file is created with all valid records stored so far */
+    if(!cache->fp || geoloc_cache_superseded(cache))
+    {
+        geoloc_cache_compact(cache);
+        return;
+    }
+
+    if(fwrite(record, sizeof(geoloc_cache_record_t), 1, cache->fp) != 1 ||
+       fflush(cache->fp) != 0)
+    {
+        /* Keep the results in memory, the file is rewritten on next store */
+        fprintf(stderr, "geoloc_cache_store: cannot write file: %s\n", cache->filename);
+        fclose(cache->fp);
+        cache->fp = NULL;
+    }
+}
+
+static void
+geoloc_cache_load(geoloc_cache_t *cache)
+{
+    const geoloc_cache_header_t *header;
+    const geoloc_cache_record_t *records;
+    const gchar *contents;
+    gsize length;
+    gsize count;
+    gsize i;
+
+    cache->loaded = TRUE;
+
+    if(!(cache->file = g_mapped_file_new(cache->filename, FALSE, NULL)))
+        return;
+
+    contents = g_mapped_file_get_contents(cache->file);
+    length = g_mapped_file_get_length(cache->file);
+    header = (const geoloc_cache_header_t*)contents;
+
+    if(length < sizeof(geoloc_cache_header_t) ||
+       memcmp(header->magic, GEOLOC_CACHE_MAGIC, sizeof(header->magic)) ||
+       header->version != GEOLOC_CACHE_VERSION ||
+       header->record_size != sizeof(geoloc_cache_record_t))
+    {
+        /* Unknown format, the file will be replaced */
+        g_mapped_file_unref(cache->file);
+        cache->file = NULL;
+        return;
+    }
+
+    /* A partially written record at the end is ignored */
+    records = (const geoloc_cache_record_t*)(contents + sizeof(geoloc_cache_header_t));
+    count = (length - sizeof(geoloc_cache_header_t)) / sizeof(geoloc_cache_record_t);
+
+    for(i=0; i<count; i++)
+        g_hash_table_insert(cache->map, (gpointer)&records[i].bssid, (gpointer)&records[i]);
+    cache->count = count;
+
+    if(geoloc_cache_superseded(cache))
+    {
+        geoloc_cache_compact(cache);
+        return;
+    }
+
+    /* Next record overwrites a partially written one */
+    if(!(cache->fp = g_fopen(cache->filename, "r+b")) ||
+       fseek(cache->fp, sizeof(geoloc_cache_header_t) + count * sizeof(geoloc_cache_record_t), SEEK_SET) != 0)
+    {
+        fprintf(stderr, "geoloc_cache_load: cannot open file for writing: %s\n", cache->filename);
+        if(cache->fp)
+        {
+            fclose(cache->fp);
+            cache->fp = NULL;
+        }
+        geoloc_cache_compact(cache);
+    }
+}
+
+static gboolean
+geoloc_cache_superseded(const geoloc_cache_t *cache)
+{
+    /* Most of the records were replaced by newer ones */
+    return (cache->count >= GEOLOC_CACHE_COMPACT_MIN &&
+            cache->count - g_hash_table_size(cache->map) > cache->count / 2);
+}
+
+static void
+geoloc_cache_compact(geoloc_cache_t *cache)
+{
+    GHashTableIter iter;
+    gpointer value;
+    GSList *records = NULL;
+    GSList *it;
+    geoloc_cache_record_t *record;
+
+    /* The valid records are copied out of the mapped file and the list */
+    g_hash_table_iter_init(&iter, cache->map);
+    while(g_hash_table_iter_next(&iter, NULL, &value))
+    {
+        record = g_malloc(sizeof(geoloc_cache_record_t));
+        memcpy(record, value, sizeof(geoloc_cache_record_t));
+        records = g_slist_prepend(records, record);
+    }
+    records = g_slist_sort(records, geoloc_cache_compact_sort);
+
+    g_hash_table_remove_all(cache->map);
+    for(it = records; it; it = it->next)
+    {
+        record = (geoloc_cache_record_t*)it->data;
+        g_hash_table_insert(cache->map, &record->bssid, record);
+    }
+
+    g_slist_free_full(cache->records, g_free);
+    cache->records = records;
+    cache->count = g_hash_table_size(cache->map);
+
+    if(cache->fp)
+    {
+        fclose(cache->fp);
+        cache->fp = NULL;
+    }
+
+    if(cache->file)
+    {
+        g_mapped_file_unref(cache->file);
+        cache->file = NULL;
+    }
+
+    if(!geoloc_cache_create(cache))
+        fprintf(stderr, "geoloc_cache_compact: cannot write file: %s\n", cache->filename);
+}
+
+static gint
+geoloc_cache_compact_sort(gconstpointer a,
+                          gconstpointer b)
+{
+    const geoloc_cache_record_t *r1 = a;
+    const geoloc_cache_record_t *r2 = b;
+
+    /* The newest record first, like the stored ones */
+    return (r1->timestamp < r2->timestamp) - (r1->timestamp > r2->timestamp);
+}
+
+static gboolean
+geoloc_cache_create(geoloc_cache_t *cache)
+{
+    geoloc_cache_header_t header;
+    gboolean ret;
+    GSList *it;
+    gchar *directory;
+
+    /* The mapped records are still needed for lookups */
+    if(cache->file)
+        return FALSE;
+
+    directory = g_path_get_dirname(cache->filename);
+    g_mkdir_with_parents(directory, 0700);
+    g_free(directory);
+
+    if(!(cache->fp = g_fopen(cache->filename, "wb")))
+        return FALSE;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, GEOLOC_CACHE_MAGIC, sizeof(GEOLOC_CACHE_MAGIC));
+    header.version = GEOLOC_CACHE_VERSION;
+    header.record_size = sizeof(geoloc_cache_record_t);
+
+    ret = (fwrite(&header, sizeof(header), 1, cache->fp) == 1);
+
+    /* Records stored so far, the oldest first */
+    cache->records = g_slist_reverse(cache->records);
+    for(it = cache->records; ret && it; it = it->next)
+        ret = (fwrite(it->data, sizeof(geoloc_cache_record_t), 1, cache->fp) == 1);
+    cache->records = g_slist_reverse(cache->records);
+
+    if(!ret || fflush(cache->fp) != 0)
+    {
+        fclose(cache->fp);
+        cache->fp = NULL;
+        return FALSE;
+    }
+
+    return TRUE;
+}
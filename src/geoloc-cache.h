@@ -0,0 +1,59 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef MTSCAN_GEOLOC_CACHE_H_
+#define MTSCAN_GEOLOC_CACHE_H_
+#include <glib.h>
+#include "geoloc-data.h"
+
+#define GEOLOC_CACHE_MAGIC    "MTSCANW"
+#define GEOLOC_CACHE_VERSION  1
+#define GEOLOC_CACHE_SSID_LEN 32
+
+/* Append-only log of online lookup results, stored in the host byte order:
+ * header, records. Results without a match have no coordinates (NaN).
+ * The last record of a BSSID is the valid one. The file is rewritten
+ * with the valid records only when most of them are superseded. */
+typedef struct geoloc_cache_header
+{
+    gchar magic[8];
+    guint32 version;
+    guint32 record_size;
+} geoloc_cache_header_t;
+
+typedef struct geoloc_cache_record
+{
+    gint64 bssid;
+    gint64 timestamp;
+    gdouble lat;
+    gdouble lon;
+    gchar ssid[GEOLOC_CACHE_SSID_LEN];
+} geoloc_cache_record_t;
+
+typedef enum geoloc_cache_ret
+{
+    GEOLOC_CACHE_MISS,
+    GEOLOC_CACHE_MATCH,
+    GEOLOC_CACHE_NO_MATCH
+} geoloc_cache_ret_t;
+
+typedef struct geoloc_cache geoloc_cache_t;
+
+geoloc_cache_t* geoloc_cache_new(const gchar*);
+void geoloc_cache_free(geoloc_cache_t*);
+geoloc_cache_ret_t geoloc_cache_lookup(geoloc_cache_t*, gint64, gint64, gint64, geoloc_data_t**);
+void geoloc_cache_store(geoloc_cache_t*, gint64, const geoloc_data_t*);
+
+#endif
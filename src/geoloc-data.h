@@ -15,8 +15,16 @@
 
 #ifndef MTSCAN_GEOLOC_DATA_H_
 #define MTSCAN_GEOLOC_DATA_H_
+#include <glib.h>
 
-typedef struct geoloc_data geoloc_data_t;
+/* Entries of a geolocation index point their SSID into the
+   mapped string table, they are never freed individually */
+typedef struct geoloc_data
+{
+    gchar *ssid;
+    gdouble lat;
+    gdouble lon;
+} geoloc_data_t;
 
 geoloc_data_t* geoloc_data_new(const gchar*, gdouble, gdouble);
 void geoloc_data_free(geoloc_data_t*);
@@ -0,0 +1,310 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+#include "geoloc-index.h"
+
+/* Source files are identified by their size, modification time
+   and a hash of the first and the last block */
+#define GEOLOC_INDEX_HASH_BLOCK (64 * 1024)
+
+G_STATIC_ASSERT(sizeof(geoloc_index_header_t) == 64);
+G_STATIC_ASSERT(sizeof(geoloc_index_record_t) == 32);
+
+typedef struct geoloc_index
+{
+    gint ref_count;
+    GMappedFile *file;
+    gchar *buffer;
+    const geoloc_index_header_t *header;
+    const geoloc_index_record_t *records;
+    const gchar *strings;
+} geoloc_index_t;
+
+typedef struct geoloc_index_source
+{
+    guint64 size;
+    gint64 mtime;
+    guint8 hash[GEOLOC_INDEX_HASH_LEN];
+} geoloc_index_source_t;
+
+typedef struct geoloc_index_build_ctx
+{
+    GArray *records;
+    GString *strings;
+    GHashTable *strings_map;
+} geoloc_index_build_ctx_t;
+
+static gboolean geoloc_index_source(const gchar*, geoloc_index_source_t*);
+static geoloc_index_t* geoloc_index_new(GMappedFile*, gchar*, const gchar*, gsize);
+static void geoloc_index_build_foreach(gpointer, gpointer, gpointer);
+static guint32 geoloc_index_string_add(geoloc_index_build_ctx_t*, const gchar*);
+static gint geoloc_index_compare(gconstpointer, gconstpointer);
+
+
+geoloc_index_t*
+geoloc_index_open(const gchar *filename,
+                  const gchar *source)
+{
+    geoloc_index_source_t src;
+    geoloc_index_t *index;
+    GMappedFile *file;
+
+    if(!geoloc_index_source(source, &src))
+        return NULL;
+
+    if(!(file = g_mapped_file_new(filename, FALSE, NULL)))
+        return NULL;
+
+    index = geoloc_index_new(file,
+                             NULL,
+                             g_mapped_file_get_contents(file),
+                             g_mapped_file_get_length(file));
+
+    if(!index)
+    {
+        g_mapped_file_unref(file);
+        return NULL;
+    }
+
+    if(index->header->source_size != src.size ||
+       index->header->source_mtime != src.mtime ||
+       memcmp(index->header->source_hash, src.hash, sizeof(src.hash)))
+    {
+        /* The source file has changed */
+        geoloc_index_unref(index);
+        return NULL;
+    }
+
+    return index;
+}
+
+geoloc_index_t*
+geoloc_index_build(const gchar       *filename,
+                   const gchar       *source,
+                   geoloc_database_t *database)
+{
+    geoloc_index_build_ctx_t ctx;
+    geoloc_index_header_t header;
+    geoloc_index_source_t src;
+    geoloc_index_t *index;
+    gchar *buffer;
+    gsize records_size;
+    gsize size;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, GEOLOC_INDEX_MAGIC, sizeof(GEOLOC_INDEX_MAGIC));
+    header.version = GEOLOC_INDEX_VERSION;
+
+    if(geoloc_index_source(source, &src))
+    {
+        header.source_size = src.size;
+        header.source_mtime = src.mtime;
+        memcpy(header.source_hash, src.hash, sizeof(src.hash));
+    }
+
+    ctx.records = g_array_sized_new(FALSE, FALSE, sizeof(geoloc_index_record_t), geoloc_database_size(database));
+    ctx.strings = g_string_new(NULL);
+    ctx.strings_map = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+
+    g_hash_table_foreach(database, geoloc_index_build_foreach, &ctx);
+    g_array_sort(ctx.records, geoloc_index_compare);
+
+    header.count = ctx.records->len;
+    header.strings_size = ctx.strings->len;
+
+    records_size = ctx.records->len * sizeof(geoloc_index_record_t);
+    size = sizeof(header) + records_size + ctx.strings->len;
+    buffer = g_malloc(size);
+    memcpy(buffer, &header, sizeof(header));
+    memcpy(buffer + sizeof(header), ctx.records->data, records_size);
+    memcpy(buffer + sizeof(header) + records_size, ctx.strings->str, ctx.strings->len);
+
+    g_array_free(ctx.records, TRUE);
+    g_string_free(ctx.strings, TRUE);
+    g_hash_table_destroy(ctx.strings_map);
+
+    if(filename &&
+       g_file_set_contents(filename, buffer, size, NULL) &&
+       (index = geoloc_index_open(filename, source)))
+    {
+        g_free(buffer);
+        return index;
+    }
+
+    /* Keep the index in memory, if it cannot be saved */
+    return geoloc_index_new(NULL, buffer, buffer, size);
+}
+
+geoloc_index_t*
+geoloc_index_ref(geoloc_index_t *index)
+{
+    g_atomic_int_inc(&index->ref_count);
+    return index;
+}
+
+void
+geoloc_index_unref(geoloc_index_t *index)
+{
+    if(index && g_atomic_int_dec_and_test(&index->ref_count))
+    {
+        if(index->file)
+            g_mapped_file_unref(index->file);
+        g_free(index->buffer);
+        g_free(index);
+    }
+}
+
+guint
+geoloc_index_size(const geoloc_index_t *index)
+{
+    return index->header->count;
+}
+
+const geoloc_index_record_t*
+geoloc_index_record(const geoloc_index_t *index,
+                    guint                 n)
+{
+    return (n < index->header->count ? &index->records[n] : NULL);
+}
+
+const gchar*
+geoloc_index_string(const geoloc_index_t *index,
+                    guint32               offset)
+{
+    if(offset == GEOLOC_INDEX_NO_STRING ||
+       offset >= index->header->strings_size)
+        return NULL;
+
+    return index->strings + offset;
+}
+
+static gboolean
+geoloc_index_source(const gchar           *filename,
+                    geoloc_index_source_t *src)
+{
+    guchar buffer[GEOLOC_INDEX_HASH_BLOCK];
+    GChecksum *checksum;
+    GStatBuf st;
+    gsize length;
+    gsize len;
+    FILE *fp;
+
+    if(g_stat(filename, &st) != 0)
+        return FALSE;
+
+    if(!(fp = g_fopen(filename, "rb")))
+        return FALSE;
+
+    src->size = st.st_size;
+    src->mtime = st.st_mtime;
+
+    checksum = g_checksum_new(G_CHECKSUM_SHA1);
+    len = fread(buffer, 1, sizeof(buffer), fp);
+    g_checksum_update(checksum, buffer, len);
+
+    if(src->size > 2 * GEOLOC_INDEX_HASH_BLOCK &&
+       fseek(fp, -GEOLOC_INDEX_HASH_BLOCK, SEEK_END) == 0)
+    {
+        len = fread(buffer, 1, sizeof(buffer), fp);
+        g_checksum_update(checksum, buffer, len);
+    }
+    fclose(fp);
+
+    length = sizeof(src->hash);
+    g_checksum_get_digest(checksum, src->hash, &length);
+    g_checksum_free(checksum);
+    return TRUE;
+}
+
+static geoloc_index_t*
+geoloc_index_new(GMappedFile *file,
+                 gchar       *buffer,
+                 const gchar *data,
+                 gsize        size)
+{
+    const geoloc_index_header_t *header = (const geoloc_index_header_t*)data;
+    geoloc_index_t *index;
+
+    if(size < sizeof(geoloc_index_header_t) ||
+       memcmp(header->magic, GEOLOC_INDEX_MAGIC, sizeof(header->magic)) ||
+       header->version != GEOLOC_INDEX_VERSION ||
+       header->count > (size - sizeof(geoloc_index_header_t)) / sizeof(geoloc_index_record_t) ||
+       header->strings_size != size - sizeof(geoloc_index_header_t) - header->count * sizeof(geoloc_index_record_t) ||
+       (header->strings_size && data[size-1] != '\0'))
+    {
+        g_free(buffer);
+        return NULL;
+    }
+
+    index = g_malloc(sizeof(geoloc_index_t));
+    index->ref_count = 1;
+    index->file = file;
+    index->buffer = buffer;
+    index->header = header;
+    index->records = (const geoloc_index_record_t*)(data + sizeof(geoloc_index_header_t));
+    index->strings = data + sizeof(geoloc_index_header_t) + header->count * sizeof(geoloc_index_record_t);
+    return index;
+}
+
+static void
+geoloc_index_build_foreach(gpointer key,
+                           gpointer value,
+                           gpointer user_data)
+{
+    geoloc_index_build_ctx_t *ctx = (geoloc_index_build_ctx_t*)user_data;
+    const geoloc_data_t *data = (const geoloc_data_t*)value;
+    geoloc_index_record_t record;
+
+    record.bssid = *(gint64*)key;
+    record.lat = data->lat;
+    record.lon = data->lon;
+    record.ssid = geoloc_index_string_add(ctx, data->ssid);
+    record.reserved = 0;
+    g_array_append_val(ctx->records, record);
+}
+
+static guint32
+geoloc_index_string_add(geoloc_index_build_ctx_t *ctx,
+                        const gchar              *string)
+{
+    gpointer offset;
+    guint32 ret;
+
+    if(!string)
+        return GEOLOC_INDEX_NO_STRING;
+
+    if(g_hash_table_lookup_extended(ctx->strings_map, string, NULL, &offset))
+        return GPOINTER_TO_UINT(offset);
+
+    if(ctx->strings->len >= GEOLOC_INDEX_NO_STRING - strlen(string) - 1)
+        return GEOLOC_INDEX_NO_STRING;
+
+    ret = (guint32)ctx->strings->len;
+    g_string_append_len(ctx->strings, string, strlen(string) + 1);
+    g_hash_table_insert(ctx->strings_map, g_strdup(string), GUINT_TO_POINTER(ret));
+    return ret;
+}
+
+static gint
+geoloc_index_compare(gconstpointer a,
+                     gconstpointer b)
+{
+    gint64 bssid_a = ((const geoloc_index_record_t*)a)->bssid;
+    gint64 bssid_b = ((const geoloc_index_record_t*)b)->bssid;
+    return (bssid_a > bssid_b) - (bssid_a < bssid_b);
+}
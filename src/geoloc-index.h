@@ -0,0 +1,60 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef MTSCAN_GEOLOC_INDEX_H_
+#define MTSCAN_GEOLOC_INDEX_H_
+#include <glib.h>
+#include "geoloc-data.h"
+#include "geoloc-database.h"
+
+#define GEOLOC_INDEX_MAGIC     "MTSCANG"
+#define GEOLOC_INDEX_VERSION   1
+#define GEOLOC_INDEX_NO_STRING G_MAXUINT32
+#define GEOLOC_INDEX_HASH_LEN  20
+
+/* Index of a single location log, stored in the host byte order:
+ * header, records sorted by BSSID, string table */
+typedef struct geoloc_index_header
+{
+    gchar magic[8];
+    guint32 version;
+    guint32 count;
+    guint64 strings_size;
+    guint64 source_size;
+    gint64 source_mtime;
+    guint8 source_hash[GEOLOC_INDEX_HASH_LEN];
+    guint32 reserved;
+} geoloc_index_header_t;
+
+typedef struct geoloc_index_record
+{
+    gint64 bssid;
+    gdouble lat;
+    gdouble lon;
+    guint32 ssid;
+    guint32 reserved;
+} geoloc_index_record_t;
+
+typedef struct geoloc_index geoloc_index_t;
+
+geoloc_index_t* geoloc_index_open(const gchar*, const gchar*);
+geoloc_index_t* geoloc_index_build(const gchar*, const gchar*, geoloc_database_t*);
+geoloc_index_t* geoloc_index_ref(geoloc_index_t*);
+void geoloc_index_unref(geoloc_index_t*);
+guint geoloc_index_size(const geoloc_index_t*);
+const geoloc_index_record_t* geoloc_index_record(const geoloc_index_t*, guint);
+const gchar* geoloc_index_string(const geoloc_index_t*, guint32);
+
+#endif
@@ -0,0 +1,330 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include <math.h>
+#include "geoloc-table.h"
+
+/* All local databases merged into a single open addressing table,
+   sized by the number of unique BSSIDs. Each slot points to a run of
+   candidates, which are stored in the order of database priority.
+   A candidate is the number of a record in the concatenated indexes,
+   the coordinates and SSIDs are read from the mapped indexes. */
+
+#define GEOLOC_TABLE_MAX_COUNT G_MAXUINT16
+
+typedef struct geoloc_table_slot
+{
+    guint32 first;
+    guint16 count;
+    guint16 tag;
+} geoloc_table_slot_t;
+
+typedef struct geoloc_table
+{
+    geoloc_index_t **indexes;
+    guint32 *offsets;
+    guint indexes_len;
+    geoloc_table_slot_t *slots;
+    guint32 capacity;
+    guint32 *candidates;
+    geoloc_table_cache_t *cache;
+    guint32 count;
+} geoloc_table_t;
+
+static guint32 geoloc_table_merge(geoloc_table_t*, guint32);
+static gint64 geoloc_table_merge_bssid(const geoloc_table_t*, const guint32*, guint);
+static void geoloc_table_heap_down(const geoloc_table_t*, guint*, const guint32*, guint, guint);
+static const geoloc_index_record_t* geoloc_table_record(const geoloc_table_t*, guint32, guint*);
+static gint64 geoloc_table_bssid(const geoloc_table_t*, guint32);
+static guint64 geoloc_table_hash(gint64);
+static geoloc_table_slot_t* geoloc_table_probe(const geoloc_table_t*, gint64);
+
+
+geoloc_table_t*
+geoloc_table_new(geoloc_index_t **indexes,
+                 guint            length)
+{
+    geoloc_table_slot_t *slot;
+    geoloc_table_t *table;
+    guint64 total = 0;
+    guint32 unique;
+    guint32 first;
+    guint32 i;
+    guint j;
+
+    table = g_malloc0(sizeof(geoloc_table_t));
+    table->indexes = g_new0(geoloc_index_t*, length);
+    table->offsets = g_new0(guint32, length + 1);
+
+    for(j=0; j<length; j++)
+    {
+        if(indexes[j] &&
+           total + geoloc_index_size(indexes[j]) <= G_MAXUINT32 / 2)
+        {
+            table->indexes[table->indexes_len++] = geoloc_index_ref(indexes[j]);
+            total += geoloc_index_size(indexes[j]);
+            table->offsets[table->indexes_len] = (guint32)total;
+        }
+    }
+
+    table->candidates = g_new(guint32, total);
+    unique = geoloc_table_merge(table, (guint32)total);
+
+    /* Keep the load factor at most 3/4 */
+    table->capacity = unique + unique / 3 + 1;
+    table->slots = g_new0(geoloc_table_slot_t, table->capacity);
+
+    for(i=0; i<table->count; i=first)
+    {
+        for(first=i+1; first<table->count && geoloc_table_bssid(table, first) == geoloc_table_bssid(table, i); first++);
+
+        slot = geoloc_table_probe(table, geoloc_table_bssid(table, i));
+        if(slot->count)
+            continue;
+
+        slot->first = i;
+        slot->count = (guint16)MIN(first - i, GEOLOC_TABLE_MAX_COUNT);
+        slot->tag = (guint16)(geoloc_table_hash(geoloc_table_bssid(table, i)) >> 48);
+    }
+
+    table->cache = g_new(geoloc_table_cache_t, table->count);
+    geoloc_table_invalidate(table);
+    return table;
+}
+
+void
+geoloc_table_free(geoloc_table_t *table)
+{
+    guint i;
+
+    if(!table)
+        return;
+
+    for(i=0; i<table->indexes_len; i++)
+        geoloc_index_unref(table->indexes[i]);
+
+    g_free(table->indexes);
+    g_free(table->offsets);
+    g_free(table->slots);
+    g_free(table->candidates);
+    g_free(table->cache);
+    g_free(table);
+}
+
+guint
+geoloc_table_size(const geoloc_table_t *table)
+{
+    return table->count;
+}
+
+guint
+geoloc_table_lookup(const geoloc_table_t *table,
+                    gint64                bssid,
+                    guint32              *first)
+{
+    const geoloc_table_slot_t *slot;
+
+    slot = geoloc_table_probe(table, bssid);
+    *first = slot->first;
+    return slot->count;
+}
+
+void
+geoloc_table_candidate(const geoloc_table_t *table,
+                       guint32               n,
+                       geoloc_data_t        *data)
+{
+    const geoloc_index_record_t *record;
+    guint index;
+
+    record = geoloc_table_record(table, table->candidates[n], &index);
+    data->ssid = (gchar*)geoloc_index_string(table->indexes[index], record->ssid);
+    data->lat = record->lat;
+    data->lon = record->lon;
+}
+
+geoloc_table_cache_t*
+geoloc_table_cache(const geoloc_table_t *table,
+                   guint32               n)
+{
+    return &table->cache[n];
+}
+
+void
+geoloc_table_invalidate(geoloc_table_t *table)
+{
+    guint32 i;
+
+    for(i=0; i<table->count; i++)
+    {
+        table->cache[i].distance = NAN;
+        table->cache[i].azimuth = NAN;
+    }
+}
+
+static guint32
+geoloc_table_merge(geoloc_table_t *table,
+                   guint32         total)
+{
+    guint *heap;
+    guint32 *pos;
+    guint32 unique = 0;
+    gint64 last = 0;
+    guint n = 0;
+    guint i;
+
+    /* Indexes are sorted by BSSID, merge them with a heap ordered
+       by BSSID and then by priority, so the runs come out in order */
+    heap = g_new(guint, table->indexes_len);
+    pos = g_new(guint32, table->indexes_len);
+
+    for(i=0; i<table->indexes_len; i++)
+    {
+        pos[i] = table->offsets[i];
+        if(pos[i] < table->offsets[i+1])
+            heap[n++] = i;
+    }
+
+    for(i=n/2; i-- > 0;)
+        geoloc_table_heap_down(table, heap, pos, n, i);
+
+    while(n && table->count < total)
+    {
+        i = heap[0];
+        if(!table->count || geoloc_table_merge_bssid(table, pos, i) != last)
+        {
+            last = geoloc_table_merge_bssid(table, pos, i);
+            unique++;
+        }
+        table->candidates[table->count++] = pos[i];
+
+        if(++pos[i] >= table->offsets[i+1])
+            heap[0] = heap[--n];
+
+        if(n)
+            geoloc_table_heap_down(table, heap, pos, n, 0);
+    }
+
+    g_free(heap);
+    g_free(pos);
+    return unique;
+}
+
+static gint64
+geoloc_table_merge_bssid(const geoloc_table_t *table,
+                         const guint32        *pos,
+                         guint                 i)
+{
+    return geoloc_index_record(table->indexes[i], pos[i] - table->offsets[i])->bssid;
+}
+
+static void
+geoloc_table_heap_down(const geoloc_table_t *table,
+                       guint                *heap,
+                       const guint32        *pos,
+                       guint                 n,
+                       guint                 i)
+{
+    gint64 bssid_child;
+    gint64 bssid;
+    guint child;
+    guint tmp;
+
+    while((child = 2*i + 1) < n)
+    {
+        bssid_child = geoloc_table_merge_bssid(table, pos, heap[child]);
+        if(child + 1 < n)
+        {
+            bssid = geoloc_table_merge_bssid(table, pos, heap[child+1]);
+            if(bssid < bssid_child ||
+               (bssid == bssid_child && heap[child+1] < heap[child]))
+            {
+                child++;
+                bssid_child = bssid;
+            }
+        }
+
+        bssid = geoloc_table_merge_bssid(table, pos, heap[i]);
+        if(bssid < bssid_child ||
+           (bssid == bssid_child && heap[i] < heap[child]))
+            break;
+
+        tmp = heap[i];
+        heap[i] = heap[child];
+        heap[child] = tmp;
+        i = child;
+    }
+}
+
+static const geoloc_index_record_t*
+geoloc_table_record(const geoloc_table_t *table,
+                    guint32               n,
+                    guint                *index)
+{
+    guint low = 0;
+    guint high = table->indexes_len;
+    guint mid;
+
+    /* Find the index, the record is in offsets[index] .. offsets[index+1] */
+    while(high - low > 1)
+    {
+        mid = low + (high - low) / 2;
+        if(table->offsets[mid] <= n)
+            low = mid;
+        else
+            high = mid;
+    }
+
+    *index = low;
+    return geoloc_index_record(table->indexes[low], n - table->offsets[low]);
+}
+
+static gint64
+geoloc_table_bssid(const geoloc_table_t *table,
+                   guint32               n)
+{
+    guint index;
+    return geoloc_table_record(table, table->candidates[n], &index)->bssid;
+}
+
+static guint64
+geoloc_table_hash(gint64 bssid)
+{
+    guint64 h = (guint64)bssid;
+    h ^= h >> 33;
+    h *= G_GUINT64_CONSTANT(0xff51afd7ed558ccd);
+    h ^= h >> 33;
+    return h;
+}
+
+static geoloc_table_slot_t*
+geoloc_table_probe(const geoloc_table_t *table,
+                   gint64                bssid)
+{
+    geoloc_table_slot_t *slot;
+    guint64 h = geoloc_table_hash(bssid);
+    guint16 tag = (guint16)(h >> 48);
+    guint32 i;
+
+    /* Linear probing, the table is never full. The tag avoids
+       reading the index for most of the other BSSIDs on the way. */
+    for(i = (guint32)(((h & G_MAXUINT32) * table->capacity) >> 32); ; i = (i + 1 < table->capacity ? i + 1 : 0))
+    {
+        slot = &table->slots[i];
+        if(!slot->count ||
+           (slot->tag == tag && geoloc_table_bssid(table, slot->first) == bssid))
+            return slot;
+    }
+}
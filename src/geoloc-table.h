@@ -0,0 +1,40 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef MTSCAN_GEOLOC_TABLE_H_
+#define MTSCAN_GEOLOC_TABLE_H_
+#include <glib.h>
+#include "geoloc-data.h"
+#include "geoloc-index.h"
+
+typedef struct geoloc_table geoloc_table_t;
+
+/* Result of the last match of a candidate, NaN until computed
+   for the current reference point */
+typedef struct geoloc_table_cache
+{
+    gfloat distance;
+    gfloat azimuth;
+} geoloc_table_cache_t;
+
+geoloc_table_t* geoloc_table_new(geoloc_index_t**, guint);
+void geoloc_table_free(geoloc_table_t*);
+guint geoloc_table_size(const geoloc_table_t*);
+guint geoloc_table_lookup(const geoloc_table_t*, gint64, guint32*);
+void geoloc_table_candidate(const geoloc_table_t*, guint32, geoloc_data_t*);
+geoloc_table_cache_t* geoloc_table_cache(const geoloc_table_t*, guint32);
+void geoloc_table_invalidate(geoloc_table_t*);
+
+#endif
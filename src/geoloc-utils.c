@@ -14,6 +14,7 @@
  */
 #include <glib.h>
 #include <math.h>
+#include "geoloc-utils.h"
 
 gdouble
 geoloc_utils_distance(gdouble lat1,
@@ -71,3 +72,42 @@ geoloc_utils_azimuth_match(gdouble az1,
 
     return (diff <= error);
 }
+
+void
+geoloc_utils_ref_init(geoloc_utils_ref_t *ref,
+                      gdouble             lat,
+                      gdouble             lon)
+{
+    ref->lat = lat * M_PI / 180.0;
+    ref->lon = lon * M_PI / 180.0;
+    ref->sin_lat = sin(ref->lat);
+    ref->cos_lat = cos(ref->lat);
+}
+
+void
+geoloc_utils_ref_vector(const geoloc_utils_ref_t *ref,
+                        gdouble                   lat,
+                        gdouble                   lon,
+                        gdouble                  *distance,
+                        gdouble                  *azimuth)
+{
+    gdouble d_lat, d_lon, sin_lat, cos_lat, a, b, c;
+
+    /* Same as geoloc_utils_distance() and geoloc_utils_azimuth(),
+       with the terms of the reference point computed only once */
+    lat *= M_PI / 180.0;
+    lon *= M_PI / 180.0;
+    sin_lat = sin(lat);
+    cos_lat = cos(lat);
+
+    d_lat = sin((lat - ref->lat) / 2.0);
+    d_lon = sin((lon - ref->lon) / 2.0);
+    a = d_lat * d_lat + d_lon * d_lon * ref->cos_lat * cos_lat;
+    c = 2.0 * atan2(sqrt(a), sqrt(1.0 - a));
+    *distance = 6371.0 * c;
+
+    a = asin(lon - ref->lon) * cos_lat;
+    b = ref->cos_lat * sin_lat - ref->sin_lat * cos_lat * cos(lon - ref->lon);
+    c = atan2(a, b) / (M_PI / 180.0);
+    *azimuth = (c < 0) ? c + 360.0 : c;
+}
@@ -16,8 +16,19 @@
 #ifndef MTSCAN_GEOLOC_UTILS_H_
 #define MTSCAN_GEOLOC_UTILS_H_
 
+typedef struct geoloc_utils_ref
+{
+    gdouble lat;
+    gdouble lon;
+    gdouble sin_lat;
+    gdouble cos_lat;
+} geoloc_utils_ref_t;
+
 gdouble geoloc_utils_distance(gdouble, gdouble, gdouble, gdouble);
 gdouble geoloc_utils_azimuth(gdouble, gdouble, gdouble, gdouble);
 gboolean geoloc_utils_azimuth_match(gdouble, gdouble, gdouble);
 
+void geoloc_utils_ref_init(geoloc_utils_ref_t*, gdouble, gdouble);
+void geoloc_utils_ref_vector(const geoloc_utils_ref_t*, gdouble, gdouble, gdouble*, gdouble*);
+
 #endif
@@ -14,31 +14,52 @@
  */
 
 #include <glib.h>
+#include <glib/gstdio.h>
 #include <math.h>
 #include <string.h>
+#include "mtscan.h"
 #include "geoloc.h"
+#include "geoloc-cache.h"
 #include "geoloc-database.h"
+#include "geoloc-index.h"
+#include "geoloc-table.h"
 #include "geoloc-utils.h"
 #include "wigle/wigle.h"
 #include "network.h"
 #include "log.h"
 #include "conf.h"
 
+#define GEOLOC_INDEX_DIR "geoloc"
+#define GEOLOC_INDEX_EXT ".idx"
+#define GEOLOC_WIGLE_CACHE "wigle.cache"
+
 typedef struct geoloc_loader_t
 {
-    GSList *databases;
     GSList *filenames;
-    size_t count;
 } geoloc_loader_t;
 
+typedef struct geoloc_loader_result
+{
+    geoloc_loader_t *loader;
+    geoloc_table_t *table;
+    gboolean final;
+} geoloc_loader_result_t;
+
 typedef struct geoloc
 {
     gboolean            init;
     geoloc_loader_t    *loader;
     wigle_t            *wigle;
-    GSList             *db_mtscan;
+    geoloc_table_t     *db_mtscan;
     geoloc_database_t  *db_wigle;
+    geoloc_cache_t     *wigle_cache;
+    gboolean            ref_valid;
+    geoloc_data_t       match;
+    gdouble             ref_lat;
+    gdouble             ref_lon;
+    geoloc_utils_ref_t  ref;
     void              (*callback)(gint64);
+    GRWLock             lock;
 } geoloc_t;
 
 static geoloc_t geoloc =
@@ -48,19 +69,27 @@ static geoloc_t geoloc =
     .wigle = NULL,
     .db_mtscan = NULL,
     .db_wigle = NULL,
+    .wigle_cache = NULL,
+    .ref_valid = FALSE,
     .callback = NULL
 };
 
 static gpointer geoloc_loader(gpointer);
+static void geoloc_loader_post(geoloc_loader_t*, geoloc_index_t**, guint, gboolean);
 static gboolean geoloc_loader_callback(gpointer);
+static gchar* geoloc_loader_index_path(const gchar*);
 static void geoloc_loader_network_callback(network_t*, gpointer);
 
 static void geoloc_wigle_cb(wigle_t*);
 static void geoloc_wigle_cb_msg(const wigle_t*, const wigle_data_t*);
+static geoloc_data_t* geoloc_wigle_restore(gint64);
 
+static const geoloc_data_t* geoloc_match_real(gint64, const gchar*, gfloat, gboolean, gfloat*, geoloc_data_t*);
+static void geoloc_match_reference(void);
+static void geoloc_match_vector(const geoloc_data_t*, geoloc_table_cache_t*, gfloat*, gfloat*);
 static gboolean geoloc_match_ssid(const geoloc_data_t*, const gchar*);
-static gboolean geoloc_match_azimuth(const geoloc_data_t*, gfloat);
-static gboolean geoloc_match_distance(const geoloc_data_t*, gfloat, gfloat*);
+static gboolean geoloc_match_azimuth(gfloat, gfloat);
+static gboolean geoloc_match_distance(gfloat, gfloat, gfloat*);
 
 
 void
@@ -83,6 +112,7 @@ geoloc_reinit(const gchar* const *filenames)
     geoloc_loader_t *context;
     GSList *list = NULL;
     const gchar* const *f;
+    gchar *path;
 
     if(filenames)
     {
@@ -90,9 +120,7 @@ geoloc_reinit(const gchar* const *filenames)
             list = g_slist_append(list, g_strdup(*f));
 
         context = g_malloc(sizeof(geoloc_loader_t));
-        context->databases = NULL;
         context->filenames = list;
-        context->count = 0;
 
         geoloc.loader = context;
         g_thread_unref(g_thread_new("geoloc_loader", geoloc_loader, context));
@@ -101,6 +129,13 @@ geoloc_reinit(const gchar* const *filenames)
     if(!geoloc.db_wigle)
         geoloc.db_wigle = geoloc_database_new();
 
+    if(!geoloc.wigle_cache)
+    {
+        path = g_build_filename(g_get_user_cache_dir(), APP_CACHE_DIR, GEOLOC_WIGLE_CACHE, NULL);
+        geoloc.wigle_cache = geoloc_cache_new(path);
+        g_free(path);
+    }
+
 }
 
 static gpointer
@@ -108,48 +143,94 @@ geoloc_loader(gpointer user_data)
 {
     geoloc_loader_t *context = (geoloc_loader_t*)user_data;
     geoloc_database_t *database;
+    geoloc_index_t **indexes;
+    gchar **paths;
     const gchar *filename;
+    guint length;
+    guint pending = 0;
     GSList *it;
-    gint count;
+    guint i;
 
-    for(it = context->filenames; it; it = it->next)
+    length = g_slist_length(context->filenames);
+    indexes = g_new0(geoloc_index_t*, length);
+    paths = g_new0(gchar*, length);
+
+    /* Use all prebuilt indexes first */
+    for(it = context->filenames, i = 0; it; it = it->next, i++)
     {
         filename = (const gchar*)it->data;
-        database = geoloc_database_new();
+        paths[i] = geoloc_loader_index_path(filename);
+        if(!(indexes[i] = geoloc_index_open(paths[i], filename)))
+            pending++;
+    }
 
-        count = log_read(filename,
-                         geoloc_loader_network_callback,
-                         database,
-                         TRUE);
+    if(pending && pending < length)
+        geoloc_loader_post(context, indexes, length, FALSE);
 
-        if(!count)
-        {
-            geoloc_database_free(database);
+    /* Rebuild indexes of new and changed files */
+    for(it = context->filenames, i = 0; pending && it; it = it->next, i++)
+    {
+        if(indexes[i])
             continue;
+
+        filename = (const gchar*)it->data;
+        database = geoloc_database_new();
+
+        if(log_read(filename,
+                    geoloc_loader_network_callback,
+                    database,
+                    TRUE) > 0)
+        {
+            indexes[i] = geoloc_index_build(paths[i], filename, database);
         }
 
-        context->databases = g_slist_append(context->databases, database);
-        context->count += geoloc_database_size(database);
+        geoloc_database_free(database);
     }
 
-    g_idle_add(geoloc_loader_callback, context);
+    geoloc_loader_post(context, indexes, length, TRUE);
+
+    for(i=0; i<length; i++)
+    {
+        geoloc_index_unref(indexes[i]);
+        g_free(paths[i]);
+    }
+    g_free(indexes);
+    g_free(paths);
     return NULL;
 }
 
+static void
+geoloc_loader_post(geoloc_loader_t  *context,
+                   geoloc_index_t  **indexes,
+                   guint             length,
+                   gboolean          final)
+{
+    geoloc_loader_result_t *result;
+
+    result = g_malloc(sizeof(geoloc_loader_result_t));
+    result->loader = context;
+    result->table = geoloc_table_new(indexes, length);
+    result->final = final;
+    g_idle_add(geoloc_loader_callback, result);
+}
+
 static gboolean
 geoloc_loader_callback(gpointer user_data)
 {
-    geoloc_loader_t *context = (geoloc_loader_t*)user_data;
+    geoloc_loader_result_t *result = (geoloc_loader_result_t*)user_data;
+    geoloc_loader_t *context = result->loader;
 
     if(geoloc.loader == context)
     {
-        if(geoloc.db_mtscan)
-            g_slist_free_full(geoloc.db_mtscan, (GDestroyNotify)geoloc_database_free);
+        g_print("geoloc_mtscan: %u entries in local databases\n", geoloc_table_size(result->table));
 
-        g_print("geoloc_mtscan: %zu entries in local databases\n", context->count);
+        g_rw_lock_writer_lock(&geoloc.lock);
+        geoloc_table_free(geoloc.db_mtscan);
+        geoloc.db_mtscan = result->table;
+        g_rw_lock_writer_unlock(&geoloc.lock);
 
-        geoloc.db_mtscan = context->databases;
-        geoloc.loader = NULL;
+        if(result->final)
+            geoloc.loader = NULL;
 
         /* Update all networks */
         if(conf_get_interface_geoloc() && geoloc.callback)
@@ -157,15 +238,41 @@ geoloc_loader_callback(gpointer user_data)
     }
     else
     {
-        g_slist_free_full(context->databases, (GDestroyNotify)geoloc_database_free);
+        geoloc_table_free(result->table);
     }
 
-    g_slist_free_full(context->filenames, g_free);
-    g_free(context);
+    if(result->final)
+    {
+        g_slist_free_full(context->filenames, g_free);
+        g_free(context);
+    }
 
+    g_free(result);
     return G_SOURCE_REMOVE;
 }
 
+static gchar*
+geoloc_loader_index_path(const gchar *filename)
+{
+    gchar *directory;
+    gchar *hash;
+    gchar *name;
+    gchar *path;
+
+    /* Indexes are kept in the cache directory, named after the source path */
+    directory = g_build_filename(g_get_user_cache_dir(), APP_CACHE_DIR, GEOLOC_INDEX_DIR, NULL);
+    g_mkdir_with_parents(directory, 0700);
+
+    hash = g_compute_checksum_for_string(G_CHECKSUM_SHA1, filename, -1);
+    name = g_strconcat(hash, GEOLOC_INDEX_EXT, NULL);
+    path = g_build_filename(directory, name, NULL);
+
+    g_free(directory);
+    g_free(hash);
+    g_free(name);
+    return path;
+}
+
 static void
 geoloc_loader_network_callback(network_t *network,
                                gpointer   user_data)
@@ -222,28 +329,65 @@ geoloc_wigle_cb_msg(const wigle_t      *src,
     if(wigle_data_get_error(wigle_data) != WIGLE_ERROR_NONE)
     {
         /* Remove network placeholder from cache on failure */
+        g_rw_lock_writer_lock(&geoloc.lock);
         geoloc_database_remove(geoloc.db_wigle, bssid);
+        g_rw_lock_writer_unlock(&geoloc.lock);
         return;
     }
 
-    if(!wigle_data_get_match(wigle_data))
-        return;
-
-    if(isnan(wigle_data_get_lat(wigle_data)) ||
+    if(!wigle_data_get_match(wigle_data) ||
+       isnan(wigle_data_get_lat(wigle_data)) ||
        isnan(wigle_data_get_lon(wigle_data)))
+    {
+        /* Remember the lack of match, to avoid further queries */
+        geoloc_cache_store(geoloc.wigle_cache, bssid, NULL);
         return;
+    }
 
     data = geoloc_data_new(wigle_data_get_ssid(wigle_data),
                            wigle_data_get_lat(wigle_data),
                            wigle_data_get_lon(wigle_data));
 
+    g_rw_lock_writer_lock(&geoloc.lock);
     geoloc_database_insert(geoloc.db_wigle, bssid, data);
+    g_rw_lock_writer_unlock(&geoloc.lock);
+    geoloc_cache_store(geoloc.wigle_cache, bssid, data);
 
     /* Update single network */
     if(conf_get_interface_geoloc() && geoloc.callback)
         geoloc.callback(bssid);
 }
 
+static geoloc_data_t*
+geoloc_wigle_restore(gint64 bssid)
+{
+    geoloc_data_t *data = NULL;
+    geoloc_cache_ret_t ret;
+
+    ret = geoloc_cache_lookup(geoloc.wigle_cache,
+                              bssid,
+                              conf_get_preferences_location_wigle_ttl() * (gint64)86400,
+                              conf_get_preferences_location_wigle_neg_ttl() * (gint64)86400,
+                              &data);
+
+    if(ret == GEOLOC_CACHE_MISS)
+        return NULL;
+
+    if(ret == GEOLOC_CACHE_NO_MATCH)
+        data = geoloc_data_new(NULL, NAN, NAN);
+
+    geoloc_database_insert(geoloc.db_wigle, bssid, data);
+    return data;
+}
+
+void
+geoloc_match_prepare(void)
+{
+    g_rw_lock_writer_lock(&geoloc.lock);
+    geoloc_match_reference();
+    g_rw_lock_writer_unlock(&geoloc.lock);
+}
+
 const geoloc_data_t*
 geoloc_match(gint64       bssid,
              const gchar* ssid,
@@ -252,27 +396,70 @@ geoloc_match(gint64       bssid,
              gfloat      *distance_out)
 {
     const geoloc_data_t *data;
-    geoloc_database_t *database;
-    GSList *it;
+
+    /* The state is modified only in the main thread, under the write lock */
+    g_rw_lock_writer_lock(&geoloc.lock);
+    geoloc_match_reference();
+    data = geoloc_match_real(bssid, ssid, azimuth, query_wigle, distance_out, &geoloc.match);
+    g_rw_lock_writer_unlock(&geoloc.lock);
+    return data;
+}
+
+gboolean
+geoloc_match_shared(gint64       bssid,
+                    const gchar *ssid,
+                    gfloat       azimuth,
+                    gfloat      *distance_out)
+{
+    geoloc_data_t buffer;
+    gboolean ret;
+
+    /* May run in several threads at once, each with different BSSIDs.
+       The reference point is the one set by geoloc_match_prepare(). */
+    g_rw_lock_reader_lock(&geoloc.lock);
+    ret = (geoloc_match_real(bssid, ssid, azimuth, FALSE, distance_out, &buffer) != NULL);
+    g_rw_lock_reader_unlock(&geoloc.lock);
+    return ret;
+}
+
+static const geoloc_data_t*
+geoloc_match_real(gint64         bssid,
+                  const gchar*   ssid,
+                  gfloat         azimuth,
+                  gboolean       query_wigle,
+                  gfloat        *distance_out,
+                  geoloc_data_t *buffer)
+{
+    const geoloc_data_t *data;
     gboolean ssid_match = FALSE;
+    gfloat g_distance;
+    gfloat g_azimuth;
+    gfloat max_distance;
+    guint32 first;
+    guint count;
+    guint i;
+
+    max_distance = conf_get_preferences_location_max_distance();
 
-    /* We need to check each local database from MTscan logs,
-     * starting from the first, which has the highest priority */
+    /* Candidates from local databases are ordered by priority,
+     * starting from the first log, which has the highest one */
     if(conf_get_preferences_location_mtscan() &&
        geoloc.db_mtscan)
     {
-        for(it = geoloc.db_mtscan; it; it = it->next)
+        /* Candidates are read into the buffer, which is returned on a match */
+        count = geoloc_table_lookup(geoloc.db_mtscan, bssid, &first);
+        for(i=0; i<count; i++)
         {
-            database = (geoloc_database_t*)it->data;
-            data = geoloc_database_lookup(database, bssid);
+            geoloc_table_candidate(geoloc.db_mtscan, first + i, buffer);
+            data = buffer;
 
-            if(data &&
-               geoloc_data_is_vaild(data) &&
+            if(geoloc_data_is_vaild(data) &&
                geoloc_match_ssid(data, ssid))
             {
                 ssid_match = TRUE;
-                if(geoloc_match_azimuth(data, azimuth) &&
-                   geoloc_match_distance(data, conf_get_preferences_location_max_distance(), distance_out))
+                geoloc_match_vector(data, geoloc_table_cache(geoloc.db_mtscan, first + i), &g_distance, &g_azimuth);
+                if(geoloc_match_azimuth(g_azimuth, azimuth) &&
+                   geoloc_match_distance(g_distance, max_distance, distance_out))
                 {
                     return data;
                 }
@@ -286,13 +473,25 @@ geoloc_match(gint64       bssid,
     {
         data = geoloc_database_lookup(geoloc.db_wigle, bssid);
 
+        /* Results of previous sessions are restored only before a query,
+           the shared matching must not modify the database */
+        if(!data &&
+           query_wigle &&
+           !ssid_match)
+        {
+            data = geoloc_wigle_restore(bssid);
+        }
+
         if(data &&
            geoloc_data_is_vaild(data) &&
-           geoloc_match_ssid(data, ssid) &&
-           geoloc_match_azimuth(data, azimuth) &&
-           geoloc_match_distance(data, conf_get_preferences_location_max_distance(), distance_out))
+           geoloc_match_ssid(data, ssid))
         {
-            return data;
+            geoloc_match_vector(data, NULL, &g_distance, &g_azimuth);
+            if(geoloc_match_azimuth(g_azimuth, azimuth) &&
+               geoloc_match_distance(g_distance, max_distance, distance_out))
+            {
+                return data;
+            }
         }
 
         if(query_wigle &&
@@ -311,6 +510,58 @@ geoloc_match(gint64       bssid,
     return NULL;
 }
 
+static void
+geoloc_match_reference(void)
+{
+    gdouble lat = conf_get_preferences_location_latitude();
+    gdouble lon = conf_get_preferences_location_longitude();
+
+    if(geoloc.ref_valid &&
+       geoloc.ref_lat == lat &&
+       geoloc.ref_lon == lon)
+        return;
+
+    /* Receiver location has changed, drop all cached results */
+    geoloc_utils_ref_init(&geoloc.ref, lat, lon);
+    geoloc.ref_lat = lat;
+    geoloc.ref_lon = lon;
+    geoloc.ref_valid = TRUE;
+    if(geoloc.db_mtscan)
+        geoloc_table_invalidate(geoloc.db_mtscan);
+}
+
+static void
+geoloc_match_vector(const geoloc_data_t  *data,
+                    geoloc_table_cache_t *cache,
+                    gfloat               *distance,
+                    gfloat               *azimuth)
+{
+    gdouble g_distance;
+    gdouble g_azimuth;
+
+    if(cache && !isnan(cache->distance))
+    {
+        *distance = cache->distance;
+        *azimuth = cache->azimuth;
+        return;
+    }
+
+    geoloc_utils_ref_vector(&geoloc.ref,
+                            geoloc_data_get_lat(data),
+                            geoloc_data_get_lon(data),
+                            &g_distance,
+                            &g_azimuth);
+
+    *distance = (gfloat)g_distance;
+    *azimuth = (gfloat)g_azimuth;
+
+    if(cache)
+    {
+        cache->distance = *distance;
+        cache->azimuth = *azimuth;
+    }
+}
+
 static gboolean
 geoloc_match_ssid(const geoloc_data_t *data,
                   const gchar         *ssid)
@@ -327,35 +578,22 @@ geoloc_match_ssid(const geoloc_data_t *data,
 }
 
 static gboolean
-geoloc_match_azimuth(const geoloc_data_t *data,
-                     gfloat               azimuth)
+geoloc_match_azimuth(gfloat g_azimuth,
+                     gfloat azimuth)
 {
-    gfloat g_azimuth;
-
     if(isnan(azimuth))
         return TRUE;
 
-    g_azimuth = (gfloat)geoloc_utils_azimuth(conf_get_preferences_location_latitude(),
-                                             conf_get_preferences_location_longitude(),
-                                             geoloc_data_get_lat(data),
-                                             geoloc_data_get_lon(data));
-
     return geoloc_utils_azimuth_match(g_azimuth, azimuth, conf_get_preferences_location_azimuth_error());
 }
 
 static gboolean
-geoloc_match_distance(const geoloc_data_t *data,
-                      gfloat               distance_limit,
-                      gfloat              *distance_out)
+geoloc_match_distance(gfloat  g_distance,
+                      gfloat  distance_limit,
+                      gfloat *distance_out)
 {
-    gfloat g_distance;
     gboolean ret;
 
-    g_distance = (gfloat)geoloc_utils_distance(conf_get_preferences_location_latitude(),
-                                               conf_get_preferences_location_longitude(),
-                                               geoloc_data_get_lat(data),
-                                               geoloc_data_get_lon(data));
-
     ret = (g_distance <= distance_limit);
 
     if(ret && distance_out)
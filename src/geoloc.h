@@ -21,6 +21,8 @@ void geoloc_init(const gchar* const*,  void(*)(gint64));
 void geoloc_reinit(const gchar* const*);
 void geoloc_wigle(const gchar*, const gchar*);
 
+void geoloc_match_prepare(void);
 const geoloc_data_t* geoloc_match(gint64, const gchar*, gfloat, gboolean, gfloat*);
+gboolean geoloc_match_shared(gint64, const gchar*, gfloat, gfloat*);
 
 #endif
@@ -0,0 +1,490 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include <glib/gstdio.h>
+#include <string.h>
+#include <zlib.h>
+#include "journal.h"
+#include "log.h"
+#include "signals.h"
+
+#ifdef G_OS_WIN32
+#include "win32.h"
+#else
+#include <unistd.h>
+#endif
+
+#define JOURNAL_NO_STRING G_MAXUINT16
+
+enum
+{
+    JOURNAL_RECORD_NETWORK = 1,
+    JOURNAL_RECORD_CHECKPOINT
+};
+
+typedef struct journal_header
+{
+    gchar magic[8];
+    guint32 version;
+    guint32 target_length;
+} journal_header_t;
+
+/* Every record is prefixed with its length and CRC-32,
+   a torn write at the end of the file is simply dropped */
+typedef struct journal_record
+{
+    guint32 length;
+    guint32 crc;
+} journal_record_t;
+
+typedef struct journal_network
+{
+    gint64 address;
+    gint64 timestamp;
+    gint64 source;
+    gdouble latitude;
+    gdouble longitude;
+    gfloat altitude;
+    gfloat accuracy;
+    gfloat azimuth;
+    gint32 frequency;
+    guint8 streams;
+    gint8 rssi;
+    gint8 noise;
+    gint8 privacy;
+    gint8 routeros;
+    gint8 nstreme;
+    gint8 tdma;
+    gint8 wds;
+    gint8 bridge;
+    gint8 airmax;
+    gint8 airmax_ac_ptp;
+    gint8 airmax_ac_ptmp;
+    gint8 airmax_ac_mixed;
+    gint8 wps;
+    guint8 sample;
+    guint8 reserved;
+} journal_network_t;
+
+typedef struct journal
+{
+    FILE *fp;
+    gchar *target;
+    GByteArray *buffer;
+    gboolean error;
+} journal_t;
+
+static void journal_write(journal_t*, guint8, gconstpointer, gsize);
+static void journal_put_string(GByteArray*, const gchar*);
+static gboolean journal_get_string(const guint8**, const guint8*, gchar**);
+static const gchar* journal_map(GMappedFile*, gchar**);
+
+
+journal_t*
+journal_open(const gchar *filename,
+             const gchar *target)
+{
+    journal_header_t header;
+    journal_t *journal;
+    FILE *fp;
+
+    if(!(fp = g_fopen(filename, "wb")))
+        return NULL;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, JOURNAL_MAGIC, sizeof(header.magic));
+    header.version = JOURNAL_VERSION;
+    header.target_length = strlen(target);
+
+    if(fwrite(&header, sizeof(header), 1, fp) != 1 ||
+       fwrite(target, header.target_length, 1, fp) != 1 ||
+       fflush(fp) != 0)
+    {
+        fclose(fp);
+        g_remove(filename);
+        return NULL;
+    }
+
+    journal = g_malloc(sizeof(journal_t));
+    journal->fp = fp;
+    journal->target = g_strdup(target);
+    journal->buffer = g_byte_array_new();
+    journal->error = FALSE;
+    return journal;
+}
+
+void
+journal_append(journal_t       *journal,
+               const network_t *net,
+               gboolean         sample)
+{
+    journal_network_t record;
+
+    memset(&record, 0, sizeof(record));
+    record.address = net->address;
+    /* Scan results carry their timestamp in the first seen field */
+    record.timestamp = net->firstseen;
+    record.source = net->source;
+    record.latitude = net->latitude;
+    record.longitude = net->longitude;
+    record.altitude = net->altitude;
+    record.accuracy = net->accuracy;
+    record.azimuth = net->azimuth;
+    record.frequency = net->frequency;
+    record.streams = net->streams;
+    record.rssi = net->rssi;
+    record.noise = net->noise;
+    record.privacy = net->flags.privacy;
+    record.routeros = net->flags.routeros;
+    record.nstreme = net->flags.nstreme;
+    record.tdma = net->flags.tdma;
+    record.wds = net->flags.wds;
+    record.bridge = net->flags.bridge;
+    record.airmax = net->ubnt_airmax;
+    record.airmax_ac_ptp = net->ubnt_ptp;
+    record.airmax_ac_ptmp = net->ubnt_ptmp;
+    record.airmax_ac_mixed = net->ubnt_mixed;
+    record.wps = net->wps;
+    record.sample = sample;
+
+    g_byte_array_set_size(journal->buffer, 0);
+    g_byte_array_append(journal->buffer, (const guint8*)&record, sizeof(record));
+    journal_put_string(journal->buffer, net->channel);
+    journal_put_string(journal->buffer, net->mode);
+    journal_put_string(journal->buffer, net->ssid);
+    journal_put_string(journal->buffer, net->radioname);
+    journal_put_string(journal->buffer, net->routeros_ver);
+    journal_put_string(journal->buffer, net->wps_manufacturer);
+    journal_put_string(journal->buffer, net->wps_model_name);
+    journal_put_string(journal->buffer, net->wps_model_number);
+    journal_put_string(journal->buffer, net->wps_serial_number);
+    journal_put_string(journal->buffer, net->wps_device_name);
+
+    journal_write(journal, JOURNAL_RECORD_NETWORK, journal->buffer->data, journal->buffer->len);
+}
+
+gboolean
+journal_flush(journal_t *journal)
+{
+    if(fflush(journal->fp) != 0)
+        journal->error = TRUE;
+    return !journal->error;
+}
+
+gboolean
+journal_checkpoint(journal_t *journal)
+{
+    gint64 ts = g_get_real_time() / 1000000;
+
+    journal_write(journal, JOURNAL_RECORD_CHECKPOINT, &ts, sizeof(ts));
+    if(!journal_flush(journal))
+        return FALSE;
+
+#ifdef G_OS_WIN32
+    win32_fsync(fileno(journal->fp));
+#else
+    fsync(fileno(journal->fp));
+#endif
+    return TRUE;
+}
+
+glong
+journal_tell(journal_t *journal)
+{
+    return ftell(journal->fp);
+}
+
+journal_t*
+journal_rotate(journal_t   *journal,
+               const gchar *filename,
+               const gchar *target,
+               glong        offset)
+{
+    journal_t *next;
+    gchar *tmp_name;
+    gchar buffer[4096];
+    gboolean ret;
+    size_t length;
+    FILE *fp;
+
+    /* Records written after the offset are carried over to the new journal */
+    if(!journal_flush(journal))
+        return NULL;
+
+    tmp_name = g_strdup_printf("%s.new", filename);
+    if(!(next = journal_open(tmp_name, target)))
+    {
+        g_free(tmp_name);
+        return NULL;
+    }
+
+    ret = ((fp = g_fopen(filename, "rb")) && fseek(fp, offset, SEEK_SET) == 0);
+    while(ret && (length = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+        ret = (fwrite(buffer, 1, length, next->fp) == length);
+
+    if(fp)
+        fclose(fp);
+
+    if(!ret || !journal_checkpoint(next))
+    {
+        journal_close(next);
+        g_remove(tmp_name);
+        g_free(tmp_name);
+        return NULL;
+    }
+
+#ifdef G_OS_WIN32
+    /* An open file cannot be replaced */
+    journal_close(journal);
+    g_remove(filename);
+    g_rename(tmp_name, filename);
+#else
+    if(g_rename(tmp_name, filename) < 0)
+    {
+        journal_close(next);
+        g_remove(tmp_name);
+        g_free(tmp_name);
+        return NULL;
+    }
+    journal_close(journal);
+#endif
+
+    g_free(tmp_name);
+    return next;
+}
+
+const gchar*
+journal_get_target(const journal_t *journal)
+{
+    return journal->target;
+}
+
+void
+journal_close(journal_t *journal)
+{
+    if(journal)
+    {
+        fclose(journal->fp);
+        g_byte_array_free(journal->buffer, TRUE);
+        g_free(journal->target);
+        g_free(journal);
+    }
+}
+
+gchar*
+journal_read_target(const gchar *filename)
+{
+    GMappedFile *file;
+    gchar *target = NULL;
+
+    if((file = g_mapped_file_new(filename, FALSE, NULL)))
+    {
+        journal_map(file, &target);
+        g_mapped_file_unref(file);
+    }
+    return target;
+}
+
+gint
+journal_replay(const gchar  *filename,
+               void        (*net_cb)(network_t*, gpointer),
+               gpointer      user_data)
+{
+    GMappedFile *file;
+    const guint8 *data;
+    const guint8 *end;
+    const guint8 *payload;
+    journal_record_t header;
+    journal_network_t record;
+    network_t net;
+    gint count = 0;
+
+    if(!(file = g_mapped_file_new(filename, FALSE, NULL)))
+        return LOG_READ_ERROR_OPEN;
+
+    if(!(data = (const guint8*)journal_map(file, NULL)))
+    {
+        g_mapped_file_unref(file);
+        return LOG_READ_ERROR_PARSE;
+    }
+
+    end = (const guint8*)g_mapped_file_get_contents(file) + g_mapped_file_get_length(file);
+
+    while(end - data >= (gssize)sizeof(journal_record_t))
+    {
+        memcpy(&header, data, sizeof(header));
+        payload = data + sizeof(header);
+
+        if(header.length < 1 ||
+           header.length > (gsize)(end - payload) ||
+           header.crc != crc32(0, payload, header.length))
+            break;
+
+        data = payload + header.length;
+
+        if(payload[0] != JOURNAL_RECORD_NETWORK ||
+           header.length < 1 + sizeof(journal_network_t))
+            continue;
+
+        memcpy(&record, payload + 1, sizeof(record));
+        payload += 1 + sizeof(record);
+
+        network_init(&net);
+        if(!journal_get_string(&payload, data, &net.channel) ||
+           !journal_get_string(&payload, data, &net.mode) ||
+           !journal_get_string(&payload, data, &net.ssid) ||
+           !journal_get_string(&payload, data, &net.radioname) ||
+           !journal_get_string(&payload, data, &net.routeros_ver) ||
+           !journal_get_string(&payload, data, &net.wps_manufacturer) ||
+           !journal_get_string(&payload, data, &net.wps_model_name) ||
+           !journal_get_string(&payload, data, &net.wps_model_number) ||
+           !journal_get_string(&payload, data, &net.wps_serial_number) ||
+           !journal_get_string(&payload, data, &net.wps_device_name))
+        {
+            network_free(&net);
+            continue;
+        }
+
+        net.address = record.address;
+        net.firstseen = record.timestamp;
+        net.lastseen = record.timestamp;
+        net.source = record.source;
+        net.latitude = record.latitude;
+        net.longitude = record.longitude;
+        net.altitude = record.altitude;
+        net.accuracy = record.accuracy;
+        net.azimuth = record.azimuth;
+        net.frequency = record.frequency;
+        net.streams = record.streams;
+        net.rssi = record.rssi;
+        net.noise = record.noise;
+        net.flags.privacy = record.privacy;
+        net.flags.routeros = record.routeros;
+        net.flags.nstreme = record.nstreme;
+        net.flags.tdma = record.tdma;
+        net.flags.wds = record.wds;
+        net.flags.bridge = record.bridge;
+        net.ubnt_airmax = record.airmax;
+        net.ubnt_ptp = record.airmax_ac_ptp;
+        net.ubnt_ptmp = record.airmax_ac_ptmp;
+        net.ubnt_mixed = record.airmax_ac_mixed;
+        net.wps = record.wps;
+
+        net.signals = signals_new();
+        if(record.sample)
+            signals_add(net.signals,
+                        net.firstseen,
+                        net.rssi,
+                        net.latitude,
+                        net.longitude,
+                        net.altitude,
+                        net.accuracy,
+                        net.azimuth,
+                        net.source);
+
+        net_cb(&net, user_data);
+        count++;
+
+        network_free(&net);
+    }
+
+    g_mapped_file_unref(file);
+    return count;
+}
+
+static void
+journal_write(journal_t     *journal,
+              guint8         type,
+              gconstpointer  data,
+              gsize          length)
+{
+    journal_record_t header;
+    gulong crc;
+
+    crc = crc32(0, &type, 1);
+    crc = crc32(crc, data, length);
+
+    header.length = length + 1;
+    header.crc = crc;
+
+    if(fwrite(&header, sizeof(header), 1, journal->fp) != 1 ||
+       fwrite(&type, 1, 1, journal->fp) != 1 ||
+       fwrite(data, length, 1, journal->fp) != 1)
+        journal->error = TRUE;
+}
+
+static void
+journal_put_string(GByteArray  *buffer,
+                   const gchar *string)
+{
+    guint16 length = JOURNAL_NO_STRING;
+
+    if(string)
+        length = MIN(strlen(string), JOURNAL_NO_STRING - 1);
+
+    g_byte_array_append(buffer, (const guint8*)&length, sizeof(length));
+    if(string)
+        g_byte_array_append(buffer, (const guint8*)string, length);
+}
+
+static gboolean
+journal_get_string(const guint8  **data,
+                   const guint8   *end,
+                   gchar         **string)
+{
+    guint16 length;
+
+    if(end - *data < (gssize)sizeof(length))
+        return FALSE;
+
+    memcpy(&length, *data, sizeof(length));
+    *data += sizeof(length);
+
+    if(length == JOURNAL_NO_STRING)
+        return TRUE;
+
+    if(end - *data < length)
+        return FALSE;
+
+    *string = g_strndup((const gchar*)*data, length);
+    *data += length;
+    return TRUE;
+}
+
+static const gchar*
+journal_map(GMappedFile  *file,
+            gchar       **target)
+{
+    journal_header_t header;
+    const gchar *data;
+    gsize size;
+
+    size = g_mapped_file_get_length(file);
+    data = g_mapped_file_get_contents(file);
+
+    if(size < sizeof(header))
+        return NULL;
+
+    memcpy(&header, data, sizeof(header));
+    if(memcmp(header.magic, JOURNAL_MAGIC, sizeof(header.magic)) ||
+       header.version != JOURNAL_VERSION ||
+       header.target_length > size - sizeof(header))
+        return NULL;
+
+    if(target)
+        *target = g_strndup(data + sizeof(header), header.target_length);
+
+    return data + sizeof(header) + header.target_length;
+}
@@ -0,0 +1,38 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef MTSCAN_JOURNAL_H_
+#define MTSCAN_JOURNAL_H_
+#include <glib.h>
+#include "network.h"
+
+#define JOURNAL_MAGIC   "MTSCANJ"
+#define JOURNAL_VERSION 1
+
+typedef struct journal journal_t;
+
+journal_t* journal_open(const gchar*, const gchar*);
+void journal_append(journal_t*, const network_t*, gboolean);
+gboolean journal_flush(journal_t*);
+gboolean journal_checkpoint(journal_t*);
+glong journal_tell(journal_t*);
+journal_t* journal_rotate(journal_t*, const gchar*, const gchar*, glong);
+const gchar* journal_get_target(const journal_t*);
+void journal_close(journal_t*);
+
+gchar* journal_read_target(const gchar*);
+gint journal_replay(const gchar*, void (*)(network_t*, gpointer), gpointer);
+
+#endif
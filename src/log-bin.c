@@ -0,0 +1,528 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include <glib/gstdio.h>
+#include <string.h>
+#include <math.h>
+#include "log.h"
+#include "log-bin.h"
+#include "signals.h"
+
+#define LOG_BIN_BLOCK_SIZE(count) (sizeof(log_bin_block_t) + (((guint64)(count) * SIGNALS_SAMPLE_SIZE + 7) & ~(guint64)7))
+
+G_STATIC_ASSERT(sizeof(log_bin_header_t) == 80);
+G_STATIC_ASSERT(sizeof(log_bin_network_t) == 128);
+G_STATIC_ASSERT(sizeof(log_bin_block_t) == 16);
+G_STATIC_ASSERT(sizeof(log_bin_index_t) == 16);
+
+typedef struct log_bin
+{
+    GMappedFile *file;
+    const log_bin_header_t *header;
+    const log_bin_network_t *networks;
+    const guint8 *samples;
+    const log_bin_index_t *index;
+    const gint64 *sources;
+    const gchar *strings;
+} log_bin_t;
+
+typedef struct log_bin_save_ctx
+{
+    FILE *fp;
+    gboolean strip_signals;
+    gboolean strip_gps;
+    gboolean strip_azi;
+    GString *strings;
+    GHashTable *strings_map;
+    size_t wrote;
+    size_t length;
+    guint32 block_count;
+} log_bin_save_ctx_t;
+
+static gboolean log_bin_section(gsize, guint64, guint64, gsize);
+static gboolean log_bin_sources(const log_bin_t*, guint8*);
+static guint32 log_bin_string_add(log_bin_save_ctx_t*, const gchar*);
+static void log_bin_record(log_bin_save_ctx_t*, const network_t*, log_bin_network_t*);
+static void log_bin_block_write(gint64, guint, const guint8*, gpointer);
+static void log_bin_write(log_bin_save_ctx_t*, gconstpointer, gsize);
+static gint log_bin_index_compare(gconstpointer, gconstpointer);
+
+
+gboolean
+log_bin_detect(const gchar *filename)
+{
+    gchar magic[sizeof(LOG_BIN_MAGIC)];
+    gboolean ret = FALSE;
+    FILE *fp;
+
+    if((fp = g_fopen(filename, "rb")))
+    {
+        ret = (fread(magic, sizeof(magic), 1, fp) == 1 &&
+               !memcmp(magic, LOG_BIN_MAGIC, sizeof(magic)));
+        fclose(fp);
+    }
+    return ret;
+}
+
+log_bin_t*
+log_bin_open(const gchar *filename)
+{
+    GMappedFile *file;
+    const log_bin_header_t *header;
+    const gchar *data;
+    log_bin_t *log;
+    gsize size;
+
+    /* Records are accessed in place */
+    if(G_BYTE_ORDER != G_LITTLE_ENDIAN)
+        return NULL;
+
+    if(!(file = g_mapped_file_new(filename, FALSE, NULL)))
+        return NULL;
+
+    size = g_mapped_file_get_length(file);
+    data = g_mapped_file_get_contents(file);
+    header = (const log_bin_header_t*)data;
+
+    if(size < sizeof(log_bin_header_t) ||
+       memcmp(header->magic, LOG_BIN_MAGIC, sizeof(header->magic)) ||
+       header->version != LOG_BIN_VERSION ||
+       header->source_count > G_MAXUINT8 ||
+       !log_bin_section(size, header->networks, header->network_count, sizeof(log_bin_network_t)) ||
+       !log_bin_section(size, header->samples, header->samples_size, sizeof(gchar)) ||
+       !log_bin_section(size, header->index, header->network_count, sizeof(log_bin_index_t)) ||
+       !log_bin_section(size, header->sources, header->source_count, sizeof(gint64)) ||
+       !log_bin_section(size, header->strings, header->strings_size, sizeof(gchar)) ||
+       (header->strings_size && data[header->strings + header->strings_size - 1] != '\0'))
+    {
+        g_mapped_file_unref(file);
+        return NULL;
+    }
+
+    log = g_malloc(sizeof(log_bin_t));
+    log->file = file;
+    log->header = header;
+    log->networks = (const log_bin_network_t*)(data + header->networks);
+    log->samples = (const guint8*)(data + header->samples);
+    log->index = (const log_bin_index_t*)(data + header->index);
+    log->sources = (const gint64*)(data + header->sources);
+    log->strings = data + header->strings;
+    return log;
+}
+
+void
+log_bin_close(log_bin_t *log)
+{
+    if(log)
+    {
+        g_mapped_file_unref(log->file);
+        g_free(log);
+    }
+}
+
+guint64
+log_bin_count(const log_bin_t *log)
+{
+    return log->header->network_count;
+}
+
+const log_bin_network_t*
+log_bin_network(const log_bin_t *log,
+                guint64          n)
+{
+    return (n < log->header->network_count ? &log->networks[n] : NULL);
+}
+
+const log_bin_network_t*
+log_bin_lookup(const log_bin_t *log,
+               gint64           address)
+{
+    guint64 low = 0;
+    guint64 high = log->header->network_count;
+    guint64 mid;
+
+    while(low < high)
+    {
+        mid = low + (high - low) / 2;
+        if(log->index[mid].address < address)
+            low = mid + 1;
+        else if(log->index[mid].address > address)
+            high = mid;
+        else
+            return log_bin_network(log, log->index[mid].network);
+    }
+    return NULL;
+}
+
+const log_bin_block_t*
+log_bin_blocks(const log_bin_t         *log,
+               const log_bin_network_t *network)
+{
+    const log_bin_block_t *block;
+    guint64 offset = network->samples;
+    guint64 count = 0;
+    guint32 i;
+
+    /* Blocks of a network follow each other */
+    for(i=0; i<network->block_count; i++)
+    {
+        if(offset % 8 != 0 ||
+           offset > log->header->samples_size ||
+           log->header->samples_size - offset < sizeof(log_bin_block_t))
+            return NULL;
+
+        block = (const log_bin_block_t*)(log->samples + offset);
+        if(log->header->samples_size - offset < LOG_BIN_BLOCK_SIZE(block->count))
+            return NULL;
+
+        count += block->count;
+        offset += LOG_BIN_BLOCK_SIZE(block->count);
+    }
+
+    if(!network->block_count || count != network->sample_count)
+        return NULL;
+
+    return (const log_bin_block_t*)(log->samples + network->samples);
+}
+
+const log_bin_block_t*
+log_bin_block_next(const log_bin_block_t *block)
+{
+    return (const log_bin_block_t*)((const guint8*)block + LOG_BIN_BLOCK_SIZE(block->count));
+}
+
+const gchar*
+log_bin_string(const log_bin_t *log,
+               guint32          offset)
+{
+    if(offset == LOG_BIN_NO_STRING ||
+       offset >= log->header->strings_size)
+        return NULL;
+
+    return log->strings + offset;
+}
+
+gint
+log_bin_read(const gchar  *filename,
+             void        (*net_cb)(network_t*, gpointer),
+             gpointer     user_data,
+             gboolean     strip_samples)
+{
+    const log_bin_network_t *record;
+    const log_bin_block_t *block;
+    guint8 map[G_MAXUINT8 + 1];
+    gboolean in_place;
+    network_t net;
+    log_bin_t *log;
+    guint64 i;
+    guint32 j;
+    gint count = 0;
+
+    if(!(log = log_bin_open(filename)))
+        return LOG_READ_ERROR_PARSE;
+
+    /* Sample blocks stay in the mapped file, unless the sources are numbered
+       differently than in memory, then each block is copied as a whole */
+    in_place = log_bin_sources(log, map);
+
+    for(i=0; i<log_bin_count(log); i++)
+    {
+        record = log_bin_network(log, i);
+
+        network_init(&net);
+        net.address = record->address;
+        net.frequency = record->frequency;
+        net.channel = g_strdup(log_bin_string(log, record->channel));
+        net.mode = g_strdup(log_bin_string(log, record->mode));
+        net.streams = record->streams;
+        net.ssid = g_strdup(log_bin_string(log, record->ssid));
+        net.radioname = g_strdup(log_bin_string(log, record->radioname));
+        net.rssi = record->rssi;
+        net.flags.privacy = record->privacy;
+        net.flags.routeros = record->routeros;
+        net.flags.nstreme = record->nstreme;
+        net.flags.tdma = record->tdma;
+        net.flags.wds = record->wds;
+        net.flags.bridge = record->bridge;
+        net.routeros_ver = g_strdup(log_bin_string(log, record->routeros_ver));
+        net.ubnt_airmax = record->airmax;
+        net.ubnt_ptp = record->airmax_ac_ptp;
+        net.ubnt_ptmp = record->airmax_ac_ptmp;
+        net.ubnt_mixed = record->airmax_ac_mixed;
+        net.wps = record->wps;
+        net.wps_manufacturer = g_strdup(log_bin_string(log, record->wps_manufacturer));
+        net.wps_model_name = g_strdup(log_bin_string(log, record->wps_model_name));
+        net.wps_model_number = g_strdup(log_bin_string(log, record->wps_model_number));
+        net.wps_serial_number = g_strdup(log_bin_string(log, record->wps_serial_number));
+        net.wps_device_name = g_strdup(log_bin_string(log, record->wps_device_name));
+        net.firstseen = record->firstseen;
+        net.lastseen = record->lastseen;
+        net.latitude = record->latitude;
+        net.longitude = record->longitude;
+        net.altitude = record->altitude;
+        net.accuracy = record->accuracy;
+        net.azimuth = record->azimuth;
+        net.signals = signals_new();
+
+        if(!strip_samples && (block = log_bin_blocks(log, record)))
+        {
+            for(j=0; j<record->block_count; j++, block=log_bin_block_next(block))
+            {
+                signals_adopt(net.signals, log->file, block->base, block->count,
+                              (const guint8*)(block + 1), (in_place ? NULL : map));
+            }
+        }
+
+        net_cb(&net, user_data);
+        network_free_null(&net);
+        count++;
+    }
+
+    log_bin_close(log);
+    return count;
+}
+
+gboolean
+log_bin_save(FILE                 *fp,
+             const log_snapshot_t *snapshot,
+             gboolean              strip_signals,
+             gboolean              strip_gps,
+             gboolean              strip_azi,
+             size_t               *wrote,
+             size_t               *length)
+{
+    log_bin_save_ctx_t ctx;
+    log_bin_header_t header;
+    log_bin_network_t *records;
+    log_bin_index_t entry;
+    const gint64 *sources;
+    GArray *index;
+    const network_t *net;
+    guint i;
+
+    ctx.fp = fp;
+    ctx.strip_signals = strip_signals;
+    ctx.strip_gps = strip_gps;
+    ctx.strip_azi = strip_azi;
+    ctx.strings = g_string_new(NULL);
+    ctx.strings_map = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    ctx.wrote = 0;
+    ctx.length = 0;
+    ctx.block_count = 0;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, LOG_BIN_MAGIC, sizeof(header.magic));
+    header.version = LOG_BIN_VERSION;
+    header.samples = sizeof(log_bin_header_t);
+
+    /* Header is written again at the end, with all offsets known */
+    log_bin_write(&ctx, &header, sizeof(header));
+
+    /* Blocks are written as stored, with source indexes of this process */
+    records = g_new(log_bin_network_t, snapshot->count);
+    for(i=0; i<snapshot->count; i++)
+    {
+        net = &snapshot->networks[i];
+        log_bin_record(&ctx, net, &records[i]);
+        records[i].samples = ctx.length - header.samples;
+        ctx.block_count = 0;
+        if(!strip_signals)
+            signals_pack(net->signals, strip_gps, strip_azi, log_bin_block_write, &ctx);
+        records[i].block_count = ctx.block_count;
+    }
+
+    header.samples_size = ctx.length - header.samples;
+    header.networks = ctx.length;
+    header.network_count = snapshot->count;
+    log_bin_write(&ctx, records, snapshot->count * sizeof(log_bin_network_t));
+
+    index = g_array_sized_new(FALSE, FALSE, sizeof(log_bin_index_t), snapshot->count);
+    for(i=0; i<snapshot->count; i++)
+    {
+        entry.address = records[i].address;
+        entry.network = i;
+        g_array_append_val(index, entry);
+    }
+    g_free(records);
+
+    header.index = header.networks + header.network_count * sizeof(log_bin_network_t);
+    g_array_sort(index, log_bin_index_compare);
+    log_bin_write(&ctx, index->data, index->len * sizeof(log_bin_index_t));
+    g_array_free(index, TRUE);
+
+    header.sources = header.index + header.network_count * sizeof(log_bin_index_t);
+    header.source_count = signals_source_table(&sources);
+    log_bin_write(&ctx, sources, header.source_count * sizeof(gint64));
+
+    header.strings = header.sources + header.source_count * sizeof(gint64);
+    header.strings_size = ctx.strings->len;
+    log_bin_write(&ctx, ctx.strings->str, ctx.strings->len);
+
+    if(fseek(fp, 0, SEEK_SET) != 0 ||
+       fwrite(&header, sizeof(header), 1, fp) != 1)
+    {
+        ctx.wrote -= MIN(ctx.wrote, sizeof(header));
+    }
+
+    g_hash_table_destroy(ctx.strings_map);
+    g_string_free(ctx.strings, TRUE);
+
+    *wrote = ctx.wrote;
+    *length = ctx.length;
+    return (ctx.wrote == ctx.length);
+}
+
+static gboolean
+log_bin_section(gsize   size,
+                guint64 offset,
+                guint64 count,
+                gsize   element)
+{
+    return (offset % 8 == 0 &&
+            offset <= size &&
+            count <= (size - offset) / element);
+}
+
+static gboolean
+log_bin_sources(const log_bin_t *log,
+                guint8          *map)
+{
+    gboolean ret = TRUE;
+    guint i;
+
+    memset(map, 0, G_MAXUINT8 + 1);
+    for(i=1; i<=log->header->source_count; i++)
+    {
+        map[i] = signals_source_index(log->sources[i-1]);
+        ret = ret && (map[i] == i);
+    }
+    return ret;
+}
+
+static guint32
+log_bin_string_add(log_bin_save_ctx_t *ctx,
+                   const gchar        *string)
+{
+    gpointer offset;
+    guint32 ret;
+
+    if(!string)
+        return LOG_BIN_NO_STRING;
+
+    if(g_hash_table_lookup_extended(ctx->strings_map, string, NULL, &offset))
+        return GPOINTER_TO_UINT(offset);
+
+    if(ctx->strings->len >= LOG_BIN_NO_STRING - strlen(string) - 1)
+        return LOG_BIN_NO_STRING;
+
+    ret = (guint32)ctx->strings->len;
+    g_string_append_len(ctx->strings, string, strlen(string) + 1);
+    g_hash_table_insert(ctx->strings_map, g_strdup(string), GUINT_TO_POINTER(ret));
+    return ret;
+}
+
+static void
+log_bin_record(log_bin_save_ctx_t *ctx,
+               const network_t    *net,
+               log_bin_network_t  *record)
+{
+    memset(record, 0, sizeof(log_bin_network_t));
+    record->address = net->address;
+    record->firstseen = net->firstseen;
+    record->lastseen = net->lastseen;
+    record->sample_count = (ctx->strip_signals ? 0 : (guint32)signals_count(net->signals));
+    record->frequency = net->frequency;
+    record->channel = log_bin_string_add(ctx, net->channel);
+    record->mode = log_bin_string_add(ctx, net->mode);
+    record->ssid = log_bin_string_add(ctx, net->ssid);
+    record->radioname = log_bin_string_add(ctx, net->radioname);
+    record->routeros_ver = log_bin_string_add(ctx, net->routeros_ver);
+    record->wps_manufacturer = log_bin_string_add(ctx, net->wps_manufacturer);
+    record->wps_model_name = log_bin_string_add(ctx, net->wps_model_name);
+    record->wps_model_number = log_bin_string_add(ctx, net->wps_model_number);
+    record->wps_serial_number = log_bin_string_add(ctx, net->wps_serial_number);
+    record->wps_device_name = log_bin_string_add(ctx, net->wps_device_name);
+    record->streams = net->streams;
+    record->rssi = net->rssi;
+    record->privacy = net->flags.privacy;
+    record->routeros = net->flags.routeros;
+    record->nstreme = net->flags.nstreme;
+    record->tdma = net->flags.tdma;
+    record->wds = net->flags.wds;
+    record->bridge = net->flags.bridge;
+    record->airmax = net->ubnt_airmax;
+    record->airmax_ac_ptp = net->ubnt_ptp;
+    record->airmax_ac_ptmp = net->ubnt_ptmp;
+    record->airmax_ac_mixed = net->ubnt_mixed;
+    record->wps = net->wps;
+
+    if(ctx->strip_gps)
+    {
+        record->latitude = NAN;
+        record->longitude = NAN;
+        record->altitude = NAN;
+        record->accuracy = NAN;
+    }
+    else
+    {
+        record->latitude = net->latitude;
+        record->longitude = net->longitude;
+        record->altitude = net->altitude;
+        record->accuracy = net->accuracy;
+    }
+
+    record->azimuth = (ctx->strip_azi ? NAN : net->azimuth);
+}
+
+static void
+log_bin_block_write(gint64        base,
+                    guint         count,
+                    const guint8 *data,
+                    gpointer      user_data)
+{
+    log_bin_save_ctx_t *ctx = (log_bin_save_ctx_t*)user_data;
+    static const guint8 padding[8] = { 0 };
+    log_bin_block_t block;
+    gsize length = (gsize)count * SIGNALS_SAMPLE_SIZE;
+
+    block.base = base;
+    block.count = count;
+    block.reserved = 0;
+    log_bin_write(ctx, &block, sizeof(block));
+    log_bin_write(ctx, data, length);
+    log_bin_write(ctx, padding, LOG_BIN_BLOCK_SIZE(count) - sizeof(block) - length);
+    ctx->block_count++;
+}
+
+static void
+log_bin_write(log_bin_save_ctx_t *ctx,
+              gconstpointer       data,
+              gsize               length)
+{
+    if(!length)
+        return;
+
+    ctx->wrote += fwrite(data, 1, length, ctx->fp);
+    ctx->length += length;
+}
+
+static gint
+log_bin_index_compare(gconstpointer a,
+                      gconstpointer b)
+{
+    gint64 addr_a = ((const log_bin_index_t*)a)->address;
+    gint64 addr_b = ((const log_bin_index_t*)b)->address;
+    return (addr_a < addr_b ? -1 : (addr_a > addr_b ? 1 : 0));
+}
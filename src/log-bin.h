@@ -0,0 +1,114 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef MTSCAN_LOG_BIN_H_
+#define MTSCAN_LOG_BIN_H_
+#include <stdio.h>
+#include <glib.h>
+#include "network.h"
+#include "log.h"
+
+#define LOG_BIN_MAGIC     "MTSCANB"
+#define LOG_BIN_VERSION   2
+#define LOG_BIN_NO_STRING G_MAXUINT32
+
+/* All values are little-endian, sections are 8-byte aligned:
+ * header, sample blocks, network records, index, sources, string table */
+typedef struct log_bin_header
+{
+    gchar magic[8];
+    guint32 version;
+    guint32 source_count;
+    guint64 network_count;
+    guint64 networks;
+    guint64 samples_size;
+    guint64 samples;
+    guint64 index;
+    guint64 sources;
+    guint64 strings;
+    guint64 strings_size;
+} log_bin_header_t;
+
+typedef struct log_bin_network
+{
+    gint64 address;
+    gint64 firstseen;
+    gint64 lastseen;
+    gdouble latitude;
+    gdouble longitude;
+    guint64 samples;
+    guint32 sample_count;
+    gint32 frequency;
+    gfloat altitude;
+    gfloat accuracy;
+    gfloat azimuth;
+    guint32 channel;
+    guint32 mode;
+    guint32 ssid;
+    guint32 radioname;
+    guint32 routeros_ver;
+    guint32 wps_manufacturer;
+    guint32 wps_model_name;
+    guint32 wps_model_number;
+    guint32 wps_serial_number;
+    guint32 wps_device_name;
+    gint8 streams;
+    gint8 rssi;
+    gint8 privacy;
+    gint8 routeros;
+    gint8 nstreme;
+    gint8 tdma;
+    gint8 wds;
+    gint8 bridge;
+    gint8 airmax;
+    gint8 airmax_ac_ptp;
+    gint8 airmax_ac_ptmp;
+    gint8 airmax_ac_mixed;
+    gint8 wps;
+    guint8 reserved[3];
+    guint32 block_count;
+} log_bin_network_t;
+
+/* Followed by the arrays of count samples, as laid out in signals.c,
+ * the source is an index into the source table of the file (0 for none) */
+typedef struct log_bin_block
+{
+    gint64 base;
+    guint32 count;
+    guint32 reserved;
+} log_bin_block_t;
+
+typedef struct log_bin_index
+{
+    gint64 address;
+    guint64 network;
+} log_bin_index_t;
+
+typedef struct log_bin log_bin_t;
+
+gboolean log_bin_detect(const gchar*);
+log_bin_t* log_bin_open(const gchar*);
+void log_bin_close(log_bin_t*);
+guint64 log_bin_count(const log_bin_t*);
+const log_bin_network_t* log_bin_network(const log_bin_t*, guint64);
+const log_bin_network_t* log_bin_lookup(const log_bin_t*, gint64);
+const log_bin_block_t* log_bin_blocks(const log_bin_t*, const log_bin_network_t*);
+const log_bin_block_t* log_bin_block_next(const log_bin_block_t*);
+const gchar* log_bin_string(const log_bin_t*, guint32);
+
+gint log_bin_read(const gchar*, void (*)(network_t*, gpointer), gpointer, gboolean);
+gboolean log_bin_save(FILE*, const log_snapshot_t*, gboolean, gboolean, gboolean, size_t*, size_t*);
+
+#endif
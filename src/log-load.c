@@ -0,0 +1,189 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include <string.h>
+#include "log.h"
+#include "log-load.h"
+
+/* Files are parsed concurrently into separate network tables,
+   which are then handed over to the caller strictly in the order
+   of the file list, so the result does not depend on the timing. */
+
+typedef struct log_load_file
+{
+    gchar *filename;
+    GPtrArray *networks;
+    gint count;
+    gboolean finished;
+} log_load_file_t;
+
+typedef struct log_load
+{
+    GThreadPool *pool;
+    log_load_file_t *files;
+    guint length;
+    gboolean strip_samples;
+    GSourceFunc progress_cb;
+    gpointer user_data;
+    GMutex mutex;
+    GCond cond;
+} log_load_t;
+
+static void log_load_thread(gpointer, gpointer);
+static void log_load_net_cb(network_t*, gpointer);
+static void log_load_net_free(gpointer);
+
+
+log_load_t*
+log_load_new(GSList      *filenames,
+             gboolean     strip_samples,
+             GSourceFunc  progress_cb,
+             gpointer     user_data)
+{
+    log_load_t *load;
+    GSList *it;
+    guint i;
+
+    load = g_malloc0(sizeof(log_load_t));
+    load->length = g_slist_length(filenames);
+    load->files = g_new0(log_load_file_t, load->length);
+    load->strip_samples = strip_samples;
+    load->progress_cb = progress_cb;
+    load->user_data = user_data;
+    g_mutex_init(&load->mutex);
+    g_cond_init(&load->cond);
+
+    load->pool = g_thread_pool_new(log_load_thread,
+                                   load,
+                                   MAX(1, MIN((gint)load->length, (gint)g_get_num_processors())),
+                                   TRUE,
+                                   NULL);
+
+    for(it=filenames, i=0; it; it=it->next, i++)
+    {
+        load->files[i].filename = g_strdup((const gchar*)it->data);
+        load->files[i].networks = g_ptr_array_new_with_free_func(log_load_net_free);
+        g_thread_pool_push(load->pool, &load->files[i], NULL);
+    }
+
+    return load;
+}
+
+guint
+log_load_length(const log_load_t *load)
+{
+    return load->length;
+}
+
+const gchar*
+log_load_filename(const log_load_t *load,
+                  guint             i)
+{
+    return load->files[i].filename;
+}
+
+gint
+log_load_read(log_load_t  *load,
+              guint        i,
+              void       (*net_cb)(network_t*, gpointer),
+              gpointer     user_data)
+{
+    log_load_file_t *file = &load->files[i];
+    guint j;
+
+    g_mutex_lock(&load->mutex);
+    while(!file->finished)
+        g_cond_wait(&load->cond, &load->mutex);
+    g_mutex_unlock(&load->mutex);
+
+    for(j=0; j<file->networks->len; j++)
+        net_cb(g_ptr_array_index(file->networks, j), user_data);
+
+    /* Release the table early, the remaining files may be large */
+    g_ptr_array_set_size(file->networks, 0);
+    return file->count;
+}
+
+void
+log_load_free(log_load_t *load)
+{
+    guint i;
+
+    g_thread_pool_free(load->pool, FALSE, TRUE);
+
+    for(i=0; i<load->length; i++)
+    {
+        g_free(load->files[i].filename);
+        g_ptr_array_free(load->files[i].networks, TRUE);
+    }
+
+    g_mutex_clear(&load->mutex);
+    g_cond_clear(&load->cond);
+    g_free(load->files);
+    g_free(load);
+}
+
+static void
+log_load_thread(gpointer data,
+                gpointer user_data)
+{
+    log_load_file_t *file = (log_load_file_t*)data;
+    log_load_t *load = (log_load_t*)user_data;
+    gint count;
+
+    count = log_read(file->filename, log_load_net_cb, file->networks, load->strip_samples);
+
+    g_mutex_lock(&load->mutex);
+    file->count = count;
+    file->finished = TRUE;
+    g_cond_broadcast(&load->cond);
+    g_mutex_unlock(&load->mutex);
+
+    if(load->progress_cb)
+        g_idle_add(load->progress_cb, load->user_data);
+}
+
+static void
+log_load_net_cb(network_t *network,
+                gpointer   user_data)
+{
+    GPtrArray *networks = (GPtrArray*)user_data;
+    network_t *copy;
+
+    /* Take over the network, the reader frees only what is left */
+    copy = g_malloc(sizeof(network_t));
+    memcpy(copy, network, sizeof(network_t));
+    g_ptr_array_add(networks, copy);
+
+    network->channel = NULL;
+    network->mode = NULL;
+    network->ssid = NULL;
+    network->radioname = NULL;
+    network->routeros_ver = NULL;
+    network->wps_manufacturer = NULL;
+    network->wps_model_name = NULL;
+    network->wps_model_number = NULL;
+    network->wps_serial_number = NULL;
+    network->wps_device_name = NULL;
+    network->signals = NULL;
+}
+
+static void
+log_load_net_free(gpointer data)
+{
+    network_t *network = (network_t*)data;
+    network_free(network);
+    g_free(network);
+}
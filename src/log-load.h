@@ -0,0 +1,29 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef MTSCAN_LOG_LOAD_H_
+#define MTSCAN_LOG_LOAD_H_
+#include <glib.h>
+#include "network.h"
+
+typedef struct log_load log_load_t;
+
+log_load_t* log_load_new(GSList*, gboolean, GSourceFunc, gpointer);
+guint log_load_length(const log_load_t*);
+const gchar* log_load_filename(const log_load_t*, guint);
+gint log_load_read(log_load_t*, guint, void (*)(network_t*, gpointer), gpointer);
+void log_load_free(log_load_t*);
+
+#endif
@@ -0,0 +1,243 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include <string.h>
+#include <math.h>
+#include "log-merge.h"
+#include "signals.h"
+
+/* Networks are merged with the same rules as in mtscan_model_add(),
+   but without any GTK data structures, for the batch mode */
+
+typedef struct log_merge
+{
+    GArray *networks;
+    GPtrArray *pending;
+    GHashTable *map;
+} log_merge_t;
+
+static void log_merge_take(gchar**, gchar**, gboolean);
+static void log_merge_details(network_t*, network_t*);
+static void log_merge_position(network_t*, const network_t*);
+static void log_merge_wps(network_t*, network_t*);
+
+
+log_merge_t*
+log_merge_new(void)
+{
+    log_merge_t *merge;
+
+    merge = g_malloc(sizeof(log_merge_t));
+    merge->networks = g_array_new(FALSE, FALSE, sizeof(network_t));
+    merge->pending = g_ptr_array_new();
+    merge->map = g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free, NULL);
+    return merge;
+}
+
+void
+log_merge_add(log_merge_t *merge,
+              network_t   *net,
+              gboolean     merge_existing)
+{
+    network_t *entry;
+    GPtrArray *pending;
+    gpointer index;
+    gint64 *address;
+    guint i;
+
+    if(merge_existing && (index = g_hash_table_lookup(merge->map, &net->address)))
+    {
+        i = GPOINTER_TO_UINT(index) - 1;
+        entry = &g_array_index(merge->networks, network_t, i);
+
+        /* Signal samples are merged at once in log_merge_snapshot() */
+        if(net->signals && signals_count(net->signals))
+        {
+            if(!(pending = g_ptr_array_index(merge->pending, i)))
+            {
+                pending = g_ptr_array_new_with_free_func((GDestroyNotify)signals_free);
+                g_ptr_array_index(merge->pending, i) = pending;
+            }
+            g_ptr_array_add(pending, net->signals);
+            net->signals = NULL;
+        }
+
+        if(net->firstseen < entry->firstseen)
+            entry->firstseen = net->firstseen;
+
+        if(net->lastseen > entry->lastseen)
+        {
+            log_merge_details(entry, net);
+            entry->lastseen = net->lastseen;
+        }
+
+        if(net->rssi > entry->rssi)
+        {
+            entry->rssi = net->rssi;
+            log_merge_position(entry, net);
+        }
+
+        if(net->wps >= entry->wps)
+            log_merge_wps(entry, net);
+        return;
+    }
+
+    /* Take over the network, leaving only empty fields for the caller */
+    g_array_set_size(merge->networks, merge->networks->len + 1);
+    entry = &g_array_index(merge->networks, network_t, merge->networks->len - 1);
+    memcpy(entry, net, sizeof(network_t));
+    entry->distance = NAN;
+    log_merge_take(&entry->channel, &net->channel, TRUE);
+    log_merge_take(&entry->mode, &net->mode, TRUE);
+    log_merge_take(&entry->ssid, &net->ssid, TRUE);
+    log_merge_take(&entry->radioname, &net->radioname, TRUE);
+    log_merge_take(&entry->routeros_ver, &net->routeros_ver, TRUE);
+    log_merge_take(&entry->wps_manufacturer, &net->wps_manufacturer, FALSE);
+    log_merge_take(&entry->wps_model_name, &net->wps_model_name, FALSE);
+    log_merge_take(&entry->wps_model_number, &net->wps_model_number, FALSE);
+    log_merge_take(&entry->wps_serial_number, &net->wps_serial_number, FALSE);
+    log_merge_take(&entry->wps_device_name, &net->wps_device_name, FALSE);
+    if(!entry->signals)
+        entry->signals = signals_new();
+    net->signals = NULL;
+
+    /* The array may be reallocated, so keep own copies of the keys */
+    address = g_new(gint64, 1);
+    *address = entry->address;
+    g_ptr_array_add(merge->pending, NULL);
+    g_hash_table_insert(merge->map, address, GUINT_TO_POINTER(merge->networks->len));
+}
+
+guint
+log_merge_length(const log_merge_t *merge)
+{
+    return merge->networks->len;
+}
+
+log_snapshot_t*
+log_merge_snapshot(log_merge_t *merge)
+{
+    log_snapshot_t *snapshot;
+    GPtrArray *pending;
+    network_t *entry;
+    guint i;
+
+    for(i=0; i<merge->networks->len; i++)
+    {
+        if((pending = g_ptr_array_index(merge->pending, i)))
+        {
+            entry = &g_array_index(merge->networks, network_t, i);
+            signals_merge_all(entry->signals, (signals_t**)pending->pdata, pending->len);
+            g_ptr_array_free(pending, TRUE);
+            g_ptr_array_index(merge->pending, i) = NULL;
+        }
+    }
+
+    snapshot = g_new(log_snapshot_t, 1);
+    snapshot->count = merge->networks->len;
+    snapshot->networks = (network_t*)g_array_free(merge->networks, FALSE);
+
+    /* The networks now belong to the snapshot */
+    merge->networks = g_array_new(FALSE, FALSE, sizeof(network_t));
+    g_ptr_array_set_size(merge->pending, 0);
+    g_hash_table_remove_all(merge->map);
+    return snapshot;
+}
+
+void
+log_merge_free(log_merge_t *merge)
+{
+    guint i;
+
+    if(!merge)
+        return;
+
+    for(i=0; i<merge->networks->len; i++)
+    {
+        network_free(&g_array_index(merge->networks, network_t, i));
+        if(g_ptr_array_index(merge->pending, i))
+            g_ptr_array_free(g_ptr_array_index(merge->pending, i), TRUE);
+    }
+
+    g_hash_table_destroy(merge->map);
+    g_ptr_array_free(merge->pending, TRUE);
+    g_array_free(merge->networks, TRUE);
+    g_free(merge);
+}
+
+static void
+log_merge_take(gchar    **dest,
+               gchar    **src,
+               gboolean   empty)
+{
+    /* The model keeps empty strings instead of NULLs in some columns */
+    *dest = (*src ? *src : (empty ? g_strdup("") : NULL));
+    *src = NULL;
+}
+
+static void
+log_merge_details(network_t *entry,
+                  network_t *net)
+{
+    g_free(entry->channel);
+    g_free(entry->mode);
+    g_free(entry->ssid);
+    g_free(entry->radioname);
+    g_free(entry->routeros_ver);
+
+    entry->frequency = net->frequency;
+    log_merge_take(&entry->channel, &net->channel, TRUE);
+    entry->streams = net->streams;
+    log_merge_take(&entry->mode, &net->mode, TRUE);
+    log_merge_take(&entry->ssid, &net->ssid, TRUE);
+    log_merge_take(&entry->radioname, &net->radioname, TRUE);
+    entry->flags = net->flags;
+    log_merge_take(&entry->routeros_ver, &net->routeros_ver, TRUE);
+    entry->ubnt_airmax = net->ubnt_airmax;
+    entry->ubnt_ptp = net->ubnt_ptp;
+    entry->ubnt_ptmp = net->ubnt_ptmp;
+    entry->ubnt_mixed = net->ubnt_mixed;
+    entry->distance = NAN;
+}
+
+static void
+log_merge_position(network_t       *entry,
+                   const network_t *net)
+{
+    entry->latitude = net->latitude;
+    entry->longitude = net->longitude;
+    entry->altitude = net->altitude;
+    entry->accuracy = net->accuracy;
+    entry->azimuth = net->azimuth;
+    entry->distance = NAN;
+}
+
+static void
+log_merge_wps(network_t *entry,
+              network_t *net)
+{
+    g_free(entry->wps_manufacturer);
+    g_free(entry->wps_model_name);
+    g_free(entry->wps_model_number);
+    g_free(entry->wps_serial_number);
+    g_free(entry->wps_device_name);
+
+    entry->wps = net->wps;
+    log_merge_take(&entry->wps_manufacturer, &net->wps_manufacturer, FALSE);
+    log_merge_take(&entry->wps_model_name, &net->wps_model_name, FALSE);
+    log_merge_take(&entry->wps_model_number, &net->wps_model_number, FALSE);
+    log_merge_take(&entry->wps_serial_number, &net->wps_serial_number, FALSE);
+    log_merge_take(&entry->wps_device_name, &net->wps_device_name, FALSE);
+}
@@ -0,0 +1,30 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef MTSCAN_LOG_MERGE_H_
+#define MTSCAN_LOG_MERGE_H_
+#include <glib.h>
+#include "network.h"
+#include "log.h"
+
+typedef struct log_merge log_merge_t;
+
+log_merge_t* log_merge_new(void);
+void log_merge_add(log_merge_t*, network_t*, gboolean);
+guint log_merge_length(const log_merge_t*);
+log_snapshot_t* log_merge_snapshot(log_merge_t*);
+void log_merge_free(log_merge_t*);
+
+#endif
@@ -0,0 +1,511 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include <glib/gstdio.h>
+#include <string.h>
+#include <math.h>
+#include "log.h"
+#include "log-pcap.h"
+#include "signals.h"
+#include "tzsp-receiver.h"
+#include "tzsp/tzsp-decap.h"
+
+/* Captures of TZSP streams or raw IEEE 802.11 frames are decoded
+   with the same parser as the live TZSP receiver, but timestamps
+   of the packets are used instead of the current time */
+
+#define PCAP_MAGIC         0xA1B2C3D4
+#define PCAP_MAGIC_NSEC    0xA1B23C4D
+#define PCAPNG_MAGIC       0x0A0D0D0A
+#define PCAPNG_BYTE_ORDER  0x1A2B3C4D
+
+#define PCAPNG_BLOCK_IDB   0x00000001
+#define PCAPNG_BLOCK_SPB   0x00000003
+#define PCAPNG_BLOCK_EPB   0x00000006
+#define PCAPNG_OPT_TSRESOL 9
+
+#define LINKTYPE_ETHERNET          1
+#define LINKTYPE_RAW             101
+#define LINKTYPE_IEEE802_11      105
+#define LINKTYPE_LINUX_SLL       113
+#define LINKTYPE_IEEE802_11_RADIO 127
+#define LINKTYPE_TZSP            128
+#define LINKTYPE_IPV4            228
+
+#define LOG_PCAP_CHANNEL_WIDTH 20
+
+typedef struct log_pcap_interface
+{
+    guint16 linktype;
+    guint64 units;
+    guint shift;
+} log_pcap_interface_t;
+
+typedef struct log_pcap_entry
+{
+    network_t *network;
+    gint64 sample_ts;
+} log_pcap_entry_t;
+
+typedef struct log_pcap
+{
+    const guint8 *data;
+    const guint8 *end;
+    gboolean swap;
+    GArray *interfaces;
+    GHashTable *map;
+    GPtrArray *entries;
+    gint64 last_ts;
+    gboolean strip_samples;
+} log_pcap_t;
+
+static gboolean log_pcap_read_classic(log_pcap_t*);
+static gboolean log_pcap_read_ng(log_pcap_t*);
+static void log_pcap_interface(log_pcap_t*, const guint8*, guint32);
+static void log_pcap_packet(log_pcap_t*, guint16, gint64, const guint8*, guint32);
+static const guint8* log_pcap_radiotap(const guint8*, guint32*, const gint8**);
+static guint16 log_pcap_u16(const log_pcap_t*, const guint8*);
+static guint32 log_pcap_u32(const log_pcap_t*, const guint8*);
+static void log_pcap_entry_free(gpointer);
+
+
+gboolean
+log_pcap_detect(const gchar *filename)
+{
+    guint32 magic;
+    gboolean ret = FALSE;
+    FILE *fp;
+
+    if((fp = g_fopen(filename, "rb")))
+    {
+        if(fread(&magic, sizeof(magic), 1, fp) == 1)
+        {
+            ret = (magic == PCAP_MAGIC ||
+                   magic == GUINT32_SWAP_LE_BE(PCAP_MAGIC) ||
+                   magic == PCAP_MAGIC_NSEC ||
+                   magic == GUINT32_SWAP_LE_BE(PCAP_MAGIC_NSEC) ||
+                   magic == PCAPNG_MAGIC);
+        }
+        fclose(fp);
+    }
+    return ret;
+}
+
+gint
+log_pcap_read(const gchar  *filename,
+              void        (*net_cb)(network_t*, gpointer),
+              gpointer      user_data,
+              gboolean      strip_samples)
+{
+    GMappedFile *file;
+    log_pcap_t pcap;
+    log_pcap_entry_t *entry;
+    guint32 magic;
+    gboolean valid;
+    gint count = 0;
+    guint i;
+
+    if(!(file = g_mapped_file_new(filename, FALSE, NULL)))
+        return LOG_READ_ERROR_OPEN;
+
+    pcap.data = (const guint8*)g_mapped_file_get_contents(file);
+    pcap.end = pcap.data + g_mapped_file_get_length(file);
+    pcap.swap = FALSE;
+    pcap.interfaces = g_array_new(FALSE, FALSE, sizeof(log_pcap_interface_t));
+    pcap.map = g_hash_table_new(g_int64_hash, g_int64_equal);
+    pcap.entries = g_ptr_array_new_with_free_func(log_pcap_entry_free);
+    pcap.last_ts = 0;
+    pcap.strip_samples = strip_samples;
+
+    valid = FALSE;
+    if(pcap.end - pcap.data >= (gssize)sizeof(magic))
+    {
+        memcpy(&magic, pcap.data, sizeof(magic));
+        if(magic == PCAPNG_MAGIC)
+            valid = log_pcap_read_ng(&pcap);
+        else
+            valid = log_pcap_read_classic(&pcap);
+    }
+
+    if(valid)
+    {
+        /* Networks are reported in order of their first appearance */
+        for(i=0; i<pcap.entries->len; i++)
+        {
+            entry = g_ptr_array_index(pcap.entries, i);
+            net_cb(entry->network, user_data);
+            count++;
+        }
+    }
+    else
+    {
+        count = LOG_READ_ERROR_PARSE;
+    }
+
+    g_ptr_array_free(pcap.entries, TRUE);
+    g_hash_table_destroy(pcap.map);
+    g_array_free(pcap.interfaces, TRUE);
+    g_mapped_file_unref(file);
+    return count;
+}
+
+static gboolean
+log_pcap_read_classic(log_pcap_t *pcap)
+{
+    const guint8 *ptr = pcap->data;
+    guint32 magic;
+    guint32 length;
+    guint16 linktype;
+    gint64 ts;
+
+    if(pcap->end - ptr < 24)
+        return FALSE;
+
+    memcpy(&magic, ptr, sizeof(magic));
+    if(magic == GUINT32_SWAP_LE_BE(PCAP_MAGIC) ||
+       magic == GUINT32_SWAP_LE_BE(PCAP_MAGIC_NSEC))
+        pcap->swap = TRUE;
+    else if(magic != PCAP_MAGIC && magic != PCAP_MAGIC_NSEC)
+        return FALSE;
+
+    linktype = log_pcap_u32(pcap, ptr + 20) & 0xFFFF;
+    ptr += 24;
+
+    /* A truncated record at the end of the file is ignored */
+    while(pcap->end - ptr >= 16)
+    {
+        ts = log_pcap_u32(pcap, ptr);
+        length = log_pcap_u32(pcap, ptr + 8);
+        ptr += 16;
+
+        if(length > (guint32)(pcap->end - ptr))
+            break;
+
+        log_pcap_packet(pcap, linktype, ts, ptr, length);
+        ptr += length;
+    }
+
+    return TRUE;
+}
+
+static gboolean
+log_pcap_read_ng(log_pcap_t *pcap)
+{
+    const guint8 *ptr = pcap->data;
+    const log_pcap_interface_t *interface;
+    guint32 type;
+    guint32 length;
+    guint32 id;
+    guint32 caplen;
+    guint64 ts;
+
+    while(pcap->end - ptr >= 12)
+    {
+        memcpy(&type, ptr, sizeof(type));
+        if(type == PCAPNG_MAGIC)
+        {
+            /* Every section may use a different byte order */
+            memcpy(&id, ptr + 8, sizeof(id));
+            if(id == PCAPNG_BYTE_ORDER)
+                pcap->swap = FALSE;
+            else if(id == GUINT32_SWAP_LE_BE(PCAPNG_BYTE_ORDER))
+                pcap->swap = TRUE;
+            else
+                return (ptr != pcap->data);
+
+            g_array_set_size(pcap->interfaces, 0);
+        }
+
+        type = log_pcap_u32(pcap, ptr);
+        length = log_pcap_u32(pcap, ptr + 4);
+        if(length < 12 || length % 4 || length > (guint32)(pcap->end - ptr))
+            return (ptr != pcap->data);
+
+        if(type == PCAPNG_BLOCK_IDB && length >= 20)
+        {
+            log_pcap_interface(pcap, ptr + 8, length - 12);
+        }
+        else if(type == PCAPNG_BLOCK_EPB && length >= 32)
+        {
+            id = log_pcap_u32(pcap, ptr + 8);
+            caplen = log_pcap_u32(pcap, ptr + 20);
+            if(id < pcap->interfaces->len && caplen <= length - 32)
+            {
+                interface = &g_array_index(pcap->interfaces, log_pcap_interface_t, id);
+                ts = ((guint64)log_pcap_u32(pcap, ptr + 12) << 32) | log_pcap_u32(pcap, ptr + 16);
+                ts = (interface->units ? ts / interface->units : ts >> interface->shift);
+                log_pcap_packet(pcap, interface->linktype, (gint64)ts, ptr + 28, caplen);
+            }
+        }
+        else if(type == PCAPNG_BLOCK_SPB && length >= 16 && pcap->interfaces->len)
+        {
+            /* Simple packets carry no timestamp, use the previous one */
+            interface = &g_array_index(pcap->interfaces, log_pcap_interface_t, 0);
+            caplen = MIN(log_pcap_u32(pcap, ptr + 8), length - 16);
+            log_pcap_packet(pcap, interface->linktype, pcap->last_ts, ptr + 12, caplen);
+        }
+
+        ptr += length;
+    }
+
+    return TRUE;
+}
+
+static void
+log_pcap_interface(log_pcap_t   *pcap,
+                   const guint8 *body,
+                   guint32       length)
+{
+    log_pcap_interface_t interface;
+    const guint8 *option;
+    guint16 code;
+    guint16 option_length;
+    guint i;
+
+    interface.linktype = log_pcap_u16(pcap, body);
+    interface.units = 1000000;
+    interface.shift = 0;
+
+    option = body + 8;
+    while(body + length - option >= 4)
+    {
+        code = log_pcap_u16(pcap, option);
+        option_length = log_pcap_u16(pcap, option + 2);
+        if(!code || body + length - option - 4 < option_length)
+            break;
+
+        if(code == PCAPNG_OPT_TSRESOL && option_length == 1)
+        {
+            if(option[4] & 0x80)
+            {
+                interface.units = 0;
+                interface.shift = option[4] & 0x7F;
+            }
+            else
+            {
+                for(interface.units = 1, i = 0; i < option[4] && i < 19; i++)
+                    interface.units *= 10;
+            }
+        }
+
+        option += 4 + ((option_length + 3) & ~3);
+    }
+
+    g_array_append_val(pcap->interfaces, interface);
+}
+
+static void
+log_pcap_packet(log_pcap_t   *pcap,
+                guint16       linktype,
+                gint64        ts,
+                const guint8 *packet,
+                guint32       length)
+{
+    const gint8 *rssi = NULL;
+    const guint8 *channel = NULL;
+    const guint8 *sensor_mac = NULL;
+    log_pcap_entry_t *entry;
+    network_t *network;
+    gint64 sample_source;
+    gint8 sample_rssi;
+
+    pcap->last_ts = ts;
+
+    switch(linktype)
+    {
+        case LINKTYPE_ETHERNET:
+            packet = decap_ethernet(packet, &length);
+            break;
+
+        case LINKTYPE_LINUX_SLL:
+            if(length <= 16 || packet[14] != 0x08 || packet[15] != 0x00)
+                return;
+            packet += 16;
+            length -= 16;
+            break;
+
+        case LINKTYPE_RAW:
+        case LINKTYPE_IPV4:
+        case LINKTYPE_TZSP:
+            break;
+
+        case LINKTYPE_IEEE802_11:
+            break;
+
+        case LINKTYPE_IEEE802_11_RADIO:
+            packet = log_pcap_radiotap(packet, &length, &rssi);
+            break;
+
+        default:
+            return;
+    }
+
+    if(!packet)
+        return;
+
+    if(linktype != LINKTYPE_IEEE802_11 &&
+       linktype != LINKTYPE_IEEE802_11_RADIO)
+    {
+        if(linktype != LINKTYPE_TZSP)
+        {
+            /* Only IPv4 UDP datagrams may carry the TZSP stream */
+            if(length < 20 || (packet[0] >> 4) != 4 || packet[9] != 17)
+                return;
+
+            packet = decap_udp(decap_ip(packet, &length), &length);
+        }
+
+        packet = decap_tzsp(packet, &length, &rssi, &channel, &sensor_mac);
+        if(!packet)
+            return;
+    }
+
+    network = tzsp_receiver_network(packet,
+                                    length,
+                                    rssi,
+                                    channel,
+                                    sensor_mac,
+                                    LOG_PCAP_CHANNEL_WIDTH,
+                                    0);
+    if(!network)
+        return;
+
+    network->firstseen = ts;
+    network->lastseen = ts;
+    sample_rssi = network->rssi;
+    sample_source = network->source;
+
+    entry = g_hash_table_lookup(pcap->map, &network->address);
+    if(entry)
+    {
+        network->firstseen = MIN(network->firstseen, entry->network->firstseen);
+        tzsp_receiver_merge(entry->network, network);
+        entry->network->firstseen = network->firstseen;
+        network_free(network);
+        g_free(network);
+    }
+    else
+    {
+        entry = g_malloc(sizeof(log_pcap_entry_t));
+        entry->network = network;
+        entry->network->signals = signals_new();
+        entry->sample_ts = G_MININT64;
+        g_ptr_array_add(pcap->entries, entry);
+
+        /* Key points to the address inside the network */
+        g_hash_table_insert(pcap->map, &network->address, entry);
+    }
+
+    /* Keep at most one signal sample per second, as in the live mode */
+    if(!pcap->strip_samples &&
+       sample_rssi != NETWORK_NO_SIGNAL &&
+       ts != entry->sample_ts)
+    {
+        signals_add(entry->network->signals,
+                    ts,
+                    sample_rssi,
+                    NAN, NAN, NAN, NAN, NAN,
+                    sample_source);
+        entry->sample_ts = ts;
+    }
+}
+
+static const guint8*
+log_pcap_radiotap(const guint8  *packet,
+                  guint32       *length,
+                  const gint8  **rssi)
+{
+    static const guint8 align[] = { 8, 1, 1, 2, 1, 1 };
+    static const guint8 size[]  = { 8, 1, 1, 4, 2, 1 };
+    guint32 present;
+    guint32 word;
+    guint16 header_length;
+    guint offset;
+    guint8 flags = 0;
+    guint i;
+
+    if(*length < 8)
+        return NULL;
+
+    memcpy(&header_length, packet + 2, sizeof(header_length));
+    header_length = GUINT16_FROM_LE(header_length);
+    memcpy(&present, packet + 4, sizeof(present));
+    present = GUINT32_FROM_LE(present);
+    if(header_length < 8 || header_length > *length)
+        return NULL;
+
+    /* Skip the extended presence bitmaps */
+    offset = 8;
+    word = present;
+    while((word & 0x80000000) && offset + 4 <= header_length)
+    {
+        memcpy(&word, packet + offset, sizeof(word));
+        word = GUINT32_FROM_LE(word);
+        offset += 4;
+    }
+
+    /* Only the leading fields are needed: flags and antenna signal */
+    for(i=0; i<G_N_ELEMENTS(size); i++)
+    {
+        if(!(present & (1 << i)))
+            continue;
+
+        offset = (offset + align[i] - 1) & ~(align[i] - 1);
+        if(offset + size[i] > header_length)
+            break;
+
+        if(i == 1)
+            flags = packet[offset];
+        else if(i == 5)
+            *rssi = (const gint8*)(packet + offset);
+
+        offset += size[i];
+    }
+
+    *length -= header_length;
+
+    /* Drop the trailing frame check sequence */
+    if((flags & 0x10) && *length >= 4)
+        *length -= 4;
+
+    return packet + header_length;
+}
+
+static guint16
+log_pcap_u16(const log_pcap_t *pcap,
+             const guint8     *ptr)
+{
+    guint16 value;
+    memcpy(&value, ptr, sizeof(value));
+    return (pcap->swap ? GUINT16_SWAP_LE_BE(value) : value);
+}
+
+static guint32
+log_pcap_u32(const log_pcap_t *pcap,
+             const guint8     *ptr)
+{
+    guint32 value;
+    memcpy(&value, ptr, sizeof(value));
+    return (pcap->swap ? GUINT32_SWAP_LE_BE(value) : value);
+}
+
+static void
+log_pcap_entry_free(gpointer data)
+{
+    log_pcap_entry_t *entry = (log_pcap_entry_t*)data;
+    network_free(entry->network);
+    g_free(entry->network);
+    g_free(entry);
+}
@@ -0,0 +1,24 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef MTSCAN_LOG_PCAP_H_
+#define MTSCAN_LOG_PCAP_H_
+#include <glib.h>
+#include "network.h"
+
+gboolean log_pcap_detect(const gchar*);
+gint log_pcap_read(const gchar*, void (*)(network_t*, gpointer), gpointer, gboolean);
+
+#endif
@@ -20,11 +20,12 @@
 #include <math.h>
 #include <zlib.h>
 #include <fcntl.h>
-#include "model.h"
-#include "ui.h"
+#include "mtscan.h"
+#include "model-format.h"
 #include "log.h"
+#include "log-bin.h"
+#include "log-pcap.h"
 #include "signals.h"
-#include "misc.h"
 
 #ifdef G_OS_WIN32
 #include "win32.h"
@@ -122,7 +123,8 @@ static const gchar *const keys_signals[] =
     "lon",
     "alt",
     "acc",
-    "azi"
+    "azi",
+    "src"
 };
 
 enum
@@ -133,7 +135,8 @@ enum
     KEY_SIGNALS_LONGITUDE,
     KEY_SIGNALS_ALTITUDE,
     KEY_SIGNALS_ACCURACY,
-    KEY_SIGNALS_AZIMUTH
+    KEY_SIGNALS_AZIMUTH,
+    KEY_SIGNALS_SOURCE
 };
 
 typedef struct read_context
@@ -147,6 +150,7 @@ typedef struct read_context
     gboolean strip_samples;
     network_t network;
     signals_node_t *signal;
+    signals_node_t sample;
     gint count;
 } read_ctx_t;
 
@@ -171,7 +175,7 @@ static gint parse_key_start(gpointer);
 static gint parse_key_end(gpointer);
 static gint parse_array_start(gpointer);
 static gint parse_array_end(gpointer);
-static gboolean log_save_foreach(GtkTreeModel*, GtkTreePath*, GtkTreeIter*, gpointer);
+static gboolean log_save_network(save_ctx_t*, const network_t*);
 static gboolean log_save_write(save_ctx_t*);
 
 static yajl_callbacks json_callbacks =
@@ -204,6 +208,12 @@ log_read(const gchar  *filename,
     yajl_handle json;
     yajl_status status;
 
+    if(log_bin_detect(filename))
+        return log_bin_read(filename, net_cb, user_data, strip_samples);
+
+    if(log_pcap_detect(filename))
+        return log_pcap_read(filename, net_cb, user_data, strip_samples);
+
     context.net_cb = net_cb;
     context.user_data = user_data;
     context.strip_samples = strip_samples;
@@ -250,7 +260,6 @@ log_read(const gchar  *filename,
     gzclose(gzfp);
     yajl_free(json);
     network_free(&context.network);
-    g_free(context.signal);
 
     return context.count;
 }
@@ -360,7 +369,14 @@ parse_string(gpointer      ptr,
              size_t        length)
 {
     read_ctx_t *ctx = (read_ctx_t*)ptr;
-    if(ctx->level == LEVEL_NETWORK)
+    if(ctx->level == LEVEL_NETWORK+1 &&
+       ctx->level_signals &&
+       ctx->signal)
+    {
+        if(ctx->key == KEY_SIGNALS_SOURCE && length == 12)
+            ctx->signal->source = str_addr_to_gint64((const gchar*)string, length);
+    }
+    else if(ctx->level == LEVEL_NETWORK)
     {
         if(ctx->key == KEY_CHANNEL)
             parse_string_update(&ctx->network.channel, string, length);
@@ -408,7 +424,8 @@ parse_key_start(gpointer ptr)
        ctx->network.address >= 0 &&
        !ctx->strip_samples)
     {
-        ctx->signal = signals_node_new0();
+        ctx->signal = &ctx->sample;
+        signals_node_init(ctx->signal);
     }
     return 1;
 }
@@ -475,8 +492,6 @@ parse_key_end(gpointer ptr)
         {
             signals_append(ctx->network.signals, ctx->signal);
         }
-        else
-            g_free(ctx->signal);
         ctx->signal = NULL;
     }
     else if(ctx->level == LEVEL_NETWORK)
@@ -521,16 +536,27 @@ parse_array_end(gpointer ptr)
     return 1;
 }
 
+void
+log_snapshot_free(log_snapshot_t *snapshot)
+{
+    guint i;
+
+    for(i=0; i<snapshot->count; i++)
+        network_free(&snapshot->networks[i]);
+    g_free(snapshot->networks);
+    g_free(snapshot);
+}
+
 log_save_error_t*
-log_save(const gchar *filename,
-         gboolean     strip_signals,
-         gboolean     strip_gps,
-         gboolean     strip_azi,
-         GList       *iterlist)
+log_save_snapshot(const gchar          *filename,
+                  const log_snapshot_t *snapshot,
+                  gboolean              strip_signals,
+                  gboolean              strip_gps,
+                  gboolean              strip_azi)
 {
     save_ctx_t ctx;
     const gchar *ext;
-    GList *i;
+    guint i;
     log_save_error_t *ret;
     gchar *tmp_name = NULL;
 
@@ -573,26 +599,29 @@ log_save(const gchar *filename,
     ctx.wrote = 0;
     ctx.length = 0;
 
-    ctx.gen = yajl_gen_alloc(NULL);
-    ctx.strip_signals = strip_signals;
-    ctx.strip_gps = strip_gps;
-    ctx.strip_azi = strip_azi;
-    //yajl_gen_config(ctx.gen, yajl_gen_beautify, 1);
-    yajl_gen_map_open(ctx.gen);
-
-    if(iterlist)
+    if(ext && !g_ascii_strcasecmp(ext, APP_FILE_BINARY))
     {
-        for(i=iterlist; i; i=i->next)
-            log_save_foreach(GTK_TREE_MODEL(ui.model->store), NULL, (GtkTreeIter*)(i->data), &ctx);
+        log_bin_save(ctx.fp, snapshot, strip_signals, strip_gps, strip_azi, &ctx.wrote, &ctx.length);
     }
     else
     {
-        gtk_tree_model_foreach(GTK_TREE_MODEL(ui.model->store), log_save_foreach, &ctx);
-    }
+        ctx.gen = yajl_gen_alloc(NULL);
+        ctx.strip_signals = strip_signals;
+        ctx.strip_gps = strip_gps;
+        ctx.strip_azi = strip_azi;
+        //yajl_gen_config(ctx.gen, yajl_gen_beautify, 1);
+        yajl_gen_map_open(ctx.gen);
 
-    yajl_gen_map_close(ctx.gen);
-    log_save_write(&ctx);
-    yajl_gen_free(ctx.gen);
+        for(i=0; i<snapshot->count; i++)
+        {
+            if(!log_save_network(&ctx, &snapshot->networks[i]))
+                break;
+        }
+
+        yajl_gen_map_close(ctx.gen);
+        log_save_write(&ctx);
+        yajl_gen_free(ctx.gen);
+    }
 
     if(ctx.gzfp)
         gzclose(ctx.gzfp);
@@ -618,247 +647,242 @@ log_save(const gchar *filename,
 }
 
 static gboolean
-log_save_foreach(GtkTreeModel *store,
-                 GtkTreePath  *path,
-                 GtkTreeIter  *iter,
-                 gpointer      data)
+log_save_network(save_ctx_t      *ctx,
+                 const network_t *net)
 {
-    save_ctx_t *ctx = (save_ctx_t*)data;
-    network_t net;
-    signals_node_t *sample;
+    signals_iter_t iter_signals;
+    signals_node_t sample;
     const gchar *buffer;
     const gchar *address;
 
-    mtscan_model_get(ui.model, iter, &net);
-
-    address = model_format_address(net.address, FALSE);
+    address = model_format_address(net->address, FALSE);
     yajl_gen_string(ctx->gen, (guchar*)address, strlen(address));
     yajl_gen_map_open(ctx->gen);
 
-    buffer = model_format_frequency(net.frequency);
+    buffer = model_format_frequency(net->frequency);
     yajl_gen_string(ctx->gen, (guchar*)keys[KEY_FREQUENCY], strlen(keys[KEY_FREQUENCY]));
     yajl_gen_number(ctx->gen, buffer, strlen(buffer));
 
     yajl_gen_string(ctx->gen, (guchar*)keys[KEY_CHANNEL], strlen(keys[KEY_CHANNEL]));
-    yajl_gen_string(ctx->gen, (guchar*)net.channel, strlen(net.channel));
+    yajl_gen_string(ctx->gen, (guchar*)net->channel, strlen(net->channel));
 
     yajl_gen_string(ctx->gen, (guchar*)keys[KEY_MODE], strlen(keys[KEY_MODE]));
-    yajl_gen_string(ctx->gen, (guchar*)net.mode, strlen(net.mode));
+    yajl_gen_string(ctx->gen, (guchar*)net->mode, strlen(net->mode));
 
-    if(net.streams)
+    if(net->streams)
     {
         yajl_gen_string(ctx->gen, (guchar*)keys[KEY_SPATIAL_STREAMS], strlen(keys[KEY_SPATIAL_STREAMS]));
-        yajl_gen_integer(ctx->gen, net.streams);
+        yajl_gen_integer(ctx->gen, net->streams);
     }
 
     yajl_gen_string(ctx->gen, (guchar*)keys[KEY_SSID], strlen(keys[KEY_SSID]));
-    yajl_gen_string(ctx->gen, (guchar*)net.ssid, strlen(net.ssid));
+    yajl_gen_string(ctx->gen, (guchar*)net->ssid, strlen(net->ssid));
 
     yajl_gen_string(ctx->gen, (guchar*)keys[KEY_RADIONAME], strlen(keys[KEY_RADIONAME]));
-    yajl_gen_string(ctx->gen, (guchar*)net.radioname, strlen(net.radioname));
+    yajl_gen_string(ctx->gen, (guchar*)net->radioname, strlen(net->radioname));
 
     yajl_gen_string(ctx->gen, (guchar*)keys[KEY_RSSI], strlen(keys[KEY_RSSI]));
-    yajl_gen_integer(ctx->gen, net.rssi);
+    yajl_gen_integer(ctx->gen, net->rssi);
 
-    if(net.flags.privacy >= 0)
+    if(net->flags.privacy >= 0)
     {
         yajl_gen_string(ctx->gen, (guchar*)keys[KEY_PRIVACY], strlen(keys[KEY_PRIVACY]));
-        yajl_gen_integer(ctx->gen, net.flags.privacy);
+        yajl_gen_integer(ctx->gen, net->flags.privacy);
     }
 
     yajl_gen_string(ctx->gen, (guchar*)keys[KEY_ROUTEROS], strlen(keys[KEY_ROUTEROS]));
-    if(net.routeros_ver && strlen(net.routeros_ver))
-        yajl_gen_string(ctx->gen, (guchar*)net.routeros_ver, strlen(net.routeros_ver));
-    else if(net.flags.routeros >= 0)
-        yajl_gen_integer(ctx->gen, net.flags.routeros);
+    if(net->routeros_ver && strlen(net->routeros_ver))
+        yajl_gen_string(ctx->gen, (guchar*)net->routeros_ver, strlen(net->routeros_ver));
+    else if(net->flags.routeros >= 0)
+        yajl_gen_integer(ctx->gen, net->flags.routeros);
 
-    if(net.flags.nstreme >= 0)
+    if(net->flags.nstreme >= 0)
     {
         yajl_gen_string(ctx->gen, (guchar *) keys[KEY_NSTREME], strlen(keys[KEY_NSTREME]));
-        yajl_gen_integer(ctx->gen, net.flags.nstreme);
+        yajl_gen_integer(ctx->gen, net->flags.nstreme);
     }
 
-    if(net.flags.tdma >= 0)
+    if(net->flags.tdma >= 0)
     {
         yajl_gen_string(ctx->gen, (guchar*)keys[KEY_TDMA], strlen(keys[KEY_TDMA]));
-        yajl_gen_integer(ctx->gen, net.flags.tdma);
+        yajl_gen_integer(ctx->gen, net->flags.tdma);
     }
 
-    if(net.flags.wds >= 0)
+    if(net->flags.wds >= 0)
     {
         yajl_gen_string(ctx->gen, (guchar*)keys[KEY_WDS], strlen(keys[KEY_WDS]));
-        yajl_gen_integer(ctx->gen, net.flags.wds);
+        yajl_gen_integer(ctx->gen, net->flags.wds);
     }
 
-    if(net.flags.bridge >= 0)
+    if(net->flags.bridge >= 0)
     {
         yajl_gen_string(ctx->gen, (guchar*)keys[KEY_BRIDGE], strlen(keys[KEY_BRIDGE]));
-        yajl_gen_integer(ctx->gen, net.flags.bridge);
+        yajl_gen_integer(ctx->gen, net->flags.bridge);
     }
 
-    if(net.ubnt_airmax >= 0)
+    if(net->ubnt_airmax >= 0)
     {
         yajl_gen_string(ctx->gen, (guchar*)keys[KEY_AIRMAX], strlen(keys[KEY_AIRMAX]));
-        yajl_gen_integer(ctx->gen, net.ubnt_airmax);
+        yajl_gen_integer(ctx->gen, net->ubnt_airmax);
     }
 
-    if(net.ubnt_ptp >= 0)
+    if(net->ubnt_ptp >= 0)
     {
         yajl_gen_string(ctx->gen, (guchar*)keys[KEY_AIRMAX_AC_PTP], strlen(keys[KEY_AIRMAX_AC_PTP]));
-        yajl_gen_integer(ctx->gen, net.ubnt_ptp);
+        yajl_gen_integer(ctx->gen, net->ubnt_ptp);
     }
 
-    if(net.ubnt_ptmp >= 0)
+    if(net->ubnt_ptmp >= 0)
     {
         yajl_gen_string(ctx->gen, (guchar*)keys[KEY_AIRMAX_AC_PTMP], strlen(keys[KEY_AIRMAX_AC_PTMP]));
-        yajl_gen_integer(ctx->gen, net.ubnt_ptmp);
+        yajl_gen_integer(ctx->gen, net->ubnt_ptmp);
     }
 
-    if(net.ubnt_mixed >= 0)
+    if(net->ubnt_mixed >= 0)
     {
         yajl_gen_string(ctx->gen, (guchar*)keys[KEY_AIRMAX_AC_MIXED], strlen(keys[KEY_AIRMAX_AC_MIXED]));
-        yajl_gen_integer(ctx->gen, net.ubnt_mixed);
+        yajl_gen_integer(ctx->gen, net->ubnt_mixed);
     }
 
-    if (net.wps >= 0)
+    if (net->wps >= 0)
     {
         yajl_gen_string(ctx->gen, (guchar*)keys[KEY_WPS], strlen(keys[KEY_WPS]));
-        yajl_gen_integer(ctx->gen, (net.wps > 0));
+        yajl_gen_integer(ctx->gen, (net->wps > 0));
 
-        if(net.wps_manufacturer)
+        if(net->wps_manufacturer)
         {
             yajl_gen_string(ctx->gen, (guchar*)keys[KEY_WPS_MANUFACTURER], strlen(keys[KEY_WPS_MANUFACTURER]));
-            yajl_gen_string(ctx->gen, (guchar*)net.wps_manufacturer, strlen(net.wps_manufacturer));
+            yajl_gen_string(ctx->gen, (guchar*)net->wps_manufacturer, strlen(net->wps_manufacturer));
         }
 
-        if(net.wps_model_name)
+        if(net->wps_model_name)
         {
             yajl_gen_string(ctx->gen, (guchar*)keys[KEY_WPS_MODEL_NAME], strlen(keys[KEY_WPS_MODEL_NAME]));
-            yajl_gen_string(ctx->gen, (guchar*)net.wps_model_name, strlen(net.wps_model_name));
+            yajl_gen_string(ctx->gen, (guchar*)net->wps_model_name, strlen(net->wps_model_name));
         }
 
-        if(net.wps_model_number)
+        if(net->wps_model_number)
         {
             yajl_gen_string(ctx->gen, (guchar*)keys[KEY_WPS_MODEL_NUMBER], strlen(keys[KEY_WPS_MODEL_NUMBER]));
-            yajl_gen_string(ctx->gen, (guchar*)net.wps_model_number, strlen(net.wps_model_number));
+            yajl_gen_string(ctx->gen, (guchar*)net->wps_model_number, strlen(net->wps_model_number));
         }
 
-        if(net.wps_serial_number)
+        if(net->wps_serial_number)
         {
             yajl_gen_string(ctx->gen, (guchar*)keys[KEY_WPS_SERIAL_NUMBER], strlen(keys[KEY_WPS_SERIAL_NUMBER]));
-            yajl_gen_string(ctx->gen, (guchar*)net.wps_serial_number, strlen(net.wps_serial_number));
+            yajl_gen_string(ctx->gen, (guchar*)net->wps_serial_number, strlen(net->wps_serial_number));
         }
 
-        if(net.wps_device_name)
+        if(net->wps_device_name)
         {
             yajl_gen_string(ctx->gen, (guchar*)keys[KEY_WPS_DEVICE_NAME], strlen(keys[KEY_WPS_DEVICE_NAME]));
-            yajl_gen_string(ctx->gen, (guchar*)net.wps_device_name, strlen(net.wps_device_name));
+            yajl_gen_string(ctx->gen, (guchar*)net->wps_device_name, strlen(net->wps_device_name));
         }
     }
 
     yajl_gen_string(ctx->gen, (guchar*)keys[KEY_FIRSTSEEN], strlen(keys[KEY_FIRSTSEEN]));
-    yajl_gen_integer(ctx->gen, net.firstseen);
+    yajl_gen_integer(ctx->gen, net->firstseen);
 
     yajl_gen_string(ctx->gen, (guchar*)keys[KEY_LASTSEEN], strlen(keys[KEY_LASTSEEN]));
-    yajl_gen_integer(ctx->gen, net.lastseen);
+    yajl_gen_integer(ctx->gen, net->lastseen);
 
-    if(!isnan(net.latitude) && !isnan(net.longitude) && !ctx->strip_gps)
+    if(!isnan(net->latitude) && !isnan(net->longitude) && !ctx->strip_gps)
     {
-        buffer = model_format_latitude(net.latitude, TRUE);
+        buffer = model_format_latitude(net->latitude, TRUE);
         yajl_gen_string(ctx->gen, (guchar*)keys[KEY_LATITUDE], strlen(keys[KEY_LATITUDE]));
         yajl_gen_number(ctx->gen, buffer, strlen(buffer));
 
-        buffer = model_format_longitude(net.longitude, TRUE);
+        buffer = model_format_longitude(net->longitude, TRUE);
         yajl_gen_string(ctx->gen, (guchar*)keys[KEY_LONGITUDE], strlen(keys[KEY_LONGITUDE]));
         yajl_gen_number(ctx->gen, buffer, strlen(buffer));
 
-        if (!isnan(net.altitude))
+        if (!isnan(net->altitude))
         {
-            buffer = model_format_altitude(net.altitude);
+            buffer = model_format_altitude(net->altitude);
             yajl_gen_string(ctx->gen, (guchar*)keys[KEY_ALTITUDE], strlen(keys[KEY_ALTITUDE]));
             yajl_gen_number(ctx->gen, buffer, strlen(buffer));
         }
 
-        if (!isnan(net.accuracy))
+        if (!isnan(net->accuracy))
         {
-            buffer = model_format_accuracy(net.accuracy);
+            buffer = model_format_accuracy(net->accuracy);
             yajl_gen_string(ctx->gen, (guchar*)keys[KEY_ACCURACY], strlen(keys[KEY_ACCURACY]));
             yajl_gen_number(ctx->gen, buffer, strlen(buffer));
         }
     }
 
-    if(!isnan(net.azimuth) && !ctx->strip_azi)
+    if(!isnan(net->azimuth) && !ctx->strip_azi)
     {
-        buffer = model_format_azimuth(net.azimuth, TRUE);
+        buffer = model_format_azimuth(net->azimuth, TRUE);
         yajl_gen_string(ctx->gen, (guchar*)keys[KEY_AZIMUTH], strlen(keys[KEY_AZIMUTH]));
         yajl_gen_number(ctx->gen, buffer, strlen(buffer));
     }
 
-    if(net.signals->head && !ctx->strip_signals)
+    if(signals_count(net->signals) && !ctx->strip_signals)
     {
         yajl_gen_string(ctx->gen, (guchar*)keys[KEY_SIGNALS], strlen(keys[KEY_SIGNALS]));
         yajl_gen_array_open(ctx->gen);
 
-        sample = net.signals->head;
-        while(sample)
+        signals_iter_init(&iter_signals, net->signals);
+        while(signals_iter_next(&iter_signals, &sample))
         {
             yajl_gen_map_open(ctx->gen);
 
             yajl_gen_string(ctx->gen, (guchar*)keys_signals[KEY_SIGNALS_TIMESTAMP], strlen(keys_signals[KEY_SIGNALS_TIMESTAMP]));
-            yajl_gen_integer(ctx->gen, sample->timestamp);
+            yajl_gen_integer(ctx->gen, sample.timestamp);
 
             yajl_gen_string(ctx->gen, (guchar*)keys_signals[KEY_SIGNALS_RSSI], strlen(keys_signals[KEY_SIGNALS_RSSI]));
-            yajl_gen_integer(ctx->gen, sample->rssi);
+            yajl_gen_integer(ctx->gen, sample.rssi);
 
-            if (!isnan(sample->latitude) &&
-                !isnan(sample->longitude) &&
+            if (!isnan(sample.latitude) &&
+                !isnan(sample.longitude) &&
                 !ctx->strip_gps)
             {
-                buffer = model_format_latitude(sample->latitude, TRUE);
+                buffer = model_format_latitude(sample.latitude, TRUE);
                 yajl_gen_string(ctx->gen, (guchar*)keys_signals[KEY_SIGNALS_LATITUDE], strlen(keys_signals[KEY_SIGNALS_LATITUDE]));
                 yajl_gen_number(ctx->gen, buffer, strlen(buffer));
 
-                buffer = model_format_longitude(sample->longitude, TRUE);
+                buffer = model_format_longitude(sample.longitude, TRUE);
                 yajl_gen_string(ctx->gen, (guchar*)keys_signals[KEY_SIGNALS_LONGITUDE], strlen(keys_signals[KEY_SIGNALS_LONGITUDE]));
                 yajl_gen_number(ctx->gen, buffer, strlen(buffer));
 
-                if (!isnan(sample->altitude))
+                if (!isnan(sample.altitude))
                 {
-                    buffer = model_format_altitude(sample->altitude);
+                    buffer = model_format_altitude(sample.altitude);
                     yajl_gen_string(ctx->gen, (guchar*)keys_signals[KEY_SIGNALS_ALTITUDE], strlen(keys_signals[KEY_SIGNALS_ALTITUDE]));
                     yajl_gen_number(ctx->gen, buffer, strlen(buffer));
                 }
 
-                if (!isnan(sample->accuracy))
+                if (!isnan(sample.accuracy))
                 {
-                    buffer = model_format_accuracy(sample->accuracy);
+                    buffer = model_format_accuracy(sample.accuracy);
                     yajl_gen_string(ctx->gen, (guchar*)keys_signals[KEY_SIGNALS_ACCURACY], strlen(keys_signals[KEY_SIGNALS_ACCURACY]));
                     yajl_gen_number(ctx->gen, buffer, strlen(buffer));
                 }
             }
 
-            if(!isnan(sample->azimuth) && !ctx->strip_azi)
+            if(!isnan(sample.azimuth) && !ctx->strip_azi)
             {
-                buffer = model_format_azimuth(sample->azimuth, TRUE);
+                buffer = model_format_azimuth(sample.azimuth, TRUE);
                 yajl_gen_string(ctx->gen, (guchar*)keys_signals[KEY_SIGNALS_AZIMUTH], strlen(keys_signals[KEY_SIGNALS_AZIMUTH]));
                 yajl_gen_number(ctx->gen, buffer, strlen(buffer));
             }
 
+            if(sample.source >= 0)
+            {
+                buffer = model_format_address(sample.source, FALSE);
+                yajl_gen_string(ctx->gen, (guchar*)keys_signals[KEY_SIGNALS_SOURCE], strlen(keys_signals[KEY_SIGNALS_SOURCE]));
+                yajl_gen_string(ctx->gen, (guchar*)buffer, strlen(buffer));
+            }
+
             yajl_gen_map_close(ctx->gen);
-            sample = sample->next;
         }
 
         yajl_gen_array_close(ctx->gen);
     }
     yajl_gen_map_close(ctx->gen);
 
-
-    /* Signals are stored in GtkListStore just as pointer,
-       so set it to NULL before freeing the struct */
-    net.signals = NULL;
-    network_free(&net);
-
-    return !log_save_write(ctx);
+    return log_save_write(ctx);
 }
 
 static gboolean
@@ -15,7 +15,7 @@
 
 #ifndef MTSCAN_LOG_H_
 #define MTSCAN_LOG_H_
-#include <gtk/gtk.h>
+#include <glib.h>
 #include "network.h"
 
 #define LOG_READ_ERROR_EMPTY  0
@@ -30,8 +30,15 @@ typedef struct log_save_error
     gboolean existing_file;
 } log_save_error_t;
 
+typedef struct log_snapshot
+{
+    network_t *networks;
+    guint count;
+} log_snapshot_t;
 
 gint log_read(const gchar*, void (*)(network_t*, gpointer), gpointer, gboolean);
-log_save_error_t* log_save(const gchar*, gboolean, gboolean, gboolean, GList*);
+
+void log_snapshot_free(log_snapshot_t*);
+log_save_error_t* log_save_snapshot(const gchar*, const log_snapshot_t*, gboolean, gboolean, gboolean);
 
 #endif
@@ -22,8 +22,10 @@
 #include "ui-log.h"
 #include "model.h"
 #include "oui.h"
-#include "log.h"
+#include "batch.h"
 #include "mtscan.h"
+#include "ui-sources.h"
+#include "ui-journal.h"
 
 #ifdef G_OS_WIN32
 #include "win32.h"
@@ -34,6 +36,7 @@ typedef struct mtscan_arg
     const gchar *config_path;
     const gchar *output_file;
     gint auto_connect;
+    GSList *sources;
     gint tzsp_port;
     const gchar *autosave_dir;
     gboolean batch_mode;
@@ -49,6 +52,7 @@ static mtscan_arg_t args =
     .config_path = NULL,
     .output_file = NULL,
     .auto_connect = 0,
+    .sources = NULL,
     .tzsp_port = 0,
     .autosave_dir = NULL,
     .batch_mode = FALSE,
@@ -82,7 +86,7 @@ mtscan_usage(void)
     printf("options:\n");
     printf("  -c  configuration file\n");
     printf("  -o  output log file\n");
-    printf("  -a  auto-connect to a given profile id\n");
+    printf("  -a  auto-connect to a given profile id (repeat to add sources)\n");
     printf("  -t  override TZSP UDP port\n");
     printf("  -d  override autosave directory and enable it\n");
     printf("  -b  headless batch mode, requires -o\n");
@@ -116,7 +120,11 @@ parse_args(gint   argc,
             break;
 
         case 'a':
-            args.auto_connect = atoi(optarg);
+            /* First profile is the primary connection, others are additional sources */
+            if(args.auto_connect <= 0)
+                args.auto_connect = atoi(optarg);
+            else
+                args.sources = g_slist_append(args.sources, GINT_TO_POINTER(atoi(optarg)));
             break;
             
         case 't':
@@ -175,12 +183,20 @@ parse_args(gint   argc,
     }
 }
 
-static void
-log_read_network_cb(network_t *network,
-                    gpointer   user_data)
+static gint
+batch_run(gint   argc,
+          gchar *argv[])
 {
-    gboolean merge = GPOINTER_TO_INT(user_data);
-    mtscan_model_add(ui.model, network, merge);
+    GSList *filenames = NULL;
+    gint ret;
+    gint i;
+
+    for(i = optind; i < argc; i++)
+        filenames = g_slist_append(filenames, argv[i]);
+
+    ret = batch_merge(filenames, args.output_file, args.strip_samples, args.strip_gps, args.strip_azi);
+    g_slist_free(filenames);
+    return ret;
 }
 
 static void
@@ -188,46 +204,16 @@ log_open(gint   argc,
          gchar *argv[])
 {
     GSList *filenames = NULL;
-    gint count;
     gint i;
 
-    if(args.batch_mode)
-    {
-        for(i = optind; i < argc; i++)
-        {
-            count = log_read(argv[i], log_read_network_cb, GINT_TO_POINTER(i != optind), args.strip_samples);
-            if(count <= 0)
-            {
-                switch(count)
-                {
-                    case LOG_READ_ERROR_OPEN:
-                        fprintf(stderr, "ERROR: Failed to open a file: %s\n", argv[i]);
-                        break;
-
-                    case LOG_READ_ERROR_READ:
-                        fprintf(stderr, "ERROR: Failed to read a file: %s\n", argv[i]);
-                        break;
-
-                    case LOG_READ_ERROR_PARSE:
-                    case LOG_READ_ERROR_EMPTY:
-                    default:
-                        fprintf(stderr, "ERROR: Failed to parse a file: %s\n", argv[i]);
-                        break;
-                }
-            }
-        }
-    }
-    else
-    {
-        for(i = optind; i < argc; i++)
-            filenames = g_slist_prepend(filenames, g_strdup(argv[i]));
+    for(i = optind; i < argc; i++)
+        filenames = g_slist_prepend(filenames, g_strdup(argv[i]));
 
-        if(filenames)
-        {
-            filenames = g_slist_reverse(filenames);
-            ui_log_open(filenames, (g_slist_length(filenames) > 1), args.strip_samples);
-            g_slist_free_full(filenames, g_free);
-        }
+    if(filenames)
+    {
+        filenames = g_slist_reverse(filenames);
+        ui_log_open(filenames, (g_slist_length(filenames) > 1), args.strip_samples);
+        g_slist_free_full(filenames, g_free);
     }
 }
 
@@ -236,8 +222,8 @@ main(gint   argc,
      gchar *argv[])
 {
     gboolean init;
-    log_save_error_t *error;
     const gchar **file;
+    GSList *list;
 
     /* hack for the yajl bug:
        https://github.com/lloyd/yajl/issues/79 */
@@ -245,9 +231,22 @@ main(gint   argc,
     init = gtk_init_check(&argc, &argv);
     parse_args(argc, argv);
 
-    if(args.batch_mode && !args.output_file)
+    if(args.batch_mode)
+    {
+        if(!args.output_file)
+        {
+            fprintf(stderr, "ERROR: Batch mode requires an output file, giving up.\n");
+            mtscan_usage();
+            return -1;
+        }
+
+        /* The batch mode does not touch any GTK structures */
+        return batch_run(argc, argv);
+    }
+
+    if(!init)
     {
-        fprintf(stderr, "ERROR: Batch mode requires an output file, giving up.\n");
+        fprintf(stderr, "ERROR: GTK initialization failed (no DISPLAY?)\n");
         mtscan_usage();
         return -1;
     }
@@ -255,56 +254,36 @@ main(gint   argc,
     memset(&ui, 0, sizeof(ui));
     ui.model = mtscan_model_new();
 
-    if(!args.batch_mode)
-    {
-        if(!init)
-        {
-            fprintf(stderr, "ERROR: GTK initialization failed (no DISPLAY?)\n");
-            mtscan_usage();
-            return -1;
-        }
-
 #ifdef G_OS_WIN32
-        win32_init();
+    win32_init();
 #endif
-        curl_global_init(CURL_GLOBAL_SSL);
-
-        /* Load the configuration file */
-        conf_init(args.config_path);
+    curl_global_init(CURL_GLOBAL_SSL);
 
-        /* Override the TZSP UDP port, if given */
-        if(args.tzsp_port)
-            conf_set_preferences_tzsp_udp_port(args.tzsp_port);
+    /* Load the configuration file */
+    conf_init(args.config_path);
 
-        /* Override the autosave directory, if given */
-        if(args.autosave_dir)
-        {
-            conf_set_interface_autosave(TRUE);
-            conf_set_path_autosave(args.autosave_dir);
-        }
+    /* Override the TZSP UDP port, if given */
+    if(args.tzsp_port)
+        conf_set_preferences_tzsp_udp_port(args.tzsp_port);
 
-        ui_init();
+    /* Override the autosave directory, if given */
+    if(args.autosave_dir)
+    {
+        conf_set_interface_autosave(TRUE);
+        conf_set_path_autosave(args.autosave_dir);
     }
 
+    ui_init();
+
+    /* Recover the autosave journal, left after an unclean exit */
+    ui_journal_recover();
+
     /* Load logs, if any */
     log_open(argc, argv);
 
     /* Save the log to a file */
     if(args.output_file)
-    {
-        if(args.batch_mode)
-        {
-            error = log_save(args.output_file, args.strip_samples, args.strip_gps, args.strip_azi, NULL);
-            if(error)
-            {
-                fprintf(stderr, "ERROR: Failed to save the log: %s\n", args.output_file);
-                g_free(error);
-                return -1;
-            }
-            return 0;
-        }
         ui_log_save_full(args.output_file, args.strip_samples, args.strip_gps, args.strip_azi, NULL, TRUE);
-    }
 
     /* Skip SSH key verification */
     if(args.skip_verification)
@@ -318,6 +297,14 @@ main(gint   argc,
     if(args.auto_connect > 0)
         ui_toggle_connection(args.auto_connect);
 
+    /* Connect additional sources in the background */
+    for(list = args.sources; list; list = list->next)
+    {
+        if(!ui_sources_add(GPOINTER_TO_INT(list->data)))
+            fprintf(stderr, "WARNING: Invalid source profile id: %d\n", GPOINTER_TO_INT(list->data));
+    }
+    g_slist_free(args.sources);
+
     /* Load the OUI database in a separate thread */
     for(file = oui_files; *file && !oui_init(*file); file++);
 
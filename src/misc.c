@@ -23,8 +23,6 @@
 #include "win32.h"
 #endif
 
-#define MAC_ADDR_HEX_LEN 12
-
 static gboolean create_liststore_from_tree_foreach(gpointer, gpointer, gpointer);
 static gboolean fill_tree_from_liststore_foreach(GtkTreeModel*, GtkTreePath*, GtkTreeIter*, gpointer);
 static gboolean create_strv_from_liststore_foreach(GtkTreeModel*, GtkTreePath*, GtkTreeIter*, gpointer);
@@ -279,51 +277,6 @@ strv_equal(const gchar* const *v1,
     return (*v1 == NULL && *v2 == NULL);
 }
 
-gint64
-str_addr_to_gint64(const gchar* str,
-                   gint         len)
-{
-    gchar buffer[MAC_ADDR_HEX_LEN+1];
-    gchar *ptr;
-    gint64 value;
-    gint i;
-
-    if(len == MAC_ADDR_HEX_LEN)
-    {
-        for(i=0; i<len; i++)
-        {
-            if(!((str[i] >= '0' && str[i] <= '9') ||
-                (str[i] >= 'A' && str[i] <= 'F') ||
-                (str[i] >= 'a' && str[i] <= 'f')))
-                return -1;
-        }
-
-        memcpy(buffer, str, MAC_ADDR_HEX_LEN);
-        buffer[MAC_ADDR_HEX_LEN] = '\0';
-        value = g_ascii_strtoll(buffer, &ptr, 16);
-        if(ptr != buffer)
-            return value;
-    }
-    return -1;
-}
-
-gboolean
-addr_to_guint8(gint64  addr,
-               guint8 *buff)
-{
-    guint8 *ptr;
-    gint i;
-
-    if(addr < 0)
-        return FALSE;
-
-    ptr = buff;
-    for(i=5; i>=0; i--)
-        *ptr++ = (uint8_t) (addr >> (CHAR_BIT * i));
-
-    return TRUE;
-}
-
 void
 mtscan_sound(const gchar *filename)
 {
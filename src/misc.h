@@ -31,9 +31,6 @@ GtkListStore* create_liststore_from_strv(const gchar* const *);
 gchar** create_strv_from_liststore(GtkListStore*);
 gboolean strv_equal(const gchar* const*, const gchar* const*);
 
-gint64 str_addr_to_gint64(const gchar*, gint);
-gboolean addr_to_guint8(gint64, guint8*);
-
 void mtscan_sound(const gchar*);
 gboolean mtscan_exec(const gchar*, guint, ...);
 gchar* timestamp_to_filename(const gchar*, gint64);
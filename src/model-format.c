@@ -0,0 +1,167 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include <string.h>
+#include <math.h>
+#include "model-format.h"
+
+static void trim_zeros(gchar*);
+
+
+/* Formatters used by the log writer keep per-thread buffers,
+   as the autosave runs outside of the main thread */
+const gchar*
+model_format_address(gint64   address,
+                     gboolean separated)
+{
+    static __thread gchar str[18];
+
+    if(!separated)
+    {
+        g_snprintf(str, sizeof(str), "%012" G_GINT64_MODIFIER "X", address);
+    }
+    else
+    {
+        g_snprintf(str, sizeof(str),
+                   "%02X:%02X:%02X:%02X:%02X:%02X",
+                   (gint)((address >> 40) & 0xFF),
+                   (gint)((address >> 32) & 0xFF),
+                   (gint)((address >> 24) & 0xFF),
+                   (gint)((address >> 16) & 0xFF),
+                   (gint)((address >>  8) & 0xFF),
+                   (gint)((address      ) & 0xFF));
+    }
+    return str;
+}
+
+const gchar*
+model_format_frequency(gint value)
+{
+    static __thread gchar output[9];
+    gint frac, i;
+
+    if((frac = value % 1000))
+    {
+        g_snprintf(output, sizeof(output), "%d.%03d", value/1000, frac);
+        for(i=strlen(output)-1; i>=0 && output[i] == '0'; i--);
+        output[i+1] = '\0';
+        return output;
+    }
+
+    g_snprintf(output, sizeof(output), "%d", value/1000);
+    return output;
+}
+
+const gchar*
+model_format_streams(gint8 value)
+{
+    static gchar output[10];
+    if(value > 0)
+        g_snprintf(output, sizeof(output), "%d", value);
+    else
+        output[0] = '\0';
+    return output;
+}
+
+const gchar*
+model_format_latitude(gdouble  value,
+                      gboolean trim)
+{
+    static __thread gchar output[12];
+    if (!isnan(value))
+    {
+        g_ascii_formatd(output, sizeof(output), "%.6f", value);
+        if(trim)
+            trim_zeros(output);
+    }
+    else
+    {
+        *output = '\0';
+    }
+    return output;
+}
+
+const gchar*
+model_format_longitude(gdouble  value,
+                       gboolean trim)
+{
+    static __thread gchar output[12];
+    if (!isnan(value))
+    {
+        g_ascii_formatd(output, sizeof(output), "%.6f", value);
+        if(trim)
+            trim_zeros(output);
+    }
+    else
+    {
+        *output = '\0';
+    }
+    return output;
+}
+
+const gchar*
+model_format_altitude(gfloat value)
+{
+    static __thread gchar output[12];
+
+    if (!isnan(value))
+        g_snprintf(output, sizeof(output), "%d", (int)round(value));
+    else
+        *output = '\0';
+
+    return output;
+}
+
+const gchar*
+model_format_accuracy(gfloat value)
+{
+    static __thread gchar output[12];
+
+    if (!isnan(value))
+        g_snprintf(output, sizeof(output), "%d", (int)round(value));
+    else
+        *output = '\0';
+
+    return output;
+}
+
+const gchar*
+model_format_azimuth(gfloat   value,
+                     gboolean trim)
+{
+    static __thread gchar output[12];
+    if(!isnan(value))
+    {
+        g_ascii_formatd(output, sizeof(output), "%.2f", value);
+        if(trim)
+            trim_zeros(output);
+    }
+    else
+    {
+        *output = '\0';
+    }
+    return output;
+}
+
+
+static void
+trim_zeros(gchar *string)
+{
+    gint i;
+    for(i=strlen(string)-1; i>=0 && string[i] == '0'; i--);
+    if(i >= 0 && string[i] == '.')
+        i++;
+    string[i+1] = '\0';
+}
@@ -0,0 +1,29 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef MTSCAN_MODEL_FORMAT_H_
+#define MTSCAN_MODEL_FORMAT_H_
+#include <glib.h>
+
+const gchar* model_format_address(gint64, gboolean);
+const gchar* model_format_frequency(gint);
+const gchar* model_format_streams(gint8);
+const gchar* model_format_latitude(gdouble, gboolean);
+const gchar* model_format_longitude(gdouble, gboolean);
+const gchar* model_format_altitude(gfloat);
+const gchar* model_format_accuracy(gfloat);
+const gchar* model_format_azimuth(gfloat, gboolean);
+
+#endif
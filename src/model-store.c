@@ -0,0 +1,1145 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+/* Network table stored as one array per column, exposed to GTK+ as a flat
+   GtkTreeModel. Rows are addressed by a stable slot number, so iterators
+   persist until the row is removed. Display order is kept separately. */
+
+#include <string.h>
+#include <math.h>
+#include "model.h"
+#include "model-store.h"
+
+#define STORE_INITIAL_SIZE 256
+#define STORE_NO_POSITION  G_MAXUINT
+#define STORE_FREE_SLOT    (G_MAXUINT-1)
+
+#define GPS_DOUBLE_PREC (1e-6)
+#define AZI_FLOAT_PREC (1e-2)
+
+typedef enum store_kind
+{
+    STORE_KIND_INT8,
+    STORE_KIND_UINT8,
+    STORE_KIND_INT,
+    STORE_KIND_INT64,
+    STORE_KIND_FLOAT,
+    STORE_KIND_DOUBLE,
+    STORE_KIND_STRING,
+    STORE_KIND_POINTER
+} store_kind_t;
+
+typedef struct store_column
+{
+    GType type;
+    store_kind_t kind;
+} store_column_t;
+
+typedef struct store_string
+{
+    guint refs;
+    gchar str[];
+} store_string_t;
+
+#define STORE_STRING(str) ((store_string_t*)((str) - G_STRUCT_OFFSET(store_string_t, str)))
+
+typedef struct mtscan_store
+{
+    GObject parent;
+    gint stamp;
+
+    /* Column data, indexed by slot */
+    gpointer data[COL_COUNT];
+    guint size;
+    guint slots;
+    guint *free_slots;
+    guint n_free;
+
+    /* Display order */
+    guint *order;
+    guint *position;
+    guint rows;
+
+    /* Interned strings, shared with snapshots */
+    GHashTable *strings;
+
+    /* Sorting */
+    gint sort_column_id;
+    GtkSortType sort_order;
+    GtkTreeIterCompareFunc sort_func[COL_COUNT];
+    gpointer sort_data[COL_COUNT];
+    GDestroyNotify sort_destroy[COL_COUNT];
+    GtkTreeIterCompareFunc default_sort_func;
+    gpointer default_sort_data;
+    GDestroyNotify default_sort_destroy;
+} mtscan_store_t;
+
+typedef struct mtscan_store_class
+{
+    GObjectClass parent_class;
+} mtscan_store_class_t;
+
+/* Public types are exposed by GtkTreeModel, narrower storage is used where possible */
+static const store_column_t columns[COL_COUNT] =
+{
+    [COL_STATE]             = { G_TYPE_UCHAR,   STORE_KIND_UINT8   },
+    [COL_ADDRESS]           = { G_TYPE_INT64,   STORE_KIND_INT64   },
+    [COL_FREQUENCY]         = { G_TYPE_INT,     STORE_KIND_INT     },
+    [COL_CHANNEL]           = { G_TYPE_STRING,  STORE_KIND_STRING  },
+    [COL_MODE]              = { G_TYPE_STRING,  STORE_KIND_STRING  },
+    [COL_STREAMS]           = { G_TYPE_CHAR,    STORE_KIND_INT8    },
+    [COL_SSID]              = { G_TYPE_STRING,  STORE_KIND_STRING  },
+    [COL_RADIONAME]         = { G_TYPE_STRING,  STORE_KIND_STRING  },
+    [COL_MAXRSSI]           = { G_TYPE_CHAR,    STORE_KIND_INT8    },
+    [COL_RSSI]              = { G_TYPE_CHAR,    STORE_KIND_INT8    },
+    [COL_NOISE]             = { G_TYPE_CHAR,    STORE_KIND_INT8    },
+    [COL_PRIVACY]           = { G_TYPE_INT,     STORE_KIND_INT8    },
+    [COL_ROUTEROS]          = { G_TYPE_INT,     STORE_KIND_INT8    },
+    [COL_NSTREME]           = { G_TYPE_INT,     STORE_KIND_INT8    },
+    [COL_TDMA]              = { G_TYPE_INT,     STORE_KIND_INT8    },
+    [COL_WDS]               = { G_TYPE_INT,     STORE_KIND_INT8    },
+    [COL_BRIDGE]            = { G_TYPE_INT,     STORE_KIND_INT8    },
+    [COL_ROUTEROS_VER]      = { G_TYPE_STRING,  STORE_KIND_STRING  },
+    [COL_AIRMAX]            = { G_TYPE_INT,     STORE_KIND_INT8    },
+    [COL_AIRMAX_AC_PTP]     = { G_TYPE_INT,     STORE_KIND_INT8    },
+    [COL_AIRMAX_AC_PTMP]    = { G_TYPE_INT,     STORE_KIND_INT8    },
+    [COL_AIRMAX_AC_MIXED]   = { G_TYPE_INT,     STORE_KIND_INT8    },
+    [COL_WPS]               = { G_TYPE_INT,     STORE_KIND_INT8    },
+    [COL_WPS_MANUFACTURER]  = { G_TYPE_STRING,  STORE_KIND_STRING  },
+    [COL_WPS_MODEL_NAME]    = { G_TYPE_STRING,  STORE_KIND_STRING  },
+    [COL_WPS_MODEL_NUMBER]  = { G_TYPE_STRING,  STORE_KIND_STRING  },
+    [COL_WPS_SERIAL_NUMBER] = { G_TYPE_STRING,  STORE_KIND_STRING  },
+    [COL_WPS_DEVICE_NAME]   = { G_TYPE_STRING,  STORE_KIND_STRING  },
+    [COL_FIRSTLOG]          = { G_TYPE_INT64,   STORE_KIND_INT64   },
+    [COL_LASTLOG]           = { G_TYPE_INT64,   STORE_KIND_INT64   },
+    [COL_LATITUDE]          = { G_TYPE_DOUBLE,  STORE_KIND_DOUBLE  },
+    [COL_LONGITUDE]         = { G_TYPE_DOUBLE,  STORE_KIND_DOUBLE  },
+    [COL_ALTITUDE]          = { G_TYPE_FLOAT,   STORE_KIND_FLOAT   },
+    [COL_ACCURACY]          = { G_TYPE_FLOAT,   STORE_KIND_FLOAT   },
+    [COL_AZIMUTH]           = { G_TYPE_FLOAT,   STORE_KIND_FLOAT   },
+    [COL_DISTANCE]          = { G_TYPE_FLOAT,   STORE_KIND_FLOAT   },
+    [COL_SIGNALS]           = { G_TYPE_POINTER, STORE_KIND_POINTER }
+};
+
+#define STORE_COL(store, col, type) ((type*)((store)->data[col]))
+#define STORE_SLOT(iter) (GPOINTER_TO_UINT((iter)->user_data))
+
+static gpointer parent_class = NULL;
+
+static void store_class_init(mtscan_store_class_t*);
+static void store_init(mtscan_store_t*);
+static void store_finalize(GObject*);
+static void store_tree_model_init(GtkTreeModelIface*);
+static void store_sortable_init(GtkTreeSortableIface*);
+
+static gsize store_kind_size(store_kind_t);
+static void store_grow(mtscan_store_t*);
+static const gchar* store_string_intern(mtscan_store_t*, const gchar*);
+static void store_iter(mtscan_store_t*, guint, GtkTreeIter*);
+static gboolean store_sorted(mtscan_store_t*);
+static gint store_compare(mtscan_store_t*, guint, guint);
+static gint store_compare_column(mtscan_store_t*, gint, guint, guint);
+static gint store_compare_qsort(gconstpointer, gconstpointer, gpointer);
+static guint store_search(mtscan_store_t*, guint);
+static void store_sort(mtscan_store_t*);
+static void store_resort_row(mtscan_store_t*, guint);
+static void store_reordered(mtscan_store_t*, guint, guint);
+
+static GtkTreeModelFlags store_get_flags(GtkTreeModel*);
+static gint store_get_n_columns(GtkTreeModel*);
+static GType store_get_column_type(GtkTreeModel*, gint);
+static gboolean store_get_iter(GtkTreeModel*, GtkTreeIter*, GtkTreePath*);
+static GtkTreePath* store_get_path(GtkTreeModel*, GtkTreeIter*);
+static void store_get_value(GtkTreeModel*, GtkTreeIter*, gint, GValue*);
+static gboolean store_iter_next(GtkTreeModel*, GtkTreeIter*);
+static gboolean store_iter_children(GtkTreeModel*, GtkTreeIter*, GtkTreeIter*);
+static gboolean store_iter_has_child(GtkTreeModel*, GtkTreeIter*);
+static gint store_iter_n_children(GtkTreeModel*, GtkTreeIter*);
+static gboolean store_iter_nth_child(GtkTreeModel*, GtkTreeIter*, GtkTreeIter*, gint);
+static gboolean store_iter_parent(GtkTreeModel*, GtkTreeIter*, GtkTreeIter*);
+
+static gboolean store_get_sort_column_id(GtkTreeSortable*, gint*, GtkSortType*);
+static void store_set_sort_column_id(GtkTreeSortable*, gint, GtkSortType);
+static void store_set_sort_func(GtkTreeSortable*, gint, GtkTreeIterCompareFunc, gpointer, GDestroyNotify);
+static void store_set_default_sort_func(GtkTreeSortable*, GtkTreeIterCompareFunc, gpointer, GDestroyNotify);
+static gboolean store_has_default_sort_func(GtkTreeSortable*);
+
+
+GType
+mtscan_store_get_type(void)
+{
+    static GType type = 0;
+    static const GInterfaceInfo tree_model_info = { (GInterfaceInitFunc)store_tree_model_init, NULL, NULL };
+    static const GInterfaceInfo sortable_info = { (GInterfaceInitFunc)store_sortable_init, NULL, NULL };
+
+    if(!type)
+    {
+        type = g_type_register_static_simple(G_TYPE_OBJECT,
+                                             "MtscanStore",
+                                             sizeof(mtscan_store_class_t),
+                                             (GClassInitFunc)store_class_init,
+                                             sizeof(mtscan_store_t),
+                                             (GInstanceInitFunc)store_init,
+                                             0);
+
+        g_type_add_interface_static(type, GTK_TYPE_TREE_MODEL, &tree_model_info);
+        g_type_add_interface_static(type, GTK_TYPE_TREE_SORTABLE, &sortable_info);
+    }
+    return type;
+}
+
+mtscan_store_t*
+mtscan_store_new(void)
+{
+    return MTSCAN_STORE(g_object_new(MTSCAN_TYPE_STORE, NULL));
+}
+
+static void
+store_class_init(mtscan_store_class_t *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS(klass);
+    parent_class = g_type_class_peek_parent(klass);
+    object_class->finalize = store_finalize;
+}
+
+static void
+store_init(mtscan_store_t *store)
+{
+    store->stamp = g_random_int();
+    store->strings = g_hash_table_new(g_str_hash, g_str_equal);
+    store->sort_column_id = GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID;
+    store->sort_order = GTK_SORT_ASCENDING;
+}
+
+static void
+store_finalize(GObject *object)
+{
+    mtscan_store_t *store = MTSCAN_STORE(object);
+    GHashTableIter iter;
+    gpointer value;
+    gint i;
+
+    g_hash_table_iter_init(&iter, store->strings);
+    while(g_hash_table_iter_next(&iter, NULL, &value))
+        g_free(value);
+    g_hash_table_destroy(store->strings);
+
+    for(i=0; i<COL_COUNT; i++)
+    {
+        g_free(store->data[i]);
+        if(store->sort_destroy[i])
+            store->sort_destroy[i](store->sort_data[i]);
+    }
+
+    if(store->default_sort_destroy)
+        store->default_sort_destroy(store->default_sort_data);
+
+    g_free(store->free_slots);
+    g_free(store->order);
+    g_free(store->position);
+
+    G_OBJECT_CLASS(parent_class)->finalize(object);
+}
+
+static void
+store_tree_model_init(GtkTreeModelIface *iface)
+{
+    iface->get_flags = store_get_flags;
+    iface->get_n_columns = store_get_n_columns;
+    iface->get_column_type = store_get_column_type;
+    iface->get_iter = store_get_iter;
+    iface->get_path = store_get_path;
+    iface->get_value = store_get_value;
+    iface->iter_next = store_iter_next;
+    iface->iter_children = store_iter_children;
+    iface->iter_has_child = store_iter_has_child;
+    iface->iter_n_children = store_iter_n_children;
+    iface->iter_nth_child = store_iter_nth_child;
+    iface->iter_parent = store_iter_parent;
+}
+
+static void
+store_sortable_init(GtkTreeSortableIface *iface)
+{
+    iface->get_sort_column_id = store_get_sort_column_id;
+    iface->set_sort_column_id = store_set_sort_column_id;
+    iface->set_sort_func = store_set_sort_func;
+    iface->set_default_sort_func = store_set_default_sort_func;
+    iface->has_default_sort_func = store_has_default_sort_func;
+}
+
+void
+mtscan_store_clear(mtscan_store_t *store)
+{
+    GtkTreeIter iter;
+    guint slot;
+    gint i;
+
+    /* Remove from the end, so that no other row is moved */
+    while(store->rows)
+    {
+        store_iter(store, store->order[store->rows-1], &iter);
+        mtscan_store_remove(store, &iter);
+    }
+
+    /* Rows that were never shown are dropped too */
+    for(slot=0; slot<store->slots; slot++)
+        if(store->position[slot] == STORE_NO_POSITION)
+            for(i=0; i<COL_COUNT; i++)
+                if(columns[i].kind == STORE_KIND_STRING)
+                    mtscan_store_string_unref(store, STORE_COL(store, i, const gchar*)[slot]);
+
+    store->slots = 0;
+    store->n_free = 0;
+    store->stamp++;
+}
+
+void
+mtscan_store_insert(mtscan_store_t *store,
+                    GtkTreeIter    *iter)
+{
+    guint slot;
+    gint i;
+
+    if(store->n_free)
+    {
+        slot = store->free_slots[--store->n_free];
+    }
+    else
+    {
+        if(store->slots == store->size)
+            store_grow(store);
+        slot = store->slots++;
+    }
+
+    for(i=0; i<COL_COUNT; i++)
+        memset((guint8*)store->data[i] + slot * store_kind_size(columns[i].kind), 0, store_kind_size(columns[i].kind));
+
+    /* The row becomes visible after the first mtscan_store_changed() */
+    store->position[slot] = STORE_NO_POSITION;
+    store_iter(store, slot, iter);
+}
+
+void
+mtscan_store_changed(mtscan_store_t *store,
+                     GtkTreeIter    *iter)
+{
+    guint slot = STORE_SLOT(iter);
+    GtkTreePath *path;
+    guint pos, i;
+
+    g_return_if_fail(iter->stamp == store->stamp);
+
+    if(store->position[slot] == STORE_NO_POSITION)
+    {
+        pos = (store_sorted(store) ? store_search(store, slot) : store->rows);
+
+        memmove(store->order + pos + 1, store->order + pos, (store->rows - pos) * sizeof(guint));
+        store->order[pos] = slot;
+        store->rows++;
+
+        for(i=pos; i<store->rows; i++)
+            store->position[store->order[i]] = i;
+
+        path = gtk_tree_path_new_from_indices(pos, -1);
+        gtk_tree_model_row_inserted(GTK_TREE_MODEL(store), path, iter);
+        gtk_tree_path_free(path);
+        return;
+    }
+
+    path = gtk_tree_path_new_from_indices(store->position[slot], -1);
+    gtk_tree_model_row_changed(GTK_TREE_MODEL(store), path, iter);
+    gtk_tree_path_free(path);
+
+    if(store_sorted(store))
+        store_resort_row(store, slot);
+}
+
+void
+mtscan_store_remove(mtscan_store_t *store,
+                    GtkTreeIter    *iter)
+{
+    guint slot = STORE_SLOT(iter);
+    GtkTreePath *path;
+    guint pos, i;
+
+    g_return_if_fail(iter->stamp == store->stamp);
+
+    for(i=0; i<COL_COUNT; i++)
+        if(columns[i].kind == STORE_KIND_STRING)
+            mtscan_store_string_unref(store, STORE_COL(store, i, const gchar*)[slot]);
+
+    pos = store->position[slot];
+    if(pos != STORE_NO_POSITION)
+    {
+        memmove(store->order + pos, store->order + pos + 1, (store->rows - pos - 1) * sizeof(guint));
+        store->rows--;
+
+        for(i=pos; i<store->rows; i++)
+            store->position[store->order[i]] = i;
+
+        store->position[slot] = STORE_NO_POSITION;
+
+        path = gtk_tree_path_new_from_indices(pos, -1);
+        gtk_tree_model_row_deleted(GTK_TREE_MODEL(store), path);
+        gtk_tree_path_free(path);
+    }
+
+    store->position[slot] = STORE_FREE_SLOT;
+    store->free_slots[store->n_free++] = slot;
+}
+
+gint
+mtscan_store_get_int(mtscan_store_t *store,
+                     GtkTreeIter    *iter,
+                     gint            column)
+{
+    guint slot = STORE_SLOT(iter);
+
+    switch(columns[column].kind)
+    {
+        case STORE_KIND_INT8:
+            return STORE_COL(store, column, gint8)[slot];
+        case STORE_KIND_UINT8:
+            return STORE_COL(store, column, guint8)[slot];
+        case STORE_KIND_INT:
+            return STORE_COL(store, column, gint)[slot];
+        default:
+            g_return_val_if_reached(0);
+    }
+}
+
+gint64
+mtscan_store_get_int64(mtscan_store_t *store,
+                       GtkTreeIter    *iter,
+                       gint            column)
+{
+    g_return_val_if_fail(columns[column].kind == STORE_KIND_INT64, 0);
+    return STORE_COL(store, column, gint64)[STORE_SLOT(iter)];
+}
+
+gfloat
+mtscan_store_get_float(mtscan_store_t *store,
+                       GtkTreeIter    *iter,
+                       gint            column)
+{
+    g_return_val_if_fail(columns[column].kind == STORE_KIND_FLOAT, NAN);
+    return STORE_COL(store, column, gfloat)[STORE_SLOT(iter)];
+}
+
+gdouble
+mtscan_store_get_double(mtscan_store_t *store,
+                        GtkTreeIter    *iter,
+                        gint            column)
+{
+    g_return_val_if_fail(columns[column].kind == STORE_KIND_DOUBLE, NAN);
+    return STORE_COL(store, column, gdouble)[STORE_SLOT(iter)];
+}
+
+const gchar*
+mtscan_store_get_string(mtscan_store_t *store,
+                        GtkTreeIter    *iter,
+                        gint            column)
+{
+    g_return_val_if_fail(columns[column].kind == STORE_KIND_STRING, NULL);
+    return STORE_COL(store, column, const gchar*)[STORE_SLOT(iter)];
+}
+
+gpointer
+mtscan_store_get_pointer(mtscan_store_t *store,
+                         GtkTreeIter    *iter,
+                         gint            column)
+{
+    g_return_val_if_fail(columns[column].kind == STORE_KIND_POINTER, NULL);
+    return STORE_COL(store, column, gpointer)[STORE_SLOT(iter)];
+}
+
+void
+mtscan_store_set_int(mtscan_store_t *store,
+                     GtkTreeIter    *iter,
+                     gint            column,
+                     gint            value)
+{
+    guint slot = STORE_SLOT(iter);
+
+    switch(columns[column].kind)
+    {
+        case STORE_KIND_INT8:
+            STORE_COL(store, column, gint8)[slot] = (gint8)value;
+            break;
+        case STORE_KIND_UINT8:
+            STORE_COL(store, column, guint8)[slot] = (guint8)value;
+            break;
+        case STORE_KIND_INT:
+            STORE_COL(store, column, gint)[slot] = value;
+            break;
+        default:
+            g_return_if_reached();
+    }
+}
+
+void
+mtscan_store_set_int64(mtscan_store_t *store,
+                       GtkTreeIter    *iter,
+                       gint            column,
+                       gint64          value)
+{
+    g_return_if_fail(columns[column].kind == STORE_KIND_INT64);
+    STORE_COL(store, column, gint64)[STORE_SLOT(iter)] = value;
+}
+
+void
+mtscan_store_set_float(mtscan_store_t *store,
+                       GtkTreeIter    *iter,
+                       gint            column,
+                       gfloat          value)
+{
+    g_return_if_fail(columns[column].kind == STORE_KIND_FLOAT);
+    STORE_COL(store, column, gfloat)[STORE_SLOT(iter)] = value;
+}
+
+void
+mtscan_store_set_double(mtscan_store_t *store,
+                        GtkTreeIter    *iter,
+                        gint            column,
+                        gdouble         value)
+{
+    g_return_if_fail(columns[column].kind == STORE_KIND_DOUBLE);
+    STORE_COL(store, column, gdouble)[STORE_SLOT(iter)] = value;
+}
+
+void
+mtscan_store_set_string(mtscan_store_t *store,
+                        GtkTreeIter    *iter,
+                        gint            column,
+                        const gchar    *value)
+{
+    const gchar **ptr;
+    const gchar *old;
+
+    g_return_if_fail(columns[column].kind == STORE_KIND_STRING);
+    ptr = &STORE_COL(store, column, const gchar*)[STORE_SLOT(iter)];
+    old = *ptr;
+    *ptr = store_string_intern(store, value);
+    mtscan_store_string_unref(store, old);
+}
+
+void
+mtscan_store_set_pointer(mtscan_store_t *store,
+                         GtkTreeIter    *iter,
+                         gint            column,
+                         gpointer        value)
+{
+    g_return_if_fail(columns[column].kind == STORE_KIND_POINTER);
+    STORE_COL(store, column, gpointer)[STORE_SLOT(iter)] = value;
+}
+
+const gchar*
+mtscan_store_string_ref(mtscan_store_t *store,
+                        const gchar    *value)
+{
+    /* Only for strings taken from the store */
+    if(value)
+        STORE_STRING(value)->refs++;
+    return value;
+}
+
+void
+mtscan_store_string_unref(mtscan_store_t *store,
+                          const gchar    *value)
+{
+    store_string_t *string;
+
+    if(!value)
+        return;
+
+    string = STORE_STRING(value);
+    if(--string->refs)
+        return;
+
+    g_hash_table_remove(store->strings, value);
+    g_free(string);
+}
+
+static gsize
+store_kind_size(store_kind_t kind)
+{
+    switch(kind)
+    {
+        case STORE_KIND_INT8:
+            return sizeof(gint8);
+        case STORE_KIND_UINT8:
+            return sizeof(guint8);
+        case STORE_KIND_INT:
+            return sizeof(gint);
+        case STORE_KIND_INT64:
+            return sizeof(gint64);
+        case STORE_KIND_FLOAT:
+            return sizeof(gfloat);
+        case STORE_KIND_DOUBLE:
+            return sizeof(gdouble);
+        case STORE_KIND_STRING:
+            return sizeof(const gchar*);
+        case STORE_KIND_POINTER:
+        default:
+            return sizeof(gpointer);
+    }
+}
+
+static void
+store_grow(mtscan_store_t *store)
+{
+    gint i;
+
+    store->size = (store->size ? store->size * 2 : STORE_INITIAL_SIZE);
+
+    for(i=0; i<COL_COUNT; i++)
+        store->data[i] = g_realloc(store->data[i], store->size * store_kind_size(columns[i].kind));
+
+    store->free_slots = g_renew(guint, store->free_slots, store->size);
+    store->order = g_renew(guint, store->order, store->size);
+    store->position = g_renew(guint, store->position, store->size);
+}
+
+static const gchar*
+store_string_intern(mtscan_store_t *store,
+                    const gchar    *value)
+{
+    store_string_t *string;
+    gsize length;
+
+    if(!value)
+        return NULL;
+
+    if((string = g_hash_table_lookup(store->strings, value)))
+    {
+        string->refs++;
+        return string->str;
+    }
+
+    length = strlen(value);
+    string = g_malloc(sizeof(store_string_t) + length + 1);
+    string->refs = 1;
+    memcpy(string->str, value, length + 1);
+    g_hash_table_insert(store->strings, string->str, string);
+    return string->str;
+}
+
+static void
+store_iter(mtscan_store_t *store,
+           guint           slot,
+           GtkTreeIter    *iter)
+{
+    iter->stamp = store->stamp;
+    iter->user_data = GUINT_TO_POINTER(slot);
+    iter->user_data2 = NULL;
+    iter->user_data3 = NULL;
+}
+
+static gboolean
+store_sorted(mtscan_store_t *store)
+{
+    if(store->sort_column_id == GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID)
+        return FALSE;
+
+    if(store->sort_column_id == GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID)
+        return (store->default_sort_func != NULL);
+
+    return TRUE;
+}
+
+static gint
+store_compare(mtscan_store_t *store,
+              guint           a,
+              guint           b)
+{
+    GtkTreeIterCompareFunc func;
+    gpointer data;
+    GtkTreeIter iter_a, iter_b;
+    gint ret;
+
+    if(store->sort_column_id == GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID)
+    {
+        func = store->default_sort_func;
+        data = store->default_sort_data;
+    }
+    else
+    {
+        func = store->sort_func[store->sort_column_id];
+        data = store->sort_data[store->sort_column_id];
+    }
+
+    if(func)
+    {
+        store_iter(store, a, &iter_a);
+        store_iter(store, b, &iter_b);
+        ret = func(GTK_TREE_MODEL(store), &iter_a, &iter_b, data);
+    }
+    else
+    {
+        ret = store_compare_column(store, store->sort_column_id, a, b);
+    }
+
+    if(store->sort_order == GTK_SORT_DESCENDING)
+    {
+        if(ret > 0)
+            ret = -1;
+        else if(ret < 0)
+            ret = 1;
+    }
+
+    return ret;
+}
+
+static gint
+store_compare_column(mtscan_store_t *store,
+                     gint            column,
+                     guint           a,
+                     guint           b)
+{
+    const gchar *s1, *s2;
+    guint8 state1, state2;
+    gint8 rssi1, rssi2;
+    gint64 lastseen1, lastseen2;
+    gdouble d1, d2;
+    gint64 i1, i2;
+
+    switch(column)
+    {
+        case COL_SSID:
+        case COL_RADIONAME:
+        case COL_ROUTEROS_VER:
+            /* Don't care about UTF-8 chars now,
+               as these are escaped by RouterOS */
+            s1 = STORE_COL(store, column, const gchar*)[a];
+            s2 = STORE_COL(store, column, const gchar*)[b];
+            return g_ascii_strcasecmp(s1 ? s1 : "", s2 ? s2 : "");
+
+        case COL_RSSI:
+            state1 = STORE_COL(store, COL_STATE, guint8)[a];
+            state2 = STORE_COL(store, COL_STATE, guint8)[b];
+            rssi1 = STORE_COL(store, COL_RSSI, gint8)[a];
+            rssi2 = STORE_COL(store, COL_RSSI, gint8)[b];
+            lastseen1 = STORE_COL(store, COL_LASTLOG, gint64)[a];
+            lastseen2 = STORE_COL(store, COL_LASTLOG, gint64)[b];
+
+            if(state1 == MODEL_STATE_INACTIVE && state2 == MODEL_STATE_INACTIVE)
+            {
+                if(lastseen1 == lastseen2)
+                    return rssi1 - rssi2;
+                return (lastseen1 < lastseen2 ? -1 : 1);
+            }
+            else if(state1 != MODEL_STATE_INACTIVE && state2 == MODEL_STATE_INACTIVE)
+                return 1;
+            else if(state1 == MODEL_STATE_INACTIVE && state2 != MODEL_STATE_INACTIVE)
+                return -1;
+            return rssi1 - rssi2;
+    }
+
+    switch(columns[column].kind)
+    {
+        case STORE_KIND_DOUBLE:
+            /* Unknown coordinates are placed last */
+            d1 = STORE_COL(store, column, gdouble)[a];
+            d2 = STORE_COL(store, column, gdouble)[b];
+            if(isnan(d1) || isnan(d2))
+                return isnan(d1) - isnan(d2);
+            if(fabs(d1 - d2) < GPS_DOUBLE_PREC)
+                return 0;
+            return (d1 < d2 ? -1 : 1);
+
+        case STORE_KIND_FLOAT:
+            /* Unknown values are placed first */
+            d1 = STORE_COL(store, column, gfloat)[a];
+            d2 = STORE_COL(store, column, gfloat)[b];
+            if(isnan(d1) || isnan(d2))
+                return isnan(d2) - isnan(d1);
+            if(fabs(d1 - d2) < AZI_FLOAT_PREC)
+                return 0;
+            return (d1 < d2 ? -1 : 1);
+
+        case STORE_KIND_STRING:
+            s1 = STORE_COL(store, column, const gchar*)[a];
+            s2 = STORE_COL(store, column, const gchar*)[b];
+            if(!s1 || !s2)
+                return (s1 != NULL) - (s2 != NULL);
+            return g_utf8_collate(s1, s2);
+
+        case STORE_KIND_INT8:
+            i1 = STORE_COL(store, column, gint8)[a];
+            i2 = STORE_COL(store, column, gint8)[b];
+            break;
+
+        case STORE_KIND_UINT8:
+            i1 = STORE_COL(store, column, guint8)[a];
+            i2 = STORE_COL(store, column, guint8)[b];
+            break;
+
+        case STORE_KIND_INT:
+            i1 = STORE_COL(store, column, gint)[a];
+            i2 = STORE_COL(store, column, gint)[b];
+            break;
+
+        case STORE_KIND_INT64:
+            i1 = STORE_COL(store, column, gint64)[a];
+            i2 = STORE_COL(store, column, gint64)[b];
+            break;
+
+        case STORE_KIND_POINTER:
+        default:
+            return 0;
+    }
+
+    return (i1 < i2 ? -1 : (i1 > i2 ? 1 : 0));
+}
+
+static gint
+store_compare_qsort(gconstpointer a,
+                    gconstpointer b,
+                    gpointer      user_data)
+{
+    return store_compare((mtscan_store_t*)user_data, *(const guint*)a, *(const guint*)b);
+}
+
+static guint
+store_search(mtscan_store_t *store,
+             guint           slot)
+{
+    guint low = 0;
+    guint high = store->rows;
+    guint mid;
+
+    /* Insert after equal rows to keep the order stable */
+    while(low < high)
+    {
+        mid = low + (high - low) / 2;
+        if(store_compare(store, slot, store->order[mid]) < 0)
+            high = mid;
+        else
+            low = mid + 1;
+    }
+    return low;
+}
+
+static void
+store_sort(mtscan_store_t *store)
+{
+    if(!store_sorted(store) || store->rows < 2)
+        return;
+
+    g_qsort_with_data(store->order, store->rows, sizeof(guint), store_compare_qsort, store);
+    store_reordered(store, 0, store->rows - 1);
+}
+
+static void
+store_resort_row(mtscan_store_t *store,
+                 guint           slot)
+{
+    guint pos = store->position[slot];
+    guint new_pos;
+
+    if((pos == 0 || store_compare(store, store->order[pos-1], slot) <= 0) &&
+       (pos+1 == store->rows || store_compare(store, slot, store->order[pos+1]) <= 0))
+    {
+        /* Still in order */
+        return;
+    }
+
+    memmove(store->order + pos, store->order + pos + 1, (store->rows - pos - 1) * sizeof(guint));
+    store->rows--;
+
+    new_pos = store_search(store, slot);
+    memmove(store->order + new_pos + 1, store->order + new_pos, (store->rows - new_pos) * sizeof(guint));
+    store->order[new_pos] = slot;
+    store->rows++;
+
+    store_reordered(store, MIN(pos, new_pos), MAX(pos, new_pos));
+}
+
+static void
+store_reordered(mtscan_store_t *store,
+                guint           first,
+                guint           last)
+{
+    GtkTreePath *path;
+    gint *new_order;
+    guint i;
+
+    /* Positions are still the old ones at this point */
+    new_order = g_new(gint, store->rows);
+    for(i=0; i<store->rows; i++)
+        new_order[i] = store->position[store->order[i]];
+
+    for(i=first; i<=last; i++)
+        store->position[store->order[i]] = i;
+
+    path = gtk_tree_path_new();
+    gtk_tree_model_rows_reordered(GTK_TREE_MODEL(store), path, NULL, new_order);
+    gtk_tree_path_free(path);
+    g_free(new_order);
+}
+
+static GtkTreeModelFlags
+store_get_flags(GtkTreeModel *model)
+{
+    return GTK_TREE_MODEL_ITERS_PERSIST | GTK_TREE_MODEL_LIST_ONLY;
+}
+
+static gint
+store_get_n_columns(GtkTreeModel *model)
+{
+    return COL_COUNT;
+}
+
+static GType
+store_get_column_type(GtkTreeModel *model,
+                      gint          index)
+{
+    g_return_val_if_fail(index >= 0 && index < COL_COUNT, G_TYPE_INVALID);
+    return columns[index].type;
+}
+
+static gboolean
+store_get_iter(GtkTreeModel *model,
+               GtkTreeIter  *iter,
+               GtkTreePath  *path)
+{
+    mtscan_store_t *store = MTSCAN_STORE(model);
+    gint i;
+
+    if(gtk_tree_path_get_depth(path) != 1)
+        return FALSE;
+
+    i = gtk_tree_path_get_indices(path)[0];
+    if(i < 0 || (guint)i >= store->rows)
+        return FALSE;
+
+    store_iter(store, store->order[i], iter);
+    return TRUE;
+}
+
+static GtkTreePath*
+store_get_path(GtkTreeModel *model,
+               GtkTreeIter  *iter)
+{
+    mtscan_store_t *store = MTSCAN_STORE(model);
+
+    g_return_val_if_fail(iter->stamp == store->stamp, NULL);
+    return gtk_tree_path_new_from_indices(store->position[STORE_SLOT(iter)], -1);
+}
+
+static void
+store_get_value(GtkTreeModel *model,
+                GtkTreeIter  *iter,
+                gint          column,
+                GValue       *value)
+{
+    mtscan_store_t *store = MTSCAN_STORE(model);
+    guint slot = STORE_SLOT(iter);
+
+    g_return_if_fail(column >= 0 && column < COL_COUNT);
+    g_return_if_fail(iter->stamp == store->stamp);
+
+    g_value_init(value, columns[column].type);
+
+    switch(columns[column].kind)
+    {
+        case STORE_KIND_INT8:
+            if(columns[column].type == G_TYPE_CHAR)
+                g_value_set_schar(value, STORE_COL(store, column, gint8)[slot]);
+            else
+                g_value_set_int(value, STORE_COL(store, column, gint8)[slot]);
+            break;
+
+        case STORE_KIND_UINT8:
+            g_value_set_uchar(value, STORE_COL(store, column, guint8)[slot]);
+            break;
+
+        case STORE_KIND_INT:
+            g_value_set_int(value, STORE_COL(store, column, gint)[slot]);
+            break;
+
+        case STORE_KIND_INT64:
+            g_value_set_int64(value, STORE_COL(store, column, gint64)[slot]);
+            break;
+
+        case STORE_KIND_FLOAT:
+            g_value_set_float(value, STORE_COL(store, column, gfloat)[slot]);
+            break;
+
+        case STORE_KIND_DOUBLE:
+            g_value_set_double(value, STORE_COL(store, column, gdouble)[slot]);
+            break;
+
+        case STORE_KIND_STRING:
+            g_value_set_static_string(value, STORE_COL(store, column, const gchar*)[slot]);
+            break;
+
+        case STORE_KIND_POINTER:
+            g_value_set_pointer(value, STORE_COL(store, column, gpointer)[slot]);
+            break;
+    }
+}
+
+static gboolean
+store_iter_next(GtkTreeModel *model,
+                GtkTreeIter  *iter)
+{
+    mtscan_store_t *store = MTSCAN_STORE(model);
+    guint pos;
+
+    g_return_val_if_fail(iter->stamp == store->stamp, FALSE);
+
+    pos = store->position[STORE_SLOT(iter)] + 1;
+    if(pos >= store->rows)
+    {
+        iter->stamp = 0;
+        return FALSE;
+    }
+
+    iter->user_data = GUINT_TO_POINTER(store->order[pos]);
+    return TRUE;
+}
+
+static gboolean
+store_iter_children(GtkTreeModel *model,
+                    GtkTreeIter  *iter,
+                    GtkTreeIter  *parent)
+{
+    return store_iter_nth_child(model, iter, parent, 0);
+}
+
+static gboolean
+store_iter_has_child(GtkTreeModel *model,
+                     GtkTreeIter  *iter)
+{
+    return FALSE;
+}
+
+static gint
+store_iter_n_children(GtkTreeModel *model,
+                      GtkTreeIter  *iter)
+{
+    mtscan_store_t *store = MTSCAN_STORE(model);
+    return (iter ? 0 : (gint)store->rows);
+}
+
+static gboolean
+store_iter_nth_child(GtkTreeModel *model,
+                     GtkTreeIter  *iter,
+                     GtkTreeIter  *parent,
+                     gint          n)
+{
+    mtscan_store_t *store = MTSCAN_STORE(model);
+
+    if(parent || n < 0 || (guint)n >= store->rows)
+        return FALSE;
+
+    store_iter(store, store->order[n], iter);
+    return TRUE;
+}
+
+static gboolean
+store_iter_parent(GtkTreeModel *model,
+                  GtkTreeIter  *iter,
+                  GtkTreeIter  *child)
+{
+    return FALSE;
+}
+
+static gboolean
+store_get_sort_column_id(GtkTreeSortable *sortable,
+                         gint            *sort_column_id,
+                         GtkSortType     *order)
+{
+    mtscan_store_t *store = MTSCAN_STORE(sortable);
+
+    if(sort_column_id)
+        *sort_column_id = store->sort_column_id;
+    if(order)
+        *order = store->sort_order;
+
+    return (store->sort_column_id != GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID &&
+            store->sort_column_id != GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID);
+}
+
+static void
+store_set_sort_column_id(GtkTreeSortable *sortable,
+                         gint             sort_column_id,
+                         GtkSortType      order)
+{
+    mtscan_store_t *store = MTSCAN_STORE(sortable);
+
+    if(store->sort_column_id == sort_column_id &&
+       store->sort_order == order)
+        return;
+
+    g_return_if_fail(sort_column_id == GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID ||
+                     sort_column_id == GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID ||
+                     (sort_column_id >= 0 && sort_column_id < COL_COUNT));
+
+    store->sort_column_id = sort_column_id;
+    store->sort_order = order;
+
+    gtk_tree_sortable_sort_column_changed(sortable);
+    store_sort(store);
+}
+
+static void
+store_set_sort_func(GtkTreeSortable        *sortable,
+                    gint                    sort_column_id,
+                    GtkTreeIterCompareFunc  func,
+                    gpointer                data,
+                    GDestroyNotify          destroy)
+{
+    mtscan_store_t *store = MTSCAN_STORE(sortable);
+
+    g_return_if_fail(sort_column_id >= 0 && sort_column_id < COL_COUNT);
+
+    if(store->sort_destroy[sort_column_id])
+        store->sort_destroy[sort_column_id](store->sort_data[sort_column_id]);
+
+    store->sort_func[sort_column_id] = func;
+    store->sort_data[sort_column_id] = data;
+    store->sort_destroy[sort_column_id] = destroy;
+
+    if(store->sort_column_id == sort_column_id)
+        store_sort(store);
+}
+
+static void
+store_set_default_sort_func(GtkTreeSortable        *sortable,
+                            GtkTreeIterCompareFunc  func,
+                            gpointer                data,
+                            GDestroyNotify          destroy)
+{
+    mtscan_store_t *store = MTSCAN_STORE(sortable);
+
+    if(store->default_sort_destroy)
+        store->default_sort_destroy(store->default_sort_data);
+
+    store->default_sort_func = func;
+    store->default_sort_data = data;
+    store->default_sort_destroy = destroy;
+
+    if(store->sort_column_id == GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID)
+        store_sort(store);
+}
+
+static gboolean
+store_has_default_sort_func(GtkTreeSortable *sortable)
+{
+    return (MTSCAN_STORE(sortable)->default_sort_func != NULL);
+}
@@ -0,0 +1,51 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef MTSCAN_MODEL_STORE_H_
+#define MTSCAN_MODEL_STORE_H_
+#include <gtk/gtk.h>
+
+#define MTSCAN_TYPE_STORE    (mtscan_store_get_type())
+#define MTSCAN_STORE(obj)    (G_TYPE_CHECK_INSTANCE_CAST((obj), MTSCAN_TYPE_STORE, mtscan_store_t))
+#define MTSCAN_IS_STORE(obj) (G_TYPE_CHECK_INSTANCE_TYPE((obj), MTSCAN_TYPE_STORE))
+
+typedef struct mtscan_store mtscan_store_t;
+
+GType mtscan_store_get_type(void);
+mtscan_store_t* mtscan_store_new(void);
+void mtscan_store_clear(mtscan_store_t*);
+
+void mtscan_store_insert(mtscan_store_t*, GtkTreeIter*);
+void mtscan_store_changed(mtscan_store_t*, GtkTreeIter*);
+void mtscan_store_remove(mtscan_store_t*, GtkTreeIter*);
+
+gint mtscan_store_get_int(mtscan_store_t*, GtkTreeIter*, gint);
+gint64 mtscan_store_get_int64(mtscan_store_t*, GtkTreeIter*, gint);
+gfloat mtscan_store_get_float(mtscan_store_t*, GtkTreeIter*, gint);
+gdouble mtscan_store_get_double(mtscan_store_t*, GtkTreeIter*, gint);
+const gchar* mtscan_store_get_string(mtscan_store_t*, GtkTreeIter*, gint);
+gpointer mtscan_store_get_pointer(mtscan_store_t*, GtkTreeIter*, gint);
+
+void mtscan_store_set_int(mtscan_store_t*, GtkTreeIter*, gint, gint);
+void mtscan_store_set_int64(mtscan_store_t*, GtkTreeIter*, gint, gint64);
+void mtscan_store_set_float(mtscan_store_t*, GtkTreeIter*, gint, gfloat);
+void mtscan_store_set_double(mtscan_store_t*, GtkTreeIter*, gint, gdouble);
+void mtscan_store_set_string(mtscan_store_t*, GtkTreeIter*, gint, const gchar*);
+void mtscan_store_set_pointer(mtscan_store_t*, GtkTreeIter*, gint, gpointer);
+
+const gchar* mtscan_store_string_ref(mtscan_store_t*, const gchar*);
+void mtscan_store_string_unref(mtscan_store_t*, const gchar*);
+
+#endif
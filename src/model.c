@@ -24,12 +24,12 @@
 #include "geoloc.h"
 
 #define UNIX_TIMESTAMP() (g_get_real_time() / 1000000)
-#define GPS_DOUBLE_PREC (1e-6)
-#define AZI_FLOAT_PREC (1e-2)
 
 #define MIKROTIK_LOW_SIGNAL_BUGFIX  1
 #define MIKROTIK_HIGH_SIGNAL_BUGFIX 1
 
+#define MODEL_GEOLOC_CHUNK 4096
+
 enum
 {
     MODEL_NETWORK_UPDATE,
@@ -39,263 +39,94 @@ enum
     MODEL_NETWORK_NEW_ALARM
 };
 
-static gint model_sort_ascii_string(GtkTreeModel*, GtkTreeIter*, GtkTreeIter*, gpointer);
-static gint model_sort_rssi(GtkTreeModel*, GtkTreeIter*, GtkTreeIter*, gpointer);
-static gint model_sort_double(GtkTreeModel*, GtkTreeIter*, GtkTreeIter*, gpointer);
-static gint model_sort_float(GtkTreeModel*, GtkTreeIter*, GtkTreeIter*, gpointer);
-static gint model_sort_version(GtkTreeModel*, GtkTreeIter*, GtkTreeIter*, gpointer);
+#define MODEL_STRINGS 10
+
+typedef struct model_snapshot_context
+{
+    log_snapshot_t *snapshot;
+    mtscan_model_t *model;
+    gboolean strip_signals;
+} model_snapshot_ctx_t;
+
+typedef struct model_geoloc_item
+{
+    gint64 address;
+    const gchar *ssid;
+    gfloat azimuth;
+    gfloat distance;
+} model_geoloc_item_t;
+
+typedef struct model_geoloc_job model_geoloc_job_t;
+
+typedef struct model_geoloc_chunk
+{
+    model_geoloc_job_t *job;
+    model_geoloc_item_t *items;
+    guint length;
+} model_geoloc_chunk_t;
+
+struct model_geoloc_job
+{
+    mtscan_model_t *model;
+    model_geoloc_item_t *items;
+    guint length;
+    model_geoloc_chunk_t *chunks;
+    GStringChunk *strings;
+    gint pending;
+    gint canceled;
+};
+
 static void model_free_foreach(gpointer, gpointer, gpointer);
 static gboolean model_clear_active_foreach(gpointer, gpointer, gpointer);
+static gboolean model_snapshot_foreach(GtkTreeModel*, GtkTreePath*, GtkTreeIter*, gpointer);
+static void model_snapshot_add(log_snapshot_t*, mtscan_model_t*, GtkTreeIter*, gboolean);
+static void model_get(mtscan_store_t*, GtkTreeIter*, network_t*);
+static guint model_strings(network_t*, gchar***);
 static gint model_update_network(mtscan_model_t*, network_t*);
+static void model_set_details(mtscan_store_t*, GtkTreeIter*, network_t*);
+static void model_set_position(mtscan_store_t*, GtkTreeIter*, network_t*);
+static void model_set_wps(mtscan_store_t*, GtkTreeIter*, network_t*);
+static void model_merge_defer(mtscan_model_t*, network_t*);
+static void model_merge_foreach(gpointer, gpointer, gpointer);
 
-static void mtscan_model_geoloc_foreach(gpointer, gpointer, gpointer);
+static void mtscan_model_geoloc_thread(gpointer, gpointer);
+static gboolean mtscan_model_geoloc_apply(gpointer);
 
-static void trim_zeros(gchar*);
 
 mtscan_model_t*
 mtscan_model_new(void)
 {
     mtscan_model_t *model = g_malloc(sizeof(mtscan_model_t));
-    model->store = gtk_list_store_new(COL_COUNT,
-                                      G_TYPE_UCHAR,    /* COL_STATE     */
-                                      G_TYPE_INT64,    /* COL_ADDRESS   */
-                                      G_TYPE_INT,      /* COL_FREQUENCY */
-                                      G_TYPE_STRING,   /* COL_CHANNEL   */
-                                      G_TYPE_STRING,   /* COL_MODE      */
-                                      G_TYPE_CHAR,     /* COL_STREAMS   */
-                                      G_TYPE_STRING,   /* COL_SSID      */
-                                      G_TYPE_STRING,   /* COL_RADIONAME */
-                                      G_TYPE_CHAR,     /* COL_MAXRSSI   */
-                                      G_TYPE_CHAR,     /* COL_RSSI      */
-                                      G_TYPE_CHAR,     /* COL_NOISE     */
-                                      G_TYPE_INT,      /* COL_PRIVACY   */
-                                      G_TYPE_INT,      /* COL_ROUTEROS  */
-                                      G_TYPE_INT,      /* COL_NSTREME   */
-                                      G_TYPE_INT,      /* COL_TDMA      */
-                                      G_TYPE_INT,      /* COL_WDS       */
-                                      G_TYPE_INT,      /* COL_BRIDGE    */
-                                      G_TYPE_STRING,   /* COL_ROS_VER   */
-                                      G_TYPE_INT,      /* COL_AIRMAX          */
-                                      G_TYPE_INT,      /* COL_AIRMAX_AC_PTP   */
-                                      G_TYPE_INT,      /* COL_AIRMAX_AC_PTMP  */
-                                      G_TYPE_INT,      /* COL_AIRMAX_AC_MIXED */
-                                      G_TYPE_INT,      /* COL_WPS       */
-                                      G_TYPE_STRING,   /* COL_WPS_MANUFACTURER  */
-                                      G_TYPE_STRING,   /* COL_WPS_MODEL_NAME    */
-                                      G_TYPE_STRING,   /* COL_WPS_MODEL_NUMBER  */
-                                      G_TYPE_STRING,   /* COL_WPS_SERIAL_NUMBER */
-                                      G_TYPE_STRING,   /* COL_WPS_DEVICE_NAME   */
-                                      G_TYPE_INT64,    /* COL_FIRSTLOG  */
-                                      G_TYPE_INT64,    /* COL_LASTLOG   */
-                                      G_TYPE_DOUBLE,   /* COL_LATITUDE  */
-                                      G_TYPE_DOUBLE,   /* COL_LONGITUDE */
-                                      G_TYPE_FLOAT,    /* COL_ALTITUDE  */
-                                      G_TYPE_FLOAT,    /* COL_ACCURACY  */
-                                      G_TYPE_FLOAT,    /* COL_AZIMUTH   */
-                                      G_TYPE_FLOAT,    /* COL_DISTANCE  */
-                                      G_TYPE_POINTER); /* COL_SIGNALS   */
-
-    gtk_tree_sortable_set_sort_func(GTK_TREE_SORTABLE(model->store), COL_SSID, model_sort_ascii_string, GINT_TO_POINTER(COL_SSID), NULL);
-    gtk_tree_sortable_set_sort_func(GTK_TREE_SORTABLE(model->store), COL_RADIONAME, model_sort_ascii_string, GINT_TO_POINTER(COL_RADIONAME), NULL);
-    gtk_tree_sortable_set_sort_func(GTK_TREE_SORTABLE(model->store), COL_RSSI, model_sort_rssi, NULL, NULL);
-    gtk_tree_sortable_set_sort_func(GTK_TREE_SORTABLE(model->store), COL_LATITUDE, model_sort_double, GINT_TO_POINTER(COL_LATITUDE), NULL);
-    gtk_tree_sortable_set_sort_func(GTK_TREE_SORTABLE(model->store), COL_LONGITUDE, model_sort_double, GINT_TO_POINTER(COL_LONGITUDE), NULL);
-    gtk_tree_sortable_set_sort_func(GTK_TREE_SORTABLE(model->store), COL_ALTITUDE, model_sort_float, GINT_TO_POINTER(COL_ALTITUDE), NULL);
-    gtk_tree_sortable_set_sort_func(GTK_TREE_SORTABLE(model->store), COL_ACCURACY, model_sort_float, GINT_TO_POINTER(COL_ACCURACY), NULL);
-    gtk_tree_sortable_set_sort_func(GTK_TREE_SORTABLE(model->store), COL_AZIMUTH, model_sort_float, GINT_TO_POINTER(COL_AZIMUTH), NULL);
-    gtk_tree_sortable_set_sort_func(GTK_TREE_SORTABLE(model->store), COL_DISTANCE, model_sort_float, GINT_TO_POINTER(COL_DISTANCE), NULL);
-    gtk_tree_sortable_set_sort_func(GTK_TREE_SORTABLE(model->store), COL_ROUTEROS_VER, model_sort_version, GINT_TO_POINTER(COL_ROUTEROS_VER), NULL);
-
+    model->store = mtscan_store_new();
     model->map = g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free, (GDestroyNotify)gtk_tree_iter_free);
     model->active = g_hash_table_new_full(g_int64_hash, g_int64_equal, NULL, NULL);
     model->active_timeout = MODEL_DEFAULT_ACTIVE_TIMEOUT;
     model->new_timeout = MODEL_DEFAULT_NEW_TIMEOUT;
     model->disabled_sorting = FALSE;
     model->buffer = NULL;
+    model->merge = NULL;
+    model->journal = NULL;
 	model->clear_active_all = FALSE;
+    model->geoloc_job = NULL;
+    model->geoloc_again = FALSE;
     return model;
 }
 
-
-static gint
-model_sort_ascii_string(GtkTreeModel *model,
-                        GtkTreeIter  *a,
-                        GtkTreeIter  *b,
-                        gpointer      data)
-{
-    gint column = GPOINTER_TO_INT(data);
-    gchar *v1, *v2;
-    gint ret;
-
-    gtk_tree_model_get(model, a,
-                       column, &v1,
-                       -1);
-
-    gtk_tree_model_get(model, b,
-                       column, &v2,
-                       -1);
-
-    /* Don't care about UTF-8 chars now,
-       as these are escaped by RouterOS */
-    ret = g_ascii_strcasecmp(v1, v2);
-
-    g_free(v1);
-    g_free(v2);
-    return ret;
-}
-
-static gint
-model_sort_rssi(GtkTreeModel *model,
-                GtkTreeIter  *a,
-                GtkTreeIter  *b,
-                gpointer      data)
+void
+mtscan_model_free(mtscan_model_t *model)
 {
-    guint8 state, state2;
-    gint8 rssi, rssi2;
-    gint64 lastseen, lastseen2;
-
-    gtk_tree_model_get(model, a,
-                       COL_STATE, &state,
-                       COL_RSSI, &rssi,
-                       COL_LASTLOG, &lastseen,
-                       -1);
-
-    gtk_tree_model_get(model, b,
-                       COL_STATE, &state2,
-                       COL_RSSI, &rssi2,
-                       COL_LASTLOG, &lastseen2,
-                       -1);
-
-    if(state == MODEL_STATE_INACTIVE && state2 == MODEL_STATE_INACTIVE)
-    {
-        if(lastseen - lastseen2 == 0)
-            return rssi - rssi2;
-        else
-            return lastseen - lastseen2;
-    }
-    else if(state != MODEL_STATE_INACTIVE && state2 == MODEL_STATE_INACTIVE)
+    if(model->geoloc_job)
     {
-        return 1;
+        /* The job is freed with its results */
+        model->geoloc_job->model = NULL;
+        g_atomic_int_set(&model->geoloc_job->canceled, TRUE);
     }
-    else if(state == MODEL_STATE_INACTIVE && state2 != MODEL_STATE_INACTIVE)
-    {
-        return -1;
-    }
-    else
-    {
-        return rssi - rssi2;
-    }
-}
-
-static gint
-model_sort_double(GtkTreeModel *model,
-                  GtkTreeIter  *a,
-                  GtkTreeIter  *b,
-                  gpointer      data)
-{
-    gint column = GPOINTER_TO_INT(data);
-    gdouble v1, v2, diff;
-    gboolean v1_isnan, v2_isnan;
-
-    gtk_tree_model_get(model, a,
-                       column, &v1,
-                       -1);
 
-    gtk_tree_model_get(model, b,
-                       column, &v2,
-                       -1);
-
-    v1_isnan = isnan(v1);
-    v2_isnan = isnan(v2);
-
-    if(v1_isnan && v2_isnan)
-        return 0;
-
-    if(!v1_isnan && v2_isnan)
-        return -1;
-
-    if(v1_isnan && !v2_isnan)
-        return 1;
-
-    diff = v1 - v2;
-    if(fabs(diff) < GPS_DOUBLE_PREC)
-        return 0;
-
-    if(diff < 0)
-        return -1;
-
-    return 1;
-}
-
-static gint
-model_sort_float(GtkTreeModel *model,
-                 GtkTreeIter  *a,
-                 GtkTreeIter  *b,
-                 gpointer      data)
-{
-    gint column = GPOINTER_TO_INT(data);
-    gfloat v1, v2, diff;
-    gboolean v1_isnan, v2_isnan;
-
-    gtk_tree_model_get(model, a,
-                       column, &v1,
-                       -1);
-
-    gtk_tree_model_get(model, b,
-                       column, &v2,
-                       -1);
-
-    v1_isnan = isnan(v1);
-    v2_isnan = isnan(v2);
-
-    if(v1_isnan && v2_isnan)
-        return 0;
-
-    if(!v1_isnan && v2_isnan)
-        return 1;
-
-    if(v1_isnan && !v2_isnan)
-        return -1;
-
-    diff = v1 - v2;
-    if(fabs(diff) < AZI_FLOAT_PREC)
-        return 0;
-
-    if(diff < 0)
-        return -1;
-
-    return 1;
-}
-
-static gint
-model_sort_version(GtkTreeModel *model,
-                   GtkTreeIter  *a,
-                   GtkTreeIter  *b,
-                   gpointer      data)
-{
-    gint column = GPOINTER_TO_INT(data);
-    gchar *v1, *v2;
-    gint ret;
-
-    gtk_tree_model_get(model, a,
-                       column, &v1,
-                       -1);
-
-    gtk_tree_model_get(model, b,
-                       column, &v2,
-                       -1);
-    ret = strcasecmp(v1, v2);
-    g_free(v1);
-    g_free(v2);
-    return ret;
-}
-
-void
-mtscan_model_free(mtscan_model_t *model)
-{
     g_hash_table_foreach(model->map, model_free_foreach, model);
     g_hash_table_destroy(model->map);
     g_hash_table_destroy(model->active);
+    if(model->merge)
+        g_hash_table_destroy(model->merge);
     g_object_unref(model->store);
     g_free(model);
 }
@@ -306,24 +137,21 @@ model_free_foreach(gpointer key,
                    gpointer data)
 {
     mtscan_model_t *model = (mtscan_model_t*)data;
-    GtkTreeModel *store = (GtkTreeModel*)model->store;
     GtkTreeIter *iter = (GtkTreeIter*)value;
-    signals_t *signals;
 
-    gtk_tree_model_get(store, iter,
-                       COL_SIGNALS, &signals, -1);
-
-    signals_free(signals);
+    signals_free(mtscan_store_get_pointer(model->store, iter, COL_SIGNALS));
 }
 
 void
 mtscan_model_clear(mtscan_model_t *model)
 {
     mtscan_model_buffer_clear(model);
+    if(model->merge)
+        g_hash_table_remove_all(model->merge);
     g_hash_table_remove_all(model->active);
     g_hash_table_foreach(model->map, model_free_foreach, model);
     g_hash_table_remove_all(model->map);
-    gtk_list_store_clear(GTK_LIST_STORE(model->store));
+    mtscan_store_clear(model->store);
 }
 
 void
@@ -340,27 +168,19 @@ model_clear_active_foreach(gpointer key,
                            gpointer data)
 {
     mtscan_model_t *model = (mtscan_model_t*)data;
-    GtkTreeModel *store = (GtkTreeModel*)model->store;
     GtkTreeIter *iter = (GtkTreeIter*)value;
     gint64 firstseen, lastseen;
-    gboolean privacy;
-    gint8 rssi;
     guint8 state;
 
-    gtk_tree_model_get(store, iter,
-                       COL_STATE, &state,
-                       COL_PRIVACY, &privacy,
-                       COL_RSSI, &rssi,
-                       COL_FIRSTLOG, &firstseen,
-                       COL_LASTLOG, &lastseen,
-                       -1);
+    state = mtscan_store_get_int(model->store, iter, COL_STATE);
+    firstseen = mtscan_store_get_int64(model->store, iter, COL_FIRSTLOG);
+    lastseen = mtscan_store_get_int64(model->store, iter, COL_LASTLOG);
 
     if(model->clear_active_all ||
        UNIX_TIMESTAMP() > lastseen+model->active_timeout)
     {
-        gtk_list_store_set(GTK_LIST_STORE(store), iter,
-                           COL_STATE, MODEL_STATE_INACTIVE,
-                           -1);
+        mtscan_store_set_int(model->store, iter, COL_STATE, MODEL_STATE_INACTIVE);
+        mtscan_store_changed(model->store, iter);
         model->clear_active_changed = TRUE;
         return TRUE;
     }
@@ -368,9 +188,8 @@ model_clear_active_foreach(gpointer key,
     if(state == MODEL_STATE_NEW &&
        UNIX_TIMESTAMP() > firstseen+model->new_timeout)
     {
-        gtk_list_store_set(GTK_LIST_STORE(store), iter,
-                           COL_STATE, MODEL_STATE_ACTIVE,
-                           -1);
+        mtscan_store_set_int(model->store, iter, COL_STATE, MODEL_STATE_ACTIVE);
+        mtscan_store_changed(model->store, iter);
         model->clear_active_changed = TRUE;
     }
 
@@ -382,43 +201,151 @@ mtscan_model_get(mtscan_model_t *model,
                  GtkTreeIter    *iter,
                  network_t      *net)
 {
+    /* Borrowed view, the strings and signals stay owned by the store
+       and must not be freed or kept after the row changes */
+    model_get(model->store, iter, net);
+}
+
+static void
+model_get(mtscan_store_t *store,
+          GtkTreeIter    *iter,
+          network_t      *net)
+{
+    /* Strings are owned by the store */
+    net->address = mtscan_store_get_int64(store, iter, COL_ADDRESS);
+    net->frequency = mtscan_store_get_int(store, iter, COL_FREQUENCY);
+    net->channel = (gchar*)mtscan_store_get_string(store, iter, COL_CHANNEL);
+    net->mode = (gchar*)mtscan_store_get_string(store, iter, COL_MODE);
+    net->streams = mtscan_store_get_int(store, iter, COL_STREAMS);
+    net->ssid = (gchar*)mtscan_store_get_string(store, iter, COL_SSID);
+    net->radioname = (gchar*)mtscan_store_get_string(store, iter, COL_RADIONAME);
+    net->rssi = mtscan_store_get_int(store, iter, COL_MAXRSSI);
+    net->flags.privacy = mtscan_store_get_int(store, iter, COL_PRIVACY);
+    net->flags.routeros = mtscan_store_get_int(store, iter, COL_ROUTEROS);
+    net->flags.nstreme = mtscan_store_get_int(store, iter, COL_NSTREME);
+    net->flags.tdma = mtscan_store_get_int(store, iter, COL_TDMA);
+    net->flags.wds = mtscan_store_get_int(store, iter, COL_WDS);
+    net->flags.bridge = mtscan_store_get_int(store, iter, COL_BRIDGE);
+    net->routeros_ver = (gchar*)mtscan_store_get_string(store, iter, COL_ROUTEROS_VER);
+    net->ubnt_airmax = mtscan_store_get_int(store, iter, COL_AIRMAX);
+    net->ubnt_ptp = mtscan_store_get_int(store, iter, COL_AIRMAX_AC_PTP);
+    net->ubnt_ptmp = mtscan_store_get_int(store, iter, COL_AIRMAX_AC_PTMP);
+    net->ubnt_mixed = mtscan_store_get_int(store, iter, COL_AIRMAX_AC_MIXED);
+    net->wps = mtscan_store_get_int(store, iter, COL_WPS);
+    net->wps_manufacturer = (gchar*)mtscan_store_get_string(store, iter, COL_WPS_MANUFACTURER);
+    net->wps_model_name = (gchar*)mtscan_store_get_string(store, iter, COL_WPS_MODEL_NAME);
+    net->wps_model_number = (gchar*)mtscan_store_get_string(store, iter, COL_WPS_MODEL_NUMBER);
+    net->wps_serial_number = (gchar*)mtscan_store_get_string(store, iter, COL_WPS_SERIAL_NUMBER);
+    net->wps_device_name = (gchar*)mtscan_store_get_string(store, iter, COL_WPS_DEVICE_NAME);
+    net->firstseen = mtscan_store_get_int64(store, iter, COL_FIRSTLOG);
+    net->lastseen = mtscan_store_get_int64(store, iter, COL_LASTLOG);
+    net->latitude = mtscan_store_get_double(store, iter, COL_LATITUDE);
+    net->longitude = mtscan_store_get_double(store, iter, COL_LONGITUDE);
+    net->altitude = mtscan_store_get_float(store, iter, COL_ALTITUDE);
+    net->accuracy = mtscan_store_get_float(store, iter, COL_ACCURACY);
+    net->azimuth = mtscan_store_get_float(store, iter, COL_AZIMUTH);
+    net->distance = mtscan_store_get_float(store, iter, COL_DISTANCE);
+    net->signals = mtscan_store_get_pointer(store, iter, COL_SIGNALS);
+}
+
+log_snapshot_t*
+mtscan_model_snapshot(mtscan_model_t *model,
+                      GList          *iterlist,
+                      gboolean        strip_signals)
+{
+    model_snapshot_ctx_t ctx;
+    GList *i;
 
-    gtk_tree_model_get(GTK_TREE_MODEL(model->store), iter,
-                       COL_ADDRESS, &net->address,
-                       COL_FREQUENCY, &net->frequency,
-                       COL_CHANNEL, &net->channel,
-                       COL_MODE, &net->mode,
-                       COL_STREAMS, &net->streams,
-                       COL_SSID, &net->ssid,
-                       COL_RADIONAME, &net->radioname,
-                       COL_MAXRSSI, &net->rssi,
-                       COL_PRIVACY, &net->flags.privacy,
-                       COL_ROUTEROS, &net->flags.routeros,
-                       COL_NSTREME, &net->flags.nstreme,
-                       COL_TDMA, &net->flags.tdma,
-                       COL_WDS, &net->flags.wds,
-                       COL_BRIDGE, &net->flags.bridge,
-                       COL_ROUTEROS_VER, &net->routeros_ver,
-                       COL_AIRMAX, &net->ubnt_airmax,
-                       COL_AIRMAX_AC_PTP, &net->ubnt_ptp,
-                       COL_AIRMAX_AC_PTMP, &net->ubnt_ptmp,
-                       COL_AIRMAX_AC_MIXED, &net->ubnt_mixed,
-                       COL_WPS, &net->wps,
-                       COL_WPS_MANUFACTURER, &net->wps_manufacturer,
-                       COL_WPS_MODEL_NAME, &net->wps_model_name,
-                       COL_WPS_MODEL_NUMBER, &net->wps_model_number,
-                       COL_WPS_SERIAL_NUMBER, &net->wps_serial_number,
-                       COL_WPS_DEVICE_NAME, &net->wps_device_name,
-                       COL_FIRSTLOG, &net->firstseen,
-                       COL_LASTLOG, &net->lastseen,
-                       COL_LATITUDE, &net->latitude,
-                       COL_LONGITUDE, &net->longitude,
-                       COL_ALTITUDE, &net->altitude,
-                       COL_ACCURACY, &net->accuracy,
-                       COL_AZIMUTH, &net->azimuth,
-                       COL_DISTANCE, &net->distance,
-                       COL_SIGNALS, &net->signals,
-                       -1);
+    ctx.snapshot = g_new(log_snapshot_t, 1);
+    ctx.snapshot->count = 0;
+    ctx.model = model;
+    ctx.strip_signals = strip_signals;
+
+    if(iterlist)
+    {
+        ctx.snapshot->networks = g_new(network_t, g_list_length(iterlist));
+        for(i=iterlist; i; i=i->next)
+            model_snapshot_add(ctx.snapshot, model, (GtkTreeIter*)(i->data), strip_signals);
+    }
+    else
+    {
+        ctx.snapshot->networks = g_new(network_t, gtk_tree_model_iter_n_children(GTK_TREE_MODEL(model->store), NULL));
+        gtk_tree_model_foreach(GTK_TREE_MODEL(model->store), model_snapshot_foreach, &ctx);
+    }
+
+    return ctx.snapshot;
+}
+
+static gboolean
+model_snapshot_foreach(GtkTreeModel *store,
+                       GtkTreePath  *path,
+                       GtkTreeIter  *iter,
+                       gpointer      data)
+{
+    model_snapshot_ctx_t *ctx = (model_snapshot_ctx_t*)data;
+    model_snapshot_add(ctx->snapshot, ctx->model, iter, ctx->strip_signals);
+    return FALSE;
+}
+
+static void
+model_snapshot_add(log_snapshot_t *snapshot,
+                   mtscan_model_t *model,
+                   GtkTreeIter    *iter,
+                   gboolean        strip_signals)
+{
+    network_t *net = &snapshot->networks[snapshot->count++];
+    gchar **strings[MODEL_STRINGS];
+    guint i, n;
+
+    /* Strings and signal samples are shared with the store,
+       neither of them is modified while referenced */
+    model_get(model->store, iter, net);
+
+    n = model_strings(net, strings);
+    for(i=0; i<n; i++)
+        mtscan_store_string_ref(model->store, *strings[i]);
+
+    net->signals = (strip_signals ? signals_new() : signals_copy(net->signals));
+}
+
+void
+mtscan_model_snapshot_free(mtscan_model_t *model,
+                           log_snapshot_t *snapshot)
+{
+    gchar **strings[MODEL_STRINGS];
+    network_t *net;
+    guint i, j, n;
+
+    for(i=0; i<snapshot->count; i++)
+    {
+        net = &snapshot->networks[i];
+        n = model_strings(net, strings);
+        for(j=0; j<n; j++)
+            mtscan_store_string_unref(model->store, *strings[j]);
+        signals_free(net->signals);
+    }
+
+    g_free(snapshot->networks);
+    g_free(snapshot);
+}
+
+static guint
+model_strings(network_t   *net,
+              gchar     ***strings)
+{
+    guint n = 0;
+
+    strings[n++] = &net->channel;
+    strings[n++] = &net->mode;
+    strings[n++] = &net->ssid;
+    strings[n++] = &net->radioname;
+    strings[n++] = &net->routeros_ver;
+    strings[n++] = &net->wps_manufacturer;
+    strings[n++] = &net->wps_model_name;
+    strings[n++] = &net->wps_model_number;
+    strings[n++] = &net->wps_serial_number;
+    strings[n++] = &net->wps_device_name;
+    return n;
 }
 
 void
@@ -428,15 +355,13 @@ mtscan_model_remove(mtscan_model_t *model,
     gint64 address;
     signals_t *signals;
 
-    gtk_tree_model_get(GTK_TREE_MODEL(model->store), iter,
-                       COL_ADDRESS, &address,
-                       COL_SIGNALS, &signals,
-                       -1);
+    address = mtscan_store_get_int64(model->store, iter, COL_ADDRESS);
+    signals = mtscan_store_get_pointer(model->store, iter, COL_SIGNALS);
 
     g_hash_table_remove(model->active, &address);
     g_hash_table_remove(model->map, &address);
     signals_free(signals);
-    gtk_list_store_remove(model->store, iter);
+    mtscan_store_remove(model->store, iter);
 }
 
 void
@@ -498,12 +423,18 @@ mtscan_model_buffer_and_inactive_update(mtscan_model_t *model)
             else if(status == MODEL_NETWORK_UPDATE)
                 state |= MODEL_UPDATE;
 
+            if(model->journal)
+                journal_append(model->journal, net, conf_get_preferences_signals());
+
             network_free(net);
             g_free(net);
             current = current->next;
         }
         g_slist_free(model->buffer);
         model->buffer = NULL;
+
+        if(model->journal)
+            journal_flush(model->journal);
     }
 
     model->clear_active_changed = FALSE;
@@ -521,11 +452,10 @@ model_update_network(mtscan_model_t *model,
     GtkTreeIter *iter_ptr;
     GtkTreeIter iter;
     gint64 *address;
-    gchar *current_ssid;
-    gchar *current_radioname;
     gint8 current_maxrssi;
     gint current_wps;
     guint8 current_state;
+    const gchar *current;
     gboolean new_network_found;
     gfloat distance = NAN;
     gchar *type;
@@ -534,14 +464,10 @@ model_update_network(mtscan_model_t *model,
     if(g_hash_table_lookup_extended(model->map, &net->address, (gpointer*)&address, (gpointer*)&iter_ptr))
     {
         /* Update a network, check current values first */
-        gtk_tree_model_get(GTK_TREE_MODEL(model->store), iter_ptr,
-                           COL_STATE, &current_state,
-                           COL_SSID, &current_ssid,
-                           COL_RADIONAME, &current_radioname,
-                           COL_MAXRSSI, &current_maxrssi,
-                           COL_WPS, &current_wps,
-                           COL_SIGNALS, &net->signals,
-                           -1);
+        current_state = mtscan_store_get_int(model->store, iter_ptr, COL_STATE);
+        current_maxrssi = mtscan_store_get_int(model->store, iter_ptr, COL_MAXRSSI);
+        current_wps = mtscan_store_get_int(model->store, iter_ptr, COL_WPS);
+        net->signals = mtscan_store_get_pointer(model->store, iter_ptr, COL_SIGNALS);
 
         /* Update state to active (keep MODEL_STATE_NEW untouched) */
         if(current_state == MODEL_STATE_INACTIVE)
@@ -551,24 +477,18 @@ model_update_network(mtscan_model_t *model,
         if((net->ssid && !net->ssid[0]) ||
            !net->ssid)
         {
+            current = mtscan_store_get_string(model->store, iter_ptr, COL_SSID);
             g_free(net->ssid);
-            net->ssid = current_ssid;
-        }
-        else
-        {
-            g_free(current_ssid);
+            net->ssid = g_strdup(current);
         }
 
-        /* ... and Radio Names */
+        /* ... and Radio Names */
         if((net->radioname && !net->radioname[0]) ||
            !net->radioname)
         {
+            current = mtscan_store_get_string(model->store, iter_ptr, COL_RADIONAME);
             g_free(net->radioname);
-            net->radioname = current_radioname;
-        }
-        else
-        {
-            g_free(current_radioname);
+            net->radioname = g_strdup(current);
         }
 
 #if MIKROTIK_LOW_SIGNAL_BUGFIX
@@ -581,25 +501,24 @@ model_update_network(mtscan_model_t *model,
 #endif
 
         if(conf_get_preferences_signals())
-            signals_append(net->signals, signals_node_new(net->firstseen,
-                                                          net->rssi,
-                                                          net->latitude,
-                                                          net->longitude,
-                                                          net->altitude,
-                                                          net->accuracy,
-                                                          net->azimuth));
+            signals_add(net->signals,
+                        net->firstseen,
+                        net->rssi,
+                        net->latitude,
+                        net->longitude,
+                        net->altitude,
+                        net->accuracy,
+                        net->azimuth,
+                        net->source);
 
         if(net->wps >= current_wps)
-        {
-            gtk_list_store_set(model->store, iter_ptr,
-                               COL_WPS, net->wps,
-                               COL_WPS_MANUFACTURER, net->wps_manufacturer,
-                               COL_WPS_MODEL_NAME, net->wps_model_name,
-                               COL_WPS_MODEL_NUMBER, net->wps_model_number,
-                               COL_WPS_SERIAL_NUMBER, net->wps_serial_number,
-                               COL_WPS_DEVICE_NAME, net->wps_device_name,
-                               -1);
-        }
+            model_set_wps(model->store, iter_ptr, net);
+
+        mtscan_store_set_int(model->store, iter_ptr, COL_STATE, current_state);
+        model_set_details(model->store, iter_ptr, net);
+        mtscan_store_set_int(model->store, iter_ptr, COL_RSSI, net->rssi);
+        mtscan_store_set_int(model->store, iter_ptr, COL_NOISE, net->noise);
+        mtscan_store_set_int64(model->store, iter_ptr, COL_LASTLOG, net->firstseen);
 
         /* At new signal peak, update additionally:
          * COL_MAXRSSI, COL_LATITUDE, COL_LONGITUDE, COL_ALTITUDE, COL_ACCURACY, COL_AZIMUTH and COL_DISTANCE */
@@ -608,64 +527,13 @@ model_update_network(mtscan_model_t *model,
             if(conf_get_interface_geoloc())
                 geoloc_match(net->address, net->ssid, net->azimuth, FALSE, &distance);
 
-            gtk_list_store_set(model->store, iter_ptr,
-                               COL_STATE, current_state,
-                               COL_FREQUENCY, net->frequency,
-                               COL_CHANNEL, (net->channel ? net->channel : ""),
-                               COL_STREAMS, net->streams,
-                               COL_MODE, (net->mode ? net->mode : ""),
-                               COL_SSID, (net->ssid ? net->ssid : ""),
-                               COL_RADIONAME, (net->radioname ? net->radioname : ""),
-                               COL_MAXRSSI, net->rssi,
-                               COL_RSSI, net->rssi,
-                               COL_NOISE, net->noise,
-                               COL_PRIVACY, net->flags.privacy,
-                               COL_ROUTEROS, net->flags.routeros,
-                               COL_NSTREME, net->flags.nstreme,
-                               COL_TDMA, net->flags.tdma,
-                               COL_WDS, net->flags.wds,
-                               COL_BRIDGE, net->flags.bridge,
-                               COL_ROUTEROS_VER, (net->routeros_ver ? net->routeros_ver : ""),
-                               COL_AIRMAX, net->ubnt_airmax,
-                               COL_AIRMAX_AC_PTP, net->ubnt_ptp,
-                               COL_AIRMAX_AC_PTMP, net->ubnt_ptmp,
-                               COL_AIRMAX_AC_MIXED, net->ubnt_mixed,
-                               COL_LASTLOG, net->firstseen,
-                               COL_LATITUDE, net->latitude,
-                               COL_LONGITUDE, net->longitude,
-                               COL_ALTITUDE, net->altitude,
-                               COL_ACCURACY, net->accuracy,
-                               COL_AZIMUTH, net->azimuth,
-                               COL_DISTANCE, distance,
-                               -1);
-        }
-        else
-        {
-            gtk_list_store_set(model->store, iter_ptr,
-                               COL_STATE, current_state,
-                               COL_FREQUENCY, net->frequency,
-                               COL_CHANNEL, (net->channel ? net->channel : ""),
-                               COL_STREAMS, net->streams,
-                               COL_MODE, (net->mode ? net->mode : ""),
-                               COL_SSID, (net->ssid ? net->ssid : ""),
-                               COL_RADIONAME, (net->radioname ? net->radioname : ""),
-                               COL_RSSI, net->rssi,
-                               COL_NOISE, net->noise,
-                               COL_PRIVACY, net->flags.privacy,
-                               COL_ROUTEROS, net->flags.routeros,
-                               COL_NSTREME, net->flags.nstreme,
-                               COL_TDMA, net->flags.tdma,
-                               COL_WDS, net->flags.wds,
-                               COL_BRIDGE, net->flags.bridge,
-                               COL_ROUTEROS_VER, (net->routeros_ver ? net->routeros_ver : ""),
-                               COL_AIRMAX, net->ubnt_airmax,
-                               COL_AIRMAX_AC_PTP, net->ubnt_ptp,
-                               COL_AIRMAX_AC_PTMP, net->ubnt_ptmp,
-                               COL_AIRMAX_AC_MIXED, net->ubnt_mixed,
-                               COL_LASTLOG, net->firstseen,
-                               -1);
+            mtscan_store_set_int(model->store, iter_ptr, COL_MAXRSSI, net->rssi);
+            model_set_position(model->store, iter_ptr, net);
+            mtscan_store_set_float(model->store, iter_ptr, COL_DISTANCE, distance);
         }
 
+        mtscan_store_changed(model->store, iter_ptr);
+
         /* Add address to the active network list */
         g_hash_table_insert(model->active, address, iter_ptr);
         new_network_found = MODEL_NETWORK_UPDATE;
@@ -678,53 +546,30 @@ model_update_network(mtscan_model_t *model,
 
         net->signals = signals_new();
         if(conf_get_preferences_signals())
-            signals_append(net->signals, signals_node_new(net->firstseen,
-                                                          net->rssi,
-                                                          net->latitude,
-                                                          net->longitude,
-                                                          net->altitude,
-                                                          net->accuracy,
-                                                          net->azimuth));
-
-        gtk_list_store_insert_with_values(model->store, &iter, -1,
-                                          COL_STATE, MODEL_STATE_NEW,
-                                          COL_ADDRESS, net->address,
-                                          COL_FREQUENCY, net->frequency,
-                                          COL_CHANNEL, (net->channel ? net->channel : ""),
-                                          COL_STREAMS, net->streams,
-                                          COL_MODE, (net->mode ? net->mode : ""),
-                                          COL_SSID, (net->ssid ? net->ssid : ""),
-                                          COL_RADIONAME, (net->radioname ? net->radioname : ""),
-                                          COL_MAXRSSI, net->rssi,
-                                          COL_RSSI, net->rssi,
-                                          COL_NOISE, net->noise,
-                                          COL_PRIVACY, net->flags.privacy,
-                                          COL_ROUTEROS, net->flags.routeros,
-                                          COL_NSTREME, net->flags.nstreme,
-                                          COL_TDMA, net->flags.tdma,
-                                          COL_WDS, net->flags.wds,
-                                          COL_BRIDGE, net->flags.bridge,
-                                          COL_ROUTEROS_VER, (net->routeros_ver ? net->routeros_ver : ""),
-                                          COL_AIRMAX, net->ubnt_airmax,
-                                          COL_AIRMAX_AC_PTP, net->ubnt_ptp,
-                                          COL_AIRMAX_AC_PTMP, net->ubnt_ptmp,
-                                          COL_AIRMAX_AC_MIXED, net->ubnt_mixed,
-                                          COL_WPS, net->wps,
-                                          COL_WPS_MANUFACTURER, net->wps_manufacturer,
-                                          COL_WPS_MODEL_NAME, net->wps_model_name,
-                                          COL_WPS_MODEL_NUMBER, net->wps_model_number,
-                                          COL_WPS_SERIAL_NUMBER, net->wps_serial_number,
-                                          COL_WPS_DEVICE_NAME, net->wps_device_name,
-                                          COL_FIRSTLOG, net->firstseen,
-                                          COL_LASTLOG, net->firstseen,
-                                          COL_LATITUDE, net->latitude,
-                                          COL_LONGITUDE, net->longitude,
-                                          COL_ALTITUDE, net->altitude,
-                                          COL_ACCURACY, net->accuracy,
-                                          COL_AZIMUTH, net->azimuth,
-                                          COL_DISTANCE, distance,
-                                          COL_SIGNALS, net->signals,
-                                          -1);
+            signals_add(net->signals,
+                        net->firstseen,
+                        net->rssi,
+                        net->latitude,
+                        net->longitude,
+                        net->altitude,
+                        net->accuracy,
+                        net->azimuth,
+                        net->source);
+
+        mtscan_store_insert(model->store, &iter);
+        mtscan_store_set_int(model->store, &iter, COL_STATE, MODEL_STATE_NEW);
+        mtscan_store_set_int64(model->store, &iter, COL_ADDRESS, net->address);
+        model_set_details(model->store, &iter, net);
+        mtscan_store_set_int(model->store, &iter, COL_MAXRSSI, net->rssi);
+        mtscan_store_set_int(model->store, &iter, COL_RSSI, net->rssi);
+        mtscan_store_set_int(model->store, &iter, COL_NOISE, net->noise);
+        model_set_wps(model->store, &iter, net);
+        mtscan_store_set_int64(model->store, &iter, COL_FIRSTLOG, net->firstseen);
+        mtscan_store_set_int64(model->store, &iter, COL_LASTLOG, net->firstseen);
+        model_set_position(model->store, &iter, net);
+        mtscan_store_set_float(model->store, &iter, COL_DISTANCE, distance);
+        mtscan_store_set_pointer(model->store, &iter, COL_SIGNALS, net->signals);
+        mtscan_store_changed(model->store, &iter);
 
         iter_ptr = gtk_tree_iter_copy(&iter);
         address = gint64dup(&net->address);
@@ -762,12 +607,61 @@ model_update_network(mtscan_model_t *model,
 
     }
 
-    /* Signals are stored in GtkListStore just as pointer,
+    /* Signals are stored in the model just as pointer,
        so set it to NULL before freeing the struct */
     net->signals = NULL;
     return new_network_found;
 }
 
+static void
+model_set_details(mtscan_store_t *store,
+                  GtkTreeIter    *iter,
+                  network_t      *net)
+{
+    mtscan_store_set_int(store, iter, COL_FREQUENCY, net->frequency);
+    mtscan_store_set_string(store, iter, COL_CHANNEL, (net->channel ? net->channel : ""));
+    mtscan_store_set_int(store, iter, COL_STREAMS, net->streams);
+    mtscan_store_set_string(store, iter, COL_MODE, (net->mode ? net->mode : ""));
+    mtscan_store_set_string(store, iter, COL_SSID, (net->ssid ? net->ssid : ""));
+    mtscan_store_set_string(store, iter, COL_RADIONAME, (net->radioname ? net->radioname : ""));
+    mtscan_store_set_int(store, iter, COL_PRIVACY, net->flags.privacy);
+    mtscan_store_set_int(store, iter, COL_ROUTEROS, net->flags.routeros);
+    mtscan_store_set_int(store, iter, COL_NSTREME, net->flags.nstreme);
+    mtscan_store_set_int(store, iter, COL_TDMA, net->flags.tdma);
+    mtscan_store_set_int(store, iter, COL_WDS, net->flags.wds);
+    mtscan_store_set_int(store, iter, COL_BRIDGE, net->flags.bridge);
+    mtscan_store_set_string(store, iter, COL_ROUTEROS_VER, (net->routeros_ver ? net->routeros_ver : ""));
+    mtscan_store_set_int(store, iter, COL_AIRMAX, net->ubnt_airmax);
+    mtscan_store_set_int(store, iter, COL_AIRMAX_AC_PTP, net->ubnt_ptp);
+    mtscan_store_set_int(store, iter, COL_AIRMAX_AC_PTMP, net->ubnt_ptmp);
+    mtscan_store_set_int(store, iter, COL_AIRMAX_AC_MIXED, net->ubnt_mixed);
+}
+
+static void
+model_set_position(mtscan_store_t *store,
+                   GtkTreeIter    *iter,
+                   network_t      *net)
+{
+    mtscan_store_set_double(store, iter, COL_LATITUDE, net->latitude);
+    mtscan_store_set_double(store, iter, COL_LONGITUDE, net->longitude);
+    mtscan_store_set_float(store, iter, COL_ALTITUDE, net->altitude);
+    mtscan_store_set_float(store, iter, COL_ACCURACY, net->accuracy);
+    mtscan_store_set_float(store, iter, COL_AZIMUTH, net->azimuth);
+}
+
+static void
+model_set_wps(mtscan_store_t *store,
+              GtkTreeIter    *iter,
+              network_t      *net)
+{
+    mtscan_store_set_int(store, iter, COL_WPS, net->wps);
+    mtscan_store_set_string(store, iter, COL_WPS_MANUFACTURER, net->wps_manufacturer);
+    mtscan_store_set_string(store, iter, COL_WPS_MODEL_NAME, net->wps_model_name);
+    mtscan_store_set_string(store, iter, COL_WPS_MODEL_NUMBER, net->wps_model_number);
+    mtscan_store_set_string(store, iter, COL_WPS_SERIAL_NUMBER, net->wps_serial_number);
+    mtscan_store_set_string(store, iter, COL_WPS_DEVICE_NAME, net->wps_device_name);
+}
+
 void
 mtscan_model_add(mtscan_model_t *model,
                  network_t      *net,
@@ -775,202 +669,287 @@ mtscan_model_add(mtscan_model_t *model,
 {
     GtkTreeIter *iter_merge;
     GtkTreeIter iter;
-    gint8 current_maxrssi;
-    gint current_wps;
-    gint64 current_firstseen;
-    gint64 current_lastseen;
-    signals_t *current_signals;
     gint64 *address;
 
     if(merge && (iter_merge = g_hash_table_lookup(model->map, &net->address)))
     {
-        /* Merge a network, check current values first */
-        gtk_tree_model_get(GTK_TREE_MODEL(model->store), iter_merge,
-                           COL_MAXRSSI, &current_maxrssi,
-                           COL_WPS, &current_wps,
-                           COL_FIRSTLOG, &current_firstseen,
-                           COL_LASTLOG, &current_lastseen,
-                           COL_SIGNALS, &current_signals,
-                           -1);
-
         /* Merge signal samples */
-        signals_merge(current_signals, net->signals);
+        if(model->merge)
+            model_merge_defer(model, net);
+        else
+            signals_merge(mtscan_store_get_pointer(model->store, iter_merge, COL_SIGNALS), net->signals);
 
         /* Update the first seen date, if required */
-        if(net->firstseen < current_firstseen)
-        {
-            gtk_list_store_set(model->store, iter_merge,
-                               COL_FIRSTLOG, net->firstseen,
-                               -1);
-        }
+        if(net->firstseen < mtscan_store_get_int64(model->store, iter_merge, COL_FIRSTLOG))
+            mtscan_store_set_int64(model->store, iter_merge, COL_FIRSTLOG, net->firstseen);
 
         /* Update the last seen date along with other values, if required */
-        if(net->lastseen > current_lastseen)
+        if(net->lastseen > mtscan_store_get_int64(model->store, iter_merge, COL_LASTLOG))
         {
-            gtk_list_store_set(model->store, iter_merge,
-                               COL_FREQUENCY, net->frequency,
-                               COL_CHANNEL, (net->channel ? net->channel : ""),
-                               COL_STREAMS, net->streams,
-                               COL_MODE, (net->mode ? net->mode : ""),
-                               COL_SSID, (net->ssid ? net->ssid : ""),
-                               COL_RADIONAME, (net->radioname ? net->radioname : ""),
-                               COL_PRIVACY, net->flags.privacy,
-                               COL_ROUTEROS, net->flags.routeros,
-                               COL_NSTREME, net->flags.nstreme,
-                               COL_TDMA, net->flags.tdma,
-                               COL_WDS, net->flags.wds,
-                               COL_BRIDGE, net->flags.bridge,
-                               COL_ROUTEROS_VER, (net->routeros_ver ? net->routeros_ver : ""),
-                               COL_AIRMAX, net->ubnt_airmax,
-                               COL_AIRMAX_AC_PTP, net->ubnt_ptp,
-                               COL_AIRMAX_AC_PTMP, net->ubnt_ptmp,
-                               COL_AIRMAX_AC_MIXED, net->ubnt_mixed,
-                               COL_LASTLOG, net->lastseen,
-                               COL_DISTANCE, NAN,
-                               -1);
+            model_set_details(model->store, iter_merge, net);
+            mtscan_store_set_int64(model->store, iter_merge, COL_LASTLOG, net->lastseen);
+            mtscan_store_set_float(model->store, iter_merge, COL_DISTANCE, NAN);
         }
 
         /* Update the max signal level together with its coordinates, if required */
-        if(net->rssi > current_maxrssi)
+        if(net->rssi > mtscan_store_get_int(model->store, iter_merge, COL_MAXRSSI))
         {
-            gtk_list_store_set(model->store, iter_merge,
-                               COL_MAXRSSI, net->rssi,
-                               COL_LATITUDE, net->latitude,
-                               COL_LONGITUDE, net->longitude,
-                               COL_ALTITUDE, net->altitude,
-                               COL_ACCURACY, net->accuracy,
-                               COL_AZIMUTH, net->azimuth,
-                               COL_DISTANCE, NAN,
-                               -1);
+            mtscan_store_set_int(model->store, iter_merge, COL_MAXRSSI, net->rssi);
+            model_set_position(model->store, iter_merge, net);
+            mtscan_store_set_float(model->store, iter_merge, COL_DISTANCE, NAN);
         }
 
-        if(net->wps >= current_wps)
-        {
-            gtk_list_store_set(model->store, iter_merge,
-                               COL_WPS, net->wps,
-                               COL_WPS_MANUFACTURER, net->wps_manufacturer,
-                               COL_WPS_MODEL_NAME, net->wps_model_name,
-                               COL_WPS_MODEL_NUMBER, net->wps_model_number,
-                               COL_WPS_SERIAL_NUMBER, net->wps_serial_number,
-                               COL_WPS_DEVICE_NAME, net->wps_device_name,
-                               -1);
-        }
+        if(net->wps >= mtscan_store_get_int(model->store, iter_merge, COL_WPS))
+            model_set_wps(model->store, iter_merge, net);
 
+        mtscan_store_changed(model->store, iter_merge);
     }
     else
     {
         /* Add a new network */
-        gtk_list_store_insert_with_values(model->store, &iter, -1,
-                                          COL_STATE, MODEL_STATE_INACTIVE,
-                                          COL_ADDRESS, net->address,
-                                          COL_FREQUENCY, net->frequency,
-                                          COL_CHANNEL, (net->channel ? net->channel : ""),
-                                          COL_STREAMS, net->streams,
-                                          COL_MODE, (net->mode ? net->mode : ""),
-                                          COL_SSID, (net->ssid ? net->ssid : ""),
-                                          COL_RADIONAME, (net->radioname ? net->radioname : ""),
-                                          COL_MAXRSSI, net->rssi,
-                                          COL_RSSI, MODEL_NO_SIGNAL,
-                                          COL_NOISE, net->noise,
-                                          COL_PRIVACY, net->flags.privacy,
-                                          COL_ROUTEROS, net->flags.routeros,
-                                          COL_NSTREME, net->flags.nstreme,
-                                          COL_TDMA, net->flags.tdma,
-                                          COL_WDS, net->flags.wds,
-                                          COL_BRIDGE, net->flags.bridge,
-                                          COL_ROUTEROS_VER, (net->routeros_ver ? net->routeros_ver : ""),
-                                          COL_AIRMAX, net->ubnt_airmax,
-                                          COL_AIRMAX_AC_PTP, net->ubnt_ptp,
-                                          COL_AIRMAX_AC_PTMP, net->ubnt_ptmp,
-                                          COL_AIRMAX_AC_MIXED, net->ubnt_mixed,
-                                          COL_WPS, net->wps,
-                                          COL_WPS_MANUFACTURER, net->wps_manufacturer,
-                                          COL_WPS_MODEL_NAME, net->wps_model_name,
-                                          COL_WPS_MODEL_NUMBER, net->wps_model_number,
-                                          COL_WPS_SERIAL_NUMBER, net->wps_serial_number,
-                                          COL_WPS_DEVICE_NAME, net->wps_device_name,
-                                          COL_FIRSTLOG, net->firstseen,
-                                          COL_LASTLOG, net->lastseen,
-                                          COL_LATITUDE, net->latitude,
-                                          COL_LONGITUDE, net->longitude,
-                                          COL_ALTITUDE, net->altitude,
-                                          COL_ACCURACY, net->accuracy,
-                                          COL_AZIMUTH, net->azimuth,
-                                          COL_DISTANCE, NAN,
-                                          COL_SIGNALS, net->signals,
-                                          -1);
+        mtscan_store_insert(model->store, &iter);
+        mtscan_store_set_int(model->store, &iter, COL_STATE, MODEL_STATE_INACTIVE);
+        mtscan_store_set_int64(model->store, &iter, COL_ADDRESS, net->address);
+        model_set_details(model->store, &iter, net);
+        mtscan_store_set_int(model->store, &iter, COL_MAXRSSI, net->rssi);
+        mtscan_store_set_int(model->store, &iter, COL_RSSI, MODEL_NO_SIGNAL);
+        mtscan_store_set_int(model->store, &iter, COL_NOISE, net->noise);
+        model_set_wps(model->store, &iter, net);
+        mtscan_store_set_int64(model->store, &iter, COL_FIRSTLOG, net->firstseen);
+        mtscan_store_set_int64(model->store, &iter, COL_LASTLOG, net->lastseen);
+        model_set_position(model->store, &iter, net);
+        mtscan_store_set_float(model->store, &iter, COL_DISTANCE, NAN);
+        mtscan_store_set_pointer(model->store, &iter, COL_SIGNALS, net->signals);
+        mtscan_store_changed(model->store, &iter);
 
         address = gint64dup(&net->address);
         g_hash_table_insert(model->map, address, gtk_tree_iter_copy(&iter));
 
-        /* Signals are stored in GtkListStore just as pointer,
+        /* Signals are stored in the model just as pointer,
            so set it to NULL before freeing the struct */
         net->signals = NULL;
     }
 }
 
+void
+mtscan_model_merge_begin(mtscan_model_t *model)
+{
+    /* Signal samples of merged networks are collected until mtscan_model_merge_end() */
+    if(!model->merge)
+        model->merge = g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free, (GDestroyNotify)g_ptr_array_unref);
+}
+
+void
+mtscan_model_merge_end(mtscan_model_t *model)
+{
+    if(!model->merge)
+        return;
+
+    g_hash_table_foreach(model->merge, model_merge_foreach, model);
+    g_hash_table_destroy(model->merge);
+    model->merge = NULL;
+}
+
+static void
+model_merge_defer(mtscan_model_t *model,
+                  network_t      *net)
+{
+    GPtrArray *pending;
+
+    if(!net->signals || !signals_count(net->signals))
+        return;
+
+    pending = g_hash_table_lookup(model->merge, &net->address);
+    if(!pending)
+    {
+        pending = g_ptr_array_new_with_free_func((GDestroyNotify)signals_free);
+        g_hash_table_insert(model->merge, gint64dup(&net->address), pending);
+    }
+
+    g_ptr_array_add(pending, net->signals);
+    net->signals = NULL;
+}
+
+static void
+model_merge_foreach(gpointer key,
+                    gpointer value,
+                    gpointer data)
+{
+    mtscan_model_t *model = (mtscan_model_t*)data;
+    GPtrArray *pending = (GPtrArray*)value;
+    GtkTreeIter *iter;
+
+    if((iter = g_hash_table_lookup(model->map, key)))
+    {
+        signals_merge_all(mtscan_store_get_pointer(model->store, iter, COL_SIGNALS),
+                          (signals_t**)pending->pdata,
+                          pending->len);
+    }
+}
+
 void
 mtscan_model_geoloc(mtscan_model_t *model,
                     gint64          addr)
 {
     GtkTreeIter *iter;
-    gchar *ssid;
-    gfloat azimuth;
     gfloat distance = NAN;
 
     if((iter = g_hash_table_lookup(model->map, &addr)))
     {
-
-        gtk_tree_model_get(GTK_TREE_MODEL(model->store), iter,
-                           COL_SSID, &ssid,
-                           COL_AZIMUTH, &azimuth,
-                           -1);
-
-        geoloc_match(addr, ssid, azimuth, FALSE, &distance);
-
-        gtk_list_store_set(model->store, iter,
-                           COL_DISTANCE, distance,
-                           -1);
-        g_free(ssid);
+        geoloc_match(addr,
+                     mtscan_store_get_string(model->store, iter, COL_SSID),
+                     mtscan_store_get_float(model->store, iter, COL_AZIMUTH),
+                     FALSE,
+                     &distance);
+
+        mtscan_store_set_float(model->store, iter, COL_DISTANCE, distance);
+        mtscan_store_changed(model->store, iter);
     }
 }
 
 void
 mtscan_model_geoloc_all(mtscan_model_t *model)
 {
-    /* Cannot use gtk_tree_model_foreach, because it is apparently not reliable with sorted models and modifications */
-    g_hash_table_foreach(model->map, mtscan_model_geoloc_foreach, model->store);
+    model_geoloc_job_t *job;
+    GThreadPool *pool;
+    GHashTableIter iter;
+    gpointer key;
+    gpointer value;
+    const gchar *ssid;
+    guint length;
+    guint count;
+    guint i;
+
+    if(model->geoloc_job)
+    {
+        /* Start again when the running job is done */
+        g_atomic_int_set(&model->geoloc_job->canceled, TRUE);
+        model->geoloc_again = TRUE;
+        return;
+    }
+
+    length = g_hash_table_size(model->map);
+    if(!length)
+        return;
+
+    /* Take a snapshot of the map, the rows may be changed
+       or removed while the distances are computed */
+    job = g_malloc(sizeof(model_geoloc_job_t));
+    job->model = model;
+    job->length = length;
+    job->items = g_new(model_geoloc_item_t, length);
+    job->strings = g_string_chunk_new(4096);
+    job->canceled = FALSE;
+
+    g_hash_table_iter_init(&iter, model->map);
+    for(i=0; g_hash_table_iter_next(&iter, &key, &value); i++)
+    {
+        ssid = mtscan_store_get_string(model->store, (GtkTreeIter*)value, COL_SSID);
+        job->items[i].address = *(gint64*)key;
+        job->items[i].ssid = (ssid ? g_string_chunk_insert_const(job->strings, ssid) : NULL);
+        job->items[i].azimuth = mtscan_store_get_float(model->store, (GtkTreeIter*)value, COL_AZIMUTH);
+        job->items[i].distance = NAN;
+    }
+
+    count = (length + MODEL_GEOLOC_CHUNK - 1) / MODEL_GEOLOC_CHUNK;
+    job->chunks = g_new(model_geoloc_chunk_t, count);
+    job->pending = (gint)count;
+    for(i=0; i<count; i++)
+    {
+        job->chunks[i].job = job;
+        job->chunks[i].items = job->items + i * MODEL_GEOLOC_CHUNK;
+        job->chunks[i].length = MIN(MODEL_GEOLOC_CHUNK, length - i * MODEL_GEOLOC_CHUNK);
+    }
+
+    model->geoloc_job = job;
+    geoloc_match_prepare();
+
+    /* The main loop is not blocked, results are applied from an idle callback */
+    pool = g_thread_pool_new(mtscan_model_geoloc_thread,
+                             NULL,
+                             (gint)MIN(count, MAX(g_get_num_processors(), 1)),
+                             TRUE,
+                             NULL);
+
+    for(i=0; i<count; i++)
+        g_thread_pool_push(pool, &job->chunks[i], NULL);
+
+    g_thread_pool_free(pool, FALSE, FALSE);
 }
 
 static void
-mtscan_model_geoloc_foreach(gpointer key,
-                            gpointer value,
-                            gpointer data)
+mtscan_model_geoloc_thread(gpointer data,
+                           gpointer user_data)
 {
-    GtkListStore *model = GTK_LIST_STORE(data);
-    GtkTreeIter *iter = (GtkTreeIter*)value;
-    gint64 address = *(gint64*)key;
-    gchar *ssid;
-    gfloat azimuth;
-    gfloat last_distance;
-    gfloat distance = NAN;
+    model_geoloc_chunk_t *chunk = (model_geoloc_chunk_t*)data;
+    model_geoloc_job_t *job = chunk->job;
+    model_geoloc_item_t *item;
+    guint i;
 
-    gtk_tree_model_get(GTK_TREE_MODEL(model), iter,
-                       COL_SSID, &ssid,
-                       COL_AZIMUTH, &azimuth,
-                       COL_DISTANCE, &last_distance,
-                       -1);
+    for(i=0; i<chunk->length && !g_atomic_int_get(&job->canceled); i++)
+    {
+        item = &chunk->items[i];
+        geoloc_match_shared(item->address,
+                            item->ssid,
+                            item->azimuth,
+                            &item->distance);
+    }
 
-    geoloc_match(address, ssid, azimuth, FALSE, &distance);
+    if(g_atomic_int_dec_and_test(&job->pending))
+        g_idle_add(mtscan_model_geoloc_apply, job);
+}
 
-    if(last_distance != distance)
+static gboolean
+mtscan_model_geoloc_apply(gpointer user_data)
+{
+    model_geoloc_job_t *job = (model_geoloc_job_t*)user_data;
+    mtscan_model_t *model = job->model;
+    model_geoloc_item_t *item;
+    GtkTreeIter *iter;
+    gfloat last_distance;
+    gboolean sorting;
+    guint i;
+
+    if(model)
     {
-        gtk_list_store_set(model, iter,
-                           COL_DISTANCE, distance,
-                          -1);
+        model->geoloc_job = NULL;
+        sorting = !model->disabled_sorting;
+
+        /* Apply only the changed distances */
+        for(i=0; i<job->length && !job->canceled; i++)
+        {
+            item = &job->items[i];
+            if(!(iter = g_hash_table_lookup(model->map, &item->address)))
+                continue;
+
+            last_distance = mtscan_store_get_float(model->store, iter, COL_DISTANCE);
+            if(isnan(last_distance) && isnan(item->distance))
+                continue;
+
+            if(last_distance != item->distance)
+            {
+                if(sorting && !model->disabled_sorting)
+                    mtscan_model_disable_sorting(model);
+                mtscan_store_set_float(model->store, iter, COL_DISTANCE, item->distance);
+                mtscan_store_changed(model->store, iter);
+            }
+        }
+
+        if(sorting)
+            mtscan_model_enable_sorting(model);
+
+        if(model->geoloc_again)
+        {
+            model->geoloc_again = FALSE;
+            mtscan_model_geoloc_all(model);
+        }
     }
 
-    g_free(ssid);
+    g_string_chunk_free(job->strings);
+    g_free(job->chunks);
+    g_free(job->items);
+    g_free(job);
+    return G_SOURCE_REMOVE;
 }
 
 void
@@ -1005,59 +984,6 @@ mtscan_model_enable_sorting(mtscan_model_t *model)
     }
 }
 
-const gchar*
-model_format_address(gint64   address,
-                     gboolean separated)
-{
-    static gchar str[18];
-
-    if(!separated)
-    {
-        g_snprintf(str, sizeof(str), "%012" G_GINT64_MODIFIER "X", address);
-    }
-    else
-    {
-        g_snprintf(str, sizeof(str),
-                   "%02X:%02X:%02X:%02X:%02X:%02X",
-                   (gint)((address >> 40) & 0xFF),
-                   (gint)((address >> 32) & 0xFF),
-                   (gint)((address >> 24) & 0xFF),
-                   (gint)((address >> 16) & 0xFF),
-                   (gint)((address >>  8) & 0xFF),
-                   (gint)((address      ) & 0xFF));
-    }
-    return str;
-}
-
-const gchar*
-model_format_frequency(gint value)
-{
-    static gchar output[9];
-    gint frac, i;
-
-    if((frac = value % 1000))
-    {
-        g_snprintf(output, sizeof(output), "%d.%03d", value/1000, frac);
-        for(i=strlen(output)-1; i>=0 && output[i] == '0'; i--);
-        output[i+1] = '\0';
-        return output;
-    }
-
-    g_snprintf(output, sizeof(output), "%d", value/1000);
-    return output;
-}
-
-const gchar*
-model_format_streams(gint8 value)
-{
-    static gchar output[10];
-    if(value > 0)
-        g_snprintf(output, sizeof(output), "%d", value);
-    else
-        output[0] = '\0';
-    return output;
-}
-
 const gchar*
 model_format_date(gint64 value)
 {
@@ -1111,86 +1037,6 @@ model_format_date(gint64 value)
     return output;
 }
 
-const gchar*
-model_format_latitude(gdouble  value,
-                      gboolean trim)
-{
-    static gchar output[12];
-    if (!isnan(value))
-    {
-        g_ascii_formatd(output, sizeof(output), "%.6f", value);
-        if(trim)
-            trim_zeros(output);
-    }
-    else
-    {
-        *output = '\0';
-    }
-    return output;
-}
-
-const gchar*
-model_format_longitude(gdouble  value,
-                       gboolean trim)
-{
-    static gchar output[12];
-    if (!isnan(value))
-    {
-        g_ascii_formatd(output, sizeof(output), "%.6f", value);
-        if(trim)
-            trim_zeros(output);
-    }
-    else
-    {
-        *output = '\0';
-    }
-    return output;
-}
-
-const gchar*
-model_format_altitude(gfloat value)
-{
-    static gchar output[12];
-
-    if (!isnan(value))
-        g_snprintf(output, sizeof(output), "%d", (int)round(value));
-    else
-        *output = '\0';
-
-    return output;
-}
-
-const gchar*
-model_format_accuracy(gfloat value)
-{
-    static gchar output[12];
-
-    if (!isnan(value))
-        g_snprintf(output, sizeof(output), "%d", (int)round(value));
-    else
-        *output = '\0';
-
-    return output;
-}
-
-const gchar*
-model_format_azimuth(gfloat   value,
-                     gboolean trim)
-{
-    static gchar output[12];
-    if(!isnan(value))
-    {
-        g_ascii_formatd(output, sizeof(output), "%.2f", value);
-        if(trim)
-            trim_zeros(output);
-    }
-    else
-    {
-        *output = '\0';
-    }
-    return output;
-}
-
 const gchar*
 model_format_distance(gfloat value)
 {
@@ -1205,14 +1051,3 @@ model_format_distance(gfloat value)
 
     return output;
 }
-
-
-static void
-trim_zeros(gchar *string)
-{
-    gint i;
-    for(i=strlen(string)-1; i>=0 && string[i] == '0'; i--);
-    if(i >= 0 && string[i] == '.')
-        i++;
-    string[i+1] = '\0';
-}
@@ -18,8 +18,12 @@
 #include <gtk/gtk.h>
 #include "network.h"
 #include "geoloc.h"
+#include "model-store.h"
+#include "model-format.h"
+#include "journal.h"
+#include "log.h"
 
-#define MODEL_NO_SIGNAL G_MININT8
+#define MODEL_NO_SIGNAL NETWORK_NO_SIGNAL
 
 #define MODEL_DEFAULT_ACTIVE_TIMEOUT 8
 #define MODEL_DEFAULT_NEW_TIMEOUT    2
@@ -44,7 +48,7 @@ enum
 
 typedef struct mtscan_model
 {
-    GtkListStore *store;
+    mtscan_store_t *store;
     GHashTable *map;
     GHashTable *active;
     gint active_timeout;
@@ -53,8 +57,12 @@ typedef struct mtscan_model
     gint last_sort_column;
     GtkSortType last_sort_order;
     GSList *buffer;
+    GHashTable *merge;
+    journal_t *journal;
     gboolean clear_active_all;
     gboolean clear_active_changed;
+    struct model_geoloc_job *geoloc_job;
+    gboolean geoloc_again;
 } mtscan_model_t;
 
 enum
@@ -104,6 +112,8 @@ void mtscan_model_free(mtscan_model_t*);
 void mtscan_model_clear(mtscan_model_t*);
 void mtscan_model_clear_active(mtscan_model_t*);
 void mtscan_model_get(mtscan_model_t*, GtkTreeIter*, network_t*);
+log_snapshot_t* mtscan_model_snapshot(mtscan_model_t*, GList*, gboolean);
+void mtscan_model_snapshot_free(mtscan_model_t*, log_snapshot_t*);
 void mtscan_model_remove(mtscan_model_t*, GtkTreeIter*);
 
 void mtscan_model_buffer_add(mtscan_model_t*, network_t*);
@@ -111,6 +121,8 @@ void mtscan_model_buffer_clear(mtscan_model_t*);
 gint mtscan_model_buffer_and_inactive_update(mtscan_model_t*);
 
 void mtscan_model_add(mtscan_model_t*, network_t*, gboolean);
+void mtscan_model_merge_begin(mtscan_model_t*);
+void mtscan_model_merge_end(mtscan_model_t*);
 
 void mtscan_model_geoloc(mtscan_model_t*, gint64);
 void mtscan_model_geoloc_all(mtscan_model_t*);
@@ -121,15 +133,7 @@ void mtscan_model_set_new_timeout(mtscan_model_t*, gint);
 void mtscan_model_disable_sorting(mtscan_model_t*);
 void mtscan_model_enable_sorting(mtscan_model_t*);
 
-const gchar* model_format_address(gint64, gboolean);
-const gchar* model_format_frequency(gint);
-const gchar* model_format_streams(gint8);
 const gchar* model_format_date(gint64);
-const gchar* model_format_latitude(gdouble, gboolean);
-const gchar* model_format_longitude(gdouble, gboolean);
-const gchar* model_format_altitude(gfloat);
-const gchar* model_format_accuracy(gfloat);
-const gchar* model_format_azimuth(gfloat, gboolean);
 const gchar* model_format_distance(gfloat);
 
 #endif
@@ -0,0 +1,758 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <openssl/ssl.h>
+#include "mt-api.h"
+#ifdef G_OS_WIN32
+#include <winsock2.h>
+#include <windows.h>
+#include <ws2tcpip.h>
+#include "win32.h"
+#define MSG_NOSIGNAL 0
+typedef SOCKET mt_api_socket_t;
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#define INVALID_SOCKET -1
+#define closesocket close
+typedef int mt_api_socket_t;
+#endif
+
+#define DEBUG 0
+
+#define MT_API_BUFFER_LEN       4096
+#define MT_API_TIMEOUT_SEC        30
+#define MT_API_CONNECT_POLL_MSEC 100
+
+typedef struct mt_api_word
+{
+    guint offset;
+    guint length;
+} mt_api_word_t;
+
+/* Single sentence, valid until the next read. Words are stored
+   in one buffer and terminated with a null character. */
+typedef struct mt_api_reply
+{
+    mt_api_reply_type_t  type;
+    GString             *data;
+    GArray              *words;
+} mt_api_reply_t;
+
+typedef struct mt_api
+{
+    mt_api_socket_t  fd;
+    gboolean         use_ssl;
+    SSL_CTX         *ssl_ctx;
+    SSL             *ssl;
+    BIO             *ssl_rbio;
+    BIO             *ssl_wbio;
+    guint            tag;
+    GByteArray      *rx;
+    gsize            rx_pos;
+    GByteArray      *tx;
+    mt_api_reply_t   reply;
+    gboolean         reply_complete;
+} mt_api_t;
+
+static gint     mt_api_connect_socket(mt_api_t*, const struct addrinfo*, const volatile gboolean*);
+static gboolean mt_api_set_blocking(mt_api_socket_t, gboolean);
+static gint     mt_api_wait(mt_api_t*, gint64);
+static gboolean mt_api_receive(mt_api_t*);
+static gboolean mt_api_send(mt_api_t*);
+static gboolean mt_api_send_raw(mt_api_t*, const guint8*, gsize);
+static gboolean mt_api_ssl_connect(mt_api_t*);
+static gboolean mt_api_ssl_flush(mt_api_t*);
+static void     mt_api_encode(GByteArray*, const gchar*, gsize);
+static gint     mt_api_decode(const guint8*, gsize, guint32*);
+static gboolean mt_api_parse(mt_api_t*);
+static gboolean mt_api_login_legacy(mt_api_t*, const gchar*, const gchar*, const gchar*);
+
+
+mt_api_t*
+mt_api_new(gboolean use_ssl)
+{
+    mt_api_t *context;
+
+    context = g_malloc0(sizeof(mt_api_t));
+    context->fd = INVALID_SOCKET;
+    context->use_ssl = use_ssl;
+    context->rx = g_byte_array_sized_new(MT_API_BUFFER_LEN);
+    context->tx = g_byte_array_sized_new(MT_API_BUFFER_LEN);
+    context->reply.data = g_string_sized_new(MT_API_BUFFER_LEN);
+    context->reply.words = g_array_new(FALSE, FALSE, sizeof(mt_api_word_t));
+    return context;
+}
+
+void
+mt_api_free(mt_api_t *context)
+{
+    if(context)
+    {
+        if(context->ssl)
+            SSL_free(context->ssl);
+        if(context->ssl_ctx)
+            SSL_CTX_free(context->ssl_ctx);
+        if(context->fd != INVALID_SOCKET)
+            closesocket(context->fd);
+
+        g_byte_array_free(context->rx, TRUE);
+        g_byte_array_free(context->tx, TRUE);
+        g_string_free(context->reply.data, TRUE);
+        g_array_free(context->reply.words, TRUE);
+        g_free(context);
+    }
+}
+
+gboolean
+mt_api_connect(mt_api_t                *context,
+               const gchar             *hostname,
+               const gchar             *port,
+               const volatile gboolean *canceled,
+               gchar                  **error)
+{
+    struct addrinfo hints = {0};
+    struct addrinfo *result;
+    struct addrinfo *rp;
+    gint ret = 0;
+
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+
+    if((ret = getaddrinfo(hostname, port, &hints, &result)))
+    {
+        *error = g_strdup(gai_strerror(ret));
+        return FALSE;
+    }
+
+    for(rp = result; rp && !(canceled && *canceled); rp = rp->ai_next)
+    {
+        if((ret = mt_api_connect_socket(context, rp, canceled)) > 0)
+            break;
+    }
+    freeaddrinfo(result);
+
+    if(context->fd == INVALID_SOCKET)
+    {
+        if(ret < 0)
+            *error = g_strdup_printf("Connection to %s:%s timed out", hostname, port);
+        else
+            *error = g_strdup_printf("Unable to connect to %s:%s", hostname, port);
+        return FALSE;
+    }
+
+    if(context->use_ssl &&
+       !mt_api_ssl_connect(context))
+    {
+        *error = g_strdup_printf("SSL handshake with %s:%s failed", hostname, port);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+gint
+mt_api_get_fd(const mt_api_t *context)
+{
+    return (gint)context->fd;
+}
+
+gboolean
+mt_api_login(mt_api_t    *context,
+             const gchar *login,
+             const gchar *password)
+{
+    const mt_api_reply_t *reply;
+    gchar *name;
+    gchar *pass;
+    guint ret;
+
+    name = g_strdup_printf("=name=%s", login);
+    pass = g_strdup_printf("=password=%s", password);
+    ret = mt_api_write(context, "/login", name, pass, NULL);
+    g_free(name);
+    g_free(pass);
+
+    if(!ret || mt_api_read(context, MT_API_TIMEOUT_SEC * 1000, &reply) != MT_API_OK)
+        return FALSE;
+
+    if(mt_api_reply_get_type(reply) != MT_API_REPLY_DONE)
+        return FALSE;
+
+    /* Pre v6.43 replies with a challenge */
+    if(mt_api_reply_get(reply, "ret", NULL))
+        return mt_api_login_legacy(context, login, password, mt_api_reply_get(reply, "ret", NULL));
+
+    return TRUE;
+}
+
+guint
+mt_api_write(mt_api_t    *context,
+             const gchar *command,
+             ...)
+{
+    /* Every command is tagged, so its replies can be told apart */
+    const gchar *word;
+    gchar tag[16];
+    va_list args;
+    gint len;
+
+    g_byte_array_set_size(context->tx, 0);
+    mt_api_encode(context->tx, command, strlen(command));
+
+    va_start(args, command);
+    while((word = va_arg(args, const gchar*)))
+        mt_api_encode(context->tx, word, strlen(word));
+    va_end(args);
+
+    if(!++context->tag)
+        context->tag = 1;
+    len = g_snprintf(tag, sizeof(tag), ".tag=%u", context->tag);
+    mt_api_encode(context->tx, tag, len);
+
+    /* Empty word ends the sentence */
+    mt_api_encode(context->tx, NULL, 0);
+
+#if DEBUG
+    printf("<api> %s (%u)\n", command, context->tag);
+#endif
+    return mt_api_send(context) ? context->tag : 0;
+}
+
+mt_api_ret_t
+mt_api_read(mt_api_t              *context,
+            gint                   timeout,
+            const mt_api_reply_t **reply)
+{
+    gint64 deadline;
+    gint64 left;
+    gint n;
+
+    deadline = g_get_monotonic_time() + (gint64)timeout * 1000;
+
+    while(!mt_api_parse(context))
+    {
+        left = deadline - g_get_monotonic_time();
+        if(left <= 0)
+            return MT_API_TIMEOUT;
+
+        n = mt_api_wait(context, left);
+        if(n < 0)
+            return MT_API_ERROR;
+        if(n == 0)
+            return MT_API_TIMEOUT;
+
+        if(!mt_api_receive(context))
+            return MT_API_ERROR;
+    }
+
+    *reply = &context->reply;
+    return MT_API_OK;
+}
+
+mt_api_reply_type_t
+mt_api_reply_get_type(const mt_api_reply_t *reply)
+{
+    return reply->type;
+}
+
+guint
+mt_api_reply_get_tag(const mt_api_reply_t *reply)
+{
+    static const gchar str_tag[] = ".tag=";
+    const mt_api_word_t *word;
+    const gchar *str;
+    guint i;
+
+    for(i=1; i<reply->words->len; i++)
+    {
+        word = &g_array_index(reply->words, mt_api_word_t, i);
+        str = reply->data->str + word->offset;
+        if(!strncmp(str, str_tag, strlen(str_tag)))
+            return (guint)strtoul(str + strlen(str_tag), NULL, 10);
+    }
+    return 0;
+}
+
+const gchar*
+mt_api_reply_get(const mt_api_reply_t *reply,
+                 const gchar          *key,
+                 gsize                *length)
+{
+    const mt_api_word_t *word;
+    const gchar *str;
+    gsize key_len = strlen(key);
+    guint i;
+
+    /* Attribute words have the form of =key=value */
+    for(i=1; i<reply->words->len; i++)
+    {
+        word = &g_array_index(reply->words, mt_api_word_t, i);
+        str = reply->data->str + word->offset;
+        if(word->length > key_len + 1 &&
+           str[0] == '=' &&
+           str[key_len+1] == '=' &&
+           !strncmp(str+1, key, key_len))
+        {
+            if(length)
+                *length = word->length - key_len - 2;
+            return str + key_len + 2;
+        }
+    }
+    return NULL;
+}
+
+static gint
+mt_api_connect_socket(mt_api_t                *context,
+                      const struct addrinfo   *rp,
+                      const volatile gboolean *canceled)
+{
+    /* Returns 1 when connected, 0 on failure or cancel, -1 on timeout */
+    struct timeval tv;
+    fd_set output;
+    fd_set except;
+    gint64 deadline;
+    gint64 left;
+    socklen_t len;
+    gint error = 0;
+    gint ret = 0;
+    gint n;
+
+    context->fd = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
+    if(context->fd == INVALID_SOCKET)
+        return 0;
+
+    /* The socket is non-blocking only for the connect, with the same timeout as the SSH transport */
+    if(!mt_api_set_blocking(context->fd, FALSE))
+        goto cleanup;
+
+    if(connect(context->fd, rp->ai_addr, rp->ai_addrlen) == 0)
+    {
+        ret = 1;
+        goto cleanup;
+    }
+
+#ifdef G_OS_WIN32
+    if(WSAGetLastError() != WSAEWOULDBLOCK)
+#else
+    if(errno != EINPROGRESS)
+#endif
+        goto cleanup;
+
+    deadline = g_get_monotonic_time() + (gint64)MT_API_TIMEOUT_SEC * G_USEC_PER_SEC;
+    while(TRUE)
+    {
+        if(canceled && *canceled)
+            goto cleanup;
+
+        left = deadline - g_get_monotonic_time();
+        if(left <= 0)
+        {
+            ret = -1;
+            goto cleanup;
+        }
+
+        /* Wake up periodically to check the cancel flag */
+        left = MIN(left, MT_API_CONNECT_POLL_MSEC * 1000);
+        tv.tv_sec = left / G_USEC_PER_SEC;
+        tv.tv_usec = left % G_USEC_PER_SEC;
+        FD_ZERO(&output);
+        FD_ZERO(&except);
+        FD_SET(context->fd, &output);
+        FD_SET(context->fd, &except);
+
+        /* Windows reports a failed connect in the exception set */
+        n = select(context->fd+1, NULL, &output, &except, &tv);
+        if(n > 0)
+            break;
+#ifndef G_OS_WIN32
+        if(n < 0 && errno == EINTR)
+            continue;
+#endif
+        if(n < 0)
+            goto cleanup;
+    }
+
+    len = sizeof(error);
+    if(getsockopt(context->fd, SOL_SOCKET, SO_ERROR, (gchar*)&error, &len) == 0 && !error)
+        ret = 1;
+
+cleanup:
+    if(ret > 0 && mt_api_set_blocking(context->fd, TRUE))
+        return 1;
+
+    closesocket(context->fd);
+    context->fd = INVALID_SOCKET;
+    return (ret < 0 ? -1 : 0);
+}
+
+static gboolean
+mt_api_set_blocking(mt_api_socket_t fd,
+                    gboolean        blocking)
+{
+#ifdef G_OS_WIN32
+    u_long mode = !blocking;
+    return (ioctlsocket(fd, FIONBIO, &mode) == 0);
+#else
+    gint flags = fcntl(fd, F_GETFL, 0);
+    if(flags < 0)
+        return FALSE;
+    flags = (blocking ? flags & ~O_NONBLOCK : flags | O_NONBLOCK);
+    return (fcntl(fd, F_SETFL, flags) == 0);
+#endif
+}
+
+static gint
+mt_api_wait(mt_api_t *context,
+            gint64    timeout)
+{
+    struct timeval tv;
+    fd_set input;
+
+    tv.tv_sec = timeout / G_USEC_PER_SEC;
+    tv.tv_usec = timeout % G_USEC_PER_SEC;
+    FD_ZERO(&input);
+    FD_SET(context->fd, &input);
+    return select(context->fd+1, &input, NULL, NULL, &tv);
+}
+
+static gboolean
+mt_api_receive(mt_api_t *context)
+{
+    guint8 buffer[MT_API_BUFFER_LEN];
+    gint n;
+
+    n = recv(context->fd, (gchar*)buffer, sizeof(buffer), 0);
+    if(n <= 0)
+        return FALSE;
+
+    /* Drop the sentences consumed by mt_api_parse before the buffer grows */
+    if(context->rx_pos)
+    {
+        g_byte_array_remove_range(context->rx, 0, context->rx_pos);
+        context->rx_pos = 0;
+    }
+
+    if(!context->ssl)
+    {
+        g_byte_array_append(context->rx, buffer, n);
+        return TRUE;
+    }
+
+    /* Decrypt all complete records, the rest waits for more data */
+    BIO_write(context->ssl_rbio, buffer, n);
+    while((n = SSL_read(context->ssl, buffer, sizeof(buffer))) > 0)
+        g_byte_array_append(context->rx, buffer, n);
+
+    if(SSL_get_error(context->ssl, n) != SSL_ERROR_WANT_READ)
+        return FALSE;
+
+    /* Post-handshake messages may need a response */
+    return mt_api_ssl_flush(context);
+}
+
+static gboolean
+mt_api_send(mt_api_t *context)
+{
+    if(!context->ssl)
+        return mt_api_send_raw(context, context->tx->data, context->tx->len);
+
+    if(SSL_write(context->ssl, context->tx->data, context->tx->len) <= 0)
+        return FALSE;
+
+    return mt_api_ssl_flush(context);
+}
+
+static gboolean
+mt_api_send_raw(mt_api_t     *context,
+                const guint8 *ptr,
+                gsize         left)
+{
+    gint n;
+
+    while(left)
+    {
+        n = send(context->fd, (const gchar*)ptr, left, MSG_NOSIGNAL);
+        if(n <= 0)
+            return FALSE;
+        ptr += n;
+        left -= n;
+    }
+    return TRUE;
+}
+
+static gboolean
+mt_api_ssl_connect(mt_api_t *context)
+{
+    /* The socket is not passed to OpenSSL, all transfers
+       go through mt_api_receive and mt_api_send_raw */
+    BIO *rbio;
+    BIO *wbio;
+    SSL *ssl;
+    gint ret;
+
+    if(!(context->ssl_ctx = SSL_CTX_new(TLS_client_method())))
+        return FALSE;
+
+    /* RouterOS without a certificate offers anonymous DH only,
+       the certificate is not verified in either case */
+    SSL_CTX_set_cipher_list(context->ssl_ctx, "ALL:@SECLEVEL=0");
+
+    rbio = BIO_new(BIO_s_mem());
+    wbio = BIO_new(BIO_s_mem());
+    if(!rbio || !wbio || !(ssl = SSL_new(context->ssl_ctx)))
+    {
+        BIO_free(rbio);
+        BIO_free(wbio);
+        return FALSE;
+    }
+
+    /* Empty read buffer means there is no data yet, not EOF */
+    BIO_set_mem_eof_return(rbio, -1);
+    SSL_set_bio(ssl, rbio, wbio);
+    SSL_set_connect_state(ssl);
+    context->ssl = ssl;
+    context->ssl_rbio = rbio;
+    context->ssl_wbio = wbio;
+
+    ret = SSL_do_handshake(ssl);
+    if(ret != 1 && SSL_get_error(ssl, ret) != SSL_ERROR_WANT_READ)
+        return FALSE;
+
+    if(!mt_api_ssl_flush(context))
+        return FALSE;
+
+    /* SSL_read in mt_api_receive continues the handshake */
+    while(!SSL_is_init_finished(ssl))
+    {
+        if(mt_api_wait(context, (gint64)MT_API_TIMEOUT_SEC * G_USEC_PER_SEC) <= 0 ||
+           !mt_api_receive(context))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+static gboolean
+mt_api_ssl_flush(mt_api_t *context)
+{
+    guint8 buffer[MT_API_BUFFER_LEN];
+    gint n;
+
+    while((n = BIO_read(context->ssl_wbio, buffer, sizeof(buffer))) > 0)
+    {
+        if(!mt_api_send_raw(context, buffer, n))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+static void
+mt_api_encode(GByteArray  *buffer,
+              const gchar *word,
+              gsize        length)
+{
+    guint8 prefix[5];
+    gint n;
+
+    if(length < 0x80)
+    {
+        prefix[0] = length;
+        n = 1;
+    }
+    else if(length < 0x4000)
+    {
+        prefix[0] = (length >> 8) | 0x80;
+        prefix[1] = length;
+        n = 2;
+    }
+    else if(length < 0x200000)
+    {
+        prefix[0] = (length >> 16) | 0xC0;
+        prefix[1] = length >> 8;
+        prefix[2] = length;
+        n = 3;
+    }
+    else if(length < 0x10000000)
+    {
+        prefix[0] = (length >> 24) | 0xE0;
+        prefix[1] = length >> 16;
+        prefix[2] = length >> 8;
+        prefix[3] = length;
+        n = 4;
+    }
+    else
+    {
+        prefix[0] = 0xF0;
+        prefix[1] = length >> 24;
+        prefix[2] = length >> 16;
+        prefix[3] = length >> 8;
+        prefix[4] = length;
+        n = 5;
+    }
+
+    g_byte_array_append(buffer, prefix, n);
+    if(length)
+        g_byte_array_append(buffer, (const guint8*)word, length);
+}
+
+static gint
+mt_api_decode(const guint8 *buff,
+              gsize         len,
+              guint32      *length)
+{
+    gint n, i;
+
+    if(!len)
+        return 0;
+
+    if(!(buff[0] & 0x80))
+        n = 1;
+    else if((buff[0] & 0xC0) == 0x80)
+        n = 2;
+    else if((buff[0] & 0xE0) == 0xC0)
+        n = 3;
+    else if((buff[0] & 0xF0) == 0xE0)
+        n = 4;
+    else
+        n = 5;
+
+    if(len < (gsize)n)
+        return 0;
+
+    *length = (n == 5) ? 0 : buff[0] & (0xFF >> n);
+    for(i=1; i<n; i++)
+        *length = (*length << 8) | buff[i];
+
+    return n;
+}
+
+static gboolean
+mt_api_parse(mt_api_t *context)
+{
+    /* Reads a single sentence from the receive buffer, if complete.
+       Words of a partial sentence are kept in the reply and consumed,
+       so that only new data is decoded on the next call. */
+    static const gchar *str_replies[] = { "!re", "!done", "!trap", "!fatal" };
+    mt_api_reply_t *reply = &context->reply;
+    const guint8 *buff = context->rx->data;
+    gsize len = context->rx->len;
+    mt_api_word_t word;
+    gsize pos = context->rx_pos;
+    guint32 length;
+    gint n;
+    guint i;
+
+    if(context->reply_complete)
+    {
+        g_string_truncate(reply->data, 0);
+        g_array_set_size(reply->words, 0);
+        context->reply_complete = FALSE;
+    }
+
+    while(TRUE)
+    {
+        if(!(n = mt_api_decode(buff + pos, len - pos, &length)) ||
+           len - pos - n < length)
+        {
+            context->rx_pos = pos;
+            return FALSE;
+        }
+
+        pos += n;
+        if(!length)
+            break;
+
+        word.offset = reply->data->len;
+        word.length = length;
+        g_string_append_len(reply->data, (const gchar*)buff + pos, length);
+        g_string_append_c(reply->data, '\0');
+        g_array_append_val(reply->words, word);
+        pos += length;
+    }
+
+    context->rx_pos = pos;
+    context->reply_complete = TRUE;
+
+    reply->type = MT_API_REPLY_UNKNOWN;
+    if(reply->words->len)
+    {
+        for(i=0; i<G_N_ELEMENTS(str_replies); i++)
+        {
+            if(!strcmp(reply->data->str, str_replies[i]))
+            {
+                reply->type = MT_API_REPLY_RE + i;
+                break;
+            }
+        }
+    }
+
+#if DEBUG
+    printf("<api> reply %s (%u words)\n", (reply->words->len ? reply->data->str : ""), reply->words->len);
+#endif
+    return TRUE;
+}
+
+static gboolean
+mt_api_login_legacy(mt_api_t    *context,
+                    const gchar *login,
+                    const gchar *password,
+                    const gchar *challenge)
+{
+    const mt_api_reply_t *reply;
+    GChecksum *checksum;
+    guint8 byte;
+    gchar *name;
+    gchar *response;
+    guint ret;
+    gsize len;
+    gint i;
+
+    /* response = 00 + md5(0x00 + password + challenge) */
+    checksum = g_checksum_new(G_CHECKSUM_MD5);
+    byte = 0;
+    g_checksum_update(checksum, &byte, 1);
+    g_checksum_update(checksum, (const guchar*)password, strlen(password));
+
+    len = strlen(challenge);
+    for(i=0; i+1<(gint)len; i+=2)
+    {
+        byte = (g_ascii_xdigit_value(challenge[i]) << 4) | g_ascii_xdigit_value(challenge[i+1]);
+        g_checksum_update(checksum, &byte, 1);
+    }
+
+    name = g_strdup_printf("=name=%s", login);
+    response = g_strdup_printf("=response=00%s", g_checksum_get_string(checksum));
+    g_checksum_free(checksum);
+
+    ret = mt_api_write(context, "/login", name, response, NULL);
+    g_free(name);
+    g_free(response);
+
+    if(!ret || mt_api_read(context, MT_API_TIMEOUT_SEC * 1000, &reply) != MT_API_OK)
+        return FALSE;
+
+    return (mt_api_reply_get_type(reply) == MT_API_REPLY_DONE);
+}
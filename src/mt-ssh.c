@@ -21,6 +21,7 @@
 #include <errno.h>
 #include <libssh/libssh.h>
 #include "mt-ssh.h"
+#include "mt-api.h"
 #ifdef G_OS_WIN32
 #include <mstcpip.h>
 #include "win32.h"
@@ -45,11 +46,14 @@
 #define PTY_ROWS               300
 #define SOCKET_BUFFER  PTY_COLS*20
 #define READ_TIMEOUT_MSEC      100
+#define API_TIMEOUT_MSEC     30000
+#define API_HEARTBEAT_MSEC    1000
 
 #define DEBUG    0
 #define DUMP_PTY 0
 
 #define MAC_ADDR_HEX_LEN 12
+#define MAC_ADDR_STR_LEN 17
 
 typedef struct mt_ssh_shdr
 {
@@ -57,6 +61,7 @@ typedef struct mt_ssh_shdr
     guint    ssid;
     guint    ssid_len;
     guint    channel;
+    guint    freq;          /* pre v6.30 */
     guint    band;          /* pre v6.30 */
     guint    channel_width; /* pre v6.30 */
     guint    rssi;
@@ -69,6 +74,14 @@ typedef struct mt_ssh_shdr
     guint    routeros_ver_len;
 } mt_ssh_shdr_t;
 
+typedef struct mt_ssh_shdr_column
+{
+    const gchar *title;
+    gsize        title_len;
+    glong        position;
+    glong        length;
+} mt_ssh_shdr_column_t;
+
 typedef struct mt_ssh_cmd
 {
     mt_ssh_cmd_type_t  type;
@@ -90,19 +103,27 @@ typedef struct mt_ssh_info
 
 typedef struct mt_ssh_net
 {
-    gint64  timestamp;
-    gint64  address;
-    guint8  flags;
-    gint    frequency;
-    gchar  *channel;
-    gchar  *mode;
-    gchar  *ssid;
-    gchar  *radioname;
-    gint8   rssi;
-    gint8   noise;
-    gchar  *routeros_ver;
+    gint64       timestamp;
+    gint64       address;
+    guint8       flags;
+    gint         frequency;
+    const gchar *channel;
+    const gchar *mode;
+    const gchar *ssid;
+    const gchar *radioname;
+    gint8        rssi;
+    gint8        noise;
+    const gchar *routeros_ver;
 } mt_ssh_net_t;
 
+/* Networks of a single scan frame. Channel and mode strings
+   are interned, other strings are stored in the chunk. */
+typedef struct mt_ssh_batch
+{
+    GArray       *nets;
+    GStringChunk *strings;
+} mt_ssh_batch_t;
+
 typedef struct mt_ssh_snf
 {
     gint processed_packets;
@@ -122,6 +143,7 @@ typedef struct mt_ssh
     gchar        *name;
     gchar        *hostname;
     gchar        *port;
+    mt_ssh_transport_t transport;
     gchar        *login;
     gchar        *password;
     gchar        *iface;
@@ -146,6 +168,10 @@ typedef struct mt_ssh
 
     /* Private data */
     ssh_channel    channel;
+    mt_api_t      *api_session;
+    guint          api_tag;
+    gint           api_section;
+    gint64         api_heartbeat_ts;
     gboolean       verify_auth;
     gchar         *identity;
     gint64         hwaddr;
@@ -163,6 +189,7 @@ typedef struct mt_ssh
     gint           dispatch_mode;
     GString       *string_buff;
     mt_ssh_shdr_t *scan_header;
+    mt_ssh_batch_t *scan_batch;
     gint           scan_line;
     gboolean       scan_too_long;
     mt_ssh_snf_t  *sniffer;
@@ -214,14 +241,32 @@ static const gchar *str_states[] =
 static const gchar str_prompt_start[] = "\x1b[9999B[";
 static const gchar str_prompt_end[]   = "] > ";
 
+#define MT_SSH_SHDR_COLUMN(title, position, length) { title, sizeof(title)-1, position, length }
+
+/* Columns of the scan header, matched by the title prefix */
+static const mt_ssh_shdr_column_t scan_columns[] =
+{
+    MT_SSH_SHDR_COLUMN("ADDRESS", G_STRUCT_OFFSET(mt_ssh_shdr_t, address), -1),
+    MT_SSH_SHDR_COLUMN("SSID", G_STRUCT_OFFSET(mt_ssh_shdr_t, ssid), G_STRUCT_OFFSET(mt_ssh_shdr_t, ssid_len)),
+    MT_SSH_SHDR_COLUMN("RADIO-NAME", G_STRUCT_OFFSET(mt_ssh_shdr_t, radioname), G_STRUCT_OFFSET(mt_ssh_shdr_t, radioname_len)),
+    MT_SSH_SHDR_COLUMN("ROUTEROS-VER", G_STRUCT_OFFSET(mt_ssh_shdr_t, routeros_ver), G_STRUCT_OFFSET(mt_ssh_shdr_t, routeros_ver_len)),
+    MT_SSH_SHDR_COLUMN("SIG", G_STRUCT_OFFSET(mt_ssh_shdr_t, rssi), -1),
+    MT_SSH_SHDR_COLUMN("NF", G_STRUCT_OFFSET(mt_ssh_shdr_t, noise), -1),
+    MT_SSH_SHDR_COLUMN("SNR", G_STRUCT_OFFSET(mt_ssh_shdr_t, snr), -1),
+    MT_SSH_SHDR_COLUMN("FREQ", G_STRUCT_OFFSET(mt_ssh_shdr_t, freq), -1),
+    MT_SSH_SHDR_COLUMN("CHANNEL-WIDTH", G_STRUCT_OFFSET(mt_ssh_shdr_t, channel_width), -1),
+    MT_SSH_SHDR_COLUMN("BAND", G_STRUCT_OFFSET(mt_ssh_shdr_t, band), -1),
+    MT_SSH_SHDR_COLUMN("CHANNEL", G_STRUCT_OFFSET(mt_ssh_shdr_t, channel), -1)
+};
+
 static mt_ssh_cmd_t*  mt_ssh_cmd_new(mt_ssh_cmd_type_t, gchar*);
 static void           mt_ssh_cmd_free(mt_ssh_cmd_t*);
 static mt_ssh_msg_t*  mt_ssh_msg_new(const mt_ssh_t*, mt_ssh_msg_type_t, gpointer);
 static void           mt_ssh_msg_free(mt_ssh_msg_t*);
 static mt_ssh_info_t* mt_ssh_info_new(mt_ssh_info_type_t, gchar*);
 static void           mt_ssh_info_free(mt_ssh_info_t*);
-static mt_ssh_net_t*  mt_ssh_net_new();
-static void           mt_ssh_net_free(mt_ssh_net_t*);
+static mt_ssh_batch_t* mt_ssh_batch_new(void);
+static void           mt_ssh_batch_free(mt_ssh_batch_t*);
 static mt_ssh_snf_t*  mt_ssh_snf_new();
 static void           mt_ssh_snf_free(mt_ssh_snf_t*);
 
@@ -230,7 +275,7 @@ gboolean mt_ssh_cb_msg(gpointer user_data);
 
 static gpointer mt_ssh_thread(gpointer);
 static gboolean mt_ssh_verify(mt_ssh_t*, ssh_session);
-static void mt_ssh_conf_keepalive(ssh_session);
+static void mt_ssh_conf_keepalive(socket_t);
 
 static void mt_ssh(mt_ssh_t*);
 static void mt_ssh_request(mt_ssh_t*, const gchar*);
@@ -240,6 +285,7 @@ static void mt_ssh_interface(mt_ssh_t*, gchar*);
 static void mt_ssh_band(mt_ssh_t*, gchar*);
 static void mt_ssh_channel_width(mt_ssh_t*, gchar*);
 static void mt_ssh_scanning(mt_ssh_t*, gchar*);
+static void mt_ssh_scanning_flush(mt_ssh_t*);
 static void mt_ssh_sniffing(mt_ssh_t*, gchar*);
 static void mt_ssh_commands(mt_ssh_t*, guint);
 static void mt_ssh_dispatch(mt_ssh_t*);
@@ -247,33 +293,48 @@ static void mt_ssh_dispatch(mt_ssh_t*);
 static void mt_ssh_scan(mt_ssh_t*);
 static void mt_ssh_stop(mt_ssh_t*, gboolean);
 
+static void     mt_ssh_api_session(mt_ssh_t*);
+static gboolean mt_ssh_api_identity(mt_ssh_t*);
+static void     mt_ssh_api(mt_ssh_t*);
+static void     mt_ssh_api_request(mt_ssh_t*, gint, guint);
+static gboolean mt_ssh_api_reply(mt_ssh_t*, const mt_api_reply_t*);
+static void     mt_ssh_api_interface(mt_ssh_t*, const mt_api_reply_t*);
+static void     mt_ssh_api_scanning(mt_ssh_t*, const mt_api_reply_t*);
+static void     mt_ssh_api_sniffing(mt_ssh_t*, const mt_api_reply_t*);
+static void     mt_ssh_api_frame(mt_ssh_t*);
+static void     mt_ssh_api_dispatch(mt_ssh_t*);
+static void     mt_ssh_api_scan(mt_ssh_t*);
+
 static gint str_count_lines(const gchar*);
 static void str_remove_char(gchar*, gchar);
 
 static mt_ssh_shdr_t* parse_scan_header(const gchar*);
-static guint          parse_scan_header_column(const gchar*, const gchar*, guint*);
-static guchar         parse_scan_flags(const gchar*, guint);
-static gint64         parse_scan_address(const gchar*, guint);
-static gint           parse_scan_channel(const gchar*, guint, gchar**, gchar**);
-static gint           parse_scan_int(const gchar*, guint, guint);
-static gchar*         parse_scan_string(const gchar*, guint, guint, gboolean);
+static guint          parse_scan_header_length(const gchar*, guint, gsize);
+static guchar         parse_scan_flags(const gchar*, gsize, guint);
+static gint64         parse_scan_address(const gchar*, gsize, guint);
+static gint           parse_scan_channel(const gchar*, gsize, guint, const gchar**, const gchar**);
+static gint           parse_scan_int(const gchar*, gsize, guint, guint);
+static const gchar*   parse_scan_string(const gchar*, gsize, guint, guint, gboolean, gsize*);
+static gint           parse_hex(gchar);
+static const gchar*   parse_intern(const gchar*, gsize);
 static gchar*         parse_scanlist(const gchar*);
 
 
 mt_ssh_t*
-mt_ssh_new(void         (*cb)(mt_ssh_t*, mt_ssh_ret_t, const gchar*),
-           void         (*cb_msg)(const mt_ssh_t*, mt_ssh_msg_type_t, gconstpointer),
-           mt_ssh_mode_t  mode_default,
-           const gchar   *name,
-           const gchar   *hostname,
-           gint           port,
-           const gchar   *login,
-           const gchar   *password,
-           const gchar   *iface,
-           gint           duration,
-           gboolean       remote,
-           gboolean       background,
-           gboolean       skip_verification)
+mt_ssh_new(void               (*cb)(mt_ssh_t*, mt_ssh_ret_t, const gchar*),
+           void               (*cb_msg)(const mt_ssh_t*, mt_ssh_msg_type_t, gconstpointer),
+           mt_ssh_mode_t       mode_default,
+           const gchar        *name,
+           const gchar        *hostname,
+           gint                port,
+           mt_ssh_transport_t  transport,
+           const gchar        *login,
+           const gchar        *password,
+           const gchar        *iface,
+           gint                duration,
+           gboolean            remote,
+           gboolean            background,
+           gboolean            skip_verification)
 {
     mt_ssh_t *context;
 
@@ -284,6 +345,7 @@ mt_ssh_new(void         (*cb)(mt_ssh_t*, mt_ssh_ret_t, const gchar*),
     context->name = g_strdup(name);
     context->hostname = g_strdup(hostname);
     context->port = g_strdup_printf("%d", port);
+    context->transport = transport;
     context->login = g_strdup(login);
     context->password = g_strdup(password);
     context->iface = g_strdup(iface);
@@ -345,6 +407,8 @@ mt_ssh_free(mt_ssh_t *context)
         g_free(context->str_prompt);
         g_free(context->identity);
         g_free(context->scan_header);
+        if(context->scan_batch)
+            mt_ssh_batch_free(context->scan_batch);
         mt_ssh_snf_free(context->sniffer);
 
         g_free(context);
@@ -385,6 +449,12 @@ mt_ssh_get_port(const mt_ssh_t *context)
     return context->port;
 }
 
+mt_ssh_transport_t
+mt_ssh_get_transport(const mt_ssh_t *context)
+{
+    return context->transport;
+}
+
 const gchar*
 mt_ssh_get_login(const mt_ssh_t *context)
 {
@@ -489,8 +559,8 @@ mt_ssh_msg_free(mt_ssh_msg_t *msg)
             mt_ssh_info_free(msg->data);
             break;
 
-        case MT_SSH_MSG_NET:
-            mt_ssh_net_free(msg->data);
+        case MT_SSH_MSG_BATCH:
+            mt_ssh_batch_free(msg->data);
             break;
 
         case MT_SSH_MSG_SNF:
@@ -530,23 +600,35 @@ mt_ssh_info_get_data(const mt_ssh_info_t *info)
     return info->data;
 }
 
-static mt_ssh_net_t*
-mt_ssh_net_new()
+static mt_ssh_batch_t*
+mt_ssh_batch_new(void)
 {
-    mt_ssh_net_t *net;
-    net = g_malloc0(sizeof(mt_ssh_net_t));
-    return net;
+    mt_ssh_batch_t *batch;
+    batch = g_malloc(sizeof(mt_ssh_batch_t));
+    batch->nets = g_array_sized_new(FALSE, TRUE, sizeof(mt_ssh_net_t), 64);
+    batch->strings = g_string_chunk_new(4096);
+    return batch;
 }
 
 static void
-mt_ssh_net_free(mt_ssh_net_t *net)
+mt_ssh_batch_free(mt_ssh_batch_t *batch)
+{
+    g_array_free(batch->nets, TRUE);
+    g_string_chunk_free(batch->strings);
+    g_free(batch);
+}
+
+guint
+mt_ssh_batch_get_length(const mt_ssh_batch_t *batch)
+{
+    return batch->nets->len;
+}
+
+const mt_ssh_net_t*
+mt_ssh_batch_get_net(const mt_ssh_batch_t *batch,
+                     guint                 i)
 {
-    g_free(net->radioname);
-    g_free(net->ssid);
-    g_free(net->channel);
-    g_free(net->mode);
-    g_free(net->routeros_ver);
-    g_free(net);
+    return &g_array_index(batch->nets, mt_ssh_net_t, i);
 }
 
 gint64
@@ -756,6 +838,12 @@ mt_ssh_thread(gpointer data)
     printf("mt-ssh thread start: %p\n", (void*)context);
 #endif
 
+    if(context->transport != MT_SSH_TRANSPORT_PTY)
+    {
+        mt_ssh_api_session(context);
+        goto cleanup_callback;
+    }
+
     if(!(session = ssh_new()))
     {
         context->return_state = MT_SSH_ERR_NEW;
@@ -786,7 +874,7 @@ mt_ssh_thread(gpointer data)
     if(context->canceled)
         goto cleanup_disconnect;
 
-    mt_ssh_conf_keepalive(session);
+    mt_ssh_conf_keepalive(ssh_get_fd(session));
 
     if(!context->skip_verification)
     {
@@ -955,10 +1043,8 @@ mt_ssh_verify(mt_ssh_t    *context,
 }
 
 static void
-mt_ssh_conf_keepalive(ssh_session session)
+mt_ssh_conf_keepalive(socket_t fd)
 {
-    socket_t fd = ssh_get_fd(session);
-
     if(fd < 0)
         return;
 
@@ -1253,6 +1339,9 @@ mt_ssh_set_state(mt_ssh_t *context,
         g_idle_add(mt_ssh_cb_msg, mt_ssh_msg_new(context, MT_SSH_MSG_INFO, mt_ssh_info_new(MT_SSH_INFO_SCANNER_START, NULL)));
     }
 
+    if(last_state == MT_SSH_STATE_SCANNING)
+        mt_ssh_scanning_flush(context);
+
     if(last_state == MT_SSH_STATE_SCANNING &&
        !context->remote_mode)
     {
@@ -1280,7 +1369,7 @@ static void
 mt_ssh_interface(mt_ssh_t *context,
                  gchar    *line)
 {
-    if((context->hwaddr = parse_scan_address(line, 0)) < 0)
+    if((context->hwaddr = parse_scan_address(line, strlen(line), 0)) < 0)
     {
         context->return_state = MT_SSH_ERR_INTERFACE;
         context->canceled = TRUE;
@@ -1327,9 +1416,12 @@ mt_ssh_scanning(mt_ssh_t *context,
     static const gchar str_scanstart2[]     = "Columns: ";
     static const gchar str_scanend[]        = "-- ";
 
-    mt_ssh_net_t *net;
-    guchar flags;
-    gint64 address;
+    const mt_ssh_shdr_t *h;
+    mt_ssh_net_t net;
+    const gchar *str;
+    gchar buffer[16];
+    gsize length;
+    gsize len;
     gchar *ptr;
 
     if(context->state == MT_SSH_STATE_WAITING_FOR_SCAN &&
@@ -1375,6 +1467,7 @@ mt_ssh_scanning(mt_ssh_t *context,
 #endif
         }
         context->scan_line = -1;
+        mt_ssh_scanning_flush(context);
         g_idle_add(mt_ssh_cb_msg, mt_ssh_msg_new(context, MT_SSH_MSG_INFO, mt_ssh_info_new(MT_SSH_INFO_HEARTBEAT, NULL)));
 #if DEBUG
         printf("<!> Found END of a scan frame\n");
@@ -1431,16 +1524,20 @@ mt_ssh_scanning(mt_ssh_t *context,
     if((ptr = strchr(line, '\x1b')))
         *ptr = '\0';
 
+    h = context->scan_header;
+    length = strlen(line);
+    memset(&net, 0, sizeof(net));
+
     /* Parse all flags at the beginning of a line */
-    flags = parse_scan_flags(line, context->scan_header->address-1);
+    net.flags = parse_scan_flags(line, length, h->address-1);
 
-    if(!(flags & MT_SSH_NET_FLAG_ACTIVE))
+    if(!(net.flags & MT_SSH_NET_FLAG_ACTIVE))
     {
         /* This network is not active at the moment, ignore it */
         return;
     }
 
-    if((address = parse_scan_address(line, context->scan_header->address)) < 0)
+    if((net.address = parse_scan_address(line, length, h->address)) < 0)
     {
         /* This line doesn't contain a valid MAC address */
 #if DEBUG
@@ -1449,48 +1546,50 @@ mt_ssh_scanning(mt_ssh_t *context,
         return;
     }
 
-    net = mt_ssh_net_new();
-    net->timestamp = g_get_real_time() / 1000000;
-    net->address = address;
-    net->flags = flags;
+    /* Rows of a scan frame are delivered together at the end of it */
+    if(!context->scan_batch)
+        context->scan_batch = mt_ssh_batch_new();
+
+    net.timestamp = g_get_real_time() / 1000000;
+
+    if(h->ssid &&
+       (str = parse_scan_string(line, length, h->ssid, h->ssid_len, FALSE, &len)))
+        net.ssid = g_string_chunk_insert_len(context->scan_batch->strings, str, len);
 
-    if(context->scan_header->ssid)
+    if(h->channel)
+        net.frequency = parse_scan_channel(line, length, h->channel, &net.channel, &net.mode);
+
+    if(h->channel_width && !net.channel) /* Pre v6.30 */
     {
-        net->ssid = parse_scan_string(line,
-                                      context->scan_header->ssid,
-                                      context->scan_header->ssid_len,
-                                      FALSE);
+        g_snprintf(buffer, sizeof(buffer), "%d", parse_scan_int(line, length, h->channel_width, 1));
+        net.channel = g_intern_string(buffer);
     }
 
-    if(context->scan_header->channel)
-        net->frequency = parse_scan_channel(line, context->scan_header->channel, &net->channel, &net->mode);
+    if(h->rssi)
+        net.rssi = (gint8)parse_scan_int(line, length, h->rssi, 3);
 
-    if(context->scan_header->channel_width && !net->channel) /* Pre v6.30 */
-        net->channel = g_strdup_printf("%d", parse_scan_int(line, context->scan_header->channel_width, 1));
+    if(h->noise > 2)
+        net.noise = (gint8)parse_scan_int(line, length, h->noise-2, 4); // __NF !
 
-    if(context->scan_header->rssi)
-        net->rssi = (gint8)parse_scan_int(line, context->scan_header->rssi, 3);
+    if(h->radioname &&
+       (str = parse_scan_string(line, length, h->radioname, h->radioname_len, h->radioname_hack, &len)))
+        net.radioname = g_string_chunk_insert_len(context->scan_batch->strings, str, len);
 
-    if(context->scan_header->noise > 2)
-        net->noise = (gint8)parse_scan_int(line, context->scan_header->noise-2, 4); // __NF !
+    if(h->routeros_ver &&
+       (str = parse_scan_string(line, length, h->routeros_ver, h->routeros_ver_len, FALSE, &len)))
+        net.routeros_ver = g_string_chunk_insert_len(context->scan_batch->strings, str, len);
 
-    if(context->scan_header->radioname)
-    {
-        net->radioname = parse_scan_string(line,
-                                           context->scan_header->radioname,
-                                           context->scan_header->radioname_len,
-                                           context->scan_header->radioname_hack);
-    }
+    g_array_append_val(context->scan_batch->nets, net);
+}
 
-    if(context->scan_header->routeros_ver)
-    {
-        net->routeros_ver = parse_scan_string(line,
-                                              context->scan_header->routeros_ver,
-                                              context->scan_header->routeros_ver_len,
-                                              FALSE);
-    }
+static void
+mt_ssh_scanning_flush(mt_ssh_t *context)
+{
+    if(!context->scan_batch)
+        return;
 
-    g_idle_add(mt_ssh_cb_msg, mt_ssh_msg_new(context, MT_SSH_MSG_NET, net));
+    g_idle_add(mt_ssh_cb_msg, mt_ssh_msg_new(context, MT_SSH_MSG_BATCH, context->scan_batch));
+    context->scan_batch = NULL;
 }
 
 static void
@@ -1698,13 +1797,24 @@ static void
 mt_ssh_stop(mt_ssh_t *context,
             gboolean  restart)
 {
+    gchar *tag;
+
     if(context->state != MT_SSH_STATE_WAITING_FOR_SCAN &&
        context->state != MT_SSH_STATE_SCANNING &&
        context->state != MT_SSH_STATE_SNIFFING)
         return;
 
-    /* Do not use mt_ssh_request, as the 'Q' is not echoed back */
-    ssh_channel_write(context->channel, "Q", 1);
+    if(context->api_session)
+    {
+        tag = g_strdup_printf("=tag=%u", context->api_tag);
+        mt_api_write(context->api_session, "/cancel", tag, NULL);
+        g_free(tag);
+    }
+    else
+    {
+        /* Do not use mt_ssh_request, as the 'Q' is not echoed back */
+        ssh_channel_write(context->channel, "Q", 1);
+    }
 
     if(restart)
     {
@@ -1717,6 +1827,445 @@ mt_ssh_stop(mt_ssh_t *context,
     mt_ssh_set_state(context, MT_SSH_STATE_WAITING_FOR_PROMPT_DIRTY);
 }
 
+static void
+mt_ssh_api_session(mt_ssh_t *context)
+{
+    mt_api_t *api;
+
+    if(context->canceled)
+        return;
+
+    g_idle_add(mt_ssh_cb_msg, mt_ssh_msg_new(context, MT_SSH_MSG_INFO, mt_ssh_info_new(MT_SSH_INFO_CONNECTING, NULL)));
+
+    api = mt_api_new(context->transport == MT_SSH_TRANSPORT_API_SSL);
+    if(!mt_api_connect(api, context->hostname, context->port, &context->canceled, &context->return_error))
+    {
+        context->return_state = MT_SSH_ERR_CONNECT;
+        goto cleanup;
+    }
+
+    if(context->canceled)
+        goto cleanup;
+
+    mt_ssh_conf_keepalive(mt_api_get_fd(api));
+
+    g_idle_add(mt_ssh_cb_msg, mt_ssh_msg_new(context, MT_SSH_MSG_INFO, mt_ssh_info_new(MT_SSH_INFO_AUTHENTICATING, NULL)));
+
+    if(!mt_api_login(api, context->login, context->password))
+    {
+        context->return_state = MT_SSH_ERR_AUTH;
+        goto cleanup;
+    }
+
+    if(context->canceled)
+        goto cleanup;
+
+    g_idle_add(mt_ssh_cb_msg, mt_ssh_msg_new(context, MT_SSH_MSG_INFO, mt_ssh_info_new(MT_SSH_INFO_CONNECTED, NULL)));
+
+    context->api_session = api;
+    if(mt_ssh_api_identity(context))
+    {
+        mt_ssh_set_state(context, MT_SSH_STATE_PROMPT);
+        mt_ssh_api(context);
+    }
+    context->api_session = NULL;
+
+    if(!context->canceled)
+        context->return_state = MT_SSH_CLOSED;
+
+cleanup:
+    mt_api_free(api);
+}
+
+static gboolean
+mt_ssh_api_identity(mt_ssh_t *context)
+{
+    const mt_api_reply_t *reply;
+    const gchar *name;
+    guint tag;
+
+    if(!(tag = mt_api_write(context->api_session, "/system/identity/print", NULL)))
+        return FALSE;
+
+    while(mt_api_read(context->api_session, API_TIMEOUT_MSEC, &reply) == MT_API_OK)
+    {
+        if(mt_api_reply_get_tag(reply) != tag)
+            continue;
+
+        if(mt_api_reply_get_type(reply) == MT_API_REPLY_RE &&
+           (name = mt_api_reply_get(reply, "name", NULL)))
+        {
+            g_free(context->identity);
+            context->identity = g_strdup(name);
+        }
+        else if(mt_api_reply_get_type(reply) != MT_API_REPLY_RE)
+        {
+            g_idle_add(mt_ssh_cb_msg, mt_ssh_msg_new(context, MT_SSH_MSG_INFO, mt_ssh_info_new(MT_SSH_INFO_IDENTITY, NULL)));
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static void
+mt_ssh_api(mt_ssh_t *context)
+{
+    const mt_api_reply_t *reply;
+    mt_api_ret_t ret;
+
+    while(TRUE)
+    {
+        /* Handle commands from the queue */
+        mt_ssh_commands(context, 0);
+        mt_ssh_api_dispatch(context);
+
+        if(context->canceled)
+            return;
+
+        ret = mt_api_read(context->api_session, READ_TIMEOUT_MSEC, &reply);
+        if(ret == MT_API_ERROR)
+            return;
+
+        if(ret == MT_API_TIMEOUT)
+        {
+            /* There is no explicit end of a scan frame, deliver
+               the rows when the device stops sending them */
+            if(context->state == MT_SSH_STATE_SCANNING &&
+               (context->scan_batch ||
+                g_get_monotonic_time() - context->api_heartbeat_ts >= API_HEARTBEAT_MSEC * 1000))
+                mt_ssh_api_frame(context);
+            continue;
+        }
+
+        if(!mt_ssh_api_reply(context, reply))
+            return;
+    }
+}
+
+static void
+mt_ssh_api_request(mt_ssh_t *context,
+                   gint      new_state,
+                   guint     tag)
+{
+    context->api_tag = tag;
+    mt_ssh_set_state(context, new_state);
+}
+
+static gboolean
+mt_ssh_api_reply(mt_ssh_t             *context,
+                 const mt_api_reply_t *reply)
+{
+    const gchar *message;
+
+    if(mt_api_reply_get_type(reply) == MT_API_REPLY_FATAL)
+    {
+        g_free(context->return_error);
+        context->return_error = g_strdup(mt_api_reply_get(reply, "message", NULL));
+        return FALSE;
+    }
+
+    /* Ignore replies to previous and /cancel commands */
+    if(mt_api_reply_get_tag(reply) != context->api_tag)
+        return TRUE;
+
+    switch(mt_api_reply_get_type(reply))
+    {
+    case MT_API_REPLY_RE:
+        if(context->state == MT_SSH_STATE_INTERFACE)
+        {
+            mt_ssh_api_interface(context, reply);
+        }
+        else if(context->state == MT_SSH_STATE_SCANLIST)
+        {
+            if((message = mt_api_reply_get(reply, "channels", NULL)))
+                g_string_append_printf(context->string_buff, "channels: %s", message);
+        }
+        else if(context->state == MT_SSH_STATE_WAITING_FOR_SCAN ||
+                context->state == MT_SSH_STATE_SCANNING)
+        {
+            mt_ssh_api_scanning(context, reply);
+        }
+        else if(context->state == MT_SSH_STATE_SNIFFING)
+        {
+            mt_ssh_api_sniffing(context, reply);
+        }
+        break;
+
+    case MT_API_REPLY_TRAP:
+        if(context->state == MT_SSH_STATE_WAITING_FOR_PROMPT_DIRTY)
+        {
+            /* The command was interrupted with /cancel */
+            break;
+        }
+
+        if(context->state == MT_SSH_STATE_INTERFACE)
+        {
+            context->return_state = MT_SSH_ERR_INTERFACE;
+            context->canceled = TRUE;
+            break;
+        }
+
+        message = mt_api_reply_get(reply, "message", NULL);
+        mt_ssh_set_state(context, MT_SSH_STATE_WAITING_FOR_PROMPT_DIRTY);
+        g_idle_add(mt_ssh_cb_msg, mt_ssh_msg_new(context, MT_SSH_MSG_INFO, mt_ssh_info_new(MT_SSH_INFO_FAILURE, g_strdup(message))));
+        break;
+
+    case MT_API_REPLY_DONE:
+        if(context->state == MT_SSH_STATE_INTERFACE)
+        {
+            if(context->hwaddr < 0)
+            {
+                context->return_state = MT_SSH_ERR_INTERFACE;
+                context->canceled = TRUE;
+                break;
+            }
+
+            g_idle_add(mt_ssh_cb_msg, mt_ssh_msg_new(context, MT_SSH_MSG_INFO, mt_ssh_info_new(MT_SSH_INFO_INTERFACE, NULL)));
+            g_idle_add(mt_ssh_cb_msg, mt_ssh_msg_new(context, MT_SSH_MSG_INFO, mt_ssh_info_new(MT_SSH_INFO_BAND, NULL)));
+            g_idle_add(mt_ssh_cb_msg, mt_ssh_msg_new(context, MT_SSH_MSG_INFO, mt_ssh_info_new(MT_SSH_INFO_CHANNEL_WIDTH, NULL)));
+        }
+        mt_ssh_set_state(context, MT_SSH_STATE_PROMPT);
+        break;
+
+    default:
+        break;
+    }
+
+    return TRUE;
+}
+
+static void
+mt_ssh_api_interface(mt_ssh_t             *context,
+                     const mt_api_reply_t *reply)
+{
+    const gchar *str;
+    gsize len;
+
+    if((str = mt_api_reply_get(reply, "mac-address", &len)))
+        context->hwaddr = parse_scan_address(str, len, 0);
+
+    if((str = mt_api_reply_get(reply, "band", NULL)) &&
+       g_ascii_strncasecmp(str, "2ghz", strlen("2ghz")) == 0)
+        context->band = MT_SSH_BAND_2GHZ;
+    else if(str && g_ascii_strncasecmp(str, "5ghz", strlen("5ghz")) == 0)
+        context->band = MT_SSH_BAND_5GHZ;
+    else
+        context->band = MT_SSH_BAND_UNKNOWN;
+
+    if((str = mt_api_reply_get(reply, "channel-width", NULL)))
+        context->channel_width = atoi(str);
+}
+
+static void
+mt_ssh_api_scanning(mt_ssh_t             *context,
+                    const mt_api_reply_t *reply)
+{
+    static const struct
+    {
+        const gchar *name;
+        guint8       flag;
+    } flags[] =
+    {
+        { "active",   MT_SSH_NET_FLAG_ACTIVE   },
+        { "privacy",  MT_SSH_NET_FLAG_PRIVACY  },
+        { "routeros", MT_SSH_NET_FLAG_ROUTEROS },
+        { "nstreme",  MT_SSH_NET_FLAG_NSTREME  },
+        { "tdma",     MT_SSH_NET_FLAG_TDMA     },
+        { "wds",      MT_SSH_NET_FLAG_WDS      },
+        { "bridge",   MT_SSH_NET_FLAG_BRIDGE   }
+    };
+    mt_ssh_net_t net;
+    const gchar *str;
+    gsize len;
+    gint section;
+    guint i;
+
+    if(context->state == MT_SSH_STATE_WAITING_FOR_SCAN)
+    {
+        context->api_section = -1;
+        mt_ssh_set_state(context, MT_SSH_STATE_SCANNING);
+    }
+
+    /* Each refresh of the scan results starts a new section */
+    if((str = mt_api_reply_get(reply, ".section", NULL)))
+    {
+        section = atoi(str);
+        if(section != context->api_section)
+        {
+            if(context->scan_batch)
+                mt_ssh_api_frame(context);
+            context->api_section = section;
+        }
+    }
+
+    memset(&net, 0, sizeof(net));
+    for(i=0; i<G_N_ELEMENTS(flags); i++)
+    {
+        if((str = mt_api_reply_get(reply, flags[i].name, NULL)) &&
+           !strcmp(str, "true"))
+            net.flags |= flags[i].flag;
+    }
+
+    if(!(net.flags & MT_SSH_NET_FLAG_ACTIVE))
+        return;
+
+    str = mt_api_reply_get(reply, "address", &len);
+    if((net.address = parse_scan_address(str, len, 0)) < 0)
+        return;
+
+    if(!context->scan_batch)
+        context->scan_batch = mt_ssh_batch_new();
+
+    net.timestamp = g_get_real_time() / 1000000;
+
+    if((str = mt_api_reply_get(reply, "ssid", &len)))
+        net.ssid = g_string_chunk_insert_len(context->scan_batch->strings, str, len);
+
+    if((str = mt_api_reply_get(reply, "channel", &len)))
+        net.frequency = parse_scan_channel(str, len, 0, &net.channel, &net.mode);
+
+    if((str = mt_api_reply_get(reply, "sig", NULL)))
+        net.rssi = (gint8)atoi(str);
+
+    if((str = mt_api_reply_get(reply, "nf", NULL)))
+        net.noise = (gint8)atoi(str);
+
+    if((str = mt_api_reply_get(reply, "radio-name", &len)))
+        net.radioname = g_string_chunk_insert_len(context->scan_batch->strings, str, len);
+
+    if((str = mt_api_reply_get(reply, "routeros-version", &len)))
+        net.routeros_ver = g_string_chunk_insert_len(context->scan_batch->strings, str, len);
+
+    g_array_append_val(context->scan_batch->nets, net);
+}
+
+static void
+mt_ssh_api_sniffing(mt_ssh_t             *context,
+                    const mt_api_reply_t *reply)
+{
+    const gchar *str;
+
+    if((str = mt_api_reply_get(reply, "processed-packets", NULL)))
+        context->sniffer->processed_packets = atoi(str);
+    if((str = mt_api_reply_get(reply, "memory-size", NULL)))
+        context->sniffer->memory_size = atoi(str);
+    if((str = mt_api_reply_get(reply, "memory-saved-packets", NULL)))
+        context->sniffer->memory_saved_packets = atoi(str);
+    if((str = mt_api_reply_get(reply, "memory-over-limit-packets", NULL)))
+        context->sniffer->memory_over_limit_packets = atoi(str);
+    if((str = mt_api_reply_get(reply, "stream-dropped-packets", NULL)))
+        context->sniffer->stream_dropped_packets = atoi(str);
+    if((str = mt_api_reply_get(reply, "stream-sent-packets", NULL)))
+        context->sniffer->stream_sent_packets = atoi(str);
+    if((str = mt_api_reply_get(reply, "real-file-limit", NULL)))
+        context->sniffer->real_file_limit = atoi(str);
+    if((str = mt_api_reply_get(reply, "real-memory-limit", NULL)))
+        context->sniffer->real_memory_limit = atoi(str);
+
+    g_idle_add(mt_ssh_cb_msg, mt_ssh_msg_new(context, MT_SSH_MSG_SNF, context->sniffer));
+    context->sniffer = mt_ssh_snf_new();
+    g_idle_add(mt_ssh_cb_msg, mt_ssh_msg_new(context, MT_SSH_MSG_INFO, mt_ssh_info_new(MT_SSH_INFO_HEARTBEAT, NULL)));
+}
+
+static void
+mt_ssh_api_frame(mt_ssh_t *context)
+{
+    mt_ssh_scanning_flush(context);
+    g_idle_add(mt_ssh_cb_msg, mt_ssh_msg_new(context, MT_SSH_MSG_INFO, mt_ssh_info_new(MT_SSH_INFO_HEARTBEAT, NULL)));
+    context->api_heartbeat_ts = g_get_monotonic_time();
+}
+
+static void
+mt_ssh_api_dispatch(mt_ssh_t *context)
+{
+    gchar *numbers;
+    gchar *value;
+    guint tag;
+
+    if(context->state != MT_SSH_STATE_PROMPT)
+        return;
+
+    numbers = g_strdup_printf("=numbers=%s", context->iface);
+
+    if(context->dispatch_interface_check ||
+       context->dispatch_band_check ||
+       context->dispatch_channel_width_check)
+    {
+        value = g_strdup_printf("?name=%s", context->iface);
+        tag = mt_api_write(context->api_session,
+                           "/interface/wireless/print",
+                           "=.proplist=mac-address,band,channel-width",
+                           value,
+                           NULL);
+        mt_ssh_api_request(context, MT_SSH_STATE_INTERFACE, tag);
+        context->dispatch_interface_check = FALSE;
+        context->dispatch_band_check = FALSE;
+        context->dispatch_channel_width_check = FALSE;
+        g_free(value);
+    }
+    /* Perform scanlist_set before scanlist_get */
+    else if(context->dispatch_scanlist_set)
+    {
+        value = g_strdup_printf("=scan-list=%s", context->dispatch_scanlist_set);
+        tag = mt_api_write(context->api_session, "/interface/wireless/set", numbers, value, NULL);
+        mt_ssh_api_request(context, MT_SSH_STATE_WAITING_FOR_PROMPT, tag);
+        g_free(context->dispatch_scanlist_set);
+        context->dispatch_scanlist_set = NULL;
+        g_free(value);
+    }
+    else if(context->dispatch_scanlist_get)
+    {
+        tag = mt_api_write(context->api_session, "/interface/wireless/info/scan-list", numbers, NULL);
+        mt_ssh_api_request(context, MT_SSH_STATE_SCANLIST, tag);
+        context->string_buff = g_string_new(NULL);
+        context->dispatch_scanlist_get = FALSE;
+    }
+    else if(context->dispatch_mode == MT_SSH_MODE_SNIFFER)
+    {
+        value = g_strdup_printf("=interface=%s", context->iface);
+        tag = mt_api_write(context->api_session, "/interface/wireless/sniffer/sniff", value, NULL);
+        mt_ssh_api_request(context, MT_SSH_STATE_SNIFFING, tag);
+        context->dispatch_mode = MT_SSH_MODE_NONE;
+        g_free(value);
+    }
+    else if(context->dispatch_mode == MT_SSH_MODE_SCANNER ||
+            context->remote_mode)
+    {
+        mt_ssh_api_scan(context);
+        context->dispatch_mode = MT_SSH_MODE_NONE;
+    }
+
+    g_free(numbers);
+}
+
+static void
+mt_ssh_api_scan(mt_ssh_t *context)
+{
+    static const gchar str_proplist[] = "=.proplist=.section,address,ssid,channel,sig,nf,radio-name,routeros-version,"
+                                        "active,privacy,routeros,nstreme,tdma,wds,bridge";
+    gchar *id;
+    gchar *duration;
+    guint tag;
+
+    id = g_strdup_printf("=.id=%s", context->iface);
+    duration = (context->duration ? g_strdup_printf("=duration=%d", context->duration) : NULL);
+
+    /* The results are streamed until the command is canceled */
+    tag = mt_api_write(context->api_session,
+                       "/interface/wireless/scan",
+                       id,
+                       str_proplist,
+                       (context->background ? "=background=yes" : duration),
+                       (context->background ? duration : NULL),
+                       NULL);
+
+    g_free(id);
+    g_free(duration);
+
+    context->api_heartbeat_ts = g_get_monotonic_time();
+    mt_ssh_api_request(context, MT_SSH_STATE_WAITING_FOR_SCAN, tag);
+}
+
 static gint
 str_count_lines(const gchar *ptr)
 {
@@ -1743,40 +2292,71 @@ str_remove_char(gchar *str,
 static mt_ssh_shdr_t*
 parse_scan_header(const gchar *buff)
 {
-    mt_ssh_shdr_t *h;
-    guint address;
+    const mt_ssh_shdr_column_t *column;
+    const gchar *start;
+    const gchar *match;
+    const gchar *found;
     const gchar *ptr;
+    mt_ssh_shdr_t *h;
+    guint *position;
+    gsize length;
+    gsize i;
 
-    address = parse_scan_header_column(buff, "ADDRESS", NULL);
+    h = g_malloc0(sizeof(mt_ssh_shdr_t));
 
-    if(!address)
+    /* Single pass over the titles, the longest title found within
+       a word wins (CHANNEL-WIDTH over CHANNEL), only the first
+       occurrence of each column is used */
+    for(ptr = buff; *ptr; )
+    {
+        while(isspace(*ptr))
+            ptr++;
+
+        start = ptr;
+        while(*ptr && !isspace(*ptr))
+            ptr++;
+
+        length = ptr - start;
+        if(!length)
+            break;
+
+        column = NULL;
+        match = NULL;
+        for(i=0; i<G_N_ELEMENTS(scan_columns); i++)
+        {
+            if(scan_columns[i].title_len <= length &&
+               (!column || scan_columns[i].title_len > column->title_len) &&
+               (found = g_strstr_len(start, length, scan_columns[i].title)))
+            {
+                column = &scan_columns[i];
+                match = found;
+            }
+        }
+
+        if(!column)
+            continue;
+
+        position = G_STRUCT_MEMBER_P(h, column->position);
+        if(*position)
+            continue;
+
+        *position = (guint)(match - buff);
+        if(column->length >= 0)
+            G_STRUCT_MEMBER(guint, h, column->length) = parse_scan_header_length(buff, *position, column->title_len);
+    }
+
+    if(!h->address)
     {
 #if DEBUG
         printf("ADDRESS position not found!");
 #endif
+        g_free(h);
         return NULL;
     }
 
-    h = g_malloc0(sizeof(mt_ssh_shdr_t));
-    h->address = address;
-
-    /* Preserve length of some columns */
-    h->ssid = parse_scan_header_column(buff, "SSID", &h->ssid_len);
-    h->radioname = parse_scan_header_column(buff, "RADIO-NAME", &h->radioname_len);
-    h->routeros_ver = parse_scan_header_column(buff, "ROUTEROS-VER", &h->routeros_ver_len);
-
-    h->rssi = parse_scan_header_column(buff, "SIG", NULL);
-    h->noise = parse_scan_header_column(buff, "NF", NULL);
-    h->snr = parse_scan_header_column(buff, "SNR", NULL);
-
     /* Pre v6.30 */
-    h->channel = parse_scan_header_column(buff, "FREQ", NULL);
-    h->channel_width = parse_scan_header_column(buff, "CHANNEL-WIDTH", NULL);
-    h->band = parse_scan_header_column(buff, "BAND", NULL);
-
-    /* Post v6.30 */
-    if(!h->channel)
-        h->channel = parse_scan_header_column(buff, "CHANNEL", NULL);
+    if(h->freq)
+        h->channel = h->freq;
 
     /* HACK for RouterOS v7 */
     /* The RADIO-NAME column is right aligned */
@@ -1804,60 +2384,36 @@ parse_scan_header(const gchar *buff)
 }
 
 static guint
-parse_scan_header_column(const gchar *buff,
-                         const gchar *title,
-                         guint       *length)
+parse_scan_header_length(const gchar *buff,
+                         guint        position,
+                         gsize        title_len)
 {
-    const gchar *ptr;
-    guint pos;
-
-    /* Length parameter is optional */
-    if(length)
-        *length = 0;
-
-    /* Find occurrence of a title in header */
-    ptr = strstr(buff, title);
-    if (!ptr)
-        return 0;
-
-    /* Found the position */
-    pos = (guint) (ptr - buff);
+    const gchar *ptr = buff + position + title_len;
+    guint length = title_len;
 
-    if(length)
+    /* Continue until next column */
+    while(isspace(*ptr))
     {
-        /* Check column width (length) */
-        ptr += strlen(title);
-        *length += strlen(title);
-
-        /* Continue until next column */
-        while(isspace(*ptr))
-        {
-            ptr++;
-            (*length)++;
-        }
-
-        if (*ptr != '\0')
-        {
-            /* Another column was found */
-            *length = *length - 1;
-        }
-        else
-        {
-            /* This is the last column, it can expand to the end of a line */
-            *length = (pos < PTY_COLS) ? (PTY_COLS - pos) : 0;
-        }
+        ptr++;
+        length++;
     }
 
-    return pos;
+    /* This is the last column, it can expand to the end of a line */
+    if(*ptr == '\0')
+        return (position < PTY_COLS) ? (PTY_COLS - position) : 0;
+
+    /* Another column was found */
+    return length - 1;
 }
 
 static guchar
 parse_scan_flags(const gchar *buff,
+                 gsize        buff_len,
                  guint        flags_len)
 {
-    size_t length = MIN(strlen(buff), flags_len);
+    gsize length = MIN(buff_len, flags_len);
     guchar flags = 0;
-    gint i;
+    gsize i;
 
     for(i=0; i<length; i++)
     {
@@ -1898,129 +2454,140 @@ parse_scan_flags(const gchar *buff,
 
 static gint64
 parse_scan_address(const gchar *buff,
+                   gsize        buff_len,
                    guint        position)
 {
-    gchar addr[MAC_ADDR_HEX_LEN+1];
-    gchar *ptr;
-    gint64 value;
+    gint64 value = 0;
+    gint hi, lo;
     gint i;
 
     if(!buff)
         return -1;
 
-    if(strlen(buff) < position+MAC_ADDR_HEX_LEN+5)
+    if(buff_len < position+MAC_ADDR_STR_LEN)
         return -1;
 
-    for(i=0; i<MAC_ADDR_HEX_LEN; i+=2)
-    {
-        addr[i] = buff[position+i+(i/2)];
-        addr[i+1] = buff[position+i+1+(i/2)];
-    }
-
-    addr[MAC_ADDR_HEX_LEN] = '\0';
-
-    for(i=0; i<MAC_ADDR_HEX_LEN; i++)
+    /* Octets are separated with a single character */
+    buff += position;
+    for(i=0; i<MAC_ADDR_STR_LEN; i+=3)
     {
-        if(!((addr[i] >= '0' && addr[i] <= '9') ||
-             (addr[i] >= 'A' && addr[i] <= 'F') ||
-             (addr[i] >= 'a' && addr[i] <= 'f')))
+        if((hi = parse_hex(buff[i])) < 0 ||
+           (lo = parse_hex(buff[i+1])) < 0)
             return -1;
-    }
 
-    value = g_ascii_strtoll(addr, &ptr, 16);
-    if(ptr != addr)
-        return value;
+        value = (value << 8) | (hi << 4) | lo;
+    }
 
-    return -1;
+    return value;
 }
 
 static gint
 parse_scan_channel(const gchar  *buff,
+                   gsize         buff_len,
                    guint         position,
-                   gchar       **channel_width,
-                   gchar       **mode)
+                   const gchar **channel_width,
+                   const gchar **mode)
 {
-    gchar *ptr, *endptr, *endstr, *nextptr;
-    gdouble frequency = 0.0;
+    const gchar *ptr, *endptr, *endstr, *nextptr, *end;
+    gint frequency = 0;
+    gint scale = 100;
 
-    if(strlen(buff) > position &&
-       isdigit(buff[position]))
-    {
-        sscanf(buff + position, "%lf", &frequency);
+    if(buff_len <= position ||
+       !isdigit(buff[position]))
+        return 0;
+
+    /* Frequency in MHz with an optional fraction, rounded to kHz */
+    end = buff + buff_len;
+    for(ptr = buff + position; ptr < end && isdigit(*ptr); ptr++)
+        frequency = frequency * 10 + (*ptr - '0');
+    frequency *= 1000;
 
-        endstr = strchr(buff + position, ' ');
-        ptr = strchr(buff + position, '/');
-        if(ptr++ && ptr < endstr)
+    if(ptr < end && *ptr == '.')
+    {
+        for(ptr++; ptr < end && isdigit(*ptr); ptr++)
         {
-            endptr = strchr(ptr, '/');
-            if(endptr && endptr < endstr)
+            if(scale)
+                frequency += (*ptr - '0') * scale;
+            else
             {
-                *channel_width = g_strndup(ptr, (endptr - ptr));
-                ptr = endptr+1;
-                endptr = strchr(ptr, ' ');
-                if(endptr)
-                {
-                    nextptr = strchr(ptr, '/');
-                    if(nextptr && nextptr < endptr)
-                        endptr = nextptr;
-                    *mode = g_strndup(ptr, (endptr - ptr));
-                }
+                frequency += (*ptr >= '5');
+                break;
             }
+            scale /= 10;
         }
     }
 
-    if (*mode)
-    {
-        /* Drop everything starting from bracket */
-        ptr = strchr(*mode, '(');
-        if (ptr)
-        {
-            *ptr = '\0';
-        }
-    }
+    /* Channel width and mode: 5180/20-Ce/ac(30dBm) */
+    ptr = buff + position;
+    endstr = memchr(ptr, ' ', end - ptr);
+    if(!endstr)
+        endstr = end;
+
+    ptr = memchr(ptr, '/', endstr - ptr);
+    if(!ptr || ++ptr >= endstr)
+        return frequency;
 
-    return (gint)round(frequency*1000.0);
+    endptr = memchr(ptr, '/', endstr - ptr);
+    if(!endptr)
+        return frequency;
+
+    *channel_width = parse_intern(ptr, endptr - ptr);
+
+    ptr = endptr + 1;
+    endptr = endstr;
+    nextptr = memchr(ptr, '/', endptr - ptr);
+    if(nextptr)
+        endptr = nextptr;
+
+    /* Drop everything starting from bracket */
+    nextptr = memchr(ptr, '(', endptr - ptr);
+    if(nextptr)
+        endptr = nextptr;
+
+    *mode = parse_intern(ptr, endptr - ptr);
+    return frequency;
 }
 
 static gint
 parse_scan_int(const gchar *buff,
+               gsize        buff_len,
                guint        position,
                guint        max_left_offset)
 {
-    gint buff_length = (gint)strlen(buff);
-    gint i, value = 0;
+    gboolean negative;
+    gint value = 0;
+    gsize i;
 
-    for(i=0; i<max_left_offset; i++)
+    for(i=position; i<position+max_left_offset && i<buff_len; i++)
     {
-        if(buff_length < position+i)
-            break;
-
-        if(isdigit(buff[position+i]) ||
-           buff[position+i] == '-')
+        if(isdigit(buff[i]) ||
+           buff[i] == '-')
         {
-            sscanf(buff+position+i, "%d", &value);
-            break;
+            negative = (buff[i] == '-');
+            for(i += negative; i<buff_len && isdigit(buff[i]); i++)
+                value = value * 10 + (buff[i] - '0');
+            return (negative ? -value : value);
         }
     }
     return value;
 }
 
-static gchar*
+static const gchar*
 parse_scan_string(const gchar *buff,
+                  gsize        buff_len,
                   guint        position,
                   guint        str_length,
-                  gboolean     left_trim)
+                  gboolean     left_trim,
+                  gsize       *length)
 {
-    guint buff_length = strlen(buff);
-
-    if(position >= buff_length)
+    if(position >= buff_len)
         return NULL;
 
     buff += position;
-    buff_length -= position;
+    buff_len -= position;
 
-    if(buff_length < str_length)
-        str_length = buff_length;
+    if(buff_len < str_length)
+        str_length = buff_len;
 
     if(left_trim)
     {
@@ -2038,7 +2605,42 @@ parse_scan_string(const gchar *buff,
             str_length--;
     }
 
-    return g_strndup(buff, str_length);
+    *length = str_length;
+    return buff;
+}
+
+static gint
+parse_hex(gchar c)
+{
+    if(c >= '0' && c <= '9')
+        return c - '0';
+    if(c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    if(c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    return -1;
+}
+
+static const gchar*
+parse_intern(const gchar *str,
+             gsize        length)
+{
+    /* Channel widths and modes repeat, keep a single copy of each */
+    gchar buffer[32];
+    const gchar *value;
+    gchar *tmp;
+
+    if(length < sizeof(buffer))
+    {
+        memcpy(buffer, str, length);
+        buffer[length] = '\0';
+        return g_intern_string(buffer);
+    }
+
+    tmp = g_strndup(str, length);
+    value = g_intern_string(tmp);
+    g_free(tmp);
+    return value;
 }
 
 static gchar*
@@ -20,6 +20,7 @@
 typedef struct mt_ssh      mt_ssh_t;
 typedef struct mt_ssh_info mt_ssh_info_t;
 typedef struct mt_ssh_net  mt_ssh_net_t;
+typedef struct mt_ssh_batch mt_ssh_batch_t;
 typedef struct mt_ssh_snf  mt_ssh_snf_t;
 
 typedef enum mt_ssh_ret
@@ -42,7 +43,7 @@ typedef enum mt_ssh_ret
 typedef enum mt_ssh_msg_type
 {
     MT_SSH_MSG_INFO,
-    MT_SSH_MSG_NET,
+    MT_SSH_MSG_BATCH,
     MT_SSH_MSG_SNF
 } mt_ssh_msg_type_t;
 
@@ -81,6 +82,13 @@ typedef enum mt_ssh_mode
     MT_SSH_MODE_SNIFFER
 } mt_ssh_mode_t;
 
+typedef enum mt_ssh_transport
+{
+    MT_SSH_TRANSPORT_PTY,
+    MT_SSH_TRANSPORT_API,
+    MT_SSH_TRANSPORT_API_SSL
+} mt_ssh_transport_t;
+
 typedef enum mt_ssh_band
 {
     MT_SSH_BAND_UNKNOWN,
@@ -88,25 +96,27 @@ typedef enum mt_ssh_band
     MT_SSH_BAND_5GHZ
 } mt_ssh_band_t;
 
-mt_ssh_t*          mt_ssh_new(void         (*cb)(mt_ssh_t*, mt_ssh_ret_t, const gchar*),
-                              void         (*cb_msg)(const mt_ssh_t*, mt_ssh_msg_type_t, gconstpointer),
-                              mt_ssh_mode_t  mode_default,
-                              const gchar   *name,
-                              const gchar   *hostname,
-                              gint           port,
-                              const gchar   *login,
-                              const gchar   *password,
-                              const gchar   *iface,
-                              gint           duration,
-                              gboolean       remote,
-                              gboolean       background,
-                              gboolean       skip_verification);
+mt_ssh_t*          mt_ssh_new(void               (*cb)(mt_ssh_t*, mt_ssh_ret_t, const gchar*),
+                              void               (*cb_msg)(const mt_ssh_t*, mt_ssh_msg_type_t, gconstpointer),
+                              mt_ssh_mode_t       mode_default,
+                              const gchar        *name,
+                              const gchar        *hostname,
+                              gint                port,
+                              mt_ssh_transport_t  transport,
+                              const gchar        *login,
+                              const gchar        *password,
+                              const gchar        *iface,
+                              gint                duration,
+                              gboolean            remote,
+                              gboolean            background,
+                              gboolean            skip_verification);
 void               mt_ssh_free(mt_ssh_t*);
 void               mt_ssh_cancel(mt_ssh_t*);
 void               mt_ssh_cmd(mt_ssh_t*, mt_ssh_cmd_type_t, const gchar*);
 const gchar*       mt_ssh_get_name(const mt_ssh_t*);
 const gchar*       mt_ssh_get_hostname(const mt_ssh_t*);
 const gchar*       mt_ssh_get_port(const mt_ssh_t*);
+mt_ssh_transport_t mt_ssh_get_transport(const mt_ssh_t*);
 const gchar*       mt_ssh_get_login(const mt_ssh_t*);
 const gchar*       mt_ssh_get_password(const mt_ssh_t*);
 const gchar*       mt_ssh_get_interface(const mt_ssh_t*);
@@ -122,6 +132,9 @@ gint               mt_ssh_get_channel_width(const mt_ssh_t*);
 mt_ssh_info_type_t mt_ssh_info_get_type(const mt_ssh_info_t*);
 const gchar*       mt_ssh_info_get_data(const mt_ssh_info_t*);
 
+guint              mt_ssh_batch_get_length(const mt_ssh_batch_t*);
+const mt_ssh_net_t* mt_ssh_batch_get_net(const mt_ssh_batch_t*, guint);
+
 gint64             mt_ssh_net_get_timestamp(const mt_ssh_net_t*);
 gint64             mt_ssh_net_get_address(const mt_ssh_net_t*);
 gint               mt_ssh_net_get_frequency(const mt_ssh_net_t*);
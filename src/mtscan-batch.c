@@ -0,0 +1,91 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "batch.h"
+#include "mtscan.h"
+
+/* Headless front end of the batch mode, linked only with mtscan-core */
+
+static void
+mtscan_batch_usage(void)
+{
+    printf("mtscan-batch " APP_VERSION " - MikroTik RouterOS wireless scanner\n");
+    printf("usage: mtscan-batch -o log [-S] [-G] [-A] logs...\n");
+    printf("options:\n");
+    printf("  -o  output log file\n");
+    printf("  -S  strip signal samples (input/output log)\n");
+    printf("  -G  strip GPS data (output log)\n");
+    printf("  -A  strip azimuth data (output log)\n");
+}
+
+gint
+main(gint   argc,
+     gchar *argv[])
+{
+    const gchar *output_file = NULL;
+    gboolean strip_samples = FALSE;
+    gboolean strip_gps = FALSE;
+    gboolean strip_azi = FALSE;
+    GSList *filenames = NULL;
+    gint ret;
+    gint c;
+
+    while((c = getopt(argc, argv, "ho:SGA")) != -1)
+    {
+        switch(c)
+        {
+        case 'h':
+            mtscan_batch_usage();
+            return 0;
+
+        case 'o':
+            output_file = optarg;
+            break;
+
+        case 'S':
+            strip_samples = TRUE;
+            break;
+
+        case 'G':
+            strip_gps = TRUE;
+            break;
+
+        case 'A':
+            strip_azi = TRUE;
+            break;
+
+        default:
+            mtscan_batch_usage();
+            return -1;
+        }
+    }
+
+    if(!output_file)
+    {
+        fprintf(stderr, "ERROR: No output file specified.\n");
+        mtscan_batch_usage();
+        return -1;
+    }
+
+    for(c = optind; c < argc; c++)
+        filenames = g_slist_append(filenames, argv[c]);
+
+    ret = batch_merge(filenames, output_file, strip_samples, strip_gps, strip_azi);
+    g_slist_free(filenames);
+    return ret;
+}
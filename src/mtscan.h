@@ -22,6 +22,9 @@
 #define APP_ICON          "mtscan"
 #define APP_FILE_EXT      ".mtscan"
 #define APP_FILE_COMPRESS ".gz"
+#define APP_FILE_BINARY   ".mtb"
+#define APP_FILE_JOURNAL  "mtscan.journal"
+#define APP_CACHE_DIR     "mtscan"
 
 #ifdef G_OS_WIN32
 #define APP_SOUND_DIR "..\\share\\sounds\\mtscan"
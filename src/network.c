@@ -13,9 +13,12 @@
  *  GNU General Public License for more details.
  */
 
+#include <string.h>
+#include <limits.h>
 #include <math.h>
-#include "ui-icons.h"
-#include "model.h"
+#include "network.h"
+
+#define MAC_ADDR_HEX_LEN 12
 
 static void validate_utf8(gchar**, const gchar*);
 static void convert_to_utf8(gchar**, const gchar*);
@@ -30,8 +33,8 @@ network_init(network_t *net)
     net->streams = 0;
     net->ssid = NULL;
     net->radioname = NULL;
-    net->rssi = MODEL_NO_SIGNAL;
-    net->noise = MODEL_NO_SIGNAL;
+    net->rssi = NETWORK_NO_SIGNAL;
+    net->noise = NETWORK_NO_SIGNAL;
     net->flags.routeros = -1;
     net->flags.privacy = -1;
     net->flags.nstreme = -1;
@@ -57,6 +60,7 @@ network_init(network_t *net)
     net->accuracy = NAN;
     net->azimuth = NAN;
     net->distance = NAN;
+    net->source = -1;
     net->signals = NULL;
 }
 
@@ -140,3 +144,48 @@ network_free_null(network_t *net)
     net->wps_device_name = NULL;
     net->signals = NULL;
 }
+
+gint64
+str_addr_to_gint64(const gchar* str,
+                   gint         len)
+{
+    gchar buffer[MAC_ADDR_HEX_LEN+1];
+    gchar *ptr;
+    gint64 value;
+    gint i;
+
+    if(len == MAC_ADDR_HEX_LEN)
+    {
+        for(i=0; i<len; i++)
+        {
+            if(!((str[i] >= '0' && str[i] <= '9') ||
+                (str[i] >= 'A' && str[i] <= 'F') ||
+                (str[i] >= 'a' && str[i] <= 'f')))
+                return -1;
+        }
+
+        memcpy(buffer, str, MAC_ADDR_HEX_LEN);
+        buffer[MAC_ADDR_HEX_LEN] = '\0';
+        value = g_ascii_strtoll(buffer, &ptr, 16);
+        if(ptr != buffer)
+            return value;
+    }
+    return -1;
+}
+
+gboolean
+addr_to_guint8(gint64  addr,
+               guint8 *buff)
+{
+    guint8 *ptr;
+    gint i;
+
+    if(addr < 0)
+        return FALSE;
+
+    ptr = buff;
+    for(i=5; i>=0; i--)
+        *ptr++ = (guint8) (addr >> (CHAR_BIT * i));
+
+    return TRUE;
+}
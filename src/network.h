@@ -15,9 +15,11 @@
 
 #ifndef MTSCAN_NETWORK_H_
 #define MTSCAN_NETWORK_H_
-#include <gtk/gtk.h>
+#include <glib.h>
 #include "signals.h"
 
+#define NETWORK_NO_SIGNAL G_MININT8
+
 typedef struct network_flags
 {
     gint privacy;
@@ -59,6 +61,7 @@ typedef struct network
     gfloat accuracy;
     gfloat azimuth;
     gfloat distance;
+    gint64 source;
     signals_t *signals;
 } network_t;
 
@@ -67,5 +70,8 @@ void network_to_utf8(network_t*, const gchar*);
 void network_free(network_t*);
 void network_free_null(network_t*);
 
+gint64 str_addr_to_gint64(const gchar*, gint);
+gboolean addr_to_guint8(gint64, guint8*);
+
 #endif
 
@@ -13,19 +13,123 @@
  *  GNU General Public License for more details.
  */
 
+#include <stdio.h>
+#include <string.h>
 #include <math.h>
 #include "signals.h"
 
+/* Samples are stored in blocks, one array per field:
+ * - timestamp as an offset from the block base,
+ * - latitude and longitude in 1e-7 degree,
+ * - altitude and accuracy in whole meters (as displayed and logged),
+ * - azimuth in 1e-2 degree,
+ * - source as an index into a process-wide table.
+ * The first block of a list is small and each next one is twice as large,
+ * up to SIGNALS_BLOCK_MAX. Released blocks are kept for reuse in short
+ * free lists, one for each block size, the rest is freed.
+ * Copies share the blocks, a shared block is never written to again,
+ * so a copy stays valid until released, even from another thread.
+ * A list keeps the block before its tail and steps from it to the tail
+ * directly, so that a shared tail can be replaced by a private copy
+ * without changing what the copies of the list see.
+ * A block may also point at packed arrays in a mapped file (count equal
+ * to size), it holds a reference to the file and is never written to. */
+
+#define SIGNALS_BLOCK_MIN     4
+#define SIGNALS_BLOCK_MAX     256
+#define SIGNALS_BLOCK_CLASSES 7
+#define SIGNALS_ARENA_MAX     64
+#define SIGNALS_SOURCES_MAX   255
+
+#define SIGNALS_LATLON_SCALE  1e7
+#define SIGNALS_AZIMUTH_SCALE 1e2
+
+#define SIGNALS_NAN_LATLON    G_MININT32
+#define SIGNALS_NAN_ALTITUDE  G_MININT16
+#define SIGNALS_NAN_ACCURACY  G_MAXUINT16
+#define SIGNALS_NAN_AZIMUTH   G_MAXUINT16
+
+/* Arrays of each field follow the header, the widest first */
+struct signals_block
+{
+    struct signals_block *next;
+    gint64 base;
+    guint count;
+    guint size;
+    gint refs;
+    GMappedFile *file;
+    guint8 *data;
+};
+
+#define SIGNALS_FIELD(b, type, offset) ((type*)((b)->data + (offset) * (b)->size))
+#define SIGNALS_TIMESTAMP(b) SIGNALS_FIELD(b, guint32, 0)
+#define SIGNALS_LATITUDE(b)  SIGNALS_FIELD(b, gint32, 4)
+#define SIGNALS_LONGITUDE(b) SIGNALS_FIELD(b, gint32, 8)
+#define SIGNALS_ALTITUDE(b)  SIGNALS_FIELD(b, gint16, 12)
+#define SIGNALS_ACCURACY(b)  SIGNALS_FIELD(b, guint16, 14)
+#define SIGNALS_AZIMUTH(b)   SIGNALS_FIELD(b, guint16, 16)
+#define SIGNALS_RSSI(b)      SIGNALS_FIELD(b, gint8, 18)
+#define SIGNALS_SOURCE(b)    SIGNALS_FIELD(b, guint8, 19)
+#define SIGNALS_FIELDS       8
+
+/* Width of each field, in the order of the arrays */
+static const guint8 fields[SIGNALS_FIELDS] = { 4, 4, 4, 2, 2, 2, 1, 1 };
+
+static signals_block_t *arena[SIGNALS_BLOCK_CLASSES];
+static guint arena_length[SIGNALS_BLOCK_CLASSES];
+G_LOCK_DEFINE_STATIC(arena);
+
+static gint64 sources[SIGNALS_SOURCES_MAX];
+static gint sources_count = 0;
+static gboolean sources_overflow = FALSE;
+G_LOCK_DEFINE_STATIC(sources);
+
+typedef struct signals_cursor
+{
+    signals_block_t *block;
+    const signals_t *list;
+    guint index;
+} signals_cursor_t;
+
+#define SIGNALS_NEXT(b, prev, tail) ((b) == (tail) ? NULL : ((b) == (prev) ? (tail) : (b)->next))
+
+static signals_block_t* signals_reserve(signals_t*, gint64, guint*);
+static void signals_link(signals_t*, signals_block_t*);
+static void signals_append_raw(signals_t*, const signals_block_t*, guint);
+static gint signals_cursor_compare(const signals_cursor_t*, const signals_cursor_t*);
+static void signals_heap_down(signals_cursor_t*, guint, guint);
+static signals_block_t* signals_block_new(gint64, guint);
+static void signals_block_release(signals_block_t*, signals_block_t*, signals_block_t*);
+static guint signals_block_class(guint);
+static void signals_block_pack(const signals_block_t*, guint8*, gboolean, gboolean);
+static guint8 signals_source_encode(gint64);
+static gint64 signals_first(const signals_t*);
+static gint64 signals_last(const signals_t*);
+
+
 signals_t*
 signals_new(void)
 {
     return g_malloc0(sizeof(signals_t));
 }
 
-signals_node_t*
-signals_node_new0(void)
+signals_t*
+signals_copy(const signals_t *list)
+{
+    signals_t *copy = signals_new();
+    signals_block_t *block;
+
+    /* The copy must not be modified */
+    for(block=list->head; block; block=SIGNALS_NEXT(block, list->prev, list->tail))
+        g_atomic_int_inc(&block->refs);
+
+    *copy = *list;
+    return copy;
+}
+
+void
+signals_node_init(signals_node_t *sample)
 {
-    signals_node_t *sample = g_malloc(sizeof(signals_node_t));
     sample->timestamp = 0;
     sample->rssi = 0;
     sample->latitude = NAN;
@@ -33,113 +137,650 @@ signals_node_new0(void)
     sample->altitude = NAN;
     sample->accuracy = NAN;
     sample->azimuth = NAN;
-    return sample;
-}
-
-signals_node_t*
-signals_node_new(gint64  timestamp,
-                 gint8   rssi,
-                 gdouble latitude,
-                 gdouble longitude,
-                 gfloat  altitude,
-                 gfloat  accuracy,
-                 gfloat  azimuth)
-{
-    signals_node_t *sample = g_malloc(sizeof(signals_node_t));
-    sample->timestamp = timestamp;
-    sample->rssi = rssi;
-    sample->latitude = latitude;
-    sample->longitude = longitude;
-    sample->altitude = altitude;
-    sample->accuracy = accuracy;
-    sample->azimuth = azimuth;
-    return sample;
+    sample->source = -1;
 }
 
 void
-signals_append(signals_t      *list,
-               signals_node_t *sample)
+signals_append(signals_t            *list,
+               const signals_node_t *sample)
 {
-    sample->next = NULL;
-    if(!list->head)
+    signals_block_t *block;
+    gdouble azimuth;
+    glong value;
+    guint i;
+
+    block = signals_reserve(list, sample->timestamp, &i);
+    SIGNALS_RSSI(block)[i] = sample->rssi;
+
+    if(isnan(sample->latitude) || isnan(sample->longitude))
     {
-        list->head = sample;
-        list->tail = sample;
+        SIGNALS_LATITUDE(block)[i] = SIGNALS_NAN_LATLON;
+        SIGNALS_LONGITUDE(block)[i] = SIGNALS_NAN_LATLON;
     }
     else
     {
-        list->tail->next = sample;
-        list->tail = sample;
+        SIGNALS_LATITUDE(block)[i] = (gint32)lround(sample->latitude * SIGNALS_LATLON_SCALE);
+        SIGNALS_LONGITUDE(block)[i] = (gint32)lround(sample->longitude * SIGNALS_LATLON_SCALE);
+    }
+
+    if(isnan(sample->altitude))
+    {
+        SIGNALS_ALTITUDE(block)[i] = SIGNALS_NAN_ALTITUDE;
     }
+    else
+    {
+        value = lround(sample->altitude);
+        SIGNALS_ALTITUDE(block)[i] = (gint16)CLAMP(value, G_MININT16+1, G_MAXINT16);
+    }
+
+    if(isnan(sample->accuracy))
+    {
+        SIGNALS_ACCURACY(block)[i] = SIGNALS_NAN_ACCURACY;
+    }
+    else
+    {
+        value = lround(sample->accuracy);
+        SIGNALS_ACCURACY(block)[i] = (guint16)CLAMP(value, 0, G_MAXUINT16-1);
+    }
+
+    if(isnan(sample->azimuth))
+    {
+        SIGNALS_AZIMUTH(block)[i] = SIGNALS_NAN_AZIMUTH;
+    }
+    else
+    {
+        azimuth = fmod(sample->azimuth, 360.0);
+        if(azimuth < 0.0)
+            azimuth += 360.0;
+        value = lround(azimuth * SIGNALS_AZIMUTH_SCALE);
+        SIGNALS_AZIMUTH(block)[i] = (guint16)(value % (glong)(360 * SIGNALS_AZIMUTH_SCALE));
+    }
+
+    SIGNALS_SOURCE(block)[i] = signals_source_encode(sample->source);
+}
+
+void
+signals_add(signals_t *list,
+            gint64     timestamp,
+            gint8      rssi,
+            gdouble    latitude,
+            gdouble    longitude,
+            gfloat     altitude,
+            gfloat     accuracy,
+            gfloat     azimuth,
+            gint64     source)
+{
+    signals_node_t sample;
+
+    sample.timestamp = timestamp;
+    sample.rssi = rssi;
+    sample.latitude = latitude;
+    sample.longitude = longitude;
+    sample.altitude = altitude;
+    sample.accuracy = accuracy;
+    sample.azimuth = azimuth;
+    sample.source = source;
+    signals_append(list, &sample);
 }
 
 void
 signals_merge(signals_t *list,
               signals_t *merge)
 {
-    signals_node_t *current_list;
-    signals_node_t *current_merge;
-    signals_node_t *tmp;
-
     if(merge->head == NULL)
         return;
 
     if(list->head == NULL)
     {
         /* Move */
-        list->head = merge->head;
-        list->tail = merge->tail;
+        *list = *merge;
     }
-    else if(merge->tail->timestamp <= list->head->timestamp)
+    else if(signals_last(merge) <= signals_first(list))
     {
         /* Prepend */
         merge->tail->next = list->head;
+        if(!list->prev)
+            list->prev = merge->tail;
         list->head = merge->head;
+        list->count += merge->count;
     }
-    else if(merge->head->timestamp >= list->tail->timestamp)
+    else if(signals_first(merge) >= signals_last(list))
     {
         /* Append */
         list->tail->next = merge->head;
+        list->prev = (merge->prev ? merge->prev : list->tail);
         list->tail = merge->tail;
+        list->count += merge->count;
     }
     else
     {
         /* Insert */
-        current_list = list->head;
-        current_merge = merge->head;
-        while(current_merge)
-        {
-            tmp = current_merge->next;
-
-            while (current_list->next &&
-                   current_list->next->timestamp < current_merge->timestamp)
-            {
-                current_list = current_list->next;
-            }
-            if(!current_list->next)
-                list->tail = current_merge;
-            current_merge->next = current_list->next;
-            current_list->next = current_merge;
-
-            current_list = current_merge;
-            current_merge = tmp;
-        }
+        signals_merge_all(list, &merge, 1);
+        return;
     }
 
     merge->head = NULL;
     merge->tail = NULL;
+    merge->prev = NULL;
+    merge->count = 0;
 }
 
 void
-signals_free(signals_t *list)
+signals_merge_all(signals_t  *list,
+                  signals_t **merge,
+                  guint       count)
 {
-    signals_node_t *current = list->head;
-    signals_node_t *next;
-    while(current)
+    signals_t output = { NULL, NULL, NULL, 0 };
+    signals_cursor_t *heap;
+    signals_cursor_t last = { NULL, NULL, 0 };
+    guint n = 0;
+    guint i;
+
+    /* k-way merge, samples equal in all fields but the source are stored once */
+    heap = g_new(signals_cursor_t, count + 1);
+
+    if(list->head)
+    {
+        heap[n].block = list->head;
+        heap[n].list = list;
+        heap[n++].index = 0;
+    }
+
+    for(i=0; i<count; i++)
+    {
+        if(merge[i]->head)
+        {
+            heap[n].block = merge[i]->head;
+            heap[n].list = merge[i];
+            heap[n++].index = 0;
+        }
+    }
+
+    for(i=n/2; i-- > 0;)
+        signals_heap_down(heap, n, i);
+
+    while(n)
+    {
+        if(!last.block || signals_cursor_compare(&last, &heap[0]) != 0)
+            signals_append_raw(&output, heap[0].block, heap[0].index);
+        last = heap[0];
+
+        if(++heap[0].index >= heap[0].block->count)
+        {
+            heap[0].block = SIGNALS_NEXT(heap[0].block, heap[0].list->prev, heap[0].list->tail);
+            heap[0].index = 0;
+            if(!heap[0].block)
+                heap[0] = heap[--n];
+        }
+
+        if(n)
+            signals_heap_down(heap, n, 0);
+    }
+
+    g_free(heap);
+
+    /* Source blocks are still referenced by the cursors until here */
+    if(list->head)
+        signals_block_release(list->head, list->prev, list->tail);
+
+    for(i=0; i<count; i++)
+    {
+        if(merge[i]->head)
+            signals_block_release(merge[i]->head, merge[i]->prev, merge[i]->tail);
+        merge[i]->head = NULL;
+        merge[i]->tail = NULL;
+        merge[i]->prev = NULL;
+        merge[i]->count = 0;
+    }
+
+    *list = output;
+}
+
+void
+signals_adopt(signals_t     *list,
+              GMappedFile   *file,
+              gint64         base,
+              guint          count,
+              const guint8  *data,
+              const guint8  *map)
+{
+    signals_block_t *block;
+    guint offset;
+    guint length;
+    guint size;
+    guint pos;
+    guint i;
+
+    if(!count)
+        return;
+
+    if(!map)
     {
-        next = current->next;
-        g_free(current);
-        current = next;
+        /* Zero-copy, the block points into the file */
+        block = g_malloc(sizeof(signals_block_t));
+        block->next = NULL;
+        block->base = base;
+        block->count = count;
+        block->size = count;
+        block->refs = 1;
+        block->file = g_mapped_file_ref(file);
+        block->data = (guint8*)data;
+        signals_link(list, block);
+        list->count += count;
+        return;
+    }
+
+    /* Sources of the file are numbered differently, copy whole arrays */
+    for(offset=0; offset<count; offset+=length)
+    {
+        length = MIN(count - offset, SIGNALS_BLOCK_MAX);
+        for(size=SIGNALS_BLOCK_MIN; size<length; size*=2);
+        block = signals_block_new(base, size);
+
+        for(i=0, pos=0; i<SIGNALS_FIELDS-1; pos+=fields[i++])
+            memcpy(block->data + pos * size, data + pos * count + offset * fields[i], length * fields[i]);
+
+        for(i=0; i<length; i++)
+            SIGNALS_SOURCE(block)[i] = map[data[pos * count + offset + i]];
+
+        block->count = length;
+        signals_link(list, block);
+        list->count += length;
     }
+}
+
+void
+signals_pack(const signals_t *list,
+             gboolean         strip_gps,
+             gboolean         strip_azi,
+             void           (*block_cb)(gint64, guint, const guint8*, gpointer),
+             gpointer         user_data)
+{
+    const signals_block_t *block;
+    guint8 *buffer = NULL;
+    guint length = 0;
+
+    for(block=list->head; block; block=SIGNALS_NEXT(block, list->prev, list->tail))
+    {
+        if(block->count == block->size && !strip_gps && !strip_azi)
+        {
+            /* Full blocks are already packed */
+            block_cb(block->base, block->count, block->data, user_data);
+            continue;
+        }
+
+        if(block->count > length)
+        {
+            length = block->count;
+            buffer = g_realloc(buffer, length * SIGNALS_SAMPLE_SIZE);
+        }
+
+        signals_block_pack(block, buffer, strip_gps, strip_azi);
+        block_cb(block->base, block->count, buffer, user_data);
+    }
+
+    g_free(buffer);
+}
+
+guint8
+signals_source_index(gint64 source)
+{
+    return signals_source_encode(source);
+}
+
+guint
+signals_source_table(const gint64 **table)
+{
+    /* Entries are never changed once added */
+    *table = sources;
+    return (guint)g_atomic_int_get(&sources_count);
+}
+
+gsize
+signals_count(const signals_t *list)
+{
+    return list->count;
+}
+
+void
+signals_free(signals_t *list)
+{
+    if(list->head)
+        signals_block_release(list->head, list->prev, list->tail);
     g_free(list);
 }
+
+void
+signals_iter_init(signals_iter_t  *iter,
+                  const signals_t *list)
+{
+    iter->block = list->head;
+    iter->prev = list->prev;
+    iter->tail = list->tail;
+    iter->index = 0;
+}
+
+gboolean
+signals_iter_next(signals_iter_t *iter,
+                  signals_node_t *sample)
+{
+    const signals_block_t *block = iter->block;
+    guint i;
+
+    while(block && iter->index >= block->count)
+    {
+        block = SIGNALS_NEXT(block, iter->prev, iter->tail);
+        iter->index = 0;
+    }
+
+    iter->block = block;
+    if(!block)
+        return FALSE;
+
+    i = iter->index++;
+    sample->timestamp = block->base + SIGNALS_TIMESTAMP(block)[i];
+    sample->rssi = SIGNALS_RSSI(block)[i];
+
+    if(SIGNALS_LATITUDE(block)[i] == SIGNALS_NAN_LATLON)
+    {
+        sample->latitude = NAN;
+        sample->longitude = NAN;
+    }
+    else
+    {
+        sample->latitude = SIGNALS_LATITUDE(block)[i] / SIGNALS_LATLON_SCALE;
+        sample->longitude = SIGNALS_LONGITUDE(block)[i] / SIGNALS_LATLON_SCALE;
+    }
+
+    sample->altitude = (SIGNALS_ALTITUDE(block)[i] == SIGNALS_NAN_ALTITUDE ? NAN : SIGNALS_ALTITUDE(block)[i]);
+    sample->accuracy = (SIGNALS_ACCURACY(block)[i] == SIGNALS_NAN_ACCURACY ? NAN : SIGNALS_ACCURACY(block)[i]);
+    sample->azimuth = (SIGNALS_AZIMUTH(block)[i] == SIGNALS_NAN_AZIMUTH ? NAN : SIGNALS_AZIMUTH(block)[i] / SIGNALS_AZIMUTH_SCALE);
+    sample->source = (SIGNALS_SOURCE(block)[i] ? sources[SIGNALS_SOURCE(block)[i] - 1] : -1);
+    return TRUE;
+}
+
+static signals_block_t*
+signals_reserve(signals_t *list,
+                gint64     timestamp,
+                guint     *index)
+{
+    signals_block_t *block = list->tail;
+    signals_block_t *copy;
+    guint size;
+    guint pos;
+    guint i;
+
+    if(block &&
+       block->count < block->size &&
+       timestamp >= block->base &&
+       timestamp - block->base <= G_MAXUINT32 &&
+       g_atomic_int_get(&block->refs) > 1)
+    {
+        /* Copy on write, the copies keep the shared tail */
+        copy = signals_block_new(block->base, block->size);
+        for(i=0, pos=0; i<SIGNALS_FIELDS; pos+=fields[i++])
+            memcpy(copy->data + pos * copy->size, block->data + pos * block->size, block->count * fields[i]);
+        copy->count = block->count;
+
+        if(list->prev)
+            list->prev->next = copy;
+        else
+            list->head = copy;
+        list->tail = copy;
+        signals_block_release(block, NULL, block);
+        block = copy;
+    }
+
+    if(!block ||
+       block->count == block->size ||
+       timestamp < block->base ||
+       timestamp - block->base > G_MAXUINT32)
+    {
+        /* A block that is not full is left behind only when out of range */
+        if(block && block->count == block->size)
+            size = MIN(block->size * 2, SIGNALS_BLOCK_MAX);
+        else
+            size = SIGNALS_BLOCK_MIN;
+
+        block = signals_block_new(timestamp, size);
+        signals_link(list, block);
+    }
+
+    *index = block->count++;
+    SIGNALS_TIMESTAMP(block)[*index] = (guint32)(timestamp - block->base);
+    list->count++;
+    return block;
+}
+
+static void
+signals_link(signals_t       *list,
+             signals_block_t *block)
+{
+    if(list->tail)
+    {
+        list->tail->next = block;
+        list->prev = list->tail;
+    }
+    else
+    {
+        list->head = block;
+    }
+    list->tail = block;
+}
+
+static void
+signals_append_raw(signals_t             *list,
+                   const signals_block_t *source,
+                   guint                  j)
+{
+    signals_block_t *block;
+    guint i;
+
+    block = signals_reserve(list, source->base + SIGNALS_TIMESTAMP(source)[j], &i);
+    SIGNALS_RSSI(block)[i] = SIGNALS_RSSI(source)[j];
+    SIGNALS_LATITUDE(block)[i] = SIGNALS_LATITUDE(source)[j];
+    SIGNALS_LONGITUDE(block)[i] = SIGNALS_LONGITUDE(source)[j];
+    SIGNALS_ALTITUDE(block)[i] = SIGNALS_ALTITUDE(source)[j];
+    SIGNALS_ACCURACY(block)[i] = SIGNALS_ACCURACY(source)[j];
+    SIGNALS_AZIMUTH(block)[i] = SIGNALS_AZIMUTH(source)[j];
+    SIGNALS_SOURCE(block)[i] = SIGNALS_SOURCE(source)[j];
+}
+
+#define SIGNALS_COMPARE(a, b) if((a) != (b)) return ((a) < (b) ? -1 : 1)
+
+static gint
+signals_cursor_compare(const signals_cursor_t *a,
+                       const signals_cursor_t *b)
+{
+    const signals_block_t *x = a->block;
+    const signals_block_t *y = b->block;
+    guint i = a->index;
+    guint j = b->index;
+
+    SIGNALS_COMPARE(x->base + SIGNALS_TIMESTAMP(x)[i], y->base + SIGNALS_TIMESTAMP(y)[j]);
+    SIGNALS_COMPARE(SIGNALS_RSSI(x)[i], SIGNALS_RSSI(y)[j]);
+    SIGNALS_COMPARE(SIGNALS_LATITUDE(x)[i], SIGNALS_LATITUDE(y)[j]);
+    SIGNALS_COMPARE(SIGNALS_LONGITUDE(x)[i], SIGNALS_LONGITUDE(y)[j]);
+    SIGNALS_COMPARE(SIGNALS_ALTITUDE(x)[i], SIGNALS_ALTITUDE(y)[j]);
+    SIGNALS_COMPARE(SIGNALS_ACCURACY(x)[i], SIGNALS_ACCURACY(y)[j]);
+    SIGNALS_COMPARE(SIGNALS_AZIMUTH(x)[i], SIGNALS_AZIMUTH(y)[j]);
+    return 0;
+}
+
+static void
+signals_heap_down(signals_cursor_t *heap,
+                  guint             n,
+                  guint             i)
+{
+    signals_cursor_t tmp;
+    guint child;
+
+    while((child = 2*i + 1) < n)
+    {
+        if(child + 1 < n && signals_cursor_compare(&heap[child+1], &heap[child]) < 0)
+            child++;
+        if(signals_cursor_compare(&heap[i], &heap[child]) <= 0)
+            break;
+        tmp = heap[i];
+        heap[i] = heap[child];
+        heap[child] = tmp;
+        i = child;
+    }
+}
+
+static signals_block_t*
+signals_block_new(gint64 base,
+                  guint  size)
+{
+    signals_block_t *block;
+    guint i = signals_block_class(size);
+
+    G_LOCK(arena);
+    if((block = arena[i]))
+    {
+        arena[i] = block->next;
+        arena_length[i]--;
+    }
+    G_UNLOCK(arena);
+
+    if(!block)
+    {
+        block = g_malloc(sizeof(signals_block_t) + size * SIGNALS_SAMPLE_SIZE);
+        block->size = size;
+        block->file = NULL;
+        block->data = (guint8*)(block + 1);
+    }
+
+    block->next = NULL;
+    block->base = base;
+    block->count = 0;
+    block->refs = 1;
+    return block;
+}
+
+static void
+signals_block_release(signals_block_t *head,
+                      signals_block_t *prev,
+                      signals_block_t *tail)
+{
+    signals_block_t *block;
+    signals_block_t *next;
+    guint i;
+
+    G_LOCK(arena);
+    for(block=head; block; block=next)
+    {
+        next = SIGNALS_NEXT(block, prev, tail);
+        if(!g_atomic_int_dec_and_test(&block->refs))
+            continue;
+
+        if(block->file)
+        {
+            g_mapped_file_unref(block->file);
+            g_free(block);
+            continue;
+        }
+
+        i = signals_block_class(block->size);
+        if(arena_length[i] < SIGNALS_ARENA_MAX)
+        {
+            block->next = arena[i];
+            arena[i] = block;
+            arena_length[i]++;
+        }
+        else
+        {
+            g_free(block);
+        }
+    }
+    G_UNLOCK(arena);
+}
+
+static guint
+signals_block_class(guint size)
+{
+    guint i = 0;
+
+    while(size > SIGNALS_BLOCK_MIN)
+    {
+        size >>= 1;
+        i++;
+    }
+    return i;
+}
+
+static void
+signals_block_pack(const signals_block_t *block,
+                   guint8                *data,
+                   gboolean               strip_gps,
+                   gboolean               strip_azi)
+{
+    guint count = block->count;
+    guint pos;
+    guint i;
+
+    for(i=0, pos=0; i<SIGNALS_FIELDS; pos+=fields[i++])
+        memcpy(data + pos * count, block->data + pos * block->size, count * fields[i]);
+
+    for(i=0; i<count; i++)
+    {
+        if(strip_gps)
+        {
+            ((gint32*)(data + 4 * count))[i] = SIGNALS_NAN_LATLON;
+            ((gint32*)(data + 8 * count))[i] = SIGNALS_NAN_LATLON;
+            ((gint16*)(data + 12 * count))[i] = SIGNALS_NAN_ALTITUDE;
+            ((guint16*)(data + 14 * count))[i] = SIGNALS_NAN_ACCURACY;
+        }
+        if(strip_azi)
+            ((guint16*)(data + 16 * count))[i] = SIGNALS_NAN_AZIMUTH;
+    }
+}
+
+static guint8
+signals_source_encode(gint64 source)
+{
+    gint count;
+    gint i;
+
+    if(source < 0)
+        return 0;
+
+    count = g_atomic_int_get(&sources_count);
+    for(i=0; i<count; i++)
+        if(sources[i] == source)
+            return (guint8)(i + 1);
+
+    G_LOCK(sources);
+    for(i=0; i<sources_count; i++)
+        if(sources[i] == source)
+            break;
+
+    if(i == sources_count)
+    {
+        if(sources_count == SIGNALS_SOURCES_MAX)
+        {
+            /* Table is full, the source is not recorded */
+            if(!sources_overflow)
+                fprintf(stderr, "WARNING: More than %d signal sources, further sources are not recorded.\n", SIGNALS_SOURCES_MAX);
+            sources_overflow = TRUE;
+            G_UNLOCK(sources);
+            return 0;
+        }
+        sources[i] = source;
+        g_atomic_int_inc(&sources_count);
+    }
+    G_UNLOCK(sources);
+    return (guint8)(i + 1);
+}
+
+static gint64
+signals_first(const signals_t *list)
+{
+    return list->head->base + SIGNALS_TIMESTAMP(list->head)[0];
+}
+
+static gint64
+signals_last(const signals_t *list)
+{
+    return list->tail->base + SIGNALS_TIMESTAMP(list->tail)[list->tail->count - 1];
+}
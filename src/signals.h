@@ -19,7 +19,6 @@
 
 typedef struct signals_node
 {
-    struct signals_node *next;
     gint64 timestamp;
     gdouble latitude;
     gdouble longitude;
@@ -27,19 +26,45 @@ typedef struct signals_node
     gfloat accuracy;
     gint8 rssi;
     gfloat azimuth;
+    gint64 source;
 } signals_node_t;
 
+/* Samples are stored quantized, see signals.c */
+#define SIGNALS_SAMPLE_SIZE 20
+
+typedef struct signals_block signals_block_t;
+
 typedef struct signals
 {
-    signals_node_t *head;
-    signals_node_t *tail;
+    signals_block_t *head;
+    signals_block_t *tail;
+    signals_block_t *prev;
+    gsize count;
 } signals_t;
 
+typedef struct signals_iter
+{
+    const signals_block_t *block;
+    const signals_block_t *prev;
+    const signals_block_t *tail;
+    guint index;
+} signals_iter_t;
+
 signals_t* signals_new(void);
-signals_node_t* signals_node_new0(void);
-signals_node_t* signals_node_new(gint64, gint8, gdouble, gdouble, gfloat, gfloat, gfloat);
-void signals_append(signals_t*, signals_node_t*);
+signals_t* signals_copy(const signals_t*);
+void signals_node_init(signals_node_t*);
+void signals_append(signals_t*, const signals_node_t*);
+void signals_add(signals_t*, gint64, gint8, gdouble, gdouble, gfloat, gfloat, gfloat, gint64);
 void signals_merge(signals_t*, signals_t*);
+void signals_merge_all(signals_t*, signals_t**, guint);
+void signals_adopt(signals_t*, GMappedFile*, gint64, guint, const guint8*, const guint8*);
+void signals_pack(const signals_t*, gboolean, gboolean, void (*)(gint64, guint, const guint8*, gpointer), gpointer);
+guint8 signals_source_index(gint64);
+guint signals_source_table(const gint64**);
+gsize signals_count(const signals_t*);
 void signals_free(signals_t*);
 
+void signals_iter_init(signals_iter_t*, const signals_t*);
+gboolean signals_iter_next(signals_iter_t*, signals_node_t*);
+
 #endif
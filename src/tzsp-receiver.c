@@ -1,37 +1,93 @@
 #include <glib.h>
 #include <string.h>
+#include <zlib.h>
 #include "tzsp/tzsp-socket.h"
 #include "tzsp/mac80211.h"
+#include "tzsp/ie-mikrotik-utils.h"
 #include "network.h"
 #include "tzsp-receiver.h"
 #include "tzsp/cambium.h"
 
-typedef struct tzsp_receiver
+#define TZSP_RECEIVER_TICK 100
+
+/* Cached BSSIDs not seen for a while are dropped, the cache is
+   cleared entirely if it is still full (e.g. random BSSID floods) */
+#define TZSP_RECEIVER_CACHE_TIMEOUT 60
+#define TZSP_RECEIVER_CACHE_MAX     4096
+
+/* Beacon body: interval and capabilities, followed by tags */
+#define TZSP_RECEIVER_BODY_FIXED_LEN 4
+#define TZSP_RECEIVER_TAG_TIM        0x05
+#define TZSP_RECEIVER_TAG_BSS_LOAD   0x0B
+
+/* Several sniffers may stream to the same UDP port, packets are
+   demultiplexed by the sensor address into separate contexts */
+
+typedef struct tzsp_receiver_sensor
 {
-    tzsp_socket_t *tzsp_socket;
+    gint64 address;
     gint channel_width;
     gint frequency_base;
+    guint32 packets;
+    guint32 drops;
+
+    /* Decoded attributes per BSSID, used from the TZSP thread only */
+    GHashTable *cache;
+    gint64 cache_sweep;
+} tzsp_receiver_sensor_t;
+
+typedef struct tzsp_receiver
+{
+    tzsp_socket_t *tzsp_socket;
     void (*cb_final)(tzsp_receiver_t*);
     void (*cb_network)(const tzsp_receiver_t*, network_t*);
-    uint8_t hw_addr[6];
+
+    /* Sensors by address, the lock is held while a packet is processed */
+    GMutex sensors_mutex;
+    GHashTable *sensors;
+    guint32 unknown;
+
+    /* Latest observation per BSSID, drained from main thread */
+    GMutex pending_mutex;
+    GHashTable *pending;
+    guint tick_id;
 } tzsp_receiver_t;
 
-typedef struct tzsp_receiver_net
+typedef struct tzsp_receiver_cache
 {
-    tzsp_receiver_t *context;
-    network_t *network;
-} tzsp_receiver_net_t;
-
+    gint64 key;
+    guint32 hash;
+    guint32 length;
+    gint64 lastseen;
+    network_t network;
+} tzsp_receiver_cache_t;
+
+static void tzsp_receiver_sensor_free(gpointer);
 static gpointer tzsp_receiver_thread(gpointer);
 static void tzsp_receiver_packet(const uint8_t*, uint32_t, const int8_t*, const uint8_t*, const uint8_t*, gpointer);
-static gboolean tzsp_receiver_callback_network(gpointer);
+static gboolean tzsp_receiver_packet_sensor(tzsp_receiver_sensor_t*, tzsp_receiver_t*, const uint8_t*, uint32_t, const int8_t*, const uint8_t*, const uint8_t*);
+static network_t* tzsp_receiver_network_new(const uint8_t*, const uint8_t*);
+static void tzsp_receiver_update(network_t*, const mac80211_frame_t*, const int8_t*, const uint8_t*, gint, gint);
+static gint64 tzsp_receiver_address(const uint8_t*);
+static void tzsp_receiver_set_string(gchar**, const uint8_t*, gsize);
+static void tzsp_receiver_set_cstring(gchar**, const gchar*);
+static tzsp_receiver_cache_t* tzsp_receiver_cache_get(tzsp_receiver_sensor_t*, const uint8_t*, uint32_t, gint, gint64, gint64, const uint8_t*, const tzsp_view_t*);
+static guint32 tzsp_receiver_cache_hash(const uint8_t*, const tzsp_view_t*, guint32*);
+static void tzsp_receiver_cache_sweep(tzsp_receiver_sensor_t*, gint64);
+static gboolean tzsp_receiver_cache_expired(gpointer, gpointer, gpointer);
+static void tzsp_receiver_cache_free(gpointer);
+static void tzsp_receiver_apply(network_t*, const network_t*);
+static void tzsp_receiver_merge_string(gchar**, gchar**);
+static GHashTable* tzsp_receiver_pending_new(void);
+static void tzsp_receiver_pending_free(gpointer);
+static gboolean tzsp_receiver_callback_tick(gpointer);
 static gboolean tzsp_receiver_callback_final(gpointer);
 
+
 tzsp_receiver_t*
 tzsp_receiver_new(guint16       udp_port,
-                  guint8        hw_addr[6],
-                  gint          channel_width,
-                  gint          frequency_base,
+                  gint          buffer_size,
+                  gboolean      filter,
                   void        (*cb_final) (tzsp_receiver_t*),
                   void        (*cb_network)(const tzsp_receiver_t*, network_t*))
 {
@@ -40,22 +96,33 @@ tzsp_receiver_new(guint16       udp_port,
 
     socket = tzsp_socket_new();
     if(socket == NULL ||
-       tzsp_socket_init(socket, udp_port, NULL, NULL) != TZSP_SOCKET_OK)
+       tzsp_socket_init(socket, udp_port, NULL) != TZSP_SOCKET_OK)
     {
         tzsp_socket_free(socket);
         return NULL;
     }
 
+    /* The kernel may limit the buffer size, this is not an error */
+    tzsp_socket_set_buffer(socket, buffer_size);
+
+    /* Drop uninteresting frames before they reach the userspace */
+    if(filter)
+        tzsp_socket_set_filter(socket);
+
     context = g_malloc0(sizeof(tzsp_receiver_t));
     context->tzsp_socket = socket;
     tzsp_socket_set_func(socket, tzsp_receiver_packet, context);
 
-    memcpy(context->hw_addr, hw_addr, 6);
-    context->channel_width = channel_width;
-    context->frequency_base = frequency_base;
     context->cb_final = cb_final;
     context->cb_network = cb_network;
 
+    g_mutex_init(&context->sensors_mutex);
+    context->sensors = g_hash_table_new_full(g_int64_hash, g_int64_equal, NULL, tzsp_receiver_sensor_free);
+
+    g_mutex_init(&context->pending_mutex);
+    context->pending = tzsp_receiver_pending_new();
+    context->tick_id = g_timeout_add(TZSP_RECEIVER_TICK, tzsp_receiver_callback_tick, context);
+
     g_thread_unref(g_thread_new("tzsp_receiver_thread", tzsp_receiver_thread, context));
     return context;
 }
@@ -63,7 +130,89 @@ tzsp_receiver_new(guint16       udp_port,
 void
 tzsp_receiver_free(tzsp_receiver_t *context)
 {
-    g_free(context);
+    if(context)
+    {
+        if(context->tick_id)
+            g_source_remove(context->tick_id);
+
+        g_hash_table_destroy(context->pending);
+        g_mutex_clear(&context->pending_mutex);
+        g_hash_table_destroy(context->sensors);
+        g_mutex_clear(&context->sensors_mutex);
+        g_free(context);
+    }
+}
+
+void
+tzsp_receiver_add_sensor(tzsp_receiver_t *context,
+                         gint64           address,
+                         gint             channel_width,
+                         gint             frequency_base)
+{
+    tzsp_receiver_sensor_t *sensor;
+
+    g_mutex_lock(&context->sensors_mutex);
+    sensor = g_hash_table_lookup(context->sensors, &address);
+    if(!sensor)
+    {
+        sensor = g_malloc0(sizeof(tzsp_receiver_sensor_t));
+        sensor->address = address;
+        sensor->cache = g_hash_table_new_full(g_int64_hash, g_int64_equal, NULL, tzsp_receiver_cache_free);
+        g_hash_table_insert(context->sensors, &sensor->address, sensor);
+    }
+    else if(sensor->channel_width != channel_width ||
+            sensor->frequency_base != frequency_base)
+    {
+        /* Decoded attributes depend on the sensor parameters */
+        g_hash_table_remove_all(sensor->cache);
+    }
+
+    sensor->channel_width = channel_width;
+    sensor->frequency_base = frequency_base;
+    g_mutex_unlock(&context->sensors_mutex);
+}
+
+void
+tzsp_receiver_remove_sensor(tzsp_receiver_t *context,
+                            gint64           address)
+{
+    g_mutex_lock(&context->sensors_mutex);
+    g_hash_table_remove(context->sensors, &address);
+    g_mutex_unlock(&context->sensors_mutex);
+}
+
+void
+tzsp_receiver_foreach_sensor(tzsp_receiver_t  *context,
+                             void            (*func)(gint64, guint32, guint32, gpointer),
+                             gpointer          user_data)
+{
+    GHashTableIter iter;
+    tzsp_receiver_sensor_t *sensor;
+
+    g_mutex_lock(&context->sensors_mutex);
+    g_hash_table_iter_init(&iter, context->sensors);
+    while(g_hash_table_iter_next(&iter, NULL, (gpointer*)&sensor))
+        func(sensor->address, sensor->packets, sensor->drops, user_data);
+    g_mutex_unlock(&context->sensors_mutex);
+}
+
+guint32
+tzsp_receiver_get_unknown(tzsp_receiver_t *context)
+{
+    guint32 value;
+
+    g_mutex_lock(&context->sensors_mutex);
+    value = context->unknown;
+    g_mutex_unlock(&context->sensors_mutex);
+    return value;
+}
+
+static void
+tzsp_receiver_sensor_free(gpointer data)
+{
+    tzsp_receiver_sensor_t *sensor = (tzsp_receiver_sensor_t*)data;
+    g_hash_table_destroy(sensor->cache);
+    g_free(sensor);
 }
 
 static gpointer
@@ -85,294 +234,720 @@ tzsp_receiver_packet(const uint8_t *packet,
 {
     /* Function called from the TZSP thread */
     tzsp_receiver_t *context = (tzsp_receiver_t*)user_data;
-    mac80211_net_t *net_80211 = NULL;
-    nv2_net_t *net_nv2 = NULL;
-    cambium_net_t *net_cambium = NULL;
-    const uint8_t *src;
-    tzsp_receiver_net_t *data;
-    gint channel = -1;
+    tzsp_receiver_sensor_t *sensor;
+    gint64 address;
 
     /* Ignore pre-6.41 TZSP packets with no sensor address included */
     if(sensor_mac == NULL)
         return;
 
-    /* Make sure that sensor address matches the desired one */
-    if(memcmp(sensor_mac, context->hw_addr, 6) != 0)
-        return;
+    address = tzsp_receiver_address(sensor_mac);
+
+    /* Make sure that sensor address matches one of the desired ones */
+    g_mutex_lock(&context->sensors_mutex);
+    sensor = g_hash_table_lookup(context->sensors, &address);
+    if(sensor)
+    {
+        sensor->packets++;
+        if(!tzsp_receiver_packet_sensor(sensor, context, packet, len, rssi, tzsp_channel, sensor_mac))
+            sensor->drops++;
+    }
+    else
+    {
+        context->unknown++;
+    }
+    g_mutex_unlock(&context->sensors_mutex);
+}
+
+static gboolean
+tzsp_receiver_packet_sensor(tzsp_receiver_sensor_t *sensor,
+                            tzsp_receiver_t        *context,
+                            const uint8_t          *packet,
+                            uint32_t                len,
+                            const int8_t           *rssi,
+                            const uint8_t          *tzsp_channel,
+                            const uint8_t          *sensor_mac)
+{
+    tzsp_receiver_cache_t *entry;
+    network_t *network;
+    network_t *current;
+    const uint8_t *src;
+    tzsp_view_t body;
+    gint64 address;
+    gint64 now;
+    gint type;
+
+    now = g_get_real_time() / 1000000;
+
+    type = mac80211_header(packet, len, &src, &body);
+    if(type == MAC80211_FRAME_BEACON ||
+       type == MAC80211_FRAME_PROBE_RESPONSE)
+    {
+        address = tzsp_receiver_address(src);
+        entry = tzsp_receiver_cache_get(sensor, packet, len, type, address, now, tzsp_channel, &body);
+        if(!entry)
+            return FALSE;
+
+        /* Update the pending observation in place, strings are copied only if changed */
+        g_mutex_lock(&context->pending_mutex);
+        current = g_hash_table_lookup(context->pending, &address);
+        if(!current)
+        {
+            current = tzsp_receiver_network_new(src, sensor_mac);
+            current->firstseen = now;
+            g_hash_table_insert(context->pending, &current->address, current);
+        }
+        tzsp_receiver_apply(current, &entry->network);
+        if(rssi && *rssi >= current->rssi)
+        {
+            /* The network is attributed to the sensor with the strongest signal */
+            current->rssi = *rssi;
+            current->source = sensor->address;
+        }
+        current->lastseen = now;
+        g_mutex_unlock(&context->pending_mutex);
+        return TRUE;
+    }
+
+    network = tzsp_receiver_network(packet,
+                                    len,
+                                    rssi,
+                                    tzsp_channel,
+                                    sensor_mac,
+                                    sensor->channel_width,
+                                    sensor->frequency_base);
+    if(!network)
+        return FALSE;
+
+    network->firstseen = now;
+    network->lastseen = now;
+
+    /* Network must be added from main thread, keep only the latest observation until next tick */
+    g_mutex_lock(&context->pending_mutex);
+    current = g_hash_table_lookup(context->pending, &network->address);
+    if(current)
+    {
+        tzsp_receiver_merge(current, network);
+        network_free(network);
+        g_free(network);
+    }
+    else
+    {
+        g_hash_table_insert(context->pending, &network->address, network);
+    }
+    g_mutex_unlock(&context->pending_mutex);
+    return TRUE;
+}
+
+network_t*
+tzsp_receiver_network(const uint8_t *packet,
+                      uint32_t       len,
+                      const int8_t  *rssi,
+                      const uint8_t *tzsp_channel,
+                      const uint8_t *sensor_mac,
+                      gint           channel_width,
+                      gint           frequency_base)
+{
+    mac80211_frame_t frame;
+    nv2_net_t *net_nv2 = NULL;
+    cambium_net_t *net_cambium = NULL;
+    const uint8_t *src;
+    network_t *network;
+    gint type;
+    gint channel;
 
     /* Try nv2 parser */
     net_nv2 = nv2_network(packet, len, &src);
     if(!net_nv2)
     {
         /* Try mac80211 parser */
-        net_80211 = mac80211_network(packet, len, &src);
-        if(!net_80211)
+        type = mac80211_parse(packet, len, &frame);
+        if(type == MAC80211_FRAME_BEACON ||
+           type == MAC80211_FRAME_PROBE_RESPONSE)
         {
-            /* This is not a IEEE 802.11 frame */
+            network = tzsp_receiver_network_new(frame.src, sensor_mac);
+            tzsp_receiver_update(network, &frame, rssi, tzsp_channel, channel_width, frequency_base);
+            return network;
+        }
+
+        /* This is not a IEEE 802.11 beacon, try cambium parser */
+        net_cambium = cambium_network(packet, len, &src);
+        if(!net_cambium)
+            return NULL;
+    }
+
+    network = tzsp_receiver_network_new(src, sensor_mac);
+
+    /* Fill the signal level value */
+    if(rssi)
+        network->rssi = *rssi;
+
+    /* Default values */
+    network->flags.routeros = 0;
+    network->ubnt_airmax = 0;
+    network->wps = 0;
+
+    /* Guess the band from the channel number, if not known */
+    if(!frequency_base)
+    {
+        channel = (tzsp_channel ? *tzsp_channel : -1);
+        frequency_base = (channel > 14 && channel < 128) ? 5000 : 2407;
+    }
+
+    if(net_nv2)
+    {
+        network->ssid = g_strdup(nv2_net_get_ssid(net_nv2));
+        network->radioname = g_strdup(nv2_net_get_radioname(net_nv2));
+        network->routeros_ver = g_strdup(nv2_net_get_version(net_nv2));
+
+        if(nv2_net_get_frequency(net_nv2))
+            network->frequency = nv2_net_get_frequency(net_nv2) * 1000;
 
-            /* Try cambium parser */
-            net_cambium = cambium_network(packet, len, &src);
-            if(!net_cambium)
-                return;
+        network->flags.privacy = nv2_net_is_privacy(net_nv2);
+        network->flags.routeros = 1;
+        network->flags.nstreme = 0;
+        network->flags.tdma = 1;
+        network->flags.wds = nv2_net_is_wds(net_nv2);
+        network->flags.bridge = nv2_net_is_bridge(net_nv2);
+
+        if(nv2_net_get_ext_channel(net_nv2))
+            network->channel = g_strdup_printf("%d-%s", channel_width, nv2_net_get_ext_channel(net_nv2));
+        else
+            network->channel = g_strdup_printf("%d", channel_width);
+
+        network->streams = nv2_net_get_chains(net_nv2);
+
+        if(nv2_net_is_vht(net_nv2))
+            network->mode = g_strdup("ac");
+        else if(nv2_net_is_ht(net_nv2))
+        {
+            if(nv2_net_get_frequency(net_nv2) < 3000)
+                network->mode = g_strdup("gn");
+            else
+                network->mode = g_strdup("an");
+        }
+        else if(nv2_net_get_frequency(net_nv2) < 3000)
+        {
+            if(nv2_net_is_ofdm(net_nv2))
+                network->mode = g_strdup("g");
+            else
+                network->mode = g_strdup("b");
         }
-        else if(net_80211->source != MAC80211_FRAME_BEACON &&
-                net_80211->source != MAC80211_FRAME_PROBE_RESPONSE)
+        else
         {
-            /* This is other IEEE 802.11 frame */
-            mac80211_net_free(net_80211);
-            return;
+            network->mode = g_strdup("a");
         }
+        nv2_net_free(net_nv2);
     }
 
-    data = g_malloc(sizeof(tzsp_receiver_net_t));
-    data->context = context;
-    data->network = g_malloc(sizeof(network_t));
-    network_init(data->network);
+    if(net_cambium)
+    {
+        network->ssid = g_strdup(cambium_net_get_ssid(net_cambium));
+
+        if(cambium_net_get_frequency(net_cambium))
+            network->frequency = cambium_net_get_frequency(net_cambium) * 1000;
+        else if(tzsp_channel)
+            network->frequency = (*tzsp_channel * 5 + frequency_base) * 1000;
+
+        cambium_net_free(net_cambium);
+    }
+
+    return network;
+}
+
+static network_t*
+tzsp_receiver_network_new(const uint8_t *src,
+                          const uint8_t *sensor_mac)
+{
+    network_t *network;
+
+    network = g_malloc(sizeof(network_t));
+    network_init(network);
 
     /* Fill the BSSID address */
-    data->network->address  = (gint64) src[0] << 40;
-    data->network->address |= (gint64) src[1] << 32;
-    data->network->address |= (gint64) src[2] << 24;
-    data->network->address |= (gint64) src[3] << 16;
-    data->network->address |= (gint64) src[4] << 8;
-    data->network->address |= (gint64) src[5] << 0;
+    network->address = tzsp_receiver_address(src);
+
+    /* Fill the sensor address */
+    if(sensor_mac)
+        network->source = tzsp_receiver_address(sensor_mac);
+
+    return network;
+}
+
+static void
+tzsp_receiver_update(network_t              *network,
+                     const mac80211_frame_t *frame,
+                     const int8_t           *rssi,
+                     const uint8_t          *tzsp_channel,
+                     gint                    channel_width,
+                     gint                    frequency_base)
+{
+    /* Fields are updated the same way as tzsp_receiver_merge() would do,
+       strings are copied from the packet only if they have changed */
+    const mac80211_info_t *info = &frame->info;
+    network_flags_t flags = { -1, -1, -1, -1, -1, -1 };
+    ie_airmax_ac_t *airmax_ac = NULL;
+    ie_wps_t *wps = NULL;
+    gchar buffer[32];
+    const gchar *ext_channel;
+    const gchar *mode = NULL;
+    gint frequency = 0;
+    gint channel = -1;
+    gint wps_level = 0;
 
     /* Fill the signal level value */
     if(rssi)
-        data->network->rssi = *rssi;
+        network->rssi = MAX(network->rssi, *rssi);
 
-    /* Default values */
-    data->network->flags.routeros = 0;
-    data->network->ubnt_airmax = 0;
-    data->network->wps = 0;
+    /* Guess the band from the channel number, if not known */
+    if(!frequency_base)
+    {
+        channel = (tzsp_channel ? *tzsp_channel : info->channel);
+        frequency_base = (channel > 14 && channel < 128) ? 5000 : 2407;
+        channel = -1;
+    }
 
-    if(net_80211)
+    flags.routeros = 0;
+    network->ubnt_airmax = 0;
+    network->ubnt_ptp = -1;
+    network->ubnt_ptmp = -1;
+    network->ubnt_mixed = -1;
+
+    if(frame->mikrotik)
     {
-        if(net_80211->ie_mikrotik)
+        if(frame->ie_mikrotik.version)
         {
-            if(!data->network->radioname)
-                data->network->radioname = g_strdup(ie_mikrotik_get_radioname(net_80211->ie_mikrotik));
-
-            if(!data->network->routeros_ver)
-                data->network->routeros_ver = g_strdup(ie_mikrotik_get_version(net_80211->ie_mikrotik));
-
-            data->network->frequency = ie_mikrotik_get_frequency(net_80211->ie_mikrotik) * 1000;
-            data->network->flags.routeros = 1;
-            data->network->flags.nstreme = ie_mikrotik_is_nstreme(net_80211->ie_mikrotik);
-            data->network->flags.tdma = FALSE;
-            data->network->flags.wds = ie_mikrotik_is_wds(net_80211->ie_mikrotik);
-            data->network->flags.bridge = ie_mikrotik_is_bridge(net_80211->ie_mikrotik);
+            ie_mikrotik_version_format(buffer, sizeof(buffer),
+                                       frame->ie_mikrotik.version_major,
+                                       frame->ie_mikrotik.version_minor,
+                                       frame->ie_mikrotik.version_type,
+                                       frame->ie_mikrotik.version_rev);
+            tzsp_receiver_set_cstring(&network->routeros_ver, buffer);
         }
 
-        if(net_80211->ie_airmax)
-            data->network->ubnt_airmax = 1;
+        frequency = frame->ie_mikrotik.frequency * 1000;
+        flags.routeros = 1;
+        flags.nstreme = ie_mikrotik_view_is_nstreme(&frame->ie_mikrotik);
+        flags.tdma = FALSE;
+        flags.wds = ie_mikrotik_view_is_wds(&frame->ie_mikrotik);
+        flags.bridge = ie_mikrotik_view_is_bridge(&frame->ie_mikrotik);
+    }
 
-        if(net_80211->ie_airmax_ac)
-        {
-            data->network->ubnt_airmax = 1;
+    if(frame->ie_airmax.ptr)
+        network->ubnt_airmax = 1;
 
-            if(!data->network->ssid)
-                data->network->ssid = g_strdup(ie_airmax_ac_get_ssid(net_80211->ie_airmax_ac));
+    if(frame->ie_airmax_ac.ptr)
+        airmax_ac = ie_airmax_ac_parse(frame->ie_airmax_ac.ptr, frame->ie_airmax_ac.len, frame->src);
 
-            if(!data->network->radioname)
-                data->network->radioname = g_strdup(ie_airmax_ac_get_radioname(net_80211->ie_airmax_ac));
+    if(airmax_ac)
+    {
+        network->ubnt_airmax = 1;
+        network->ubnt_ptp = ie_airmax_ac_is_ptp(airmax_ac);
+        network->ubnt_ptmp = ie_airmax_ac_is_ptmp(airmax_ac);
+        network->ubnt_mixed = ie_airmax_ac_is_mixed(airmax_ac);
+    }
 
-            data->network->ubnt_ptp = ie_airmax_ac_is_ptp(net_80211->ie_airmax_ac);
-            data->network->ubnt_ptmp = ie_airmax_ac_is_ptmp(net_80211->ie_airmax_ac);
-            data->network->ubnt_mixed = ie_airmax_ac_is_mixed(net_80211->ie_airmax_ac);
-        }
+    /* Radio name: MikroTik IE, Airmax AC IE, Cisco IE */
+    if(frame->mikrotik && frame->ie_mikrotik.radioname.len)
+        tzsp_receiver_set_string(&network->radioname, frame->ie_mikrotik.radioname.ptr, frame->ie_mikrotik.radioname.len);
+    else if(airmax_ac && ie_airmax_ac_get_radioname(airmax_ac))
+        tzsp_receiver_set_cstring(&network->radioname, ie_airmax_ac_get_radioname(airmax_ac));
+    else if(frame->radioname.len)
+        tzsp_receiver_set_string(&network->radioname, frame->radioname.ptr, frame->radioname.len);
 
-        if(net_80211->ie_wps)
+    /* SSID: Airmax AC IE, SSID tag */
+    if(airmax_ac && ie_airmax_ac_get_ssid(airmax_ac))
+        tzsp_receiver_set_cstring(&network->ssid, ie_airmax_ac_get_ssid(airmax_ac));
+    else if(frame->ssid.len)
+        tzsp_receiver_set_string(&network->ssid, frame->ssid.ptr, frame->ssid.len);
+
+    ie_airmax_ac_free(airmax_ac);
+
+    if(frame->ie_wps.ptr)
+    {
+        wps_level = 1;
+        if(frame->source == MAC80211_FRAME_PROBE_RESPONSE)
         {
-            data->network->wps = 1;
-            if(net_80211->source == MAC80211_FRAME_PROBE_RESPONSE)
+            wps_level = 2;
+            wps = ie_wps_parse(frame->ie_wps.ptr, frame->ie_wps.len);
+            if(wps)
             {
-                data->network->wps = 2;
-                if(!data->network->wps_manufacturer)
-                    data->network->wps_manufacturer = g_strdup(ie_wps_get_manufacturer(net_80211->ie_wps));
-                if(!data->network->wps_model_name)
-                    data->network->wps_model_name = g_strdup(ie_wps_get_model_name(net_80211->ie_wps));
-                if(!data->network->wps_model_number)
-                    data->network->wps_model_number = g_strdup(ie_wps_get_model_number(net_80211->ie_wps));
-                if(!data->network->wps_serial_number)
-                    data->network->wps_serial_number = g_strdup(ie_wps_get_serial_number(net_80211->ie_wps));
-                if(!data->network->wps_device_name)
-                    data->network->wps_device_name = g_strdup(ie_wps_get_device_name(net_80211->ie_wps));
+                tzsp_receiver_set_cstring(&network->wps_manufacturer, ie_wps_get_manufacturer(wps));
+                tzsp_receiver_set_cstring(&network->wps_model_name, ie_wps_get_model_name(wps));
+                tzsp_receiver_set_cstring(&network->wps_model_number, ie_wps_get_model_number(wps));
+                tzsp_receiver_set_cstring(&network->wps_serial_number, ie_wps_get_serial_number(wps));
+                tzsp_receiver_set_cstring(&network->wps_device_name, ie_wps_get_device_name(wps));
+                ie_wps_free(wps);
             }
         }
+    }
+    network->wps = MAX(network->wps, wps_level);
+
+    /* Network frequency based on TZSP channel on 5 GHz band */
+    if(!frequency &&
+       frequency_base == 5000 &&
+       tzsp_channel)
+    {
+        /* HACK! Workaround for 4.9 GHz */
+        if(info->channel >= 160 && /* 4800 */
+           info->channel <= 199 && /* 4995 */
+           *tzsp_channel >= 11 && /* 4800 */
+           *tzsp_channel <= 50 && /* 4995 */
+           (info->channel - (int)*tzsp_channel) == (184 - 35))
+        {
+            /* Valid for Ubiquiti Airmax & Airmax AC (4920 - 4995 MHz) */
+            /* Not tested below 4920 MHz */
+            frequency = (4920 + ((info->channel - 184) * 5)) * 1000;
+        }
+        else /* ≥ 5000 MHz */
+        {
+            frequency = (frequency_base + *tzsp_channel * 5) * 1000;
+        }
+    }
 
-        /* Network frequency based on TZSP channel on 5 GHz band */
-        if(!data->network->frequency &&
-           context->frequency_base == 5000 &&
-           tzsp_channel)
+    if(!frequency)
+    {
+        if(info->channel >= 0)
         {
-            /* HACK! Workaround for 4.9 GHz */
-            if(net_80211->channel >= 160 && /* 4800 */
-               net_80211->channel <= 199 && /* 4995 */
-               *tzsp_channel >= 11 && /* 4800 */
-               *tzsp_channel <= 50 && /* 4995 */
-               (net_80211->channel - (int)*tzsp_channel) == (184 - 35))
-            {
-                /* Valid for Ubiquiti Airmax & Airmax AC (4920 - 4995 MHz) */
-                /* Not tested below 4920 MHz */
-                data->network->frequency = (4920 + ((net_80211->channel - 184) * 5)) * 1000;
-            }
-            else /* ≥ 5000 MHz */
-            {
-                data->network->frequency = (context->frequency_base + *tzsp_channel * 5) * 1000;
-            }
+            /* Use channel from beacon tag for other bands (i.e. 2.4 GHz) due to DSSS channel overlap */
+            channel = info->channel;
+        }
+        else if(tzsp_channel)
+        {
+            /* Fallback to TZSP channel, if beacon does not contain channel number */
+            channel = *tzsp_channel;
         }
 
-        if(!data->network->frequency)
+        if(channel >= 0)
         {
-            if(net_80211->channel >= 0)
+            if(frequency_base == 2407 && channel >= 128)
             {
-                /* Use channel from beacon tag for other bands (i.e. 2.4 GHz) due to DSSS channel overlap */
-                channel = net_80211->channel;
+                /* Sub 2.4 GHz (negative unsigned 8-bit value, i.e. ≥ 128) */
+                frequency = (frequency_base - (256 - channel) * 5) * 1000;
             }
-            else if(tzsp_channel)
+            else if(frequency_base == 2407 && channel == 14)
             {
-                /* Fallback to TZSP channel, if beacon does not contain channel number */
-                channel = *tzsp_channel;
+                /* Special case for channel 14 */
+                frequency = 2484 * 1000;
             }
-
-            if(channel >= 0)
+            else
             {
-                if(context->frequency_base == 2407 && channel >= 128)
-                {
-                    /* Sub 2.4 GHz (negative unsigned 8-bit value, i.e. ≥ 128) */
-                    data->network->frequency = (context->frequency_base - (256 - channel) * 5) * 1000;
-                }
-                else if(context->frequency_base == 2407 && channel == 14)
-                {
-                    /* Special case for channel 14 */
-                    data->network->frequency = 2484 * 1000;
-                }
-                else
-                {
-                    /* Regular channel */
-                    data->network->frequency = (context->frequency_base + channel * 5) * 1000;
-                }
+                /* Regular channel */
+                frequency = (frequency_base + channel * 5) * 1000;
             }
         }
+    }
 
-        if(!data->network->ssid)
-            data->network->ssid = g_strdup(net_80211->ssid);
+    network->frequency = frequency;
+    network->streams = mac80211_info_get_chains(info);
+    flags.privacy = mac80211_info_is_privacy(info);
+    network->flags = flags;
+
+    ext_channel = mac80211_info_get_ext_channel(info);
+    if(ext_channel)
+        g_snprintf(buffer, sizeof(buffer), "%d-%s", channel_width, ext_channel);
+    else
+        g_snprintf(buffer, sizeof(buffer), "%d", channel_width);
+    tzsp_receiver_set_cstring(&network->channel, buffer);
+
+    if(mac80211_info_is_he(info))
+        mode = "ax";
+    else if(mac80211_info_is_vht(info))
+        mode = "ac";
+    else if(mac80211_info_is_ht(info))
+        mode = (frequency && frequency < 3000000) ? "gn" : "an";
+    else if(mac80211_info_is_ofdm(info))
+        mode = (frequency && frequency < 3000000) ? "g" : "a";
+    else if(mac80211_info_is_dsss(info))
+        mode = "b";
+
+    tzsp_receiver_set_cstring(&network->mode, mode);
+}
 
-        if(!data->network->radioname)
-            data->network->radioname = g_strdup(net_80211->radioname);
+static gint64
+tzsp_receiver_address(const uint8_t *addr)
+{
+    return ((gint64)addr[0] << 40) |
+           ((gint64)addr[1] << 32) |
+           ((gint64)addr[2] << 24) |
+           ((gint64)addr[3] << 16) |
+           ((gint64)addr[4] << 8) |
+           ((gint64)addr[5] << 0);
+}
 
-        data->network->streams = mac80211_net_get_chains(net_80211);
-        data->network->flags.privacy = mac80211_net_is_privacy(net_80211);
+static void
+tzsp_receiver_set_string(gchar         **current,
+                         const uint8_t  *value,
+                         gsize           len)
+{
+    /* Replace the string only if it differs */
+    if(*current &&
+       strlen(*current) == len &&
+       memcmp(*current, value, len) == 0)
+        return;
 
-        if(!data->network->channel)
-        {
-            if(mac80211_net_get_ext_channel(net_80211))
-                data->network->channel = g_strdup_printf("%d-%s", context->channel_width, mac80211_net_get_ext_channel(net_80211));
-            else
-                data->network->channel = g_strdup_printf("%d", context->channel_width);
-        }
+    g_free(*current);
+    *current = g_strndup((const gchar*)value, len);
+}
 
-        if(mac80211_net_is_he(net_80211))
-            data->network->mode = g_strdup("ax");
-        else if(mac80211_net_is_vht(net_80211))
-            data->network->mode = g_strdup("ac");
-        else if(mac80211_net_is_ht(net_80211))
-        {
-            if(data->network->frequency &&
-               data->network->frequency < 3000000)
-                data->network->mode = g_strdup("gn");
-            else
-                data->network->mode = g_strdup("an");
-        }
-        else if(mac80211_net_is_ofdm(net_80211))
+static void
+tzsp_receiver_set_cstring(gchar       **current,
+                          const gchar  *value)
+{
+    if(value && *value)
+        tzsp_receiver_set_string(current, (const uint8_t*)value, strlen(value));
+}
+
+static tzsp_receiver_cache_t*
+tzsp_receiver_cache_get(tzsp_receiver_sensor_t *sensor,
+                        const uint8_t          *packet,
+                        uint32_t                len,
+                        gint                    type,
+                        gint64                  address,
+                        gint64                  now,
+                        const uint8_t          *tzsp_channel,
+                        const tzsp_view_t      *body)
+{
+    tzsp_receiver_cache_t *entry;
+    mac80211_frame_t frame;
+    guint32 length;
+    guint32 hash;
+    gint64 key;
+
+    if(now >= sensor->cache_sweep + TZSP_RECEIVER_CACHE_TIMEOUT)
+        tzsp_receiver_cache_sweep(sensor, now);
+
+    hash = tzsp_receiver_cache_hash(tzsp_channel, body, &length);
+
+    /* Beacons and probe responses are kept separately */
+    key = address | ((gint64)type << 48);
+    entry = g_hash_table_lookup(sensor->cache, &key);
+    if(entry &&
+       entry->hash == hash &&
+       entry->length == length)
+    {
+        entry->lastseen = now;
+        return entry;
+    }
+
+    /* The frame has changed, decode it again */
+    if(mac80211_parse(packet, len, &frame) != type)
+        return NULL;
+
+    if(!entry)
+    {
+        if(g_hash_table_size(sensor->cache) >= TZSP_RECEIVER_CACHE_MAX)
         {
-            if(data->network->frequency &&
-               data->network->frequency < 3000000)
-                data->network->mode = g_strdup("g");
-            else
-                data->network->mode = g_strdup("a");
+            tzsp_receiver_cache_sweep(sensor, now);
+            if(g_hash_table_size(sensor->cache) >= TZSP_RECEIVER_CACHE_MAX)
+                g_hash_table_remove_all(sensor->cache);
         }
-        else if(mac80211_net_is_dsss(net_80211))
+
+        entry = g_malloc(sizeof(tzsp_receiver_cache_t));
+        entry->key = key;
+        network_init(&entry->network);
+        g_hash_table_insert(sensor->cache, &entry->key, entry);
+    }
+    else
+    {
+        network_free(&entry->network);
+        network_init(&entry->network);
+    }
+
+    tzsp_receiver_update(&entry->network, &frame, NULL, tzsp_channel, sensor->channel_width, sensor->frequency_base);
+    entry->hash = hash;
+    entry->length = length;
+    entry->lastseen = now;
+    return entry;
+}
+
+static guint32
+tzsp_receiver_cache_hash(const uint8_t     *tzsp_channel,
+                         const tzsp_view_t *body,
+                         guint32           *length)
+{
+    const uint8_t *run;
+    guint8 seed[2];
+    guint32 hash;
+    guint32 i;
+    guint8 tag_len;
+
+    /* Beacons of an AP usually differ only in the timestamp, sequence number,
+       TIM and BSS Load. None of them is decoded, so these are not hashed.
+       The decoded attributes depend on the frame type, TZSP channel and the rest of the body. */
+    seed[0] = (tzsp_channel != NULL);
+    seed[1] = (tzsp_channel ? *tzsp_channel : 0);
+    hash = crc32(0L, seed, sizeof(seed));
+    *length = 0;
+
+    if(!body->len)
+        return hash;
+
+    /* Consecutive hashed tags are passed to crc32() at once */
+    run = body->ptr;
+    for(i=TZSP_RECEIVER_BODY_FIXED_LEN; i+2 <= body->len; i+=2+tag_len)
+    {
+        tag_len = body->ptr[i+1];
+        if(body->ptr[i] == TZSP_RECEIVER_TAG_TIM ||
+           body->ptr[i] == TZSP_RECEIVER_TAG_BSS_LOAD)
         {
-            data->network->mode = g_strdup("b");
+            hash = crc32(hash, run, body->ptr + i - run);
+            *length += body->ptr + i - run;
+            run = body->ptr + i + 2 + tag_len;
         }
-        nv2_net_free(net_nv2);
-        mac80211_net_free(net_80211);
     }
 
-    if(net_nv2)
+    if(run < body->ptr + body->len)
     {
-        data->network->ssid = g_strdup(nv2_net_get_ssid(net_nv2));
-        data->network->radioname = g_strdup(nv2_net_get_radioname(net_nv2));
-        data->network->routeros_ver = g_strdup(nv2_net_get_version(net_nv2));
+        hash = crc32(hash, run, body->ptr + body->len - run);
+        *length += body->ptr + body->len - run;
+    }
 
-        if(nv2_net_get_frequency(net_nv2))
-            data->network->frequency = nv2_net_get_frequency(net_nv2) * 1000;
+    return hash;
+}
 
-        data->network->flags.privacy = nv2_net_is_privacy(net_nv2);
-        data->network->flags.routeros = 1;
-        data->network->flags.nstreme = 0;
-        data->network->flags.tdma = 1;
-        data->network->flags.wds = nv2_net_is_wds(net_nv2);
-        data->network->flags.bridge = nv2_net_is_bridge(net_nv2);
+static void
+tzsp_receiver_cache_sweep(tzsp_receiver_sensor_t *sensor,
+                          gint64                  now)
+{
+    g_hash_table_foreach_remove(sensor->cache, tzsp_receiver_cache_expired, &now);
+    sensor->cache_sweep = now;
+}
 
-        if(nv2_net_get_ext_channel(net_nv2))
-            data->network->channel = g_strdup_printf("%d-%s", context->channel_width, nv2_net_get_ext_channel(net_nv2));
-        else
-            data->network->channel = g_strdup_printf("%d", context->channel_width);
+static gboolean
+tzsp_receiver_cache_expired(gpointer key,
+                            gpointer value,
+                            gpointer user_data)
+{
+    tzsp_receiver_cache_t *entry = (tzsp_receiver_cache_t*)value;
+    gint64 now = *(gint64*)user_data;
 
-        data->network->streams = nv2_net_get_chains(net_nv2);
+    return (now - entry->lastseen >= TZSP_RECEIVER_CACHE_TIMEOUT);
+}
 
-        if(nv2_net_is_vht(net_nv2))
-            data->network->mode = g_strdup("ac");
-        else if(nv2_net_is_ht(net_nv2))
-        {
-            if(nv2_net_get_frequency(net_nv2) < 3000)
-                data->network->mode = g_strdup("gn");
-            else
-                data->network->mode = g_strdup("an");
-        }
-        else if(nv2_net_get_frequency(net_nv2) < 3000)
-        {
-            if(nv2_net_is_ofdm(net_nv2))
-                data->network->mode = g_strdup("g");
-            else
-                data->network->mode = g_strdup("b");
-        }
-        else
-        {
-            data->network->mode = g_strdup("a");
-        }
-        nv2_net_free(net_nv2);
-    }
+static void
+tzsp_receiver_cache_free(gpointer data)
+{
+    tzsp_receiver_cache_t *entry = (tzsp_receiver_cache_t*)data;
+    network_free(&entry->network);
+    g_free(entry);
+}
 
-    if(net_cambium)
-    {
-        data->network->ssid = g_strdup(cambium_net_get_ssid(net_cambium));
+static void
+tzsp_receiver_apply(network_t       *current,
+                    const network_t *network)
+{
+    /* Same as tzsp_receiver_merge(), without taking over the strings */
+    current->frequency = network->frequency;
+    current->streams = network->streams;
+    current->flags = network->flags;
+    current->ubnt_airmax = network->ubnt_airmax;
+    current->ubnt_ptp = network->ubnt_ptp;
+    current->ubnt_ptmp = network->ubnt_ptmp;
+    current->ubnt_mixed = network->ubnt_mixed;
+    current->wps = MAX(current->wps, network->wps);
+
+    tzsp_receiver_set_cstring(&current->channel, network->channel);
+    tzsp_receiver_set_cstring(&current->mode, network->mode);
+    tzsp_receiver_set_cstring(&current->ssid, network->ssid);
+    tzsp_receiver_set_cstring(&current->radioname, network->radioname);
+    tzsp_receiver_set_cstring(&current->routeros_ver, network->routeros_ver);
+    tzsp_receiver_set_cstring(&current->wps_manufacturer, network->wps_manufacturer);
+    tzsp_receiver_set_cstring(&current->wps_model_name, network->wps_model_name);
+    tzsp_receiver_set_cstring(&current->wps_model_number, network->wps_model_number);
+    tzsp_receiver_set_cstring(&current->wps_serial_number, network->wps_serial_number);
+    tzsp_receiver_set_cstring(&current->wps_device_name, network->wps_device_name);
+}
 
-        if(cambium_net_get_frequency(net_cambium))
-            data->network->frequency = cambium_net_get_frequency(net_cambium) * 1000;
-        else if(tzsp_channel)
-            data->network->frequency = (*tzsp_channel * 5 + context->frequency_base) * 1000;
+void
+tzsp_receiver_merge(network_t *current,
+                    network_t *network)
+{
+    /* Scalar values are taken from the latest observation,
+       signal level and WPS information are kept at maximum */
+    current->frequency = network->frequency;
+    current->streams = network->streams;
+    if(network->rssi >= current->rssi)
+    {
+        current->rssi = network->rssi;
+        current->source = network->source;
+    }
+    current->flags = network->flags;
+    current->ubnt_airmax = network->ubnt_airmax;
+    current->ubnt_ptp = network->ubnt_ptp;
+    current->ubnt_ptmp = network->ubnt_ptmp;
+    current->ubnt_mixed = network->ubnt_mixed;
+    current->wps = MAX(current->wps, network->wps);
+    current->lastseen = network->lastseen;
+
+    tzsp_receiver_merge_string(&current->channel, &network->channel);
+    tzsp_receiver_merge_string(&current->mode, &network->mode);
+    tzsp_receiver_merge_string(&current->ssid, &network->ssid);
+    tzsp_receiver_merge_string(&current->radioname, &network->radioname);
+    tzsp_receiver_merge_string(&current->routeros_ver, &network->routeros_ver);
+    tzsp_receiver_merge_string(&current->wps_manufacturer, &network->wps_manufacturer);
+    tzsp_receiver_merge_string(&current->wps_model_name, &network->wps_model_name);
+    tzsp_receiver_merge_string(&current->wps_model_number, &network->wps_model_number);
+    tzsp_receiver_merge_string(&current->wps_serial_number, &network->wps_serial_number);
+    tzsp_receiver_merge_string(&current->wps_device_name, &network->wps_device_name);
+}
 
-        cambium_net_free(net_cambium);
+static void
+tzsp_receiver_merge_string(gchar **current,
+                           gchar **value)
+{
+    /* Move the string if present, otherwise keep the previous one */
+    if(*value)
+    {
+        g_free(*current);
+        *current = *value;
+        *value = NULL;
     }
+}
 
-    data->network->firstseen = g_get_real_time() / 1000000;
-    data->network->lastseen = data->network->firstseen;
+static GHashTable*
+tzsp_receiver_pending_new(void)
+{
+    /* Key points to the address inside the value */
+    return g_hash_table_new_full(g_int64_hash, g_int64_equal, NULL, tzsp_receiver_pending_free);
+}
 
-    /* Network must be added from main thread */
-    g_idle_add(tzsp_receiver_callback_network, data);
+static void
+tzsp_receiver_pending_free(gpointer data)
+{
+    network_t *network = (network_t*)data;
+    network_free(network);
+    g_free(network);
 }
 
 static gboolean
-tzsp_receiver_callback_network(gpointer user_data)
+tzsp_receiver_callback_tick(gpointer user_data)
 {
-    tzsp_receiver_net_t *data = (tzsp_receiver_net_t*)user_data;
-    data->context->cb_network(data->context, data->network);
-    g_free(data);
-    return G_SOURCE_REMOVE;
+    tzsp_receiver_t *context = (tzsp_receiver_t*)user_data;
+    GHashTable *pending;
+    GHashTableIter iter;
+    network_t *network;
+
+    g_mutex_lock(&context->pending_mutex);
+    if(!g_hash_table_size(context->pending))
+    {
+        g_mutex_unlock(&context->pending_mutex);
+        return G_SOURCE_CONTINUE;
+    }
+    pending = context->pending;
+    context->pending = tzsp_receiver_pending_new();
+    g_mutex_unlock(&context->pending_mutex);
+
+    /* Ownership of each network is passed to the callback */
+    g_hash_table_iter_init(&iter, pending);
+    while(g_hash_table_iter_next(&iter, NULL, (gpointer*)&network))
+    {
+        g_hash_table_iter_steal(&iter);
+        context->cb_network(context, network);
+    }
+
+    g_hash_table_destroy(pending);
+    return G_SOURCE_CONTINUE;
 }
 
 static gboolean
@@ -383,6 +958,11 @@ tzsp_receiver_callback_final(gpointer user_data)
     tzsp_socket_free(context->tzsp_socket);
     context->tzsp_socket = NULL;
 
+    /* Deliver the remaining observations */
+    tzsp_receiver_callback_tick(context);
+    g_source_remove(context->tick_id);
+    context->tick_id = 0;
+
     context->cb_final(context);
     return G_SOURCE_REMOVE;
 }
@@ -399,6 +979,12 @@ tzsp_receiver_disable(tzsp_receiver_t *context)
     tzsp_socket_disable(context->tzsp_socket);
 }
 
+guint32
+tzsp_receiver_get_drops(const tzsp_receiver_t *context)
+{
+    return context->tzsp_socket ? tzsp_socket_get_drops(context->tzsp_socket) : 0;
+}
+
 void
 tzsp_receiver_cancel(tzsp_receiver_t *context)
 {
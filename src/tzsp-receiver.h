@@ -4,16 +4,23 @@
 typedef struct tzsp_receiver tzsp_receiver_t;
 
 tzsp_receiver_t* tzsp_receiver_new(guint16,
-                                   guint8[6],
-                                   gint,
                                    gint,
+                                   gboolean,
                                    void (*)(tzsp_receiver_t*),
                                    void (*)(const tzsp_receiver_t*, network_t*));
 void tzsp_receiver_free(tzsp_receiver_t*);
+void tzsp_receiver_add_sensor(tzsp_receiver_t*, gint64, gint, gint);
+void tzsp_receiver_remove_sensor(tzsp_receiver_t*, gint64);
+void tzsp_receiver_foreach_sensor(tzsp_receiver_t*, void (*)(gint64, guint32, guint32, gpointer), gpointer);
+guint32 tzsp_receiver_get_unknown(tzsp_receiver_t*);
 void tzsp_receiver_enable(tzsp_receiver_t*);
 void tzsp_receiver_disable(tzsp_receiver_t*);
+guint32 tzsp_receiver_get_drops(const tzsp_receiver_t*);
 void tzsp_receiver_cancel(tzsp_receiver_t*);
 
+network_t* tzsp_receiver_network(const guint8*, guint32, const gint8*, const guint8*, const guint8*, gint, gint);
+void tzsp_receiver_merge(network_t*, network_t*);
+
 
 #endif
 
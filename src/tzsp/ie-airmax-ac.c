@@ -19,6 +19,7 @@
 #include <openssl/sha.h>
 #include <openssl/aes.h>
 #include <string.h>
+#include <pthread.h>
 #include "ie-airmax-ac.h"
 #include "utils.h"
 
@@ -41,6 +42,8 @@
 #define IE_AIRMAX_AC_TAG_RADIONAME  0x01
 #define IE_AIRMAX_AC_TAG_SSID       0x02
 
+#define IE_AIRMAX_AC_CACHE_SIZE 64
+
 typedef struct ie_airmax_ac
 {
     uint8_t mode;
@@ -48,59 +51,138 @@ typedef struct ie_airmax_ac
     char *ssid;
 } ie_airmax_ac_t;
 
+typedef struct ie_airmax_ac_cache
+{
+    bool used;
+    uint64_t stamp;
+    uint8_t addr[6];
+    AES_KEY aes_key;
+    uint8_t data_len;
+    uint8_t ciphertext[UINT8_MAX];
+    uint8_t data[UINT8_MAX];
+    bool valid;
+} ie_airmax_ac_cache_t;
+
+static ie_airmax_ac_cache_t cache[IE_AIRMAX_AC_CACHE_SIZE];
+static uint64_t cache_stamp;
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static ie_airmax_ac_cache_t* ie_airmax_ac_cache_get(const uint8_t[6]);
 static ie_airmax_ac_t* ie_airmax_ac_process_data(const uint8_t*, uint8_t);
 static void ie_airmax_ac_process_tag(ie_airmax_ac_t*, uint8_t, uint8_t, const uint8_t*);
 
-ie_airmax_ac_t*
-ie_airmax_ac_parse(const uint8_t *ie,
-                   uint8_t        ie_len,
-                   const uint8_t  addr[6])
+bool
+ie_airmax_ac_match(const uint8_t *ie,
+                   uint8_t        ie_len)
 {
     static const uint8_t magic[] = { 0x00, 0x27, 0x22, 0xff, 0xff, 0xff, 0x02 };
-    static const uint8_t hmac_key[] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
-    uint8_t data[UINT8_MAX];
     uint8_t data_len;
-    uint8_t hmac[SHA_DIGEST_LENGTH];
-    AES_KEY aes_key;
-    int i;
 
     if(ie_len < IE_AIRMAX_AC_HEADER_LEN + IE_AIRMAX_AC_DATA_HEADER_LEN)
-        return NULL;
+        return false;
 
     /* The IE must start with a magic byte sequence */
     if(memcmp(magic, ie, sizeof(magic)) != 0)
-        return NULL;
+        return false;
 
     data_len = ie[IE_AIRMAX_AC_DATA_LEN_IDX];
 
     /* Data must be aligned to 128-bit blocks */
     if(data_len % 16)
-        return NULL;
+        return false;
 
     /* The IE length must match the header+data length */
-    if(IE_AIRMAX_AC_HEADER_LEN + data_len != ie_len)
+    return (IE_AIRMAX_AC_HEADER_LEN + data_len == ie_len);
+}
+
+ie_airmax_ac_t*
+ie_airmax_ac_parse(const uint8_t *ie,
+                   uint8_t        ie_len,
+                   const uint8_t  addr[6])
+{
+    const uint8_t *ciphertext = ie + IE_AIRMAX_AC_HEADER_LEN;
+    ie_airmax_ac_cache_t *entry;
+    ie_airmax_ac_t *context;
+    uint8_t data_len;
+    int i;
+
+    if(!ie_airmax_ac_match(ie, ie_len))
         return NULL;
 
-    /* Generate the AES key */
-    if(HMAC(EVP_sha1(), hmac_key, 6, addr, 6, hmac, NULL))
+    data_len = ie[IE_AIRMAX_AC_DATA_LEN_IDX];
+
+    pthread_mutex_lock(&cache_mutex);
+
+    entry = ie_airmax_ac_cache_get(addr);
+    if(entry == NULL)
     {
-        /* The AES uses only 128 bits (16B) of the HMAC-SHA1 hash */
-        AES_set_decrypt_key(hmac, 128, &aes_key);
+        pthread_mutex_unlock(&cache_mutex);
+        return NULL;
+    }
 
+    /* Decrypt only if the data has changed since the last beacon */
+    if(entry->data_len != data_len ||
+       memcmp(entry->ciphertext, ciphertext, data_len) != 0)
+    {
         /* Decrypt each 128-bit data block */
         for(i=0; i<data_len; i+=16)
-            AES_decrypt(ie + IE_AIRMAX_AC_HEADER_LEN + i, data + i, &aes_key);
+            AES_decrypt(ciphertext + i, entry->data + i, &entry->aes_key);
+
+        memcpy(entry->ciphertext, ciphertext, data_len);
+        entry->data_len = data_len;
 
         /* Verify the data */
-        if(memcmp(data+IE_AIRMAX_AC_ADDR1, addr, 6) != 0 ||
-           memcmp(data+IE_AIRMAX_AC_ADDR2, addr, 6) != 0)
+        entry->valid = (memcmp(entry->data+IE_AIRMAX_AC_ADDR1, addr, 6) == 0 &&
+                        memcmp(entry->data+IE_AIRMAX_AC_ADDR2, addr, 6) == 0);
+    }
+
+    context = (entry->valid ? ie_airmax_ac_process_data(entry->data, data_len) : NULL);
+
+    pthread_mutex_unlock(&cache_mutex);
+    return context;
+}
+
+static ie_airmax_ac_cache_t*
+ie_airmax_ac_cache_get(const uint8_t addr[6])
+{
+    static const uint8_t hmac_key[] = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
+    uint8_t hmac[SHA_DIGEST_LENGTH];
+    ie_airmax_ac_cache_t *entry = NULL;
+    int i;
+
+    cache_stamp++;
+
+    for(i=0; i<IE_AIRMAX_AC_CACHE_SIZE; i++)
+    {
+        if(cache[i].used &&
+           memcmp(cache[i].addr, addr, 6) == 0)
         {
-            return NULL;
+            cache[i].stamp = cache_stamp;
+            return &cache[i];
         }
 
-        return ie_airmax_ac_process_data(data, data_len);
+        /* Remember free or least recently used entry */
+        if(entry == NULL ||
+           (entry->used && !cache[i].used) ||
+           (entry->used && cache[i].stamp < entry->stamp))
+        {
+            entry = &cache[i];
+        }
     }
-    return NULL;
+
+    /* Generate the AES key */
+    if(!HMAC(EVP_sha1(), hmac_key, 6, addr, 6, hmac, NULL))
+        return NULL;
+
+    /* The AES uses only 128 bits (16B) of the HMAC-SHA1 hash */
+    AES_set_decrypt_key(hmac, 128, &entry->aes_key);
+
+    memcpy(entry->addr, addr, 6);
+    entry->used = true;
+    entry->stamp = cache_stamp;
+    entry->data_len = 0;
+    entry->valid = false;
+    return entry;
 }
 
 static ie_airmax_ac_t*
@@ -20,6 +20,7 @@
 
 typedef struct ie_airmax_ac ie_airmax_ac_t;
 
+bool ie_airmax_ac_match(const uint8_t*, uint8_t);
 ie_airmax_ac_t* ie_airmax_ac_parse(const uint8_t*, uint8_t, const uint8_t[6]);
 
 bool ie_airmax_ac_is_ptp(ie_airmax_ac_t*);
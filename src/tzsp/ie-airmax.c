@@ -24,17 +24,24 @@ typedef struct ie_airmax
     uint8_t placeholder;
 } ie_airmax_t;
 
-ie_airmax_t*
-ie_airmax_parse(const uint8_t *ie,
+bool
+ie_airmax_match(const uint8_t *ie,
                 uint8_t        ie_len)
 {
     static const uint8_t magic[] = { 0x00, 0x15, 0x6d, 0xff, 0xff, 0xff };
 
     if(ie_len != IE_AIRMAX_LEN)
-        return NULL;
+        return false;
 
     /* The IE must start with a magic byte sequence */
-    if(memcmp(magic, ie, sizeof(magic)) != 0)
+    return memcmp(magic, ie, sizeof(magic)) == 0;
+}
+
+ie_airmax_t*
+ie_airmax_parse(const uint8_t *ie,
+                uint8_t        ie_len)
+{
+    if(!ie_airmax_match(ie, ie_len))
         return NULL;
 
     /* TODO: reverse engineering */
@@ -20,6 +20,7 @@
 
 typedef struct ie_airmax ie_airmax_t;
 
+bool ie_airmax_match(const uint8_t*, uint8_t);
 ie_airmax_t* ie_airmax_parse(const uint8_t*, uint8_t);
 void ie_airmax_free(ie_airmax_t*);
 
@@ -16,6 +16,8 @@
 #define _GNU_SOURCE
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
+#include "ie-mikrotik-utils.h"
 
 #define MIKROTIK_VERSION_ALPHA     'a'
 #define MIKROTIK_VERSION_BETA      'b'
@@ -30,26 +32,34 @@ ie_mikrotik_version(uint8_t major,
                     uint8_t type,
                     uint8_t rev)
 {
-    char *version;
+    char version[IE_MIKROTIK_VERSION_LEN];
 
+    if(ie_mikrotik_version_format(version, sizeof(version), major, minor, type, rev) < 0)
+        return NULL;
+
+    return strdup(version);
+}
+
+int
+ie_mikrotik_version_format(char    *output,
+                           size_t   len,
+                           uint8_t  major,
+                           uint8_t  minor,
+                           uint8_t  type,
+                           uint8_t  rev)
+{
     if(rev)
     {
-        if(asprintf(&version, "%d.%d%s%d",
-                    major,
-                    minor,
-                    ie_mikrotik_version_separator(type),
-                    rev) < 0)
-            version = NULL;
-    }
-    else
-    {
-        if(asprintf(&version, "%d.%d",
-                    major,
-                    minor) < 0)
-            version = NULL;
+        return snprintf(output, len, "%d.%d%s%d",
+                        major,
+                        minor,
+                        ie_mikrotik_version_separator(type),
+                        rev);
     }
 
-    return version;
+    return snprintf(output, len, "%d.%d",
+                    major,
+                    minor);
 }
 
 static const char*
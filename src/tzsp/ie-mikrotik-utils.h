@@ -17,6 +17,9 @@
 #define MTSCAN_TZSP_IE_MIKROTIK_UTILS_H
 #include <stdint.h>
 
+#define IE_MIKROTIK_VERSION_LEN 24
+
 char* ie_mikrotik_version(uint8_t, uint8_t, uint8_t, uint8_t);
+int ie_mikrotik_version_format(char*, size_t, uint8_t, uint8_t, uint8_t, uint8_t);
 
 #endif
@@ -72,90 +72,135 @@ typedef struct ie_mikrotik
     char *version;
 } ie_mikrotik_t;
 
-static ie_mikrotik_t* ie_mikrotik_process_data(const uint8_t*, uint8_t);
-static void ie_mikrotik_process_tag(ie_mikrotik_t*, uint8_t, uint8_t, const uint8_t*);
+static void ie_mikrotik_process_tag(ie_mikrotik_view_t*, uint8_t, uint8_t, const uint8_t*);
 
-ie_mikrotik_t*
-ie_mikrotik_parse(const uint8_t *ie,
-                  uint8_t        ie_len)
+bool
+ie_mikrotik_parse_view(const uint8_t      *ie,
+                       uint8_t             ie_len,
+                       ie_mikrotik_view_t *view)
 {
     static const uint8_t magic[] = { 0x00, 0x0c, 0x42, 0x00, 0x00, 0x00 };
+    uint8_t tag_len;
+    int i;
 
     if(ie_len < IE_MIKROTIK_HEADER_LEN)
-        return NULL;
+        return false;
 
     /* The IE must start with a magic byte sequence */
     if(memcmp(magic, ie, sizeof(magic)) != 0)
+        return false;
+
+    memset(view, 0, sizeof(ie_mikrotik_view_t));
+
+    for(i=IE_MIKROTIK_HEADER_LEN;
+        i+IE_MIKROTIK_TAG_HEADER_LEN <= ie_len;
+        i+=IE_MIKROTIK_TAG_HEADER_LEN + tag_len)
+    {
+        tag_len = ie[i+1];
+        if((i + IE_MIKROTIK_TAG_HEADER_LEN + tag_len) > ie_len)
+            break;
+
+        ie_mikrotik_process_tag(view, ie[i], tag_len, ie+i+IE_MIKROTIK_TAG_HEADER_LEN);
+    }
+
+    return true;
+}
+
+ie_mikrotik_t*
+ie_mikrotik_parse(const uint8_t *ie,
+                  uint8_t        ie_len)
+{
+    ie_mikrotik_view_t view;
+
+    if(!ie_mikrotik_parse_view(ie, ie_len, &view))
         return NULL;
 
-    return ie_mikrotik_process_data(ie, ie_len);
+    return ie_mikrotik_new(&view);
 }
 
-static ie_mikrotik_t*
-ie_mikrotik_process_data(const uint8_t *ie,
-                         uint8_t        ie_len)
+ie_mikrotik_t*
+ie_mikrotik_new(const ie_mikrotik_view_t *view)
 {
     ie_mikrotik_t *context;
-    uint8_t tag_len;
-    int i;
 
     context = calloc(sizeof(ie_mikrotik_t), 1);
     if(context == NULL)
         return NULL;
 
-    for(i=IE_MIKROTIK_HEADER_LEN;
-        i+IE_MIKROTIK_TAG_HEADER_LEN <= ie_len;
-        i+=IE_MIKROTIK_TAG_HEADER_LEN + tag_len)
-    {
-        tag_len = ie[i+1];
-        if((i + IE_MIKROTIK_TAG_HEADER_LEN + tag_len) > ie_len)
-            break;
+    context->flags1 = view->flags1;
+    context->flags2 = view->flags2;
+    context->mru = view->mru;
+    context->framer_limit = view->framer_limit;
+    context->frequency = view->frequency;
 
-        ie_mikrotik_process_tag(context, ie[i], tag_len, ie+i+IE_MIKROTIK_TAG_HEADER_LEN);
-    }
+    if(view->radioname.len)
+        context->radioname = tzsp_utils_string(view->radioname.ptr, view->radioname.len);
 
+    if(view->version)
+        context->version = ie_mikrotik_version(view->version_major,
+                                               view->version_minor,
+                                               view->version_type,
+                                               view->version_rev);
     return context;
 }
 
 static void
-ie_mikrotik_process_tag(ie_mikrotik_t *context,
-                        uint8_t        type,
-                        uint8_t        len,
-                        const uint8_t *value)
+ie_mikrotik_process_tag(ie_mikrotik_view_t *view,
+                        uint8_t             type,
+                        uint8_t             len,
+                        const uint8_t      *value)
 {
     if(type == IE_MIKROTIK_TAG_DATA &&
        len == IE_MIKROTIK_TAG_DATA_LEN)
     {
-        context->flags1 = value[IE_MIKROTIK_DATA_FLAGS1];
-        context->flags2 = value[IE_MIKROTIK_DATA_FLAGS2];
+        view->flags1 = value[IE_MIKROTIK_DATA_FLAGS1];
+        view->flags2 = value[IE_MIKROTIK_DATA_FLAGS2];
 
-        if(!context->version)
+        if(!view->version)
         {
-            context->version = ie_mikrotik_version(value[IE_MIKROTIK_DATA_VERSION_MAJOR],
-                                                   value[IE_MIKROTIK_DATA_VERSION_MINOR],
-                                                   value[IE_MIKROTIK_DATA_VERSION_TYPE],
-                                                   value[IE_MIKROTIK_DATA_VERSION_REV]);
+            view->version = true;
+            view->version_major = value[IE_MIKROTIK_DATA_VERSION_MAJOR];
+            view->version_minor = value[IE_MIKROTIK_DATA_VERSION_MINOR];
+            view->version_type = value[IE_MIKROTIK_DATA_VERSION_TYPE];
+            view->version_rev = value[IE_MIKROTIK_DATA_VERSION_REV];
         }
 
-        context->mru = (value[IE_MIKROTIK_DATA_MRU_H] << 8) |
-                        value[IE_MIKROTIK_DATA_MRU_L];
+        view->mru = (value[IE_MIKROTIK_DATA_MRU_H] << 8) |
+                     value[IE_MIKROTIK_DATA_MRU_L];
 
-        if(!context->radioname &&
-           *(value+IE_MIKROTIK_DATA_RADIONAME))
-            context->radioname = tzsp_utils_string(value+IE_MIKROTIK_DATA_RADIONAME,
-                                                   IE_MIKROTIK_DATA_RADIONAME_LEN);
+        if(!view->radioname.len)
+            view->radioname = tzsp_utils_view(value+IE_MIKROTIK_DATA_RADIONAME,
+                                              IE_MIKROTIK_DATA_RADIONAME_LEN);
 
-        context->framer_limit = (value[IE_MIKROTIK_DATA_FRAMER_LIMIT_H] << 8) |
-                                 value[IE_MIKROTIK_DATA_FRAMER_LIMIT_L];
+        view->framer_limit = (value[IE_MIKROTIK_DATA_FRAMER_LIMIT_H] << 8) |
+                              value[IE_MIKROTIK_DATA_FRAMER_LIMIT_L];
     }
     else if(type == IE_MIKROTIK_TAG_FREQ &&
             len == IE_MIKROTIK_TAG_FREQ_LEN)
     {
-        context->frequency = (value[IE_MIKROTIK_FREQUENCY_H] << 8) |
-                              value[IE_MIKROTIK_FREQUENCY_L];
+        view->frequency = (value[IE_MIKROTIK_FREQUENCY_H] << 8) |
+                           value[IE_MIKROTIK_FREQUENCY_L];
     }
 }
 
+bool
+ie_mikrotik_view_is_nstreme(const ie_mikrotik_view_t *view)
+{
+    return (view->flags1 & IE_MIKROTIK_FLAGS1_NSTREME) != 0;
+}
+
+bool
+ie_mikrotik_view_is_wds(const ie_mikrotik_view_t *view)
+{
+    return (view->flags1 & IE_MIKROTIK_FLAGS1_DOING_WDS) != 0;
+}
+
+bool
+ie_mikrotik_view_is_bridge(const ie_mikrotik_view_t *view)
+{
+    return (view->flags2 & IE_MIKROTIK_FLAGS2_BRIDGE) != 0;
+}
+
 bool
 ie_mikrotik_is_nstreme(ie_mikrotik_t *context)
 {
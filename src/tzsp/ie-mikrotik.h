@@ -17,10 +17,32 @@
 #define MTSCAN_TZSP_IE_MIKROTIK_H
 #include <stdint.h>
 #include <stdbool.h>
+#include "utils.h"
 
 typedef struct ie_mikrotik ie_mikrotik_t;
 
+typedef struct ie_mikrotik_view
+{
+    uint8_t flags1;
+    uint8_t flags2;
+    uint16_t mru;
+    uint16_t framer_limit;
+    uint16_t frequency;
+    tzsp_view_t radioname;
+    bool version;
+    uint8_t version_major;
+    uint8_t version_minor;
+    uint8_t version_type;
+    uint8_t version_rev;
+} ie_mikrotik_view_t;
+
+bool ie_mikrotik_parse_view(const uint8_t*, uint8_t, ie_mikrotik_view_t*);
+bool ie_mikrotik_view_is_nstreme(const ie_mikrotik_view_t*);
+bool ie_mikrotik_view_is_wds(const ie_mikrotik_view_t*);
+bool ie_mikrotik_view_is_bridge(const ie_mikrotik_view_t*);
+
 ie_mikrotik_t* ie_mikrotik_parse(const uint8_t*, uint8_t);
+ie_mikrotik_t* ie_mikrotik_new(const ie_mikrotik_view_t*);
 
 bool ie_mikrotik_is_nstreme(ie_mikrotik_t*);
 bool ie_mikrotik_is_wds(ie_mikrotik_t*);
@@ -20,6 +20,7 @@
 #include <stdio.h>
 #include "ie-mikrotik.h"
 #include "ie-mikrotik-utils.h"
+#include "ie-wps.h"
 #include "utils.h"
 
 #define IE_WPS_HEADER_LEN 4
@@ -47,17 +48,24 @@ static void ie_wps_process_tag(ie_wps_t*, uint16_t, uint16_t, const uint8_t*);
 ie_wps_t*
 ie_wps_parse(const uint8_t *ie,
              uint8_t        ie_len)
+{
+    if(!ie_wps_match(ie, ie_len))
+        return NULL;
+
+    return ie_wps_process_data(ie, ie_len);
+}
+
+bool
+ie_wps_match(const uint8_t *ie,
+             uint8_t        ie_len)
 {
     static const uint8_t magic[] = { 0x00, 0x50, 0xf2, 0x04 };
 
     if(ie_len < IE_WPS_HEADER_LEN)
-        return NULL;
+        return false;
 
     /* The IE must start with a magic byte sequence */
-    if(memcmp(magic, ie, sizeof(magic)) != 0)
-        return NULL;
-
-    return ie_wps_process_data(ie, ie_len);
+    return memcmp(magic, ie, sizeof(magic)) == 0;
 }
 
 static ie_wps_t*
@@ -20,6 +20,7 @@
 
 typedef struct ie_wps ie_wps_t;
 
+bool ie_wps_match(const uint8_t*, uint8_t);
 ie_wps_t* ie_wps_parse(const uint8_t*, uint8_t);
 
 const char* ie_wps_get_manufacturer(const ie_wps_t*);
@@ -30,6 +30,7 @@
 #define MAC80211_ADDR_BSSID      16
 
 #define MAC80211_MGMT_HEADER_LEN 12
+#define MAC80211_MGMT_TIMESTAMP_LEN 8
 #define MAC80211_MGMT_TAG_LEN     2
 
 #define MAC80211_MGMT_HEADER_CAPS_LO 10
@@ -97,31 +98,117 @@
 #define VHT_CHANNEL_MODE_2x80 3
 
 static int mac80211_frame(const uint8_t*, uint32_t);
-static void mac80211_process(mac80211_net_t*, const uint8_t*, uint32_t);
-static void mac80211_process_tag(mac80211_net_t*, uint8_t, uint8_t, const uint8_t*, const uint8_t*);
+static void mac80211_process(mac80211_frame_t*, const uint8_t*, uint32_t);
+static void mac80211_process_tag(mac80211_frame_t*, uint8_t, uint8_t, const uint8_t*);
+
+int
+mac80211_header(const uint8_t  *data,
+                uint32_t        len,
+                const uint8_t **src,
+                tzsp_view_t    *body)
+{
+    uint32_t end, i;
+    uint8_t tag_len;
+    int type;
+
+    type = mac80211_frame(data, len);
+    if(type == MAC80211_FRAME_INVALID)
+        return type;
+
+    *src = data+MAC80211_ADDR_SRC;
+
+    if(type == MAC80211_FRAME_UNKNOWN)
+        return type;
+
+    data += MAC80211_HEADER_LEN;
+    len -= MAC80211_HEADER_LEN;
+
+    /* Everything past the timestamp, up to the last complete tag */
+    end = (len < MAC80211_MGMT_HEADER_LEN ? len : MAC80211_MGMT_HEADER_LEN);
+    for(i=MAC80211_MGMT_HEADER_LEN;
+        i+MAC80211_MGMT_TAG_LEN <= len;
+        i+=MAC80211_MGMT_TAG_LEN + tag_len)
+    {
+        tag_len = data[i+1];
+        if((i + MAC80211_MGMT_TAG_LEN + tag_len) > len)
+            break;
+        end = i + MAC80211_MGMT_TAG_LEN + tag_len;
+    }
+
+    if(end > MAC80211_MGMT_TIMESTAMP_LEN)
+    {
+        body->ptr = data + MAC80211_MGMT_TIMESTAMP_LEN;
+        body->len = end - MAC80211_MGMT_TIMESTAMP_LEN;
+    }
+    else
+    {
+        body->ptr = NULL;
+        body->len = 0;
+    }
+    return type;
+}
+
+int
+mac80211_parse(const uint8_t    *data,
+               uint32_t          len,
+               mac80211_frame_t *frame)
+{
+    int type;
+
+    type = mac80211_frame(data, len);
+    if(type == MAC80211_FRAME_INVALID)
+        return type;
+
+    memset(frame, 0, sizeof(mac80211_frame_t));
+    frame->source = type;
+    frame->src = data+MAC80211_ADDR_SRC;
+    frame->info.channel = -1;
+
+    if(type == MAC80211_FRAME_UNKNOWN)
+        return type;
+
+    mac80211_process(frame, data, len);
+    return type;
+}
 
 mac80211_net_t*
 mac80211_network(const uint8_t  *data,
                  uint32_t        len,
                  const uint8_t **src)
 {
+    mac80211_frame_t frame;
     mac80211_net_t *net;
-    int frame;
 
-    frame = mac80211_frame(data, len);
-    if(frame == MAC80211_FRAME_INVALID)
+    if(mac80211_parse(data, len, &frame) == MAC80211_FRAME_INVALID)
         return NULL;
 
-    *src = data+MAC80211_ADDR_SRC;
+    *src = frame.src;
 
-    if(frame == MAC80211_FRAME_UNKNOWN)
+    if(frame.source == MAC80211_FRAME_UNKNOWN)
         return NULL;
 
     net = calloc(sizeof(mac80211_net_t), 1);
-    net->source = frame;
-    net->channel = -1;
+    net->source = frame.source;
+    net->info = frame.info;
+
+    if(frame.ssid.len)
+        net->ssid = tzsp_utils_string(frame.ssid.ptr, frame.ssid.len);
+
+    if(frame.radioname.len)
+        net->radioname = tzsp_utils_string(frame.radioname.ptr, frame.radioname.len);
+
+    if(frame.mikrotik)
+        net->ie_mikrotik = ie_mikrotik_new(&frame.ie_mikrotik);
+
+    if(frame.ie_airmax.ptr)
+        net->ie_airmax = ie_airmax_parse(frame.ie_airmax.ptr, frame.ie_airmax.len);
+
+    if(frame.ie_airmax_ac.ptr)
+        net->ie_airmax_ac = ie_airmax_ac_parse(frame.ie_airmax_ac.ptr, frame.ie_airmax_ac.len, frame.src);
+
+    if(frame.ie_wps.ptr)
+        net->ie_wps = ie_wps_parse(frame.ie_wps.ptr, frame.ie_wps.len);
 
-    mac80211_process(net, data, len);
     return net;
 }
 
@@ -151,21 +238,19 @@ mac80211_frame(const uint8_t *data,
 }
 
 static void
-mac80211_process(mac80211_net_t *context,
-                 const uint8_t  *data,
-                 uint32_t        len)
+mac80211_process(mac80211_frame_t *context,
+                 const uint8_t    *data,
+                 uint32_t          len)
 {
-    const uint8_t *src;
     uint8_t data_type;
     uint8_t data_len;
     int i;
 
-    src = data + MAC80211_ADDR_SRC;
     data = data + MAC80211_HEADER_LEN;
     len = len - MAC80211_HEADER_LEN;
 
-    context->caps = (data[MAC80211_MGMT_HEADER_CAPS_HI] << 8) |
-                     data[MAC80211_MGMT_HEADER_CAPS_LO];
+    context->info.caps = (data[MAC80211_MGMT_HEADER_CAPS_HI] << 8) |
+                          data[MAC80211_MGMT_HEADER_CAPS_LO];
 
     for(i=MAC80211_MGMT_HEADER_LEN;
         i+MAC80211_MGMT_TAG_LEN <= len;
@@ -180,28 +265,26 @@ mac80211_process(mac80211_net_t *context,
             mac80211_process_tag(context,
                                  data_type,
                                  data_len,
-                                 data+i+MAC80211_MGMT_TAG_LEN,
-                                 src);
+                                 data+i+MAC80211_MGMT_TAG_LEN);
         }
     }
 }
 
 static void
-mac80211_process_tag(mac80211_net_t *context,
-                     uint8_t         type,
-                     uint8_t         len,
-                     const uint8_t  *data,
-                     const uint8_t  *bssid)
+mac80211_process_tag(mac80211_frame_t *frame,
+                     uint8_t           type,
+                     uint8_t           len,
+                     const uint8_t    *data)
 {
     static const uint8_t oui_epigram[] = { 0x00, 0x90, 0x4c };
+    mac80211_info_t *context = &frame->info;
 
     if(type == MAC80211_MGMT_TAG_SSID &&
-       !context->ssid &&
+       !frame->ssid.len &&
        len &&
        data[0])
     {
-
-        context->ssid = tzsp_utils_string(data, len);
+        frame->ssid = tzsp_utils_view(data, len);
     }
     else if((type == MAC80211_MGMT_TAG_RATES ||
              type == MAC80211_MGMT_TAG_RATES_EXT) &&
@@ -264,7 +347,7 @@ mac80211_process_tag(mac80211_net_t *context,
     else if(type == MAC80211_MGMT_TAG_CISCO &&
             len >= MAC80211_MGMT_TAG_CISCO_MIN_LEN)
     {
-        context->radioname = tzsp_utils_string(data+10, 16);
+        frame->radioname = tzsp_utils_view(data+10, 16);
     }
     else if(type == MAC80211_MGMT_TAG_VHT_CAPS &&
             len == MAC80211_MGMT_TAG_VHT_CAPS_LEN)
@@ -311,17 +394,30 @@ mac80211_process_tag(mac80211_net_t *context,
             }
         }
 
-        if(!context->ie_mikrotik)
-            context->ie_mikrotik = ie_mikrotik_parse(data, len);
+        if(!frame->mikrotik)
+            frame->mikrotik = ie_mikrotik_parse_view(data, len, &frame->ie_mikrotik);
 
-        if(!context->ie_airmax)
-            context->ie_airmax = ie_airmax_parse(data, len);
+        if(!frame->ie_airmax.ptr &&
+           ie_airmax_match(data, len))
+        {
+            frame->ie_airmax.ptr = data;
+            frame->ie_airmax.len = len;
+        }
 
-        if(!context->ie_airmax_ac)
-            context->ie_airmax_ac = ie_airmax_ac_parse(data, len, bssid);
+        /* Encrypted, decoded only when needed */
+        if(!frame->ie_airmax_ac.ptr &&
+           ie_airmax_ac_match(data, len))
+        {
+            frame->ie_airmax_ac.ptr = data;
+            frame->ie_airmax_ac.len = len;
+        }
 
-        if(!context->ie_wps)
-            context->ie_wps = ie_wps_parse(data, len);
+        if(!frame->ie_wps.ptr &&
+           ie_wps_match(data, len))
+        {
+            frame->ie_wps.ptr = data;
+            frame->ie_wps.len = len;
+        }
     }
     else if(type == MAC80211_MGMT_TAG_EXT &&
             len)
@@ -332,50 +428,50 @@ mac80211_process_tag(mac80211_net_t *context,
 }
 
 bool
-mac80211_net_is_privacy(mac80211_net_t *context)
+mac80211_info_is_privacy(const mac80211_info_t *context)
 {
     return (context->caps & MAC80211_CAPS_PRIVACY) != 0;
 }
 
 bool
-mac80211_net_is_dsss(mac80211_net_t *context)
+mac80211_info_is_dsss(const mac80211_info_t *context)
 {
     return context->dsss_rates != 0;
 }
 
 bool
-mac80211_net_is_ofdm(mac80211_net_t *context)
+mac80211_info_is_ofdm(const mac80211_info_t *context)
 {
     return context->ofdm_rates != 0;
 }
 
 bool
-mac80211_net_is_ht(mac80211_net_t *context)
+mac80211_info_is_ht(const mac80211_info_t *context)
 {
     return context->ht;
 }
 
 bool
-mac80211_net_is_vht(mac80211_net_t *context)
+mac80211_info_is_vht(const mac80211_info_t *context)
 {
     return context->vht;
 }
 
 bool
-mac80211_net_is_he(mac80211_net_t *context)
+mac80211_info_is_he(const mac80211_info_t *context)
 {
     return context->he;
 }
 
 uint8_t
-mac80211_net_get_chains(mac80211_net_t *context)
+mac80211_info_get_chains(const mac80211_info_t *context)
 {
     return (context->vht_chains > context->ht_chains ?
             context->vht_chains : context->ht_chains);
 }
 
 const char*
-mac80211_net_get_ext_channel(mac80211_net_t *context)
+mac80211_info_get_ext_channel(const mac80211_info_t *context)
 {
     static const char channel_Ce[]      = "Ce";
     static const char channel_eC[]      = "eC";
@@ -429,6 +525,54 @@ mac80211_net_get_ext_channel(mac80211_net_t *context)
     return NULL;
 }
 
+bool
+mac80211_net_is_privacy(mac80211_net_t *context)
+{
+    return mac80211_info_is_privacy(&context->info);
+}
+
+bool
+mac80211_net_is_dsss(mac80211_net_t *context)
+{
+    return mac80211_info_is_dsss(&context->info);
+}
+
+bool
+mac80211_net_is_ofdm(mac80211_net_t *context)
+{
+    return mac80211_info_is_ofdm(&context->info);
+}
+
+bool
+mac80211_net_is_ht(mac80211_net_t *context)
+{
+    return mac80211_info_is_ht(&context->info);
+}
+
+bool
+mac80211_net_is_vht(mac80211_net_t *context)
+{
+    return mac80211_info_is_vht(&context->info);
+}
+
+bool
+mac80211_net_is_he(mac80211_net_t *context)
+{
+    return mac80211_info_is_he(&context->info);
+}
+
+uint8_t
+mac80211_net_get_chains(mac80211_net_t *context)
+{
+    return mac80211_info_get_chains(&context->info);
+}
+
+const char*
+mac80211_net_get_ext_channel(mac80211_net_t *context)
+{
+    return mac80211_info_get_ext_channel(&context->info);
+}
+
 void
 mac80211_net_free(mac80211_net_t *context)
 {
@@ -29,11 +29,8 @@ enum
     MAC80211_FRAME_PROBE_RESPONSE = 2,
 };
 
-typedef struct mac80211_net
+typedef struct mac80211_info
 {
-    int source;
-    char *ssid;
-    char *radioname;
     int channel;
     uint16_t caps;
     uint8_t dsss_rates;
@@ -47,15 +44,49 @@ typedef struct mac80211_net
     uint8_t vht_chan0;
     uint8_t vht_chan1;
     uint8_t vht_chains;
+    bool he;
+} mac80211_info_t;
+
+/* Parsed frame, all views point into the packet buffer */
+typedef struct mac80211_frame
+{
+    int source;
+    const uint8_t *src;
+    tzsp_view_t ssid;
+    tzsp_view_t radioname;
+    mac80211_info_t info;
+    bool mikrotik;
+    ie_mikrotik_view_t ie_mikrotik;
+    tzsp_view_t ie_airmax;
+    tzsp_view_t ie_airmax_ac;
+    tzsp_view_t ie_wps;
+} mac80211_frame_t;
+
+typedef struct mac80211_net
+{
+    int source;
+    char *ssid;
+    char *radioname;
+    mac80211_info_t info;
     ie_mikrotik_t *ie_mikrotik;
     ie_airmax_t *ie_airmax;
     ie_airmax_ac_t *ie_airmax_ac;
     ie_wps_t *ie_wps;
-    bool he;
 } mac80211_net_t;
 
+int mac80211_header(const uint8_t *, uint32_t, const uint8_t **, tzsp_view_t *);
+int mac80211_parse(const uint8_t *, uint32_t, mac80211_frame_t *);
 mac80211_net_t* mac80211_network(const uint8_t *, uint32_t, const uint8_t **);
 
+bool mac80211_info_is_privacy(const mac80211_info_t *);
+bool mac80211_info_is_dsss(const mac80211_info_t *);
+bool mac80211_info_is_ofdm(const mac80211_info_t *);
+bool mac80211_info_is_ht(const mac80211_info_t *);
+bool mac80211_info_is_vht(const mac80211_info_t *);
+bool mac80211_info_is_he(const mac80211_info_t *);
+uint8_t mac80211_info_get_chains(const mac80211_info_t *);
+const char* mac80211_info_get_ext_channel(const mac80211_info_t *);
+
 bool mac80211_net_is_privacy(mac80211_net_t *);
 bool mac80211_net_is_dsss(mac80211_net_t *);
 bool mac80211_net_is_ofdm(mac80211_net_t *);
@@ -0,0 +1,378 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+#include "tzsp-decap.h"
+#include "mac80211.h"
+
+/* Parser benchmark over pcap files. Allocations are counted by
+   wrapping the allocator at link time (-Wl,--wrap), so only calls
+   made by the parser objects are seen. */
+
+#define PCAP_MAGIC              0xA1B2C3D4
+#define PCAP_MAGIC_NSEC         0xA1B23C4D
+#define PCAP_HEADER_LEN         24
+#define PCAP_RECORD_HEADER_LEN  16
+
+#define LINKTYPE_ETHERNET       1
+#define LINKTYPE_80211          105
+#define LINKTYPE_RADIOTAP       127
+
+#define BENCH_DEFAULT_PASSES    100
+
+typedef struct bench_frame
+{
+    const uint8_t *data;
+    uint32_t len;
+} bench_frame_t;
+
+typedef struct bench_corpus
+{
+    bench_frame_t *frames;
+    size_t count;
+    size_t size;
+} bench_corpus_t;
+
+typedef struct bench_result
+{
+    uint64_t frames;
+    uint64_t parsed;
+    uint64_t allocs;
+    double seconds;
+} bench_result_t;
+
+void* __real_malloc(size_t);
+void* __real_calloc(size_t, size_t);
+void* __real_realloc(void*, size_t);
+char* __real_strdup(const char*);
+
+static uint64_t allocs = 0;
+
+void*
+__wrap_malloc(size_t size)
+{
+    allocs++;
+    return __real_malloc(size);
+}
+
+void*
+__wrap_calloc(size_t nmemb,
+              size_t size)
+{
+    allocs++;
+    return __real_calloc(nmemb, size);
+}
+
+void*
+__wrap_realloc(void   *ptr,
+               size_t  size)
+{
+    allocs++;
+    return __real_realloc(ptr, size);
+}
+
+char*
+__wrap_strdup(const char *s)
+{
+    allocs++;
+    return __real_strdup(s);
+}
+
+static void
+show_usage(FILE *fp,
+           char *arg)
+{
+    fprintf(fp, "usage: %s [ -n <passes> ] <file.pcap> [ <file.pcap> ... ]\n", arg);
+    fprintf(fp, "supported link types: 802.11, radiotap, ethernet (TZSP)\n");
+}
+
+static uint32_t
+bench_u32(const uint8_t *ptr,
+          bool           swap)
+{
+    uint32_t value;
+    memcpy(&value, ptr, sizeof(value));
+    return swap ? __builtin_bswap32(value) : value;
+}
+
+static bool
+bench_corpus_add(bench_corpus_t *corpus,
+                 const uint8_t  *data,
+                 uint32_t        len)
+{
+    bench_frame_t *frames;
+
+    if(corpus->count == corpus->size)
+    {
+        corpus->size = (corpus->size ? corpus->size * 2 : 1024);
+        if(!(frames = __real_realloc(corpus->frames, corpus->size * sizeof(bench_frame_t))))
+            return false;
+        corpus->frames = frames;
+    }
+
+    corpus->frames[corpus->count].data = data;
+    corpus->frames[corpus->count].len = len;
+    corpus->count++;
+    return true;
+}
+
+static const uint8_t*
+bench_decap(uint32_t       linktype,
+            const uint8_t *ptr,
+            uint32_t      *len)
+{
+    const int8_t *rssi;
+    const uint8_t *channel;
+    const uint8_t *sensor_mac;
+    uint16_t radiotap_len;
+
+    switch(linktype)
+    {
+        case LINKTYPE_80211:
+            return ptr;
+
+        case LINKTYPE_RADIOTAP:
+            if(*len < 4)
+                return NULL;
+            radiotap_len = (uint16_t)(ptr[2] | (ptr[3] << 8));
+            if(radiotap_len > *len)
+                return NULL;
+            *len -= radiotap_len;
+            return ptr + radiotap_len;
+
+        case LINKTYPE_ETHERNET:
+            ptr = decap_ethernet(ptr, len);
+            ptr = decap_ip(ptr, len);
+            ptr = decap_udp(ptr, len);
+            return ptr ? decap_tzsp(ptr, len, &rssi, &channel, &sensor_mac) : NULL;
+
+        default:
+            return NULL;
+    }
+}
+
+static bool
+bench_corpus_load(bench_corpus_t *corpus,
+                  const char     *filename)
+{
+    const uint8_t *ptr;
+    const uint8_t *end;
+    const uint8_t *frame;
+    uint8_t *buffer;
+    uint32_t magic;
+    uint32_t linktype;
+    uint32_t caplen;
+    uint32_t len;
+    bool swap;
+    long size;
+    FILE *fp;
+
+    if(!(fp = fopen(filename, "rb")))
+        return false;
+
+    if(fseek(fp, 0, SEEK_END) != 0 ||
+       (size = ftell(fp)) < PCAP_HEADER_LEN ||
+       fseek(fp, 0, SEEK_SET) != 0 ||
+       !(buffer = __real_malloc((size_t)size)))
+    {
+        fclose(fp);
+        return false;
+    }
+
+    if(fread(buffer, (size_t)size, 1, fp) != 1)
+    {
+        free(buffer);
+        fclose(fp);
+        return false;
+    }
+    fclose(fp);
+
+    memcpy(&magic, buffer, sizeof(magic));
+    swap = (magic == __builtin_bswap32(PCAP_MAGIC) ||
+            magic == __builtin_bswap32(PCAP_MAGIC_NSEC));
+    if(!swap && magic != PCAP_MAGIC && magic != PCAP_MAGIC_NSEC)
+    {
+        free(buffer);
+        return false;
+    }
+
+    /* Frames point into the buffer, it is kept until exit */
+    linktype = bench_u32(buffer + 20, swap) & 0xFFFF;
+    ptr = buffer + PCAP_HEADER_LEN;
+    end = buffer + size;
+
+    while(end - ptr >= PCAP_RECORD_HEADER_LEN)
+    {
+        caplen = bench_u32(ptr + 8, swap);
+        ptr += PCAP_RECORD_HEADER_LEN;
+        if(caplen > (uint32_t)(end - ptr))
+            break;
+
+        len = caplen;
+        if((frame = bench_decap(linktype, ptr, &len)))
+        {
+            if(!bench_corpus_add(corpus, frame, len))
+                break;
+        }
+        ptr += caplen;
+    }
+
+    return true;
+}
+
+static double
+bench_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+bench_parse(const bench_corpus_t *corpus,
+            int                   passes,
+            bench_result_t       *result)
+{
+    mac80211_frame_t frame;
+    double start;
+    size_t i;
+    int pass;
+
+    memset(result, 0, sizeof(bench_result_t));
+    allocs = 0;
+    start = bench_now();
+
+    for(pass=0; pass<passes; pass++)
+    {
+        for(i=0; i<corpus->count; i++)
+        {
+            if(mac80211_parse(corpus->frames[i].data, corpus->frames[i].len, &frame) > MAC80211_FRAME_UNKNOWN)
+                result->parsed++;
+        }
+    }
+
+    result->seconds = bench_now() - start;
+    result->frames = (uint64_t)corpus->count * passes;
+    result->allocs = allocs;
+}
+
+static void
+bench_network(const bench_corpus_t *corpus,
+              int                   passes,
+              bench_result_t       *result)
+{
+    mac80211_net_t *net;
+    const uint8_t *src;
+    double start;
+    size_t i;
+    int pass;
+
+    memset(result, 0, sizeof(bench_result_t));
+    allocs = 0;
+    start = bench_now();
+
+    for(pass=0; pass<passes; pass++)
+    {
+        for(i=0; i<corpus->count; i++)
+        {
+            if((net = mac80211_network(corpus->frames[i].data, corpus->frames[i].len, &src)))
+            {
+                result->parsed++;
+                mac80211_net_free(net);
+            }
+        }
+    }
+
+    result->seconds = bench_now() - start;
+    result->frames = (uint64_t)corpus->count * passes;
+    result->allocs = allocs;
+}
+
+static void
+bench_print(const char           *name,
+            const bench_result_t *result)
+{
+    printf("%-16s %10llu frames %10llu parsed %12.0f frames/s %8.3f allocs/frame\n",
+           name,
+           (unsigned long long)result->frames,
+           (unsigned long long)result->parsed,
+           (result->seconds > 0 ? result->frames / result->seconds : 0.0),
+           (result->frames ? (double)result->allocs / result->frames : 0.0));
+}
+
+int
+main(int   argc,
+     char *argv[])
+{
+    bench_corpus_t corpus;
+    bench_result_t result;
+    int passes = BENCH_DEFAULT_PASSES;
+    int c;
+
+    while((c = getopt(argc, argv, "hn:")) != -1)
+    {
+        switch(c)
+        {
+            case 'h':
+                show_usage(stdout, argv[0]);
+                exit(EXIT_SUCCESS);
+
+            case 'n':
+                passes = atoi(optarg);
+                break;
+
+            case ':':
+            case '?':
+                show_usage(stderr, argv[0]);
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    if(optind >= argc || passes <= 0)
+    {
+        show_usage(stderr, argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    memset(&corpus, 0, sizeof(corpus));
+    for(; optind < argc; optind++)
+    {
+        if(!bench_corpus_load(&corpus, argv[optind]))
+        {
+            fprintf(stderr, "Could not read pcap file %s\n", argv[optind]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if(!corpus.count)
+    {
+        fprintf(stderr, "No 802.11 frames found\n");
+        exit(EXIT_FAILURE);
+    }
+
+    bench_parse(&corpus, passes, &result);
+    bench_print("mac80211_parse", &result);
+
+    bench_network(&corpus, passes, &result);
+    bench_print("mac80211_network", &result);
+
+    return EXIT_SUCCESS;
+}
@@ -20,12 +20,14 @@
 #include <signal.h>
 #include "tzsp-sniffer.h"
 #include "tzsp-socket.h"
+#include "tzsp-dump.h"
 #include "mac80211.h"
 
 #define TZSP_UDP_PORT 0x9090
 
 static tzsp_sniffer_t *tzsp_sniffer = NULL;
 static tzsp_socket_t *tzsp_socket = NULL;
+static tzsp_dump_t *tzsp_dump = NULL;
 
 static void
 signal_handler(int signo)
@@ -64,8 +66,9 @@ static void
 show_usage(FILE *fp,
            char *arg)
 {
-    fprintf(fp, "network socket usage: %s [ -o <filename> ] [ -s <src-ip> ]\n", arg);
-    fprintf(fp, "pcap capture usage:   %s -p -i <interface> [ -o <filename> ]  [ -s <src-ip> ] \n", arg);
+    fprintf(fp, "network socket usage: %s [ -o <filename> [ -C <MB> ] [ -G <seconds> ] ] [ -s <src-ip> ]\n", arg);
+    fprintf(fp, "pcap capture usage:   %s -p -i <interface> [ -o <filename> [ -C <MB> ] [ -G <seconds> ] ]  [ -s <src-ip> ] \n", arg);
+    fprintf(fp, "output file rotation: -C by size, -G by time\n");
 }
 
 static void
@@ -80,6 +83,9 @@ process(const uint8_t *packet,
     nv2_net_t *net_nv2 = NULL;
     const uint8_t *src;
 
+    /* Frames are written from a separate thread */
+    if(tzsp_dump)
+        tzsp_dump_push(tzsp_dump, packet, len);
 
     net_nv2 = nv2_network(packet, len, &src);
     if(!net_nv2)
@@ -244,9 +250,11 @@ main(int   argc,
     char *output = NULL;
     char *ip_src = NULL;
     bool use_pcap = false;
+    uint64_t rotate_size = 0;
+    uint32_t rotate_time = 0;
     int c;
 
-    while((c = getopt(argc, argv, "hi:o:s:p")) != -1)
+    while((c = getopt(argc, argv, "hi:o:s:pC:G:")) != -1)
     {
         switch(c)
         {
@@ -270,6 +278,14 @@ main(int   argc,
                 use_pcap = true;
                 break;
 
+            case 'C':
+                rotate_size = strtoull(optarg, NULL, 10) * 1000000;
+                break;
+
+            case 'G':
+                rotate_time = (uint32_t)strtoul(optarg, NULL, 10);
+                break;
+
             case ':':
             case '?':
                 show_usage(stderr, argv[0]);
@@ -291,10 +307,43 @@ main(int   argc,
         exit(EXIT_FAILURE);
     }
 
+    if((rotate_size || rotate_time) && !output)
+    {
+        fprintf(stderr, "Output file rotation requires an output file\n");
+        show_usage(stderr, argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    if(output)
+    {
+        tzsp_dump = tzsp_dump_new();
+        switch(tzsp_dump_init(tzsp_dump, output, rotate_size, rotate_time))
+        {
+            case TZSP_DUMP_OK:
+                break;
+
+            case TZSP_DUMP_ERROR_MEMORY:
+                fprintf(stderr, "Memory allocation failed\n");
+                exit(EXIT_FAILURE);
+
+            case TZSP_DUMP_ERROR_OPEN:
+                fprintf(stderr, "Could not open output file %s\n", output);
+                exit(EXIT_FAILURE);
+
+            case TZSP_DUMP_ERROR_THREAD:
+                fprintf(stderr, "Could not start the writer thread\n");
+                exit(EXIT_FAILURE);
+
+            default:
+                fprintf(stderr, "Unknown error\n");
+                exit(EXIT_FAILURE);
+        }
+    }
+
     if(use_pcap)
     {
         tzsp_sniffer = tzsp_sniffer_new();
-        switch(tzsp_sniffer_init(tzsp_sniffer, TZSP_UDP_PORT, output, ip_src, dev_if, 100))
+        switch(tzsp_sniffer_init(tzsp_sniffer, TZSP_UDP_PORT, ip_src, dev_if, 100))
         {
             case TZSP_SNIFFER_OK:
                 break;
@@ -319,14 +368,6 @@ main(int   argc,
                 fprintf(stderr, "Could not install packet filter\n");
                 exit(EXIT_FAILURE);
 
-            case TZSP_SNIFFER_ERROR_DUMP_OPEN_DEAD:
-                fprintf(stderr, "Could not open virtual output device\n");
-                exit(EXIT_FAILURE);
-
-            case TZSP_SNIFFER_ERROR_DUMP_OPEN:
-                fprintf(stderr, "Could not open output file %s\n", output);
-                exit(EXIT_FAILURE);
-
             default:
                 fprintf(stderr, "Unknown error\n");
                 exit(EXIT_FAILURE);
@@ -335,7 +376,7 @@ main(int   argc,
     else
     {
         tzsp_socket = tzsp_socket_new();
-        switch(tzsp_socket_init(tzsp_socket, TZSP_UDP_PORT, output, ip_src))
+        switch(tzsp_socket_init(tzsp_socket, TZSP_UDP_PORT, ip_src))
         {
             case TZSP_SOCKET_OK:
                 break;
@@ -352,14 +393,6 @@ main(int   argc,
                 fprintf(stderr, "Failed to bind a port\n");
                 exit(EXIT_FAILURE);
 
-            case TZSP_SOCKET_ERROR_DUMP_OPEN_DEAD:
-                fprintf(stderr, "Could not open virtual output device\n");
-                exit(EXIT_FAILURE);
-
-            case TZSP_SOCKET_ERROR_DUMP_OPEN:
-                fprintf(stderr, "Could not open output file %s\n", output);
-                exit(EXIT_FAILURE);
-
             default:
                 fprintf(stderr, "Unknown error\n");
                 exit(EXIT_FAILURE);
@@ -399,5 +432,17 @@ main(int   argc,
     if(tzsp_socket)
         tzsp_socket_free(tzsp_socket);
 
+    if(tzsp_dump)
+    {
+        tzsp_dump_finish(tzsp_dump);
+        fprintf(stderr, "Output: %llu frames in %u file(s), queue high-water %u/%u, %u dropped\n",
+                (unsigned long long)tzsp_dump_get_frames(tzsp_dump),
+                tzsp_dump_get_files(tzsp_dump),
+                tzsp_dump_get_high_water(tzsp_dump),
+                TZSP_DUMP_QUEUE_LEN,
+                tzsp_dump_get_drops(tzsp_dump));
+        tzsp_dump_free(tzsp_dump);
+    }
+
     return 0;
 }
@@ -0,0 +1,352 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/time.h>
+#include "tzsp-dump.h"
+
+/* Frames are passed from the receive thread to the writer thread
+   through a single-producer, single-consumer ring of fixed slots,
+   so the receiver never waits for the disk. When the ring is full,
+   the frame is dropped and counted. */
+
+#define TZSP_DUMP_BUFFER_LEN    (1024 * 1024)
+#define TZSP_DUMP_IDLE_USEC     10000
+#define TZSP_DUMP_FLUSH_SEC     1
+
+#define PCAP_MAGIC              0xA1B2C3D4
+#define PCAP_VERSION_MAJOR      2
+#define PCAP_VERSION_MINOR      4
+#define PCAP_LINKTYPE_80211     105
+#define PCAP_HEADER_LEN         24
+#define PCAP_RECORD_HEADER_LEN  16
+
+typedef struct tzsp_dump_header
+{
+    uint32_t magic;
+    uint16_t version_major;
+    uint16_t version_minor;
+    int32_t  thiszone;
+    uint32_t sigfigs;
+    uint32_t snaplen;
+    uint32_t linktype;
+} tzsp_dump_header_t;
+
+typedef struct tzsp_dump_slot
+{
+    struct timeval ts;
+    uint32_t len;
+    uint32_t caplen;
+    uint8_t data[TZSP_DUMP_SNAPLEN];
+} tzsp_dump_slot_t;
+
+typedef struct tzsp_dump
+{
+    char            *output;
+    FILE            *fp;
+    char            *buffer;
+    uint64_t         rotate_size;
+    uint32_t         rotate_time;
+    uint64_t         file_len;
+    time_t           file_ts;
+    time_t           flush_ts;
+    bool             dirty;
+    bool             thread;
+    pthread_t        writer;
+    tzsp_dump_slot_t *slots;
+    atomic_uint      head;
+    atomic_uint      tail;
+    atomic_bool      canceled;
+    atomic_uint      high_water;
+    atomic_uint      drops;
+    atomic_uint      files;
+    atomic_ullong    frames;
+} tzsp_dump_t;
+
+static void* tzsp_dump_thread(void*);
+static bool tzsp_dump_write(tzsp_dump_t*, const tzsp_dump_slot_t*);
+static bool tzsp_dump_open(tzsp_dump_t*, time_t);
+static void tzsp_dump_close(tzsp_dump_t*);
+
+
+tzsp_dump_t*
+tzsp_dump_new()
+{
+    return calloc(sizeof(tzsp_dump_t), 1);
+}
+
+int
+tzsp_dump_init(tzsp_dump_t *context,
+               const char  *output,
+               uint64_t     rotate_size,
+               uint32_t     rotate_time)
+{
+    struct timeval now;
+
+    context->rotate_size = rotate_size;
+    context->rotate_time = rotate_time;
+    context->output = strdup(output);
+    context->buffer = malloc(TZSP_DUMP_BUFFER_LEN);
+    context->slots = calloc(TZSP_DUMP_QUEUE_LEN, sizeof(tzsp_dump_slot_t));
+    if(!context->output || !context->buffer || !context->slots)
+        return TZSP_DUMP_ERROR_MEMORY;
+
+    atomic_init(&context->head, 0);
+    atomic_init(&context->tail, 0);
+    atomic_init(&context->canceled, false);
+    atomic_init(&context->high_water, 0);
+    atomic_init(&context->drops, 0);
+    atomic_init(&context->files, 0);
+    atomic_init(&context->frames, 0);
+
+    gettimeofday(&now, NULL);
+    if(!tzsp_dump_open(context, now.tv_sec))
+        return TZSP_DUMP_ERROR_OPEN;
+
+    if(pthread_create(&context->writer, NULL, tzsp_dump_thread, context) != 0)
+        return TZSP_DUMP_ERROR_THREAD;
+
+    context->thread = true;
+    return TZSP_DUMP_OK;
+}
+
+bool
+tzsp_dump_push(tzsp_dump_t   *context,
+               const uint8_t *packet,
+               uint32_t       len)
+{
+    /* Function called from the receive thread only */
+    tzsp_dump_slot_t *slot;
+    unsigned int head;
+    unsigned int used;
+
+    head = atomic_load_explicit(&context->head, memory_order_relaxed);
+    used = head - atomic_load_explicit(&context->tail, memory_order_acquire);
+    if(used >= TZSP_DUMP_QUEUE_LEN)
+    {
+        atomic_fetch_add_explicit(&context->drops, 1, memory_order_relaxed);
+        return false;
+    }
+
+    slot = &context->slots[head % TZSP_DUMP_QUEUE_LEN];
+    gettimeofday(&slot->ts, NULL);
+    slot->len = len;
+    slot->caplen = (len < TZSP_DUMP_SNAPLEN) ? len : TZSP_DUMP_SNAPLEN;
+    memcpy(slot->data, packet, slot->caplen);
+    atomic_store_explicit(&context->head, head + 1, memory_order_release);
+
+    if(used + 1 > atomic_load_explicit(&context->high_water, memory_order_relaxed))
+        atomic_store_explicit(&context->high_water, used + 1, memory_order_relaxed);
+
+    return true;
+}
+
+uint32_t
+tzsp_dump_get_high_water(const tzsp_dump_t *context)
+{
+    return atomic_load((atomic_uint*)&context->high_water);
+}
+
+uint32_t
+tzsp_dump_get_drops(const tzsp_dump_t *context)
+{
+    return atomic_load((atomic_uint*)&context->drops);
+}
+
+uint64_t
+tzsp_dump_get_frames(const tzsp_dump_t *context)
+{
+    return atomic_load((atomic_ullong*)&context->frames);
+}
+
+uint32_t
+tzsp_dump_get_files(const tzsp_dump_t *context)
+{
+    return atomic_load((atomic_uint*)&context->files);
+}
+
+void
+tzsp_dump_finish(tzsp_dump_t *context)
+{
+    /* The writer drains the queue before it exits */
+    if(context->thread)
+    {
+        atomic_store(&context->canceled, true);
+        pthread_join(context->writer, NULL);
+        context->thread = false;
+    }
+
+    tzsp_dump_close(context);
+}
+
+void
+tzsp_dump_free(tzsp_dump_t *context)
+{
+    if(context)
+    {
+        tzsp_dump_finish(context);
+        free(context->slots);
+        free(context->buffer);
+        free(context->output);
+        free(context);
+    }
+}
+
+static void*
+tzsp_dump_thread(void *user_data)
+{
+    tzsp_dump_t *context = (tzsp_dump_t*)user_data;
+    tzsp_dump_slot_t *slot;
+    struct timeval now;
+    unsigned int tail;
+
+    while(true)
+    {
+        tail = atomic_load_explicit(&context->tail, memory_order_relaxed);
+        if(tail == atomic_load_explicit(&context->head, memory_order_acquire))
+        {
+            if(atomic_load(&context->canceled))
+                break;
+
+            /* Keep the file reasonably up to date while idle */
+            gettimeofday(&now, NULL);
+            if(context->dirty &&
+               now.tv_sec - context->flush_ts >= TZSP_DUMP_FLUSH_SEC)
+            {
+                fflush(context->fp);
+                context->dirty = false;
+                context->flush_ts = now.tv_sec;
+            }
+
+            usleep(TZSP_DUMP_IDLE_USEC);
+            continue;
+        }
+
+        slot = &context->slots[tail % TZSP_DUMP_QUEUE_LEN];
+        if(tzsp_dump_write(context, slot))
+            atomic_fetch_add_explicit(&context->frames, 1, memory_order_relaxed);
+        else
+            atomic_fetch_add_explicit(&context->drops, 1, memory_order_relaxed);
+
+        atomic_store_explicit(&context->tail, tail + 1, memory_order_release);
+    }
+
+    return NULL;
+}
+
+static bool
+tzsp_dump_write(tzsp_dump_t            *context,
+                const tzsp_dump_slot_t *slot)
+{
+    uint32_t header[4];
+    bool rotate;
+
+    rotate = (context->rotate_size &&
+              context->file_len > PCAP_HEADER_LEN &&
+              context->file_len + PCAP_RECORD_HEADER_LEN + slot->caplen > context->rotate_size);
+
+    rotate |= (context->rotate_time &&
+               slot->ts.tv_sec - context->file_ts >= context->rotate_time);
+
+    if(rotate || !context->fp)
+    {
+        tzsp_dump_close(context);
+        if(!tzsp_dump_open(context, slot->ts.tv_sec))
+            return false;
+    }
+
+    header[0] = (uint32_t)slot->ts.tv_sec;
+    header[1] = (uint32_t)slot->ts.tv_usec;
+    header[2] = slot->caplen;
+    header[3] = slot->len;
+
+    if(fwrite(header, sizeof(header), 1, context->fp) != 1 ||
+       fwrite(slot->data, slot->caplen, 1, context->fp) != 1)
+    {
+        /* Try again with a new file */
+        tzsp_dump_close(context);
+        return false;
+    }
+
+    context->file_len += PCAP_RECORD_HEADER_LEN + slot->caplen;
+    context->dirty = true;
+    return true;
+}
+
+static bool
+tzsp_dump_open(tzsp_dump_t *context,
+               time_t       ts)
+{
+    tzsp_dump_header_t header;
+    unsigned int index;
+    char *filename;
+
+    /* Next files are named like in tcpdump: output, output1, output2... */
+    index = atomic_load(&context->files);
+    if(!index)
+        filename = strdup(context->output);
+    else if(asprintf(&filename, "%s%u", context->output, index) < 0)
+        filename = NULL;
+
+    if(!filename)
+        return false;
+
+    context->fp = fopen(filename, "wb");
+    free(filename);
+    if(!context->fp)
+        return false;
+
+    setvbuf(context->fp, context->buffer, _IOFBF, TZSP_DUMP_BUFFER_LEN);
+
+    /* The file is written in the host byte order */
+    header.magic = PCAP_MAGIC;
+    header.version_major = PCAP_VERSION_MAJOR;
+    header.version_minor = PCAP_VERSION_MINOR;
+    header.thiszone = 0;
+    header.sigfigs = 0;
+    header.snaplen = TZSP_DUMP_SNAPLEN;
+    header.linktype = PCAP_LINKTYPE_80211;
+
+    if(fwrite(&header, sizeof(header), 1, context->fp) != 1)
+    {
+        fclose(context->fp);
+        context->fp = NULL;
+        return false;
+    }
+
+    atomic_fetch_add(&context->files, 1);
+    context->file_len = PCAP_HEADER_LEN;
+    context->file_ts = ts;
+    context->flush_ts = ts;
+    context->dirty = true;
+    return true;
+}
+
+static void
+tzsp_dump_close(tzsp_dump_t *context)
+{
+    if(context->fp)
+    {
+        fclose(context->fp);
+        context->fp = NULL;
+    }
+    context->dirty = false;
+}
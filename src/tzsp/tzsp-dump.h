@@ -0,0 +1,45 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef MTSCAN_TZSP_DUMP_H
+#define MTSCAN_TZSP_DUMP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TZSP_DUMP_QUEUE_LEN 1024
+#define TZSP_DUMP_SNAPLEN   8192
+
+typedef struct tzsp_dump tzsp_dump_t;
+
+enum
+{
+    TZSP_DUMP_OK           =  0,
+    TZSP_DUMP_ERROR_MEMORY = -1,
+    TZSP_DUMP_ERROR_OPEN   = -2,
+    TZSP_DUMP_ERROR_THREAD = -3
+};
+
+tzsp_dump_t* tzsp_dump_new();
+int tzsp_dump_init(tzsp_dump_t*, const char*, uint64_t, uint32_t);
+bool tzsp_dump_push(tzsp_dump_t*, const uint8_t*, uint32_t);
+uint32_t tzsp_dump_get_high_water(const tzsp_dump_t*);
+uint32_t tzsp_dump_get_drops(const tzsp_dump_t*);
+uint64_t tzsp_dump_get_frames(const tzsp_dump_t*);
+uint32_t tzsp_dump_get_files(const tzsp_dump_t*);
+void tzsp_dump_finish(tzsp_dump_t*);
+void tzsp_dump_free(tzsp_dump_t*);
+
+#endif
@@ -33,8 +33,6 @@
 typedef struct tzsp_sniffer
 {
     pcap_t         *capture;
-    pcap_t         *dump;
-    pcap_dumper_t  *dumper;
     volatile bool   canceled;
     volatile bool   enabled;
     char            errbuf[PCAP_ERRBUF_SIZE];
@@ -52,7 +50,6 @@ tzsp_sniffer_new()
 int
 tzsp_sniffer_init(tzsp_sniffer_t *context,
                   uint16_t        udp_port,
-                  const char     *output,
                   const char     *ip_src,
                   const char     *dev_if,
                   int             latency)
@@ -116,30 +113,10 @@ tzsp_sniffer_init(tzsp_sniffer_t *context,
         goto free_filter;
     }
 
-    if(output)
-    {
-        if ((context->dump = pcap_open_dead(DLT_IEEE802_11, BUFSIZ)) == NULL)
-        {
-            snprintf(context->errbuf, PCAP_ERRBUF_SIZE, "pcap_open_dead failed");
-            ret = TZSP_SNIFFER_ERROR_DUMP_OPEN_DEAD;
-            goto free_filter;
-        }
-
-        if ((context->dumper = pcap_dump_open(context->dump, output)) == NULL)
-        {
-            snprintf(context->errbuf, PCAP_ERRBUF_SIZE, "pcap_open_dead failed");
-            ret = TZSP_SNIFFER_ERROR_DUMP_OPEN;
-            goto free_dump;
-        }
-    }
-
     pcap_freecode(&fp);
     free(filter_exp);
     return TZSP_SNIFFER_OK;
 
-free_dump:
-    pcap_close(context->dump);
-    context->dump = NULL;
 free_filter:
     pcap_freecode(&fp);
 free_capture:
@@ -194,12 +171,6 @@ tzsp_sniffer_loop(tzsp_sniffer_t *context)
             if((ptr = decap_tzsp(ptr, &header->caplen, &rssi, &channel, &sensor_mac)) == NULL)
                 continue;
 
-            if(context->dumper)
-            {
-                header->len = header->caplen;
-                pcap_dump((u_char*)context->dumper, header, ptr);
-            }
-
             if(context->user_func)
                 context->user_func(ptr, header->caplen, rssi, channel, sensor_mac, context->user_data);
         }
@@ -232,10 +203,6 @@ tzsp_sniffer_free(tzsp_sniffer_t *context)
 {
     if(context)
     {
-        if(context->dumper)
-            pcap_dump_close(context->dumper);
-        if(context->dump)
-            pcap_close(context->dump);
         if(context->capture)
             pcap_close(context->capture);
         free(context);
@@ -28,13 +28,11 @@ enum
     TZSP_SNIFFER_ERROR_CAPTURE        = -3,
     TZSP_SNIFFER_ERROR_DATALINK       = -4,
     TZSP_SNIFFER_ERROR_FILTER         = -5,
-    TZSP_SNIFFER_ERROR_SET_FILTER     = -6,
-    TZSP_SNIFFER_ERROR_DUMP_OPEN_DEAD = -7,
-    TZSP_SNIFFER_ERROR_DUMP_OPEN      = -8
+    TZSP_SNIFFER_ERROR_SET_FILTER     = -6
 };
 
 tzsp_sniffer_t* tzsp_sniffer_new();
-int tzsp_sniffer_init(tzsp_sniffer_t*, uint16_t, const char*, const char*, const char*, int);
+int tzsp_sniffer_init(tzsp_sniffer_t*, uint16_t, const char*, const char*, int);
 const char* tzsp_sniffer_get_error(const tzsp_sniffer_t*);
 void tzsp_sniffer_set_func(tzsp_sniffer_t*, void (*)(const uint8_t*, uint32_t, const int8_t*, const uint8_t*, const uint8_t*, void*), void*);
 void tzsp_sniffer_loop(tzsp_sniffer_t*);
@@ -18,9 +18,6 @@
 #include <stdint.h>
 #include <unistd.h>
 #include <stdbool.h>
-#ifdef HAVE_PCAP
-#include <pcap.h>
-#endif
 #include <string.h>
 #include <sys/time.h>
 #include <errno.h>
@@ -35,6 +32,9 @@
 #include <netinet/ip.h>
 #include <netinet/in.h>
 #endif
+#ifdef __linux__
+#include <linux/filter.h>
+#endif
 #include "tzsp-decap.h"
 #include "tzsp-socket.h"
 
@@ -46,21 +46,40 @@ typedef int socket_t;
 #endif
 
 #define SOCKET_BUFF_LEN 65536
+#define SOCKET_TIMEOUT  10000
+
+#ifdef __linux__
+/* Every slot fits the largest UDP datagram, so no TZSP frame is truncated.
+   Only the pages actually written by the kernel become resident. */
+#define TZSP_SOCKET_MMSG
+#define SOCKET_BATCH     64
+#define SOCKET_BATCH_LEN SOCKET_BUFF_LEN
+#endif
+
+#ifdef SO_ATTACH_FILTER
+#define FILTER_UDP_HEADER_LEN  8
+#define FILTER_TZSP_HEADER_LEN 4
+#define FILTER_TAGS_MAX       24
+#define FILTER_TAG_LEN        11
+#define FILTER_LEN            (7 + FILTER_TAGS_MAX * FILTER_TAG_LEN + 1 + 9)
+#endif
 
 typedef struct tzsp_socket
 {
     socket_t         socket;
-#ifdef HAVE_PCAP
-    pcap_t          *dump;
-    pcap_dumper_t   *dumper;
-#endif
     volatile bool    canceled;
     volatile bool    enabled;
+    volatile uint32_t drops;
+    volatile uint32_t truncated;
     uint32_t         src;
     void           (*user_func)(const uint8_t*, uint32_t, const int8_t*, const uint8_t*, const uint8_t*, void*);
     void            *user_data;
 } tzsp_socket_t;
 
+static void tzsp_socket_process(tzsp_socket_t*, const uint8_t*, uint32_t, const struct sockaddr_in*);
+#ifdef TZSP_SOCKET_MMSG
+static void tzsp_socket_loop_mmsg(tzsp_socket_t*);
+#endif
 static void tzsp_socket_close(tzsp_socket_t*);
 
 
@@ -73,11 +92,13 @@ tzsp_socket_new()
 int
 tzsp_socket_init(tzsp_socket_t *context,
                  uint16_t       tzsp_port,
-                 const char    *output,
                  const char    *ip_src)
 {
     struct sockaddr_in addr;
     int ret;
+#ifdef SO_RXQ_OVFL
+    int enable = 1;
+#endif
 
     if(!ip_src)
         context->src = INADDR_NONE;
@@ -103,30 +124,13 @@ tzsp_socket_init(tzsp_socket_t *context,
         goto free_socket;
     }
 
-    if(output)
-    {
-#ifdef HAVE_PCAP
-        if((context->dump = pcap_open_dead(DLT_IEEE802_11, BUFSIZ)) == NULL)
-        {
-            ret = TZSP_SOCKET_ERROR_DUMP_OPEN_DEAD;
-            goto free_socket;
-        }
-
-        if((context->dumper = pcap_dump_open(context->dump, output)) == NULL)
-        {
-            ret = TZSP_SOCKET_ERROR_DUMP_OPEN;
-            goto free_dump;
-        }
+#ifdef SO_RXQ_OVFL
+    /* Report the number of datagrams dropped by the kernel */
+    setsockopt(context->socket, SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable));
 #endif
-    }
 
     return TZSP_SOCKET_OK;
 
-#ifdef HAVE_PCAP
-free_dump:
-    pcap_close(context->dump);
-    context->dump = NULL;
-#endif
 free_socket:
     tzsp_socket_close(context);
     return ret;
@@ -141,30 +145,110 @@ tzsp_socket_set_func(tzsp_socket_t  *context,
     context->user_data = user_data;
 }
 
+int
+tzsp_socket_set_buffer(tzsp_socket_t *context,
+                       int            size)
+{
+    if(size <= 0)
+        return 0;
+
+    return setsockopt(context->socket, SOL_SOCKET, SO_RCVBUF, (const char*)&size, sizeof(size));
+}
+
+int
+tzsp_socket_set_filter(tzsp_socket_t *context)
+{
+#ifdef SO_ATTACH_FILTER
+    /* Accept only TZSP frames carrying 802.11 beacons, probe responses,
+       nv2 beacons (data frames with 0x90 flags) and Cambium beacons
+       (action no ack). The tag list is walked with an unrolled loop,
+       as classic BPF does not allow backward jumps. */
+    struct sock_filter code[FILTER_LEN];
+    struct sock_fprog prog;
+    int end, pc = 0;
+    int i;
+
+    end = 7 + FILTER_TAGS_MAX * FILTER_TAG_LEN + 1;
+
+    /* The socket filter starts at the UDP header */
+    code[pc++] = (struct sock_filter)BPF_STMT(BPF_LD|BPF_H|BPF_ABS, FILTER_UDP_HEADER_LEN);
+    code[pc++] = (struct sock_filter)BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, 0x0100, 1, 0);
+    code[pc++] = (struct sock_filter)BPF_STMT(BPF_RET|BPF_K, 0);
+    code[pc++] = (struct sock_filter)BPF_STMT(BPF_LD|BPF_H|BPF_ABS, FILTER_UDP_HEADER_LEN + 2);
+    code[pc++] = (struct sock_filter)BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, 0x0012, 1, 0);
+    code[pc++] = (struct sock_filter)BPF_STMT(BPF_RET|BPF_K, 0);
+    code[pc++] = (struct sock_filter)BPF_STMT(BPF_LDX|BPF_W|BPF_IMM, FILTER_UDP_HEADER_LEN + FILTER_TZSP_HEADER_LEN);
+
+    for(i=0; i<FILTER_TAGS_MAX; i++)
+    {
+        /* X points at the current tag */
+        code[pc++] = (struct sock_filter)BPF_STMT(BPF_LD|BPF_B|BPF_IND, 0);
+        code[pc++] = (struct sock_filter)BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, 0x00, 0, 3);
+        /* Padding tag has no length */
+        code[pc++] = (struct sock_filter)BPF_STMT(BPF_MISC|BPF_TXA, 0);
+        code[pc++] = (struct sock_filter)BPF_STMT(BPF_ALU|BPF_ADD|BPF_K, 1);
+        code[pc++] = (struct sock_filter)BPF_STMT(BPF_JMP|BPF_JA, 5);
+        /* End tag is followed by the frame */
+        code[pc++] = (struct sock_filter)BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, 0x01, 0, 1);
+        code[pc] = (struct sock_filter)BPF_STMT(BPF_JMP|BPF_JA, end - pc - 1);
+        pc++;
+        /* Other tags: X += length + 2 */
+        code[pc++] = (struct sock_filter)BPF_STMT(BPF_LD|BPF_B|BPF_IND, 1);
+        code[pc++] = (struct sock_filter)BPF_STMT(BPF_ALU|BPF_ADD|BPF_K, 2);
+        code[pc++] = (struct sock_filter)BPF_STMT(BPF_ALU|BPF_ADD|BPF_X, 0);
+        code[pc++] = (struct sock_filter)BPF_STMT(BPF_MISC|BPF_TAX, 0);
+    }
+
+    /* Too many tags, leave it to the userspace */
+    code[pc++] = (struct sock_filter)BPF_STMT(BPF_RET|BPF_K, 0xFFFFFFFF);
+
+    /* Frame control */
+    code[pc++] = (struct sock_filter)BPF_STMT(BPF_LD|BPF_B|BPF_IND, 1);
+    code[pc++] = (struct sock_filter)BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, 0x80, 6, 0);
+    code[pc++] = (struct sock_filter)BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, 0x50, 5, 0);
+    code[pc++] = (struct sock_filter)BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, 0xE0, 4, 0);
+    code[pc++] = (struct sock_filter)BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, 0x08, 0, 2);
+    code[pc++] = (struct sock_filter)BPF_STMT(BPF_LD|BPF_B|BPF_IND, 2);
+    code[pc++] = (struct sock_filter)BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, 0x90, 1, 0);
+    code[pc++] = (struct sock_filter)BPF_STMT(BPF_RET|BPF_K, 0);
+    code[pc++] = (struct sock_filter)BPF_STMT(BPF_RET|BPF_K, 0xFFFFFFFF);
+
+    prog.len = pc;
+    prog.filter = code;
+    return setsockopt(context->socket, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog));
+#else
+    return -1;
+#endif
+}
+
+uint32_t
+tzsp_socket_get_drops(const tzsp_socket_t *context)
+{
+    return context->drops + context->truncated;
+}
+
 void
 tzsp_socket_loop(tzsp_socket_t *context)
 {
     uint8_t packet[SOCKET_BUFF_LEN];
-    const uint8_t *ptr;
     struct sockaddr_in addr;
     socklen_t len;
     struct timeval timeout;
-#ifdef HAVE_PCAP
-    struct pcap_pkthdr header;
-#endif
     fd_set input;
-    const int8_t *rssi;
-    const uint8_t *channel;
-    const uint8_t *sensor_mac;
     ssize_t ret;
-    uint32_t data_len;
+
+#ifdef TZSP_SOCKET_MMSG
+    tzsp_socket_loop_mmsg(context);
+    if(context->canceled)
+        return;
+#endif
 
     while(!context->canceled)
     {
         FD_ZERO(&input);
         FD_SET(context->socket, &input);
         timeout.tv_sec  = 0;
-        timeout.tv_usec = 100 * 100;
+        timeout.tv_usec = SOCKET_TIMEOUT;
 
         ret = select(context->socket+1, &input, NULL, NULL, &timeout);
         if(ret < 0)
@@ -185,36 +269,131 @@ tzsp_socket_loop(tzsp_socket_t *context)
             break;
         }
 
-        if(!context->canceled &&
-            context->enabled)
+        tzsp_socket_process(context, packet, (uint32_t)ret, &addr);
+    }
+}
+
+#ifdef TZSP_SOCKET_MMSG
+static void
+tzsp_socket_loop_mmsg(tzsp_socket_t *context)
+{
+    /* Datagrams are received in batches, up to SOCKET_BATCH per syscall.
+       The call blocks until the first one arrives, then takes whatever
+       is already queued. The receive timeout lets it check for cancel. */
+    struct mmsghdr *msgs;
+    struct iovec *iovecs;
+    struct sockaddr_in *addrs;
+    uint8_t *buffers;
+    uint8_t *controls;
+    struct cmsghdr *cmsg;
+    struct timeval timeout;
+    size_t control_len;
+    int ret, i;
+
+    timeout.tv_sec  = 0;
+    timeout.tv_usec = SOCKET_TIMEOUT;
+    if(setsockopt(context->socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) < 0)
+        return;
+
+    control_len = CMSG_SPACE(sizeof(uint32_t));
+    msgs = calloc(SOCKET_BATCH, sizeof(struct mmsghdr));
+    iovecs = calloc(SOCKET_BATCH, sizeof(struct iovec));
+    addrs = calloc(SOCKET_BATCH, sizeof(struct sockaddr_in));
+    buffers = malloc(SOCKET_BATCH * SOCKET_BATCH_LEN);
+    controls = malloc(SOCKET_BATCH * control_len);
+
+    if(!msgs || !iovecs || !addrs || !buffers || !controls)
+        goto cleanup;
+
+    for(i=0; i<SOCKET_BATCH; i++)
+    {
+        iovecs[i].iov_base = buffers + i * SOCKET_BATCH_LEN;
+        iovecs[i].iov_len = SOCKET_BATCH_LEN;
+    }
+
+    while(!context->canceled)
+    {
+        for(i=0; i<SOCKET_BATCH; i++)
+        {
+            msgs[i].msg_hdr.msg_name = &addrs[i];
+            msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+            msgs[i].msg_hdr.msg_iov = &iovecs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            msgs[i].msg_hdr.msg_control = controls + i * control_len;
+            msgs[i].msg_hdr.msg_controllen = control_len;
+            msgs[i].msg_hdr.msg_flags = 0;
+        }
+
+        ret = recvmmsg(context->socket, msgs, SOCKET_BATCH, MSG_WAITFORONE, NULL);
+        if(ret < 0)
         {
-            if(context->src != INADDR_NONE && context->src != addr.sin_addr.s_addr)
+            if(errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)
                 continue;
 
-#ifdef HAVE_PCAP
-            gettimeofday(&header.ts, NULL);
-            header.caplen = (uint32_t)ret;
-#endif
+            /* Not supported by the kernel, use the select() loop */
+            if(errno == ENOSYS)
+                break;
 
-            rssi = NULL;
-            channel = NULL;
-            sensor_mac = NULL;
-            data_len = (uint32_t)ret;
-            if((ptr = decap_tzsp(packet, &data_len, &rssi, &channel, &sensor_mac)) == NULL)
-                continue;
+            context->canceled = true;
+            break;
+        }
+
+        for(i=0; i<ret; i++)
+        {
+            for(cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cmsg; cmsg = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsg))
+            {
+                /* The kernel reports the total count of dropped datagrams */
+                if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL)
+                    memcpy((void*)&context->drops, CMSG_DATA(cmsg), sizeof(uint32_t));
+            }
 
-#ifdef HAVE_PCAP
-            if(context->dumper)
+            if(msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
             {
-                header.len = header.caplen;
-                pcap_dump((u_char*)context->dumper, &header, ptr);
+                context->truncated++;
+                continue;
             }
-#endif
 
-            if(context->user_func)
-                context->user_func(ptr, data_len, rssi, channel, sensor_mac, context->user_data);
+            tzsp_socket_process(context, iovecs[i].iov_base, msgs[i].msg_len, &addrs[i]);
         }
     }
+
+cleanup:
+    free(controls);
+    free(buffers);
+    free(addrs);
+    free(iovecs);
+    free(msgs);
+}
+#endif
+
+static void
+tzsp_socket_process(tzsp_socket_t            *context,
+                    const uint8_t            *packet,
+                    uint32_t                  len,
+                    const struct sockaddr_in *addr)
+{
+    const uint8_t *ptr;
+    const int8_t *rssi;
+    const uint8_t *channel;
+    const uint8_t *sensor_mac;
+    uint32_t data_len;
+
+    if(context->canceled ||
+       !context->enabled)
+        return;
+
+    if(context->src != INADDR_NONE && context->src != addr->sin_addr.s_addr)
+        return;
+
+    rssi = NULL;
+    channel = NULL;
+    sensor_mac = NULL;
+    data_len = len;
+    if((ptr = decap_tzsp(packet, &data_len, &rssi, &channel, &sensor_mac)) == NULL)
+        return;
+
+    if(context->user_func)
+        context->user_func(ptr, data_len, rssi, channel, sensor_mac, context->user_data);
 }
 
 void
@@ -241,12 +420,6 @@ tzsp_socket_free(tzsp_socket_t *context)
     if(context)
     {
         tzsp_socket_close(context);
-#ifdef HAVE_PCAP
-        if(context->dumper)
-            pcap_dump_close(context->dumper);
-        if(context->dump)
-            pcap_close(context->dump);
-#endif
         free(context);
     }
 }
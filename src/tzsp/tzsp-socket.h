@@ -25,14 +25,15 @@ enum
     TZSP_SOCKET_OK                   =  0,
     TZSP_SOCKET_ERROR_INVALID_IP     = -1,
     TZSP_SOCKET_ERROR_SOCKET         = -2,
-    TZSP_SOCKET_ERROR_BIND           = -3,
-    TZSP_SOCKET_ERROR_DUMP_OPEN_DEAD = -4,
-    TZSP_SOCKET_ERROR_DUMP_OPEN      = -5
+    TZSP_SOCKET_ERROR_BIND           = -3
 };
 
 tzsp_socket_t* tzsp_socket_new();
-int tzsp_socket_init(tzsp_socket_t*, uint16_t, const char*, const char*);
+int tzsp_socket_init(tzsp_socket_t*, uint16_t, const char*);
 void tzsp_socket_set_func(tzsp_socket_t*, void (*)(const uint8_t*, uint32_t, const int8_t*, const uint8_t*, const uint8_t*, void*), void*);
+int tzsp_socket_set_buffer(tzsp_socket_t*, int);
+int tzsp_socket_set_filter(tzsp_socket_t*);
+uint32_t tzsp_socket_get_drops(const tzsp_socket_t*);
 void tzsp_socket_loop(tzsp_socket_t*);
 void tzsp_socket_enable(tzsp_socket_t*);
 void tzsp_socket_disable(tzsp_socket_t*);
@@ -37,4 +37,15 @@ char* tzsp_utils_string(const uint8_t *input,
     return output;
 }
 
+tzsp_view_t
+tzsp_utils_view(const uint8_t *input,
+                size_t         maxlen)
+{
+    tzsp_view_t view;
+
+    view.len = strnlen((const char*)input, maxlen);
+    view.ptr = (view.len ? input : NULL);
+    return view;
+}
+
 #endif
\ No newline at end of file
@@ -33,6 +33,13 @@
 #include <stdint.h>
 #include <stddef.h>
 
+typedef struct tzsp_view
+{
+    const uint8_t *ptr;
+    size_t len;
+} tzsp_view_t;
+
 char* tzsp_utils_string(const uint8_t*, size_t);
+tzsp_view_t tzsp_utils_view(const uint8_t*, size_t);
 
 #endif
\ No newline at end of file
@@ -23,8 +23,12 @@
 #include "conf.h"
 #include "misc.h"
 #include "tzsp-receiver.h"
+#include "ui-sources.h"
+
+static gboolean source_timeout_deferred = FALSE;
 
 static void ui_callback_network_real(network_t*);
+static void ui_callback_update(void);
 
 static gboolean ui_callback_timeout(gpointer);
 static gboolean ui_callback_heartbeat_timeout(gpointer);
@@ -49,6 +53,20 @@ ui_callback_verify(const mt_ssh_t *context,
 {
     gboolean verify;
 
+    if(ui_sources_contains(context))
+    {
+        verify = (ui_dialog_yesno(GTK_WINDOW(ui.window), data) == UI_DIALOG_YES);
+
+        if(!ui_sources_contains(context))
+            return;
+
+        if(verify)
+            mt_ssh_cmd((mt_ssh_t*)context, MT_SSH_CMD_AUTH, NULL);
+        else
+            mt_ssh_cancel((mt_ssh_t*)context);
+        return;
+    }
+
     if(ui.conn != context)
         return;
 
@@ -71,6 +89,12 @@ ui_callback_connected(const mt_ssh_t *context)
 {
     const gchar* name;
 
+    if(ui_sources_contains(context))
+    {
+        ui_sources_connected(context);
+        return;
+    }
+
     if(ui.conn != context)
         return;
 
@@ -97,6 +121,12 @@ ui_callback_disconnected(const mt_ssh_t *context,
 {
     ui_connection_mode_t mode;
 
+    if(ui_sources_contains(context))
+    {
+        ui_sources_disconnected(context, cancelled);
+        return;
+    }
+
     if(ui.conn != context)
         return;
 
@@ -122,6 +152,12 @@ void
 ui_callback_state(const mt_ssh_t *context,
                   gint            value)
 {
+    if(ui_sources_contains(context))
+    {
+        ui_sources_state(context, (gboolean)value);
+        return;
+    }
+
     if(ui.conn != context)
         return;
 
@@ -145,7 +181,8 @@ void
 ui_callback_failure(const mt_ssh_t *context,
                     const gchar    *error)
 {
-    if(context != ui.conn)
+    if(context != ui.conn &&
+       !ui_sources_contains(context))
         return;
 
     ui_dialog(GTK_WINDOW(ui.window),
@@ -159,7 +196,8 @@ void
 ui_callback_network(const mt_ssh_t *context,
                     network_t      *net)
 {
-    if(ui.conn != context)
+    if(ui.conn != context &&
+       !ui_sources_contains(context))
     {
         network_free(net);
         g_free(net);
@@ -190,10 +228,43 @@ ui_callback_network_real(network_t *net)
 
 void
 ui_callback_heartbeat(const mt_ssh_t *context)
+{
+    if(ui_sources_contains(context))
+    {
+        ui_callback_update();
+        ui_sources_heartbeat(context);
+
+        if(ui.activity == MTSCAN_MODE_NONE)
+            ui.activity = MTSCAN_MODE_SCANNER;
+    }
+    else if(ui.conn == context)
+    {
+        ui_callback_update();
+
+        if(ui.data_timeout)
+            g_source_remove(ui.data_timeout);
+        ui.data_timeout = g_timeout_add(ui.model->active_timeout * 1000, ui_callback_timeout, &ui);
+
+        ui.activity = ui.mode;
+    }
+    else
+        return;
+
+    ui.activity_ts = UNIX_TIMESTAMP();
+    gtk_widget_queue_draw(ui.activity_icon);
+
+    if(ui.activity_timeout)
+        g_source_remove(ui.activity_timeout);
+    ui.activity_timeout = g_timeout_add(500, ui_callback_heartbeat_timeout, &ui);
+}
+
+static void
+ui_callback_update(void)
 {
     gint ret;
 
-    if(ui.conn != context)
+    /* Results are kept in the buffer while logs are being loaded */
+    if(ui.loading)
         return;
 
     gtk_widget_freeze_child_notify(ui.treeview);
@@ -226,18 +297,6 @@ ui_callback_heartbeat(const mt_ssh_t *context)
     }
 
     gtk_widget_thaw_child_notify(ui.treeview);
-
-    ui.activity = ui.mode;
-    ui.activity_ts = UNIX_TIMESTAMP();
-    gtk_widget_queue_draw(ui.activity_icon);
-
-    if(ui.activity_timeout)
-        g_source_remove(ui.activity_timeout);
-    ui.activity_timeout = g_timeout_add(500, ui_callback_heartbeat_timeout, &ui);
-
-    if(ui.data_timeout)
-        g_source_remove(ui.data_timeout);
-    ui.data_timeout = g_timeout_add(ui.model->active_timeout * 1000, ui_callback_timeout, &ui);
 }
 
 static gboolean
@@ -245,12 +304,46 @@ ui_callback_timeout(gpointer user_data)
 {
     mtscan_gtk_t *ui = (mtscan_gtk_t*)user_data;
 
-    mtscan_model_clear_active(ui->model);
-    ui_status_update_networks();
     ui->data_timeout = 0;
+    ui_callback_source_timeout();
     return G_SOURCE_REMOVE;
 }
 
+void
+ui_callback_source_timeout(void)
+{
+    if(ui.loading)
+    {
+        source_timeout_deferred = TRUE;
+        return;
+    }
+
+    /* Some source is still alive, expire only the networks it does not see */
+    if(ui.data_timeout ||
+       ui_sources_alive())
+    {
+        ui_callback_update();
+        return;
+    }
+
+    mtscan_model_clear_active(ui.model);
+    ui_status_update_networks();
+}
+
+void
+ui_callback_resume(void)
+{
+    /* Apply everything that was held back during the log loading */
+    if(source_timeout_deferred)
+    {
+        source_timeout_deferred = FALSE;
+        ui_callback_source_timeout();
+        return;
+    }
+
+    ui_callback_update();
+}
+
 static gboolean
 ui_callback_heartbeat_timeout(gpointer user_data)
 {
@@ -301,9 +394,5 @@ ui_callback_geoloc(gint64 addr)
     if(addr >= 0)
         mtscan_model_geoloc(ui.model, addr);
     else
-    {
-        ui_view_lock(ui.treeview);
         mtscan_model_geoloc_all(ui.model);
-        ui_view_unlock(ui.treeview);
-    }
 }
@@ -25,6 +25,8 @@ void ui_callback_state(const mt_ssh_t*, gint);
 void ui_callback_failure(const mt_ssh_t*, const gchar*);
 void ui_callback_network(const mt_ssh_t*, network_t*);
 void ui_callback_heartbeat(const mt_ssh_t*);
+void ui_callback_source_timeout(void);
+void ui_callback_resume(void);
 void ui_callback_scanlist(const mt_ssh_t*, const gchar*);
 
 void ui_callback_tzsp(tzsp_receiver_t*);
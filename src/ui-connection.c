@@ -22,6 +22,7 @@
 #include "ui-callbacks.h"
 #include "callbacks.h"
 #include "conf.h"
+#include "mt-api.h"
 
 typedef struct ui_connection
 {
@@ -41,6 +42,9 @@ typedef struct ui_connection
     GtkWidget *e_host;
     GtkWidget *s_port;
 
+    GtkWidget *l_transport;
+    GtkWidget *c_transport;
+
     GtkWidget *l_login;
     GtkWidget *e_login;
 
@@ -84,6 +88,7 @@ static void ui_connection_destroy(GtkWidget*, gpointer);
 static void ui_connection_format_desc(GtkCellLayout*, GtkCellRenderer*, GtkTreeModel*, GtkTreeIter*, gpointer);
 static void ui_connection_profile_changed(GtkComboBox*, gpointer);
 static void ui_connection_profile_unset(GtkWidget*, gpointer);
+static void ui_connection_transport_changed(GtkComboBox*, gpointer);
 static void ui_connection_mode_toggled(GtkWidget*, gpointer);
 static void ui_connection_duration_toggled(GtkWidget*, gpointer);
 static void ui_connection_remote_toggled(GtkWidget*, gpointer);
@@ -148,7 +153,7 @@ ui_connection_new(gint                 profile,
 
     gtk_box_pack_start(GTK_BOX(c->content), gtk_hseparator_new(), FALSE, FALSE, 4);
 
-    c->table = gtk_table_new(8, 3, TRUE);
+    c->table = gtk_table_new(9, 3, TRUE);
     gtk_table_set_homogeneous(GTK_TABLE(c->table), FALSE);
     gtk_table_set_row_spacings(GTK_TABLE(c->table), 2);
     gtk_table_set_col_spacings(GTK_TABLE(c->table), 2);
@@ -164,6 +169,17 @@ ui_connection_new(gint                 profile,
     gtk_table_attach(GTK_TABLE(c->table), c->e_host, 1, 2, row, row+1, GTK_EXPAND|GTK_FILL, 0, 0, 0);
     gtk_table_attach(GTK_TABLE(c->table), c->s_port, 2, 3, row, row+1, GTK_EXPAND|GTK_FILL, 0, 0, 0);
 
+    row++;
+    c->l_transport = gtk_label_new("Transport:");
+    gtk_misc_set_alignment(GTK_MISC(c->l_transport), 0.0, 0.5);
+    c->c_transport = gtk_combo_box_text_new();
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(c->c_transport), "SSH");
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(c->c_transport), "API");
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(c->c_transport), "API-SSL");
+    gtk_combo_box_set_active(GTK_COMBO_BOX(c->c_transport), MTSCAN_CONF_PROFILE_TRANSPORT_PTY);
+    gtk_table_attach(GTK_TABLE(c->table), c->l_transport, 0, 1, row, row+1, GTK_EXPAND|GTK_FILL, 0, 0, 0);
+    gtk_table_attach(GTK_TABLE(c->table), c->c_transport, 1, 2, row, row+1, GTK_EXPAND|GTK_FILL, 0, 0, 0);
+
     row++;
     c->l_login = gtk_label_new("Login:");
     gtk_misc_set_alignment(GTK_MISC(c->l_login), 0.0, 0.5);
@@ -246,6 +262,7 @@ ui_connection_new(gint                 profile,
 
     g_signal_connect(c->e_host, "changed", G_CALLBACK(ui_connection_profile_unset), c);
     g_signal_connect(c->s_port, "changed", G_CALLBACK(ui_connection_profile_unset), c);
+    g_signal_connect(c->c_transport, "changed", G_CALLBACK(ui_connection_profile_unset), c);
     g_signal_connect(c->e_login, "changed", G_CALLBACK(ui_connection_profile_unset), c);
     g_signal_connect(c->e_password, "changed", G_CALLBACK(ui_connection_profile_unset), c);
     g_signal_connect(c->e_interface, "changed", G_CALLBACK(ui_connection_profile_unset), c);
@@ -256,6 +273,7 @@ ui_connection_new(gint                 profile,
     g_signal_connect(c->c_remote, "toggled", G_CALLBACK(ui_connection_profile_unset), c);
     g_signal_connect(c->c_background, "toggled", G_CALLBACK(ui_connection_profile_unset), c);
 
+    g_signal_connect(c->c_transport, "changed", G_CALLBACK(ui_connection_transport_changed), c);
     g_signal_connect(c->r_scanner, "toggled", G_CALLBACK(ui_connection_mode_toggled), c);
     g_signal_connect(c->r_sniffer, "toggled", G_CALLBACK(ui_connection_mode_toggled), c);
     g_signal_connect(c->c_duration, "toggled", G_CALLBACK(ui_connection_duration_toggled), c);
@@ -379,6 +397,30 @@ ui_connection_profile_unset(GtkWidget *widget,
         gtk_combo_box_set_active(GTK_COMBO_BOX(c->c_profile), -1);
 }
 
+static void
+ui_connection_transport_changed(GtkComboBox *combo,
+                                gpointer     user_data)
+{
+    ui_connection_t *c = (ui_connection_t*)user_data;
+    static const gint ports[] = { 22, MT_API_PORT, MT_API_SSL_PORT };
+    gint transport = gtk_combo_box_get_active(combo);
+    gint port = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(c->s_port));
+    guint i;
+
+    if(transport < 0 || transport >= (gint)G_N_ELEMENTS(ports))
+        return;
+
+    /* Follow the transport, unless a custom port is set */
+    for(i=0; i<G_N_ELEMENTS(ports); i++)
+    {
+        if(port == ports[i])
+        {
+            gtk_spin_button_set_value(GTK_SPIN_BUTTON(c->s_port), (gdouble)ports[transport]);
+            break;
+        }
+    }
+}
+
 static void
 ui_connection_mode_toggled(GtkWidget *widget,
                            gpointer   user_data)
@@ -459,6 +501,7 @@ ui_connection_unlock(ui_connection_t *c,
     gtk_widget_set_sensitive(c->b_profile_clear, value);
     gtk_widget_set_sensitive(c->e_host, value);
     gtk_widget_set_sensitive(c->s_port, value);
+    gtk_widget_set_sensitive(c->c_transport, value);
     gtk_widget_set_sensitive(c->e_login, value);
     gtk_widget_set_sensitive(c->e_password, value);
     gtk_widget_set_sensitive(c->c_password, value);
@@ -583,6 +626,7 @@ ui_connection_connect(GtkWidget *widget,
     gchar *name = NULL;
     const gchar *hostname = gtk_entry_get_text(GTK_ENTRY(c->e_host));
     gint port = gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(c->s_port));
+    mt_ssh_transport_t transport = (mt_ssh_transport_t)gtk_combo_box_get_active(GTK_COMBO_BOX(c->c_transport));
     const gchar *login = gtk_entry_get_text(GTK_ENTRY(c->e_login));
     const gchar *password = gtk_entry_get_text(GTK_ENTRY(c->e_password));
     const gchar *iface = gtk_entry_get_text(GTK_ENTRY(c->e_interface));
@@ -648,6 +692,7 @@ ui_connection_connect(GtkWidget *widget,
                          name,
                          hostname,
                          port,
+                         transport,
                          login,
                          password,
                          iface,
@@ -688,6 +733,7 @@ ui_connection_from_profile(ui_connection_t      *c,
     c->profile_reset_flag = FALSE;
 
     gtk_entry_set_text(GTK_ENTRY(c->e_host), conf_profile_get_host(p));
+    gtk_combo_box_set_active(GTK_COMBO_BOX(c->c_transport), conf_profile_get_transport(p));
     gtk_spin_button_set_value(GTK_SPIN_BUTTON(c->s_port), (gdouble)conf_profile_get_port(p));
     gtk_entry_set_text(GTK_ENTRY(c->e_login), conf_profile_get_login(p));
     gtk_entry_set_text(GTK_ENTRY(c->e_password), conf_profile_get_password(p));
@@ -714,6 +760,7 @@ ui_connection_to_profile(ui_connection_t *c,
     p = conf_profile_new(g_strdup(name),
                          g_strdup(gtk_entry_get_text(GTK_ENTRY(c->e_host))),
                          gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(c->s_port)),
+                         (mtscan_conf_profile_transport_t)gtk_combo_box_get_active(GTK_COMBO_BOX(c->c_transport)),
                          g_strdup(gtk_entry_get_text(GTK_ENTRY(c->e_login))),
                          g_strdup(keep_pass ? gtk_entry_get_text(GTK_ENTRY(c->e_password)) : ""),
                          g_strdup(gtk_entry_get_text(GTK_ENTRY(c->e_interface))),
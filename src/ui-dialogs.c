@@ -66,6 +66,7 @@ ui_dialog_open(GtkWindow *window,
     GtkWidget *box;
     GtkWidget *strip_signals;
     GtkFileFilter *filter;
+    GtkFileFilter *filter_capture;
     GtkFileFilter *filter_all;
     GSList *filenames = NULL;
     const gchar *dir;
@@ -96,8 +97,16 @@ ui_dialog_open(GtkWindow *window,
     gtk_file_filter_set_name(filter, filetype_default);
     gtk_file_filter_add_pattern(filter, "*" APP_FILE_EXT);
     gtk_file_filter_add_pattern(filter, "*" APP_FILE_EXT APP_FILE_COMPRESS);
+    gtk_file_filter_add_pattern(filter, "*" APP_FILE_BINARY);
     gtk_file_chooser_add_filter(GTK_FILE_CHOOSER(dialog), filter);
 
+    filter_capture = gtk_file_filter_new();
+    gtk_file_filter_set_name(filter_capture, "Packet capture (TZSP, IEEE 802.11)");
+    gtk_file_filter_add_pattern(filter_capture, "*.pcap");
+    gtk_file_filter_add_pattern(filter_capture, "*.pcapng");
+    gtk_file_filter_add_pattern(filter_capture, "*.cap");
+    gtk_file_chooser_add_filter(GTK_FILE_CHOOSER(dialog), filter_capture);
+
     filter_all = gtk_file_filter_new();
     gtk_file_filter_set_name(filter_all, "All files");
     gtk_file_filter_add_pattern(filter_all, "*");
@@ -175,6 +184,7 @@ ui_dialog_save(GtkWindow *window)
     gtk_file_filter_set_name(filter, filetype_default);
     gtk_file_filter_add_pattern(filter, "*" APP_FILE_EXT);
     gtk_file_filter_add_pattern(filter, "*" APP_FILE_EXT APP_FILE_COMPRESS);
+    gtk_file_filter_add_pattern(filter, "*" APP_FILE_BINARY);
     gtk_file_chooser_add_filter(GTK_FILE_CHOOSER(dialog), filter);
 
     g_signal_connect(dialog, "response", G_CALLBACK(ui_dialog_save_response), &ret);
@@ -223,7 +233,9 @@ ui_dialog_save_response(GtkWidget *dialog,
     strip_gps = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(g_object_get_data(G_OBJECT(dialog), "mtscan-strip-gps")));
     strip_azi = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(g_object_get_data(G_OBJECT(dialog), "mtscan-strip-azi")));
 
-    if(compress)
+    if(str_has_suffix(filename, APP_FILE_BINARY))
+        add_suffix = FALSE;
+    else if(compress)
         add_suffix = !str_has_suffix(filename, APP_FILE_EXT APP_FILE_COMPRESS);
     else
         add_suffix = !str_has_suffix(filename, APP_FILE_EXT);
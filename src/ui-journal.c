@@ -0,0 +1,243 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include <glib/gstdio.h>
+#include "ui.h"
+#include "ui-journal.h"
+#include "ui-log.h"
+#include "ui-view.h"
+#include "ui-dialogs.h"
+#include "journal.h"
+#include "log.h"
+#include "conf.h"
+
+/* In the journal mode, the autosave writes the full log only when
+   the model was changed by something other than the scanning.
+   Otherwise, each scan result is appended to the journal on the
+   heartbeat and the autosave only syncs it to the disk.
+   The journal is rotated only after the full log was written,
+   keeping the records added while the log was being saved. */
+
+static journal_t *journal = NULL;
+static gchar *journal_path = NULL;
+static gboolean journal_compact = FALSE;
+
+static journal_t *pending_journal = NULL;
+static glong pending_offset = -1;
+static void (*pending_cb)(const gchar*, gboolean) = NULL;
+
+static void ui_journal_start(const gchar*);
+static void ui_journal_autosave_cb(const gchar*, gboolean);
+static void ui_journal_net_cb(network_t*, gpointer);
+
+
+void
+ui_journal_recover(void)
+{
+    gchar *filename;
+    gchar *target;
+    gint count;
+
+    filename = g_build_filename(conf_get_path_autosave(), APP_FILE_JOURNAL, NULL);
+    if(!g_file_test(filename, G_FILE_TEST_EXISTS) ||
+       !(target = journal_read_target(filename)))
+    {
+        g_free(filename);
+        return;
+    }
+
+    ui_view_lock(ui.treeview);
+    mtscan_model_merge_begin(ui.model);
+
+    /* The journal contains only changes since the last full save */
+    if(g_file_test(target, G_FILE_TEST_EXISTS))
+        log_read(target, ui_journal_net_cb, NULL, FALSE);
+
+    count = journal_replay(filename, ui_journal_net_cb, NULL);
+
+    mtscan_model_merge_end(ui.model);
+    ui_view_unlock(ui.treeview);
+    ui_status_update_networks();
+
+    if(count > 0)
+    {
+        ui_changed();
+        if(!ui_log_save_full(target, FALSE, FALSE, FALSE, NULL, TRUE))
+        {
+            /* Keep the journal for another attempt */
+            g_free(target);
+            g_free(filename);
+            return;
+        }
+    }
+    else
+    {
+        ui_set_title(target);
+    }
+
+    g_remove(filename);
+    g_free(target);
+    g_free(filename);
+}
+
+void
+ui_journal_autosave(const gchar  *filename,
+                    void        (*cb)(const gchar*, gboolean))
+{
+    if(journal && !journal_compact)
+    {
+        if(!journal_checkpoint(journal))
+        {
+            cb(journal_path, FALSE);
+            ui_journal_stop();
+            return;
+        }
+
+        ui.log_ts = UNIX_TIMESTAMP();
+        return;
+    }
+
+    /* The snapshot is taken right away, records appended after
+       this point are carried over to the rotated journal */
+    if(!ui_log_save_async(filename, FALSE, FALSE, FALSE, ui_journal_autosave_cb))
+        return;
+
+    pending_cb = cb;
+    if(journal)
+    {
+        pending_journal = journal;
+        pending_offset = journal_tell(journal);
+    }
+    else
+    {
+        /* Nothing to carry over, record changes from now on */
+        ui_journal_start(filename);
+        pending_journal = journal;
+        pending_offset = -1;
+    }
+    journal_compact = FALSE;
+}
+
+void
+ui_journal_invalidate(void)
+{
+    journal_compact = TRUE;
+}
+
+void
+ui_journal_saved(const gchar *filename,
+                 gboolean     stripped)
+{
+    if(!journal)
+        return;
+
+    if(stripped)
+        ui_journal_invalidate();
+    else
+        ui_journal_start(filename);
+}
+
+gboolean
+ui_journal_flush(void)
+{
+    gchar *target;
+    gboolean ret;
+
+    if(!journal ||
+       !ui.changed ||
+       !conf_get_interface_autosave())
+        return TRUE;
+
+    /* The journal is kept, it is removed with ui_journal_stop() */
+    target = g_strdup(journal_get_target(journal));
+    ret = ui_log_save_full(target, FALSE, FALSE, FALSE, NULL, TRUE);
+    g_free(target);
+    return ret;
+}
+
+void
+ui_journal_stop(void)
+{
+    if(!journal)
+        return;
+
+    ui.model->journal = NULL;
+    journal_close(journal);
+    journal = NULL;
+
+    g_remove(journal_path);
+    g_free(journal_path);
+    journal_path = NULL;
+}
+
+static void
+ui_journal_start(const gchar *filename)
+{
+    ui_journal_stop();
+
+    journal_path = g_build_filename(conf_get_path_autosave(), APP_FILE_JOURNAL, NULL);
+    journal = journal_open(journal_path, filename);
+    if(!journal)
+    {
+        g_free(journal_path);
+        journal_path = NULL;
+    }
+
+    ui.model->journal = journal;
+    journal_compact = FALSE;
+}
+
+static void
+ui_journal_autosave_cb(const gchar *filename,
+                       gboolean     success)
+{
+    journal_t *next;
+
+    /* Skip the rotation if the journal was stopped or replaced meanwhile */
+    if(journal && journal == pending_journal)
+    {
+        if(!success)
+        {
+            /* Write the full log again on the next autosave */
+            journal_compact = TRUE;
+        }
+        else if(pending_offset >= 0)
+        {
+            if((next = journal_rotate(journal, journal_path, filename, pending_offset)))
+            {
+                journal = next;
+                ui.model->journal = journal;
+            }
+            else
+            {
+                journal_compact = TRUE;
+            }
+        }
+    }
+
+    pending_journal = NULL;
+    pending_offset = -1;
+
+    if(pending_cb)
+        pending_cb(filename, success);
+    pending_cb = NULL;
+}
+
+static void
+ui_journal_net_cb(network_t *network,
+                  gpointer   user_data)
+{
+    mtscan_model_add(ui.model, network, TRUE);
+}
@@ -0,0 +1,27 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef MTSCAN_UI_JOURNAL_H_
+#define MTSCAN_UI_JOURNAL_H_
+#include <gtk/gtk.h>
+
+void ui_journal_recover(void);
+void ui_journal_autosave(const gchar*, void (*)(const gchar*, gboolean));
+void ui_journal_invalidate(void);
+void ui_journal_saved(const gchar*, gboolean);
+gboolean ui_journal_flush(void);
+void ui_journal_stop(void);
+
+#endif
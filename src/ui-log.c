@@ -17,16 +17,42 @@
 #include "ui.h"
 #include "ui-view.h"
 #include "ui-dialogs.h"
+#include "ui-journal.h"
+#include "ui-callbacks.h"
 #include "log.h"
+#include "log-load.h"
 #include "conf.h"
 
 typedef struct ui_log_open_context
 {
     gboolean merge;
     gboolean changed;
+    guint loaded;
+    guint length;
+    GMainLoop *loop;
+    GtkWidget *progress;
 } ui_log_open_context_t;
 
+typedef struct ui_log_save_context
+{
+    gchar *filename;
+    log_snapshot_t *snapshot;
+    gboolean strip_signals;
+    gboolean strip_gps;
+    gboolean strip_azi;
+    guint revision;
+    log_save_error_t *error;
+    void (*cb)(const gchar*, gboolean);
+    guint source;
+} ui_log_save_context_t;
+
+static GThread *save_thread = NULL;
+static ui_log_save_context_t *save_context = NULL;
+
+static gboolean ui_log_open_progress(gpointer);
 static void ui_log_open_net_cb(network_t*, gpointer);
+static gpointer ui_log_save_thread(gpointer);
+static gboolean ui_log_save_thread_callback(gpointer);
 
 
 void
@@ -37,10 +63,13 @@ ui_log_open(GSList   *list,
     ui_log_open_context_t context;
     GSList *errors = NULL;
     const gchar *filename;
+    log_load_t *load;
+    GtkWidget *window;
     gint count;
     GString *text;
     GSList *it;
     gchar *str;
+    guint i;
 
     if(!list)
         return;
@@ -50,6 +79,33 @@ ui_log_open(GSList   *list,
 
     context.merge = merge;
     context.changed = FALSE;
+    context.loaded = 0;
+    context.length = g_slist_length(list);
+    context.loop = g_main_loop_new(NULL, FALSE);
+
+    /* All files are parsed in the background first, the model
+       is updated afterwards in the original order of the list */
+    load = log_load_new(list, strip_samples, ui_log_open_progress, &context);
+
+    window = gtk_window_new(GTK_WINDOW_TOPLEVEL);
+    gtk_window_set_title(GTK_WINDOW(window), APP_NAME);
+    gtk_window_set_transient_for(GTK_WINDOW(window), GTK_WINDOW(ui.window));
+    gtk_window_set_modal(GTK_WINDOW(window), TRUE);
+    gtk_window_set_position(GTK_WINDOW(window), GTK_WIN_POS_CENTER_ON_PARENT);
+    gtk_window_set_deletable(GTK_WINDOW(window), FALSE);
+    gtk_window_set_resizable(GTK_WINDOW(window), FALSE);
+    gtk_container_set_border_width(GTK_CONTAINER(window), 10);
+    context.progress = gtk_progress_bar_new();
+    gtk_widget_set_size_request(context.progress, 300, -1);
+    gtk_progress_bar_set_text(GTK_PROGRESS_BAR(context.progress), "Loading logs...");
+    gtk_container_add(GTK_CONTAINER(window), context.progress);
+    gtk_widget_show_all(window);
+
+    /* Scan results and autosave are held back until the model is updated */
+    ui.loading = TRUE;
+    g_main_loop_run(context.loop);
+    g_main_loop_unref(context.loop);
+    gtk_widget_destroy(window);
 
     if(!context.merge)
         ui_clear();
@@ -57,14 +113,17 @@ ui_log_open(GSList   *list,
     ui_set_title(NULL);
     ui_view_lock(ui.treeview);
 
-    while(list != NULL)
+    if(context.merge)
+        mtscan_model_merge_begin(ui.model);
+
+    for(i=0; i<log_load_length(load); i++)
     {
-        filename = (gchar*)list->data;
+        filename = log_load_filename(load, i);
 
-        count = log_read(filename,
-                         ui_log_open_net_cb,
-                         &context,
-                         strip_samples);
+        count = log_load_read(load,
+                              i,
+                              ui_log_open_net_cb,
+                              &context);
 
         if(count <= 0)
         {
@@ -90,12 +149,16 @@ ui_log_open(GSList   *list,
         }
         else if(!context.merge)
             ui_set_title(filename);
-
-        list = list->next;
     }
 
+    log_load_free(load);
+
+    if(context.merge)
+        mtscan_model_merge_end(ui.model);
+
     if(context.changed)
     {
+        ui_journal_invalidate();
         if(conf_get_interface_geoloc())
             mtscan_model_geoloc_all(ui.model);
         ui_status_update_networks();
@@ -105,6 +168,9 @@ ui_log_open(GSList   *list,
 
     ui_view_unlock(ui.treeview);
 
+    ui.loading = FALSE;
+    ui_callback_resume();
+
     if(errors)
     {
         text = g_string_new("<big><b>Some errors occurred:</b></big>");
@@ -122,6 +188,25 @@ ui_log_open(GSList   *list,
     }
 }
 
+static gboolean
+ui_log_open_progress(gpointer user_data)
+{
+    ui_log_open_context_t *context = (ui_log_open_context_t*)user_data;
+    gchar *text;
+
+    context->loaded++;
+
+    text = g_strdup_printf("Loading logs (%u/%u)", context->loaded, context->length);
+    gtk_progress_bar_set_text(GTK_PROGRESS_BAR(context->progress), text);
+    gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(context->progress), (gdouble)context->loaded / context->length);
+    g_free(text);
+
+    if(context->loaded == context->length)
+        g_main_loop_quit(context->loop);
+
+    return G_SOURCE_REMOVE;
+}
+
 static void
 ui_log_open_net_cb(network_t *network,
                    gpointer   user_data)
@@ -143,8 +228,13 @@ ui_log_save(const gchar *filename,
             GList       *iterlist,
             gboolean     show_message)
 {
+    log_snapshot_t *snapshot;
     log_save_error_t *error;
-    error = log_save(filename, strip_signals, strip_gps, strip_azi, iterlist);
+
+    ui_log_save_wait();
+    snapshot = mtscan_model_snapshot(ui.model, iterlist, strip_signals);
+    error = log_save_snapshot(filename, snapshot, strip_signals, strip_gps, strip_azi);
+    mtscan_model_snapshot_free(ui.model, snapshot);
 
     if(error)
     {
@@ -185,6 +275,8 @@ ui_log_save_full(const gchar *filename,
 {
     if(ui_log_save(filename, strip_signals, strip_gps, strip_azi, iterlist, show_message))
     {
+        ui_journal_saved(filename, (strip_signals || strip_gps || strip_azi));
+
         /* update the window title */
         ui.changed = FALSE;
         ui.log_ts = UNIX_TIMESTAMP();
@@ -193,3 +285,90 @@ ui_log_save_full(const gchar *filename,
     }
     return FALSE;
 }
+
+gboolean
+ui_log_save_async(const gchar *filename,
+                  gboolean     strip_signals,
+                  gboolean     strip_gps,
+                  gboolean     strip_azi,
+                  void       (*cb)(const gchar*, gboolean))
+{
+    ui_log_save_context_t *context;
+
+    if(save_thread)
+        return FALSE;
+
+    context = g_malloc0(sizeof(ui_log_save_context_t));
+    context->filename = g_strdup(filename);
+    context->snapshot = mtscan_model_snapshot(ui.model, NULL, strip_signals);
+    context->strip_signals = strip_signals;
+    context->strip_gps = strip_gps;
+    context->strip_azi = strip_azi;
+    context->revision = ui.revision;
+    context->cb = cb;
+
+    save_context = context;
+    save_thread = g_thread_new("ui_log_save_thread", ui_log_save_thread, context);
+    return TRUE;
+}
+
+void
+ui_log_save_wait(void)
+{
+    ui_log_save_context_t *context = save_context;
+
+    if(!save_thread)
+        return;
+
+    /* Finish the pending save right away, instead of waiting for the idle callback */
+    g_thread_join(save_thread);
+    save_thread = NULL;
+    g_source_remove(context->source);
+    ui_log_save_thread_callback(context);
+}
+
+static gpointer
+ui_log_save_thread(gpointer user_data)
+{
+    ui_log_save_context_t *context = (ui_log_save_context_t*)user_data;
+
+    context->error = log_save_snapshot(context->filename,
+                                       context->snapshot,
+                                       context->strip_signals,
+                                       context->strip_gps,
+                                       context->strip_azi);
+
+    context->source = g_idle_add(ui_log_save_thread_callback, context);
+    return NULL;
+}
+
+static gboolean
+ui_log_save_thread_callback(gpointer user_data)
+{
+    ui_log_save_context_t *context = (ui_log_save_context_t*)user_data;
+
+    if(save_thread)
+    {
+        g_thread_join(save_thread);
+        save_thread = NULL;
+    }
+    save_context = NULL;
+
+    if(!context->error)
+    {
+        /* Keep the unsaved state if anything was changed in the meantime */
+        if(ui.revision == context->revision)
+            ui.changed = FALSE;
+        ui.log_ts = UNIX_TIMESTAMP();
+        ui_set_title(context->filename);
+    }
+
+    if(context->cb)
+        context->cb(context->filename, (context->error == NULL));
+
+    mtscan_model_snapshot_free(ui.model, context->snapshot);
+    g_free(context->error);
+    g_free(context->filename);
+    g_free(context);
+    return G_SOURCE_REMOVE;
+}
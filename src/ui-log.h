@@ -21,5 +21,7 @@ void ui_log_open(GSList*, gboolean, gboolean);
 
 gboolean ui_log_save(const gchar*, gboolean, gboolean, gboolean, GList*, gboolean);
 gboolean ui_log_save_full(const gchar*, gboolean, gboolean, gboolean, GList*, gboolean);
+gboolean ui_log_save_async(const gchar*, gboolean, gboolean, gboolean, void (*)(const gchar*, gboolean));
+void ui_log_save_wait(void);
 
 #endif
@@ -71,6 +71,7 @@ typedef struct ui_preferences
     GtkWidget *e_general_fallback_encoding;
     GtkWidget *x_general_no_style_override;
     GtkWidget *x_general_signals;
+    GtkWidget *x_general_autosave_journal;
     GtkWidget *x_general_display_time_only;
     GtkWidget *x_general_compact_status;
     GtkWidget *x_general_reconnect;
@@ -100,6 +101,9 @@ typedef struct ui_preferences
     GtkWidget *table_tzsp;
     GtkWidget *l_tzsp_udp_port;
     GtkWidget *s_tzsp_udp_port;
+    GtkWidget *l_tzsp_buffer;
+    GtkWidget *s_tzsp_buffer;
+    GtkWidget *x_tzsp_filter;
     GtkWidget *box_tzsp_info;
     GtkWidget *i_tzsp_info;
     GtkWidget *l_tzsp_info;
@@ -143,6 +147,10 @@ typedef struct ui_preferences
     GtkWidget *e_location_wigle_api_url;
     GtkWidget *l_location_wigle_api_key;
     GtkWidget *e_location_wigle_api_key;
+    GtkWidget *l_location_wigle_ttl;
+    GtkWidget *s_location_wigle_ttl;
+    GtkWidget *l_location_wigle_neg_ttl;
+    GtkWidget *s_location_wigle_neg_ttl;
     GtkWidget *l_location_azimuth_error;
     GtkWidget *s_location_azimuth_error;
     GtkWidget *l_location_min_distance;
@@ -205,7 +213,7 @@ ui_preferences_dialog(void)
     gtk_notebook_append_page(GTK_NOTEBOOK(p.notebook), p.page_general, gtk_label_new("General"));
     gtk_container_child_set(GTK_CONTAINER(p.notebook), p.page_general, "tab-expand", FALSE, "tab-fill", FALSE, NULL);
 
-    p.table_general = gtk_table_new(13, 3, TRUE);
+    p.table_general = gtk_table_new(14, 3, TRUE);
     gtk_table_set_homogeneous(GTK_TABLE(p.table_general), FALSE);
     gtk_table_set_row_spacings(GTK_TABLE(p.table_general), 4);
     gtk_table_set_col_spacings(GTK_TABLE(p.table_general), 4);
@@ -268,6 +276,10 @@ ui_preferences_dialog(void)
     p.x_general_signals = gtk_check_button_new_with_label("Record all signal samples");
     gtk_table_attach(GTK_TABLE(p.table_general), p.x_general_signals, 0, 3, row, row+1, GTK_EXPAND|GTK_FILL, 0, 0, 0);
 
+    row++;
+    p.x_general_autosave_journal = gtk_check_button_new_with_label("Incremental autosave (journal)");
+    gtk_table_attach(GTK_TABLE(p.table_general), p.x_general_autosave_journal, 0, 3, row, row+1, GTK_EXPAND|GTK_FILL, 0, 0, 0);
+
     row++;
     p.x_general_display_time_only = gtk_check_button_new_with_label("Display time only");
     gtk_table_attach(GTK_TABLE(p.table_general), p.x_general_display_time_only, 0, 3, row, row+1, GTK_EXPAND|GTK_FILL, 0, 0, 0);
@@ -399,6 +411,17 @@ ui_preferences_dialog(void)
     p.s_tzsp_udp_port = gtk_spin_button_new(GTK_ADJUSTMENT(gtk_adjustment_new(0.0, 1024.0, 65535.0, 1.0, 10.0, 0.0)), 0, 0);
     gtk_table_attach(GTK_TABLE(p.table_tzsp), p.s_tzsp_udp_port, 1, 3, row, row+1, GTK_EXPAND|GTK_FILL, 0, 0, 0);
 
+    row++;
+    p.l_tzsp_buffer = gtk_label_new("Receive buffer (KiB, 0 = system):");
+    gtk_misc_set_alignment(GTK_MISC(p.l_tzsp_buffer), 0.0, 0.5);
+    gtk_table_attach(GTK_TABLE(p.table_tzsp), p.l_tzsp_buffer, 0, 1, row, row+1, GTK_EXPAND|GTK_FILL, 0, 0, 0);
+    p.s_tzsp_buffer = gtk_spin_button_new(GTK_ADJUSTMENT(gtk_adjustment_new(0.0, 0.0, 262144.0, 64.0, 1024.0, 0.0)), 0, 0);
+    gtk_table_attach(GTK_TABLE(p.table_tzsp), p.s_tzsp_buffer, 1, 3, row, row+1, GTK_EXPAND|GTK_FILL, 0, 0, 0);
+
+    row++;
+    p.x_tzsp_filter = gtk_check_button_new_with_label("Drop non-beacon frames in kernel");
+    gtk_table_attach(GTK_TABLE(p.table_tzsp), p.x_tzsp_filter, 0, 3, row, row+1, GTK_EXPAND|GTK_FILL, 0, 0, 0);
+
     p.box_tzsp_info = gtk_hbox_new(FALSE, 5);
     p.i_tzsp_info = gtk_image_new_from_icon_name("dialog-warning", GTK_ICON_SIZE_MENU);
     gtk_box_pack_start(GTK_BOX(p.box_tzsp_info), p.i_tzsp_info, FALSE, FALSE, 1);
@@ -479,7 +502,7 @@ ui_preferences_dialog(void)
     gtk_notebook_append_page(GTK_NOTEBOOK(p.notebook), p.page_location, gtk_label_new("Location"));
     gtk_container_child_set(GTK_CONTAINER(p.notebook), p.page_location, "tab-expand", FALSE, "tab-fill", FALSE, NULL);
 
-    p.table_location = gtk_table_new(12, 3, TRUE);
+    p.table_location = gtk_table_new(14, 3, TRUE);
     gtk_table_set_homogeneous(GTK_TABLE(p.table_location), FALSE);
     gtk_table_set_row_spacings(GTK_TABLE(p.table_location), 4);
     gtk_table_set_col_spacings(GTK_TABLE(p.table_location), 4);
@@ -555,6 +578,20 @@ ui_preferences_dialog(void)
     p.e_location_wigle_api_key = gtk_entry_new();
     gtk_table_attach(GTK_TABLE(p.table_location), p.e_location_wigle_api_key, 1, 3, row, row+1, GTK_EXPAND|GTK_FILL, 0, 0, 0);
 
+    row++;
+    p.l_location_wigle_ttl = gtk_label_new("WiGLE cache TTL [days]:");
+    gtk_misc_set_alignment(GTK_MISC(p.l_location_wigle_ttl), 0.0, 0.5);
+    gtk_table_attach(GTK_TABLE(p.table_location), p.l_location_wigle_ttl, 0, 1, row, row+1, GTK_EXPAND|GTK_FILL, 0, 0, 0);
+    p.s_location_wigle_ttl = gtk_spin_button_new(GTK_ADJUSTMENT(gtk_adjustment_new(0.0, 0, 9999.0, 1.0, 1.0, 0.0)), 0, 0);
+    gtk_table_attach(GTK_TABLE(p.table_location), p.s_location_wigle_ttl, 1, 3, row, row+1, GTK_EXPAND|GTK_FILL, 0, 0, 0);
+
+    row++;
+    p.l_location_wigle_neg_ttl = gtk_label_new("WiGLE no match TTL [days]:");
+    gtk_misc_set_alignment(GTK_MISC(p.l_location_wigle_neg_ttl), 0.0, 0.5);
+    gtk_table_attach(GTK_TABLE(p.table_location), p.l_location_wigle_neg_ttl, 0, 1, row, row+1, GTK_EXPAND|GTK_FILL, 0, 0, 0);
+    p.s_location_wigle_neg_ttl = gtk_spin_button_new(GTK_ADJUSTMENT(gtk_adjustment_new(0.0, 0, 9999.0, 1.0, 1.0, 0.0)), 0, 0);
+    gtk_table_attach(GTK_TABLE(p.table_location), p.s_location_wigle_neg_ttl, 1, 3, row, row+1, GTK_EXPAND|GTK_FILL, 0, 0, 0);
+
     row++;
     p.l_location_azimuth_error = gtk_label_new("Azimuth error ± [°]:");
     gtk_misc_set_alignment(GTK_MISC(p.l_location_azimuth_error), 0.0, 0.5);
@@ -927,6 +964,7 @@ ui_preferences_load(ui_preferences_t *p)
     gtk_entry_set_text(GTK_ENTRY(p->e_general_fallback_encoding), conf_get_preferences_fallback_encoding());
     gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(p->x_general_no_style_override), conf_get_preferences_no_style_override());
     gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(p->x_general_signals), conf_get_preferences_signals());
+    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(p->x_general_autosave_journal), conf_get_preferences_autosave_journal());
     gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(p->x_general_display_time_only), conf_get_preferences_display_time_only());
     gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(p->x_general_compact_status), conf_get_preferences_compact_status());
     gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(p->x_general_reconnect), conf_get_preferences_reconnect());
@@ -951,6 +989,8 @@ ui_preferences_load(ui_preferences_t *p)
 
     /* TZSP */
     gtk_spin_button_set_value(GTK_SPIN_BUTTON(p->s_tzsp_udp_port), conf_get_preferences_tzsp_udp_port());
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(p->s_tzsp_buffer), conf_get_preferences_tzsp_buffer());
+    gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(p->x_tzsp_filter), conf_get_preferences_tzsp_filter());
 
     /* GNSS */
     gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(p->r_gnss_wsa), conf_get_preferences_gnss_source());
@@ -1008,6 +1048,8 @@ ui_preferences_load(ui_preferences_t *p)
     gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(p->x_location_wigle), conf_get_preferences_location_wigle());
     gtk_entry_set_text(GTK_ENTRY(p->e_location_wigle_api_url), conf_get_preferences_location_wigle_api_url());
     gtk_entry_set_text(GTK_ENTRY(p->e_location_wigle_api_key), conf_get_preferences_location_wigle_api_key());
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(p->s_location_wigle_ttl), conf_get_preferences_location_wigle_ttl());
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(p->s_location_wigle_neg_ttl), conf_get_preferences_location_wigle_neg_ttl());
     gtk_spin_button_set_value(GTK_SPIN_BUTTON(p->s_location_azimuth_error), conf_get_preferences_location_azimuth_error());
     gtk_spin_button_set_value(GTK_SPIN_BUTTON(p->s_location_min_distance), conf_get_preferences_location_min_distance());
     gtk_spin_button_set_value(GTK_SPIN_BUTTON(p->s_location_max_distance), conf_get_preferences_location_max_distance());
@@ -1105,6 +1147,7 @@ ui_preferences_apply(GtkWidget *widget,
     }
 
     conf_set_preferences_signals(gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(p->x_general_signals)));
+    conf_set_preferences_autosave_journal(gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(p->x_general_autosave_journal)));
     conf_set_preferences_display_time_only(gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(p->x_general_display_time_only)));
     conf_set_preferences_compact_status(gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(p->x_general_compact_status)));
     conf_set_preferences_reconnect(gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(p->x_general_reconnect)));
@@ -1138,6 +1181,8 @@ ui_preferences_apply(GtkWidget *widget,
     }
 
     conf_set_preferences_tzsp_udp_port(new_tzsp_udp_port);
+    conf_set_preferences_tzsp_buffer(gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(p->s_tzsp_buffer)));
+    conf_set_preferences_tzsp_filter(gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(p->x_tzsp_filter)));
 
     /* GNSS */
     new_gnss_source = (gint)gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(p->r_gnss_wsa));
@@ -1252,6 +1297,10 @@ ui_preferences_apply(GtkWidget *widget,
             geoloc_wigle(new_location_wigle_api_url, new_location_wigle_api_key);
     }
 
+    /* Expiry is checked on each lookup in the WiGLE cache */
+    conf_set_preferences_location_wigle_ttl(gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(p->s_location_wigle_ttl)));
+    conf_set_preferences_location_wigle_neg_ttl(gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(p->s_location_wigle_neg_ttl)));
+
     /* --- */
     gtk_widget_destroy(p->window);
 }
@@ -0,0 +1,301 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#include "ui.h"
+#include "ui-sources.h"
+#include "ui-callbacks.h"
+#include "callbacks.h"
+#include "conf.h"
+
+#define UI_SOURCES_RECONNECT_DELAY 3000
+
+/* Additional connections, running alongside the primary one (ui.conn).
+   They share the model, but not the connection dialog or the toolbar state. */
+
+typedef struct ui_source
+{
+    gint profile;
+    mt_ssh_t *conn;
+    gboolean connected;
+    gboolean active;
+    gint64 hwaddr;
+    gint band;
+    gint channel_width;
+    guint data_timeout;
+    guint reconnect;
+} ui_source_t;
+
+static GSList *sources = NULL;
+
+static gboolean ui_sources_connect(ui_source_t*);
+static ui_source_t* ui_sources_find(const mt_ssh_t*);
+static void ui_sources_remove(ui_source_t*);
+static gboolean ui_sources_timeout(gpointer);
+static gboolean ui_sources_reconnect(gpointer);
+
+gboolean
+ui_sources_add(gint profile)
+{
+    ui_source_t *source;
+
+    source = g_malloc0(sizeof(ui_source_t));
+    source->profile = profile;
+
+    if(!ui_sources_connect(source))
+    {
+        g_free(source);
+        return FALSE;
+    }
+
+    sources = g_slist_prepend(sources, source);
+    return TRUE;
+}
+
+static gboolean
+ui_sources_connect(ui_source_t *source)
+{
+    GtkListStore *profiles = conf_get_profiles();
+    conf_profile_t *p;
+    GtkTreeIter iter;
+
+    if(source->profile <= 0 ||
+       !gtk_tree_model_iter_nth_child(GTK_TREE_MODEL(profiles), &iter, NULL, source->profile-1))
+        return FALSE;
+
+    p = conf_profile_list_get(profiles, &iter);
+
+    /* Additional sources always work in the scanner mode, but their
+       sniffers may be set up to stream to the primary tzsp-receiver */
+    source->conn = mt_ssh_new(callback_mt_ssh,
+                              callback_mt_ssh_msg,
+                              MT_SSH_MODE_SCANNER,
+                              conf_profile_get_name(p),
+                              conf_profile_get_host(p),
+                              conf_profile_get_port(p),
+                              (mt_ssh_transport_t)conf_profile_get_transport(p),
+                              conf_profile_get_login(p),
+                              conf_profile_get_password(p),
+                              conf_profile_get_interface(p),
+                              (conf_profile_get_duration(p) ? conf_profile_get_duration_time(p) : 0),
+                              conf_profile_get_remote(p),
+                              conf_profile_get_background(p),
+                              conf_get_runtime_skip_verification());
+
+    conf_profile_free(p);
+    return (source->conn != NULL);
+}
+
+gboolean
+ui_sources_contains(const mt_ssh_t *context)
+{
+    return (ui_sources_find(context) != NULL);
+}
+
+static ui_source_t*
+ui_sources_find(const mt_ssh_t *context)
+{
+    GSList *it;
+
+    if(!context)
+        return NULL;
+
+    for(it = sources; it; it = it->next)
+        if(((ui_source_t*)it->data)->conn == context)
+            return (ui_source_t*)it->data;
+
+    return NULL;
+}
+
+void
+ui_sources_connected(const mt_ssh_t *context)
+{
+    ui_source_t *source = ui_sources_find(context);
+
+    if(!source)
+        return;
+
+    source->connected = TRUE;
+    source->hwaddr = mt_ssh_get_hwaddr(context);
+    source->band = mt_ssh_get_band(context);
+    source->channel_width = mt_ssh_get_channel_width(context);
+    ui_tzsp_sensor_add(source->hwaddr, source->band, source->channel_width);
+}
+
+void
+ui_sources_disconnected(const mt_ssh_t *context,
+                        gboolean        cancelled)
+{
+    ui_source_t *source = ui_sources_find(context);
+
+    if(!source)
+        return;
+
+    if(source->connected)
+        ui_tzsp_sensor_remove(source->hwaddr);
+
+    source->conn = NULL;
+    source->connected = FALSE;
+    source->active = FALSE;
+
+    if(source->data_timeout)
+    {
+        g_source_remove(source->data_timeout);
+        source->data_timeout = 0;
+        ui_callback_source_timeout();
+    }
+
+    if(!cancelled &&
+       conf_get_preferences_reconnect())
+    {
+        /* Try to reconnect in the background */
+        source->reconnect = g_timeout_add(UI_SOURCES_RECONNECT_DELAY, ui_sources_reconnect, source);
+        return;
+    }
+
+    ui_sources_remove(source);
+}
+
+void
+ui_sources_state(const mt_ssh_t *context,
+                 gboolean        active)
+{
+    ui_source_t *source = ui_sources_find(context);
+
+    if(source)
+        source->active = active;
+}
+
+void
+ui_sources_heartbeat(const mt_ssh_t *context)
+{
+    ui_source_t *source = ui_sources_find(context);
+
+    if(!source)
+        return;
+
+    if(source->data_timeout)
+        g_source_remove(source->data_timeout);
+    source->data_timeout = g_timeout_add(ui.model->active_timeout * 1000, ui_sources_timeout, source);
+}
+
+gboolean
+ui_sources_alive(void)
+{
+    GSList *it;
+
+    /* A pending data timeout means that the source has sent a heartbeat recently */
+    for(it = sources; it; it = it->next)
+        if(((ui_source_t*)it->data)->data_timeout)
+            return TRUE;
+
+    return FALSE;
+}
+
+guint
+ui_sources_count(void)
+{
+    GSList *it;
+    guint count = 0;
+
+    for(it = sources; it; it = it->next)
+        if(((ui_source_t*)it->data)->connected)
+            count++;
+
+    return count;
+}
+
+void
+ui_sources_tzsp(void)
+{
+    ui_source_t *source;
+    GSList *it;
+
+    for(it = sources; it; it = it->next)
+    {
+        source = (ui_source_t*)it->data;
+        if(source->connected)
+            ui_tzsp_sensor_add(source->hwaddr, source->band, source->channel_width);
+    }
+}
+
+void
+ui_sources_cmd(mt_ssh_cmd_type_t  cmd,
+               const gchar       *data)
+{
+    GSList *it;
+    ui_source_t *source;
+
+    for(it = sources; it; it = it->next)
+    {
+        source = (ui_source_t*)it->data;
+        if(source->conn && source->connected)
+            mt_ssh_cmd(source->conn, cmd, data);
+    }
+}
+
+void
+ui_sources_cancel(void)
+{
+    ui_source_t *source;
+
+    while(sources)
+    {
+        source = (ui_source_t*)sources->data;
+
+        /* The connection will be freed in its final callback */
+        if(source->conn)
+            mt_ssh_cancel(source->conn);
+
+        if(source->connected)
+            ui_tzsp_sensor_remove(source->hwaddr);
+
+        ui_sources_remove(source);
+    }
+}
+
+static void
+ui_sources_remove(ui_source_t *source)
+{
+    if(source->data_timeout)
+        g_source_remove(source->data_timeout);
+
+    if(source->reconnect)
+        g_source_remove(source->reconnect);
+
+    sources = g_slist_remove(sources, source);
+    g_free(source);
+}
+
+static gboolean
+ui_sources_timeout(gpointer user_data)
+{
+    ui_source_t *source = (ui_source_t*)user_data;
+
+    source->data_timeout = 0;
+    ui_callback_source_timeout();
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean
+ui_sources_reconnect(gpointer user_data)
+{
+    ui_source_t *source = (ui_source_t*)user_data;
+
+    source->reconnect = 0;
+    if(!ui_sources_connect(source))
+        ui_sources_remove(source);
+
+    return G_SOURCE_REMOVE;
+}
@@ -0,0 +1,32 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+#ifndef MTSCAN_UI_SOURCES_H_
+#define MTSCAN_UI_SOURCES_H_
+#include "mt-ssh.h"
+
+gboolean ui_sources_add(gint);
+gboolean ui_sources_contains(const mt_ssh_t*);
+void ui_sources_connected(const mt_ssh_t*);
+void ui_sources_disconnected(const mt_ssh_t*, gboolean);
+void ui_sources_state(const mt_ssh_t*, gboolean);
+void ui_sources_heartbeat(const mt_ssh_t*);
+gboolean ui_sources_alive(void);
+guint ui_sources_count(void);
+void ui_sources_tzsp(void);
+void ui_sources_cmd(mt_ssh_cmd_type_t, const gchar*);
+void ui_sources_cancel(void);
+
+#endif
@@ -33,6 +33,7 @@
 #include "ui-callbacks.h"
 #include "misc.h"
 #include "export-csv.h"
+#include "ui-sources.h"
 
 static void ui_toolbar_connect(GtkWidget*, gpointer);
 static void ui_toolbar_scan(GtkWidget*, gpointer);
@@ -239,10 +240,13 @@ ui_toolbar_scan(GtkWidget *widget,
     if(ui.conn)
     {
         mt_ssh_cmd(ui.conn, MT_SSH_CMD_STOP, NULL);
+        ui_sources_cmd(MT_SSH_CMD_STOP, NULL);
         if(!ui.active && ui.mode == MTSCAN_MODE_SCANNER)
             mt_ssh_cmd(ui.conn, MT_SSH_CMD_SCAN, NULL);
         else if(!ui.active && ui.mode == MTSCAN_MODE_SNIFFER)
             mt_ssh_cmd(ui.conn, MT_SSH_CMD_SNIFF, NULL);
+        if(!ui.active)
+            ui_sources_cmd(MT_SSH_CMD_SCAN, NULL);
         gtk_widget_set_sensitive(widget, FALSE);
     }
 }
@@ -262,10 +266,12 @@ ui_toolbar_restart(GtkWidget *widget,
     if(ui.conn)
     {
         mt_ssh_cmd(ui.conn, MT_SSH_CMD_STOP, NULL);
+        ui_sources_cmd(MT_SSH_CMD_STOP, NULL);
         if(ui.mode == MTSCAN_MODE_SCANNER)
             mt_ssh_cmd(ui.conn, MT_SSH_CMD_SCAN, NULL);
         else if(ui.mode == MTSCAN_MODE_SNIFFER)
             mt_ssh_cmd(ui.conn, MT_SSH_CMD_SNIFF, NULL);
+        ui_sources_cmd(MT_SSH_CMD_SCAN, NULL);
         gtk_widget_set_sensitive(widget, FALSE);
     }
 }
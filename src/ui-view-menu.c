@@ -99,11 +99,6 @@ ui_view_menu(GtkWidget      *treeview,
             flags |= FLAG_GEOLOC;
 
         menu = ui_view_menu_create(GTK_TREE_VIEW(treeview), count, &net, flags);
-
-        /* Signals are stored in GtkListStore just as pointer,
-           so set it to NULL before freeing the struct */
-        net.signals = NULL;
-        network_free(&net);
     }
     else
     {
@@ -22,6 +22,7 @@
 #include "ui-view-menu.h"
 #include "ui-icons.h"
 #include "ui-dialogs.h"
+#include "ui-journal.h"
 #include "signals.h"
 
 static const gchar* mtscan_view_cols[] =
@@ -1154,6 +1155,7 @@ ui_view_remove_iter(GtkWidget    *treeview,
     mtscan_model_t *model = g_object_get_data(G_OBJECT(treeview), "mtscan-model");
 
     mtscan_model_remove(model, iter);
+    ui_journal_invalidate();
     ui_changed();
     ui_status_update_networks();
 
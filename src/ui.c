@@ -31,6 +31,8 @@
 #include "signals.h"
 #include "misc.h"
 #include "ui-callbacks.h"
+#include "ui-sources.h"
+#include "ui-journal.h"
 
 #ifdef G_OS_WIN32
 #include "win32.h"
@@ -65,8 +67,10 @@ static gboolean ui_delete_event(GtkWidget*, GdkEvent*, gpointer);
 static void ui_drag_data_received(GtkWidget*, GdkDragContext*, gint, gint, GtkSelectionData*, guint, guint);
 static gboolean ui_idle_timeout(gpointer);
 static gboolean ui_idle_timeout_autosave(gpointer);
+static void ui_autosave_done(const gchar*, gboolean);
 static void ui_gnss(mtscan_gnss_state_t, const mtscan_gnss_data_t*, gpointer);
 static gchar* ui_get_name(const gchar*);
+static void ui_status_sensor_cb(gint64, guint32, guint32, gpointer);
 
 void
 ui_init(void)
@@ -197,12 +201,19 @@ ui_delete_event(GtkWidget *widget,
 {
     GdkWindow *window;
     gboolean really_quit;
+    gboolean flushed;
     gboolean maximized;
     gint x, y;
 
+    flushed = ui_journal_flush();
     really_quit = ui_can_discard_unsaved();
     if(really_quit)
     {
+        /* Keep the journal for recovery, if the autosave has failed
+           and the changes were not saved in another way */
+        if(flushed || !ui.changed)
+            ui_journal_stop();
+
         window = gtk_widget_get_window(GTK_WIDGET(widget));
         maximized = window && (gdk_window_get_state(window) & GDK_WINDOW_STATE_MAXIMIZED);
         if(!maximized)
@@ -310,6 +321,10 @@ ui_idle_timeout(gpointer user_data)
         mtscan_sound(APP_SOUND_GNSS_LOST);
     }
 
+    /* Refresh the kernel drop counter of the TZSP socket */
+    if(ui->tzsp_rx)
+        ui_status_update_networks();
+
     return G_SOURCE_CONTINUE;
 }
 
@@ -320,6 +335,13 @@ ui_idle_timeout_autosave(gpointer user_data)
     gint64 ts;
     gchar *filename;
 
+    if(ui->loading)
+        return G_SOURCE_CONTINUE;
+
+    if(!conf_get_interface_autosave() ||
+       !conf_get_preferences_autosave_journal())
+        ui_journal_stop();
+
     if(conf_get_interface_autosave() &&
        ui->changed &&
        ui->active)
@@ -327,17 +349,12 @@ ui_idle_timeout_autosave(gpointer user_data)
         ts = UNIX_TIMESTAMP();
         if((ts - ui->log_ts) >= conf_get_preferences_autosave_interval()*60)
         {
+            /* Serialization is done in the background, from a snapshot of the model */
             filename = (!ui->filename ? timestamp_to_filename(conf_get_path_autosave(), ui->log_ts) : NULL);
-            if(!ui_log_save_full((!filename ? ui->filename : filename), FALSE, FALSE, FALSE, NULL, FALSE))
-            {
-                g_signal_emit_by_name(ui->b_autosave, "clicked");
-
-                ui_dialog(GTK_WINDOW(ui->window),
-                          GTK_MESSAGE_ERROR,
-                          "Error",
-                          "Unable to save a file:\n%s\n\n<b>Autosave has been disabled.</b>",
-                          (!filename ? ui->filename : filename));
-            }
+            if(conf_get_preferences_autosave_journal())
+                ui_journal_autosave((!filename ? ui->filename : filename), ui_autosave_done);
+            else
+                ui_log_save_async((!filename ? ui->filename : filename), FALSE, FALSE, FALSE, ui_autosave_done);
             g_free(filename);
         }
     }
@@ -345,6 +362,22 @@ ui_idle_timeout_autosave(gpointer user_data)
     return G_SOURCE_CONTINUE;
 }
 
+static void
+ui_autosave_done(const gchar *filename,
+                 gboolean     success)
+{
+    if(success)
+        return;
+
+    g_signal_emit_by_name(ui.b_autosave, "clicked");
+
+    ui_dialog(GTK_WINDOW(ui.window),
+              GTK_MESSAGE_ERROR,
+              "Error",
+              "Unable to save a file:\n%s\n\n<b>Autosave has been disabled.</b>",
+              filename);
+}
+
 static void
 ui_gnss(mtscan_gnss_state_t       state,
         const mtscan_gnss_data_t *gnss_data,
@@ -466,9 +499,18 @@ ui_disconnected(void)
     gtk_widget_set_sensitive(GTK_WIDGET(ui.b_restart), TRUE);
     gtk_label_set_text(GTK_LABEL(ui.l_conn_status), "disconnected");
 
-    mtscan_model_buffer_clear(ui.model);
-    mtscan_model_clear_active(ui.model);
-    ui_status_update_networks();
+    if(ui.data_timeout)
+    {
+        g_source_remove(ui.data_timeout);
+        ui.data_timeout = 0;
+    }
+
+    if(!ui_sources_alive())
+    {
+        mtscan_model_buffer_clear(ui.model);
+        mtscan_model_clear_active(ui.model);
+        ui_status_update_networks();
+    }
 
     ui_tzsp_destroy();
 }
@@ -476,6 +518,7 @@ ui_disconnected(void)
 void
 ui_changed(void)
 {
+    ui.revision++;
     if(!ui.changed)
     {
         ui.changed = TRUE;
@@ -487,6 +530,7 @@ ui_changed(void)
 gboolean
 ui_can_discard_unsaved(void)
 {
+    ui_log_save_wait();
     if(!ui.changed)
         return TRUE;
 
@@ -507,16 +551,25 @@ ui_status_update_networks(void)
 {
     static gint last_networks = -1;
     static gint last_active = -1;
+    static guint32 last_drops = 0;
     gint networks, active;
+    guint32 drops;
+    guint32 unknown;
+    gchar *tooltip;
+    GString *str;
     gchar *text;
 
     networks = g_hash_table_size(ui.model->map);
     active = g_hash_table_size(ui.model->active);
+    drops = (ui.tzsp_rx ? tzsp_receiver_get_drops(ui.tzsp_rx) : 0);
     if(networks != last_networks ||
-       active != last_active)
+       active != last_active ||
+       drops != last_drops)
     {
         if(conf_get_preferences_compact_status())
             text = g_strdup_printf("%d/%d", active, networks);
+        else if(drops)
+            text = g_strdup_printf("%d/%d networks (%u dropped)", active, networks, drops);
         else
             text = g_strdup_printf("%d/%d networks", active, networks);
 
@@ -524,7 +577,37 @@ ui_status_update_networks(void)
         g_free(text);
         last_active = active;
         last_networks = networks;
+        last_drops = drops;
+    }
+
+    /* Per-sensor statistics of the tzsp-receiver */
+    tooltip = NULL;
+    if(ui.tzsp_rx)
+    {
+        str = g_string_new(NULL);
+        tzsp_receiver_foreach_sensor(ui.tzsp_rx, ui_status_sensor_cb, str);
+        unknown = tzsp_receiver_get_unknown(ui.tzsp_rx);
+        if(unknown)
+            g_string_append_printf(str, "%sUnknown sensors: %u packets", (str->len ? "\n" : ""), unknown);
+        tooltip = g_string_free(str, FALSE);
     }
+    gtk_widget_set_tooltip_text(ui.l_net_status, tooltip);
+    g_free(tooltip);
+}
+
+static void
+ui_status_sensor_cb(gint64   address,
+                    guint32  packets,
+                    guint32  drops,
+                    gpointer user_data)
+{
+    GString *str = (GString*)user_data;
+
+    g_string_append_printf(str, "%s%s: %u packets (%u dropped)",
+                           (str->len ? "\n" : ""),
+                           model_format_address(address, FALSE),
+                           packets,
+                           drops);
 }
 
 void
@@ -563,7 +646,7 @@ ui_get_name(const gchar *filename)
         *ext = '\0';
         ext = strrchr(name, '.');
     }
-    if(ext && !g_ascii_strcasecmp(ext, APP_FILE_EXT))
+    if(ext && (!g_ascii_strcasecmp(ext, APP_FILE_EXT) || !g_ascii_strcasecmp(ext, APP_FILE_BINARY)))
         *ext = '\0';
 
     return name;
@@ -572,8 +655,11 @@ ui_get_name(const gchar *filename)
 void
 ui_clear(void)
 {
+    ui_log_save_wait();
+    ui_journal_invalidate();
     mtscan_model_clear(ui.model);
     ui.changed = FALSE;
+    ui.revision++;
     ui_status_update_networks();
 }
 
@@ -677,6 +763,7 @@ ui_toggle_connection(gint auto_connect_profile)
         gtk_widget_set_sensitive(GTK_WIDGET(ui.b_connect), FALSE);
 
         mt_ssh_cancel(ui.conn);
+        ui_sources_cancel();
         return;
     }
 
@@ -689,9 +776,6 @@ ui_toggle_connection(gint auto_connect_profile)
 void
 ui_tzsp(void)
 {
-    gint frequency_base;
-    guint8 tzsp_hwaddr[6];
-
     if(ui.mode != MTSCAN_MODE_SNIFFER)
         return;
 
@@ -699,31 +783,63 @@ ui_tzsp(void)
     ui_tzsp_destroy();
 
     /* Make sure that sensor address is available */
-    if(!addr_to_guint8(ui.hwaddr, tzsp_hwaddr))
+    if(ui.hwaddr < 0)
     {
         ui_dialog(NULL, GTK_MESSAGE_WARNING, "Error", "<b>Failed to create tzsp-receiver</b>\n\nSensor address is unavailable.");
         return;
     }
 
-    if(ui.band == MTSCAN_BAND_2GHZ)
-        frequency_base = 2407;
-    else if(ui.band == MTSCAN_BAND_5GHZ)
-        frequency_base = 5000;
-    else
+    if(ui.band != MTSCAN_BAND_2GHZ &&
+       ui.band != MTSCAN_BAND_5GHZ)
     {
         ui_dialog(NULL, GTK_MESSAGE_WARNING, "Error", "<b>Failed to create tzsp-receiver</b>\n\nFrequency band is unknown.");
         return;
     }
 
     ui.tzsp_rx = tzsp_receiver_new((guint16)conf_get_preferences_tzsp_udp_port(),
-                                   tzsp_hwaddr,
-                                   ui.channel_width,
-                                   frequency_base,
+                                   conf_get_preferences_tzsp_buffer() * 1024,
+                                   conf_get_preferences_tzsp_filter(),
                                    ui_callback_tzsp,
                                    ui_callback_tzsp_network);
 
     if(!ui.tzsp_rx)
+    {
         ui_dialog(NULL, GTK_MESSAGE_WARNING, "Error", "<b>Failed to enable tzsp-receiver.</b>");
+        return;
+    }
+
+    /* Sniffers of additional sources may stream to the same port */
+    ui_tzsp_sensor_add(ui.hwaddr, ui.band, ui.channel_width);
+    ui_sources_tzsp();
+}
+
+gboolean
+ui_tzsp_sensor_add(gint64 hwaddr,
+                   gint   band,
+                   gint   channel_width)
+{
+    gint frequency_base;
+
+    if(!ui.tzsp_rx || hwaddr < 0)
+        return FALSE;
+
+    if(band == MTSCAN_BAND_2GHZ)
+        frequency_base = 2407;
+    else if(band == MTSCAN_BAND_5GHZ)
+        frequency_base = 5000;
+    else
+        return FALSE;
+
+    tzsp_receiver_add_sensor(ui.tzsp_rx, hwaddr, channel_width, frequency_base);
+    return TRUE;
+}
+
+void
+ui_tzsp_sensor_remove(gint64 hwaddr)
+{
+    /* Keep the primary sensor as long as the receiver exists */
+    if(ui.tzsp_rx && hwaddr >= 0 && hwaddr != ui.hwaddr)
+        tzsp_receiver_remove_sensor(ui.tzsp_rx, hwaddr);
 }
 
 void
@@ -81,9 +81,11 @@ typedef struct mtscan_gtk
 
     mtscan_model_t *model;
     gboolean changed;
+    guint revision;
     gchar *filename;
     gchar *name;
     gint64 log_ts;
+    gboolean loading;
 
     ui_connection_t *conn_dialog;
     ui_scanlist_t *scanlist;
@@ -122,5 +124,7 @@ void ui_screenshot(void);
 void ui_toggle_connection(gint);
 void ui_tzsp(void);
 void ui_tzsp_destroy(void);
+gboolean ui_tzsp_sensor_add(gint64, gint, gint);
+void ui_tzsp_sensor_remove(gint64);
 
 #endif
@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+#
+#  MTscan - MikroTik RouterOS wireless scanner
+#  Copyright (c) 2015-2026  Konrad Kosmatka
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+
+# Stand-in RouterOS API server. Listens on a free local port, runs
+# the client given on the command line with <host> <port> <transport>
+# appended and answers the sentences sent by mt-ssh in the API mode.
+# The scan is streamed in sections, only the =.proplist attributes
+# are sent. With --ssl the connection uses anonymous DH, like api-ssl
+# on a router without a certificate.
+
+import socket
+import ssl
+import struct
+import subprocess
+import sys
+import time
+
+FRAMES = 3
+ROWS = 4
+CHUNK = 7
+FRAME_GAP = 0.3
+TIMEOUT = 10
+INTERFACE = 'wlan1'
+PROPLIST = ['.section', 'address', 'ssid', 'channel', 'sig', 'nf', 'radio-name',
+            'routeros-version', 'active', 'privacy']
+
+
+def encode(word):
+    data = word.encode()
+    n = len(data)
+    if n < 0x80:
+        prefix = struct.pack('>B', n)
+    elif n < 0x4000:
+        prefix = struct.pack('>H', n | 0x8000)
+    elif n < 0x200000:
+        prefix = struct.pack('>I', n | 0xC00000)[1:]
+    elif n < 0x10000000:
+        prefix = struct.pack('>I', n | 0xE0000000)
+    else:
+        prefix = b'\xF0' + struct.pack('>I', n)
+    return prefix + data
+
+
+def sentence(words):
+    return b''.join(encode(w) for w in words) + b'\x00'
+
+
+def read_exact(conn, n):
+    data = b''
+    while len(data) < n:
+        chunk = conn.recv(n - len(data))
+        if not chunk:
+            raise EOFError
+        data += chunk
+    return data
+
+
+def read_sentence(conn):
+    words = []
+    while True:
+        c = read_exact(conn, 1)[0]
+        if c < 0x80:
+            n = c
+        elif c & 0xC0 == 0x80:
+            n = ((c & 0x3F) << 8) | read_exact(conn, 1)[0]
+        elif c & 0xE0 == 0xC0:
+            b = read_exact(conn, 2)
+            n = ((c & 0x1F) << 16) | (b[0] << 8) | b[1]
+        elif c & 0xF0 == 0xE0:
+            b = read_exact(conn, 3)
+            n = ((c & 0x0F) << 24) | (b[0] << 16) | (b[1] << 8) | b[2]
+        else:
+            n = struct.unpack('>I', read_exact(conn, 4))[0]
+        if not n:
+            return words
+        words.append(read_exact(conn, n).decode())
+
+
+def attributes(words, prefix):
+    attrs = {}
+    for word in words[1:]:
+        if word.startswith(prefix):
+            key, _, value = word[len(prefix):].partition('=')
+            attrs[key] = value
+    return attrs
+
+
+def scan_row(section, i):
+    # One row in each section is inactive and must be skipped
+    return {
+        '.section': str(section),
+        'address': '4C:5E:0C:00:%02X:%02X' % (section, i),
+        'ssid': 'net-%d-%d' % (section, i),
+        'channel': '5180/20-Ce/an',
+        'sig': str(-40 - i),
+        'nf': '-110',
+        'radio-name': 'ap-%d-%d' % (section, i),
+        'routeros-version': '6.49.10',
+        'active': 'true' if i < ROWS else 'false',
+        'privacy': 'true' if i % 2 else 'false',
+        'uptime': '1d02:03:04',
+    }
+
+
+def stream_scan(conn, tag, proplist):
+    for section in range(FRAMES):
+        data = b''
+        for i in range(ROWS + 1):
+            row = scan_row(section, i)
+            words = ['!re', tag] + ['=%s=%s' % (k, row[k]) for k in proplist if k in row]
+            data += sentence(words)
+        # Small writes check the reassembly of split words
+        for i in range(0, len(data), CHUNK):
+            conn.sendall(data[i:i + CHUNK])
+        time.sleep(FRAME_GAP)
+
+
+def serve(conn):
+    errors = []
+    scan_tag = None
+
+    while True:
+        try:
+            words = read_sentence(conn)
+        except (EOFError, OSError):
+            break
+
+        command = words[0]
+        tag = '.tag=' + attributes(words, '.').get('tag', '')
+        args = attributes(words, '=')
+        queries = attributes(words, '?')
+
+        if command == '/login':
+            if args.get('name') != 'admin':
+                errors.append('unexpected login: %s' % args.get('name'))
+            conn.sendall(sentence(['!done', tag]))
+        elif command == '/system/identity/print':
+            conn.sendall(sentence(['!re', tag, '=name=stand-in']) + sentence(['!done', tag]))
+        elif command == '/interface/wireless/print':
+            if queries.get('name') != INTERFACE:
+                errors.append('unexpected interface query: %s' % queries.get('name'))
+            conn.sendall(sentence(['!re', tag, '=mac-address=4C:5E:0C:AA:BB:CC',
+                                   '=band=5ghz-a/n', '=channel-width=20mhz']) +
+                         sentence(['!done', tag]))
+        elif command == '/interface/wireless/info/scan-list':
+            conn.sendall(sentence(['!re', tag, '=channels=5180/20/a,5200/20/a']) + sentence(['!done', tag]))
+        elif command == '/interface/wireless/scan':
+            proplist = args.get('.proplist', '').split(',')
+            missing = [p for p in PROPLIST if p not in proplist]
+            if missing:
+                errors.append('.proplist without %s' % ','.join(missing))
+            if args.get('.id') != INTERFACE:
+                errors.append('unexpected scan interface: %s' % args.get('.id'))
+            scan_tag = tag
+            stream_scan(conn, tag, proplist)
+        elif command == '/cancel':
+            if scan_tag:
+                conn.sendall(sentence(['!trap', scan_tag, '=category=2', '=message=interrupted']) +
+                             sentence(['!done', scan_tag]))
+            conn.sendall(sentence(['!done', tag]))
+        else:
+            errors.append('unexpected command: %s' % command)
+            conn.sendall(sentence(['!trap', tag, '=message=no such command']) + sentence(['!done', tag]))
+
+    if not scan_tag:
+        errors.append('no scan was requested')
+    return errors
+
+
+def main():
+    args = sys.argv[1:]
+    use_ssl = bool(args) and args[0] == '--ssl'
+    if use_ssl:
+        args = args[1:]
+    if not args:
+        sys.stderr.write('usage: %s [--ssl] <client> [args...]\n' % sys.argv[0])
+        return 2
+
+    server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    server.bind(('127.0.0.1', 0))
+    server.listen(1)
+    server.settimeout(TIMEOUT)
+    port = server.getsockname()[1]
+
+    client = subprocess.Popen(args + ['127.0.0.1', str(port), 'api-ssl' if use_ssl else 'api'])
+
+    try:
+        conn, _ = server.accept()
+    except socket.timeout:
+        client.kill()
+        sys.stderr.write('mt-api-server: no connection\n')
+        return 1
+
+    conn.settimeout(TIMEOUT)
+    if use_ssl:
+        context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        context.maximum_version = ssl.TLSVersion.TLSv1_2
+        context.set_ciphers('aNULL:@SECLEVEL=0')
+        conn = context.wrap_socket(conn, server_side=True)
+
+    errors = serve(conn)
+    conn.close()
+    server.close()
+
+    for error in errors:
+        sys.stderr.write('mt-api-server: %s\n' % error)
+
+    ret = client.wait(TIMEOUT)
+    return ret if ret else (1 if errors else 0)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
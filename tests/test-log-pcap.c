@@ -0,0 +1,201 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+/* Writes a capture of beacons with radiotap headers and reads it back
+   with log_pcap_read(). Each beacon carries a different set of leading
+   radiotap fields, the antenna signal must be found after all of them. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib/gstdio.h>
+#include "log.h"
+#include "log-pcap.h"
+
+#define TEST_LINKTYPE 127
+#define TEST_CHANNEL  6
+
+typedef struct test_frame
+{
+    const gchar *name;
+    guint32 present;
+    guint8 fields[24];
+    guint fields_length;
+    gint8 rssi;
+} test_frame_t;
+
+static const test_frame_t frames[] =
+{
+    /* Flags, FHSS (hop set, hop pattern), antenna signal */
+    { "fhss", 0x00000032,
+      { 0x00, 0x01, 0x02, 0xCD },
+      4, -51 },
+
+    /* Flags, rate, FHSS, antenna signal */
+    { "rate-fhss", 0x00000036,
+      { 0x00, 0x02, 0x01, 0x02, 0xC4 },
+      5, -60 },
+
+    /* TSFT, flags, rate, channel, FHSS, antenna signal */
+    { "tsft-channel-fhss", 0x0000003F,
+      { 0, 0, 0, 0, 0, 0, 0, 0,
+        0x00, 0x02,
+        0x85, 0x09, 0xA0, 0x00,
+        0x01, 0x02, 0xBE },
+      17, -66 },
+};
+
+static gint networks = 0;
+static gint errors = 0;
+
+
+static gsize
+test_beacon(guint8 *buffer,
+            guint   index)
+{
+    static const guint8 header[] =
+    {
+        0x80, 0x00, 0x00, 0x00,
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+        0x4C, 0x5E, 0x0C, 0x00, 0x00, 0x00,
+        0x4C, 0x5E, 0x0C, 0x00, 0x00, 0x00,
+        0x00, 0x00,
+        0, 0, 0, 0, 0, 0, 0, 0,
+        0x64, 0x00,
+        0x01, 0x00
+    };
+    gchar *ssid = g_strdup_printf("net-%u", index);
+    gsize length = sizeof(header);
+
+    memcpy(buffer, header, sizeof(header));
+    buffer[15] = index;
+    buffer[21] = index;
+
+    buffer[length++] = 0;
+    buffer[length++] = strlen(ssid);
+    memcpy(buffer + length, ssid, strlen(ssid));
+    length += strlen(ssid);
+
+    buffer[length++] = 3;
+    buffer[length++] = 1;
+    buffer[length++] = TEST_CHANNEL;
+
+    g_free(ssid);
+    return length;
+}
+
+static gboolean
+test_write(const gchar *filename)
+{
+    guint8 packet[256];
+    guint32 record[4];
+    guint32 header[6] = { 0xA1B2C3D4, 0x00040002, 0, 0, 65535, TEST_LINKTYPE };
+    guint16 header_length;
+    gsize length;
+    gboolean ret;
+    FILE *fp;
+    guint i;
+
+    if(!(fp = g_fopen(filename, "wb")))
+        return FALSE;
+
+    ret = (fwrite(header, sizeof(header), 1, fp) == 1);
+
+    for(i=0; ret && i<G_N_ELEMENTS(frames); i++)
+    {
+        header_length = 8 + frames[i].fields_length;
+        packet[0] = 0;
+        packet[1] = 0;
+        packet[2] = header_length & 0xFF;
+        packet[3] = header_length >> 8;
+        packet[4] = frames[i].present & 0xFF;
+        packet[5] = (frames[i].present >> 8) & 0xFF;
+        packet[6] = (frames[i].present >> 16) & 0xFF;
+        packet[7] = frames[i].present >> 24;
+        memcpy(packet + 8, frames[i].fields, frames[i].fields_length);
+        length = header_length + test_beacon(packet + header_length, i);
+
+        record[0] = 1000 + i;
+        record[1] = 0;
+        record[2] = length;
+        record[3] = length;
+        ret = (fwrite(record, sizeof(record), 1, fp) == 1 &&
+               fwrite(packet, length, 1, fp) == 1);
+    }
+
+    if(fclose(fp) != 0)
+        ret = FALSE;
+    return ret;
+}
+
+static void
+test_cb(network_t *network,
+        gpointer   user_data)
+{
+    guint i = network->address & 0xFF;
+    gchar *ssid = g_strdup_printf("net-%u", i);
+
+    if(i >= G_N_ELEMENTS(frames) ||
+       network->address != (G_GINT64_CONSTANT(0x4C5E0C000000) | i) ||
+       g_strcmp0(network->ssid, ssid) ||
+       network->rssi != frames[i].rssi)
+    {
+        fprintf(stderr, "%s: unexpected network %012" G_GINT64_MODIFIER "X '%s' %d\n",
+                (i < G_N_ELEMENTS(frames) ? frames[i].name : "?"),
+                network->address, network->ssid, network->rssi);
+        errors++;
+    }
+
+    /* The network stays owned by the reader */
+    networks++;
+    g_free(ssid);
+}
+
+int
+main(int   argc,
+     char *argv[])
+{
+    gchar *filename;
+    gint count;
+    gint fd;
+
+    if((fd = g_file_open_tmp("mtscan-XXXXXX.pcap", &filename, NULL)) < 0)
+    {
+        fprintf(stderr, "unable to create a temporary file\n");
+        return EXIT_FAILURE;
+    }
+    g_close(fd, NULL);
+
+    if(!test_write(filename))
+    {
+        fprintf(stderr, "unable to write %s\n", filename);
+        g_remove(filename);
+        g_free(filename);
+        return EXIT_FAILURE;
+    }
+
+    count = log_pcap_read(filename, test_cb, NULL, FALSE);
+    g_remove(filename);
+    g_free(filename);
+
+    printf("%d networks, %d errors\n", networks, errors);
+
+    if(count != G_N_ELEMENTS(frames) ||
+       networks != G_N_ELEMENTS(frames) ||
+       errors)
+        return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,180 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+/* Runs a streaming scan against mt-api-server.py, which starts this
+   program with <host> <port> <api|api-ssl>. The frames and rows must
+   match the ones sent by the server. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mt-ssh.h"
+
+#define TEST_FRAMES      3
+#define TEST_ROWS        4
+#define TEST_TIMEOUT_SEC 10
+
+static GMainLoop *loop = NULL;
+static mt_ssh_t *conn = NULL;
+static mt_ssh_ret_t result = MT_SSH_INVALID;
+static gint batches = 0;
+static gint rows = 0;
+static gint errors = 0;
+
+
+static gboolean
+test_check(const mt_ssh_net_t *net)
+{
+    gint64 address = mt_ssh_net_get_address(net);
+    gint section = (address >> 8) & 0xFF;
+    gint i = address & 0xFF;
+    gchar *ssid = g_strdup_printf("net-%d-%d", section, i);
+    gchar *radioname = g_strdup_printf("ap-%d-%d", section, i);
+    gboolean ret;
+
+    ret = (address >> 16 == 0x4C5E0C00 &&
+           section == batches &&
+           i < TEST_ROWS &&
+           !g_strcmp0(mt_ssh_net_get_ssid(net), ssid) &&
+           !g_strcmp0(mt_ssh_net_get_radioname(net), radioname) &&
+           !g_strcmp0(mt_ssh_net_get_routeros_ver(net), "6.49.10") &&
+           mt_ssh_net_get_frequency(net) == 5180000 &&
+           mt_ssh_net_get_rssi(net) == -40 - i &&
+           mt_ssh_net_get_noise(net) == -110 &&
+           !mt_ssh_net_get_privacy(net) == !(i % 2));
+
+    if(!ret)
+    {
+        fprintf(stderr, "frame %d: unexpected row %012" G_GINT64_MODIFIER "X '%s' '%s' %d %d %d\n",
+                batches, address, mt_ssh_net_get_ssid(net), mt_ssh_net_get_radioname(net),
+                mt_ssh_net_get_frequency(net), mt_ssh_net_get_rssi(net), mt_ssh_net_get_noise(net));
+    }
+
+    g_free(ssid);
+    g_free(radioname);
+    return ret;
+}
+
+static void
+test_cb_msg(const mt_ssh_t    *context,
+            mt_ssh_msg_type_t  type,
+            gconstpointer      data)
+{
+    const mt_ssh_batch_t *batch = data;
+    const mt_ssh_info_t *info = data;
+    guint i;
+
+    if(type == MT_SSH_MSG_INFO &&
+       mt_ssh_info_get_type(info) == MT_SSH_INFO_FAILURE)
+    {
+        fprintf(stderr, "failure: %s\n", mt_ssh_info_get_data(info));
+        errors++;
+        return;
+    }
+
+    if(type != MT_SSH_MSG_BATCH)
+        return;
+
+    if(mt_ssh_batch_get_length(batch) != TEST_ROWS)
+    {
+        fprintf(stderr, "frame %d: %u rows, expected %d\n", batches, mt_ssh_batch_get_length(batch), TEST_ROWS);
+        errors++;
+    }
+
+    for(i=0; i<mt_ssh_batch_get_length(batch); i++)
+    {
+        if(!test_check(mt_ssh_batch_get_net(batch, i)))
+            errors++;
+    }
+
+    rows += mt_ssh_batch_get_length(batch);
+    if(++batches == TEST_FRAMES)
+        mt_ssh_cancel(conn);
+}
+
+static void
+test_cb(mt_ssh_t     *context,
+        mt_ssh_ret_t  return_state,
+        const gchar  *return_error)
+{
+    if(return_error)
+        fprintf(stderr, "error: %s\n", return_error);
+
+    result = return_state;
+    mt_ssh_free(context);
+    g_main_loop_quit(loop);
+}
+
+static gboolean
+test_timeout(gpointer user_data)
+{
+    fprintf(stderr, "timeout after %d frames\n", batches);
+    mt_ssh_cancel(conn);
+    errors++;
+    return G_SOURCE_REMOVE;
+}
+
+int
+main(int   argc,
+     char *argv[])
+{
+    mt_ssh_transport_t transport;
+
+    if(argc != 4)
+    {
+        fprintf(stderr, "usage: %s <host> <port> <api|api-ssl>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if(!strcmp(argv[3], "api"))
+        transport = MT_SSH_TRANSPORT_API;
+    else if(!strcmp(argv[3], "api-ssl"))
+        transport = MT_SSH_TRANSPORT_API_SSL;
+    else
+    {
+        fprintf(stderr, "unknown transport: %s\n", argv[3]);
+        return EXIT_FAILURE;
+    }
+
+    loop = g_main_loop_new(NULL, FALSE);
+    conn = mt_ssh_new(test_cb,
+                      test_cb_msg,
+                      MT_SSH_MODE_SCANNER,
+                      "test",
+                      argv[1],
+                      atoi(argv[2]),
+                      transport,
+                      "admin",
+                      "",
+                      "wlan1",
+                      0,
+                      TRUE,
+                      FALSE,
+                      TRUE);
+
+    g_timeout_add_seconds(TEST_TIMEOUT_SEC, test_timeout, NULL);
+    g_main_loop_run(loop);
+    g_main_loop_unref(loop);
+
+    printf("%s: %d frames, %d rows\n", argv[3], batches, rows);
+
+    if(result != MT_SSH_CANCELED ||
+       batches != TEST_FRAMES ||
+       rows != TEST_FRAMES * TEST_ROWS ||
+       errors)
+        return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
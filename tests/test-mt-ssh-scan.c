@@ -0,0 +1,656 @@
+/*
+ *  MTscan - MikroTik RouterOS wireless scanner
+ *  Copyright (c) 2015-2026  Konrad Kosmatka
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ */
+
+/* Feeds DUMP_PTY traces through mt_ssh_scanning() and compares
+   the rows with the line parser it replaced (kept below as baseline_*).
+   The static functions are reached by including the source file. */
+
+#include <getopt.h>
+#include "mt-ssh.c"
+
+#define TEST_DEFAULT_PASSES 200
+
+typedef struct test_row
+{
+    gint64 address;
+    guchar flags;
+    gint frequency;
+    gchar *channel;
+    gchar *mode;
+    gchar *ssid;
+    gchar *radioname;
+    gint8 rssi;
+    gint8 noise;
+    gchar *routeros_ver;
+} test_row_t;
+
+typedef struct test_baseline
+{
+    gint scan_line;
+    mt_ssh_shdr_t *scan_header;
+} test_baseline_t;
+
+static GPtrArray *rows_new = NULL;
+static guint64 rows_count = 0;
+
+static mt_ssh_shdr_t* baseline_parse_scan_header(const gchar*);
+static guint baseline_parse_scan_header_column(const gchar*, const gchar*, guint*);
+static guchar baseline_parse_scan_flags(const gchar*, guint);
+static gint64 baseline_parse_scan_address(const gchar*, guint);
+static gint baseline_parse_scan_channel(const gchar*, guint, gchar**, gchar**);
+static gint baseline_parse_scan_int(const gchar*, guint, guint);
+static gchar* baseline_parse_scan_string(const gchar*, guint, guint, gboolean);
+
+
+static void
+test_row_free(gpointer data)
+{
+    test_row_t *row = (test_row_t*)data;
+    g_free(row->channel);
+    g_free(row->mode);
+    g_free(row->ssid);
+    g_free(row->radioname);
+    g_free(row->routeros_ver);
+    g_free(row);
+}
+
+static void
+test_cb_msg(const mt_ssh_t    *context,
+            mt_ssh_msg_type_t  type,
+            gconstpointer      data)
+{
+    const mt_ssh_batch_t *batch = data;
+    const mt_ssh_net_t *net;
+    test_row_t *row;
+    guint i;
+
+    if(type != MT_SSH_MSG_BATCH)
+        return;
+
+    rows_count += mt_ssh_batch_get_length(batch);
+    if(!rows_new)
+        return;
+
+    for(i=0; i<mt_ssh_batch_get_length(batch); i++)
+    {
+        net = mt_ssh_batch_get_net(batch, i);
+        row = g_malloc0(sizeof(test_row_t));
+        row->address = net->address;
+        row->flags = net->flags;
+        row->frequency = net->frequency;
+        row->channel = g_strdup(net->channel);
+        row->mode = g_strdup(net->mode);
+        row->ssid = g_strdup(net->ssid);
+        row->radioname = g_strdup(net->radioname);
+        row->rssi = net->rssi;
+        row->noise = net->noise;
+        row->routeros_ver = g_strdup(net->routeros_ver);
+        g_ptr_array_add(rows_new, row);
+    }
+}
+
+static GPtrArray*
+test_load(const gchar *filename)
+{
+    GPtrArray *lines;
+    gchar *contents;
+    gchar *line;
+    gchar *ptr;
+
+    if(!g_file_get_contents(filename, &contents, NULL, NULL))
+        return NULL;
+
+    /* Split the same way as the PTY reader, prompts are handled before scanning */
+    str_remove_char(contents, '\n');
+    lines = g_ptr_array_new_with_free_func(g_free);
+    ptr = contents;
+    while((line = strsep(&ptr, "\r")))
+    {
+        if(*line && strncmp(line, str_prompt_start, strlen(str_prompt_start)))
+            g_ptr_array_add(lines, g_strdup(line));
+    }
+
+    g_free(contents);
+    return lines;
+}
+
+static mt_ssh_t*
+test_context_new(void)
+{
+    mt_ssh_t *context;
+
+    context = g_malloc0(sizeof(mt_ssh_t));
+    context->cb_msg = test_cb_msg;
+    context->remote_mode = TRUE;
+    context->state = MT_SSH_STATE_WAITING_FOR_SCAN;
+    context->scan_line = -1;
+    return context;
+}
+
+static void
+test_context_free(mt_ssh_t *context)
+{
+    g_free(context->scan_header);
+    g_free(context->dispatch_scanlist_set);
+    g_free(context);
+}
+
+static void
+test_drain(void)
+{
+    while(g_main_context_iteration(NULL, FALSE));
+}
+
+static void
+test_run_new(GPtrArray *lines)
+{
+    mt_ssh_t *context;
+    gchar buffer[PTY_COLS*4];
+    guint i;
+
+    context = test_context_new();
+    for(i=0; i<lines->len; i++)
+    {
+        g_strlcpy(buffer, g_ptr_array_index(lines, i), sizeof(buffer));
+        mt_ssh_scanning(context, buffer);
+    }
+    mt_ssh_scanning_flush(context);
+    test_drain();
+    test_context_free(context);
+}
+
+static test_row_t*
+test_baseline_line(test_baseline_t *b,
+                   gchar           *line)
+{
+    test_row_t *row;
+    guchar flags;
+    gint64 address;
+    gchar *ptr;
+
+    if(b->scan_line >= 0 &&
+       !strncmp(line, "-- ", strlen("-- ")))
+    {
+        b->scan_line = -1;
+        return NULL;
+    }
+
+    if(b->scan_line < 0)
+    {
+        if(strstr(line, "Flags: "))
+            b->scan_line = 0;
+        return NULL;
+    }
+
+    if(b->scan_line == 0 &&
+       strstr(line, "Columns: "))
+        return NULL;
+
+    if(++b->scan_line == 1)
+    {
+        g_free(b->scan_header);
+        b->scan_header = baseline_parse_scan_header(line);
+        return NULL;
+    }
+
+    if(!b->scan_header)
+        return NULL;
+
+    if((ptr = strchr(line, '\x1b')))
+        *ptr = '\0';
+
+    flags = baseline_parse_scan_flags(line, b->scan_header->address-1);
+    if(!(flags & MT_SSH_NET_FLAG_ACTIVE))
+        return NULL;
+
+    if((address = baseline_parse_scan_address(line, b->scan_header->address)) < 0)
+        return NULL;
+
+    row = g_malloc0(sizeof(test_row_t));
+    row->address = address;
+    row->flags = flags;
+
+    if(b->scan_header->ssid)
+        row->ssid = baseline_parse_scan_string(line, b->scan_header->ssid, b->scan_header->ssid_len, FALSE);
+
+    if(b->scan_header->channel)
+        row->frequency = baseline_parse_scan_channel(line, b->scan_header->channel, &row->channel, &row->mode);
+
+    if(b->scan_header->channel_width && !row->channel)
+        row->channel = g_strdup_printf("%d", baseline_parse_scan_int(line, b->scan_header->channel_width, 1));
+
+    if(b->scan_header->rssi)
+        row->rssi = (gint8)baseline_parse_scan_int(line, b->scan_header->rssi, 3);
+
+    if(b->scan_header->noise > 2)
+        row->noise = (gint8)baseline_parse_scan_int(line, b->scan_header->noise-2, 4);
+
+    if(b->scan_header->radioname)
+        row->radioname = baseline_parse_scan_string(line, b->scan_header->radioname, b->scan_header->radioname_len, b->scan_header->radioname_hack);
+
+    if(b->scan_header->routeros_ver)
+        row->routeros_ver = baseline_parse_scan_string(line, b->scan_header->routeros_ver, b->scan_header->routeros_ver_len, FALSE);
+
+    return row;
+}
+
+static guint64
+test_run_baseline(GPtrArray *lines,
+                  GPtrArray *rows)
+{
+    test_baseline_t b = { -1, NULL };
+    gchar buffer[PTY_COLS*4];
+    test_row_t *row;
+    guint64 count = 0;
+    guint i;
+
+    for(i=0; i<lines->len; i++)
+    {
+        g_strlcpy(buffer, g_ptr_array_index(lines, i), sizeof(buffer));
+        if((row = test_baseline_line(&b, buffer)))
+        {
+            count++;
+            if(rows)
+                g_ptr_array_add(rows, row);
+            else
+                test_row_free(row);
+        }
+    }
+
+    g_free(b.scan_header);
+    return count;
+}
+
+static gboolean
+test_compare(const gchar      *filename,
+             guint             i,
+             const test_row_t *a,
+             const test_row_t *b)
+{
+    if(a->address == b->address &&
+       a->flags == b->flags &&
+       a->frequency == b->frequency &&
+       !g_strcmp0(a->channel, b->channel) &&
+       !g_strcmp0(a->mode, b->mode) &&
+       !g_strcmp0(a->ssid, b->ssid) &&
+       !g_strcmp0(a->radioname, b->radioname) &&
+       a->rssi == b->rssi &&
+       a->noise == b->noise &&
+       !g_strcmp0(a->routeros_ver, b->routeros_ver))
+        return TRUE;
+
+    fprintf(stderr, "%s: row %u differs\n", filename, i);
+    fprintf(stderr, "  baseline: %012" G_GINT64_MODIFIER "X %02X %d '%s' '%s' '%s' '%s' %d %d '%s'\n",
+            a->address, a->flags, a->frequency, a->channel, a->mode, a->ssid, a->radioname, a->rssi, a->noise, a->routeros_ver);
+    fprintf(stderr, "  current:  %012" G_GINT64_MODIFIER "X %02X %d '%s' '%s' '%s' '%s' %d %d '%s'\n",
+            b->address, b->flags, b->frequency, b->channel, b->mode, b->ssid, b->radioname, b->rssi, b->noise, b->routeros_ver);
+    return FALSE;
+}
+
+static gboolean
+test_file(const gchar *filename,
+          gint         passes)
+{
+    GPtrArray *lines;
+    GPtrArray *rows_baseline;
+    gboolean ret = TRUE;
+    guint64 count;
+    gint64 start;
+    gdouble time_new;
+    gdouble time_baseline;
+    guint i;
+    gint pass;
+
+    if(!(lines = test_load(filename)))
+    {
+        fprintf(stderr, "%s: could not read the trace\n", filename);
+        return FALSE;
+    }
+
+    rows_new = g_ptr_array_new_with_free_func(test_row_free);
+    rows_baseline = g_ptr_array_new_with_free_func(test_row_free);
+    test_run_new(lines);
+    test_run_baseline(lines, rows_baseline);
+
+    if(!rows_baseline->len)
+    {
+        fprintf(stderr, "%s: no rows found\n", filename);
+        ret = FALSE;
+    }
+
+    if(rows_new->len != rows_baseline->len)
+    {
+        fprintf(stderr, "%s: %u rows, baseline %u rows\n", filename, rows_new->len, rows_baseline->len);
+        ret = FALSE;
+    }
+
+    for(i=0; ret && i<rows_new->len; i++)
+        ret = test_compare(filename, i, g_ptr_array_index(rows_baseline, i), g_ptr_array_index(rows_new, i));
+
+    g_ptr_array_free(rows_new, TRUE);
+    g_ptr_array_free(rows_baseline, TRUE);
+    rows_new = NULL;
+
+    if(ret)
+    {
+        rows_count = 0;
+        start = g_get_monotonic_time();
+        for(pass=0; pass<passes; pass++)
+            test_run_new(lines);
+        time_new = (g_get_monotonic_time() - start) / 1000000.0;
+        count = rows_count;
+
+        start = g_get_monotonic_time();
+        for(pass=0; pass<passes; pass++)
+            test_run_baseline(lines, NULL);
+        time_baseline = (g_get_monotonic_time() - start) / 1000000.0;
+
+        printf("%s: %" G_GUINT64_FORMAT " rows, %.0f rows/s (baseline %.0f rows/s)\n",
+               filename,
+               count / passes,
+               (time_new > 0 ? count / time_new : 0.0),
+               (time_baseline > 0 ? count / time_baseline : 0.0));
+    }
+
+    g_ptr_array_free(lines, TRUE);
+    return ret;
+}
+
+gint
+main(gint   argc,
+     gchar *argv[])
+{
+    gint passes = TEST_DEFAULT_PASSES;
+    gboolean ret = TRUE;
+    gint c;
+
+    while((c = getopt(argc, argv, "n:")) != -1)
+    {
+        switch(c)
+        {
+            case 'n':
+                passes = atoi(optarg);
+                break;
+
+            default:
+                fprintf(stderr, "usage: %s [ -n <passes> ] <trace> [ <trace> ... ]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if(optind >= argc || passes <= 0)
+    {
+        fprintf(stderr, "usage: %s [ -n <passes> ] <trace> [ <trace> ... ]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    for(; optind < argc; optind++)
+        ret = test_file(argv[optind], passes) && ret;
+
+    return (ret ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/* Line parser as of the previous release */
+static mt_ssh_shdr_t*
+baseline_parse_scan_header(const gchar *buff)
+{
+    mt_ssh_shdr_t *h;
+    guint address;
+    const gchar *ptr;
+
+    address = baseline_parse_scan_header_column(buff, "ADDRESS", NULL);
+    if(!address)
+        return NULL;
+
+    h = g_malloc0(sizeof(mt_ssh_shdr_t));
+    h->address = address;
+
+    h->ssid = baseline_parse_scan_header_column(buff, "SSID", &h->ssid_len);
+    h->radioname = baseline_parse_scan_header_column(buff, "RADIO-NAME", &h->radioname_len);
+    h->routeros_ver = baseline_parse_scan_header_column(buff, "ROUTEROS-VER", &h->routeros_ver_len);
+
+    h->rssi = baseline_parse_scan_header_column(buff, "SIG", NULL);
+    h->noise = baseline_parse_scan_header_column(buff, "NF", NULL);
+    h->snr = baseline_parse_scan_header_column(buff, "SNR", NULL);
+
+    h->channel = baseline_parse_scan_header_column(buff, "FREQ", NULL);
+    h->channel_width = baseline_parse_scan_header_column(buff, "CHANNEL-WIDTH", NULL);
+    h->band = baseline_parse_scan_header_column(buff, "BAND", NULL);
+
+    if(!h->channel)
+        h->channel = baseline_parse_scan_header_column(buff, "CHANNEL", NULL);
+
+    if(h->radioname &&
+       h->snr &&
+       h->radioname > h->snr &&
+       h->radioname - h->snr > 5)
+    {
+        ptr = buff + h->snr + strlen("SNR");
+        while(isspace(*ptr))
+            ptr++;
+
+        if(strncmp(ptr, "RADIO-NAME", strlen("RADIO-NAME")) == 0)
+        {
+            h->radioname_len += h->radioname - h->snr - strlen("SNR") - 2;
+            h->radioname = h->snr+5;
+            h->radioname_hack = TRUE;
+        }
+    }
+
+    return h;
+}
+
+static guint
+baseline_parse_scan_header_column(const gchar *buff,
+                                  const gchar *title,
+                                  guint       *length)
+{
+    const gchar *ptr;
+    guint pos;
+
+    if(length)
+        *length = 0;
+
+    ptr = strstr(buff, title);
+    if(!ptr)
+        return 0;
+
+    pos = (guint)(ptr - buff);
+
+    if(length)
+    {
+        ptr += strlen(title);
+        *length += strlen(title);
+
+        while(isspace(*ptr))
+        {
+            ptr++;
+            (*length)++;
+        }
+
+        if(*ptr != '\0')
+            *length = *length - 1;
+        else
+            *length = (pos < PTY_COLS) ? (PTY_COLS - pos) : 0;
+    }
+
+    return pos;
+}
+
+static guchar
+baseline_parse_scan_flags(const gchar *buff,
+                          guint        flags_len)
+{
+    size_t length = MIN(strlen(buff), flags_len);
+    guchar flags = 0;
+    gsize i;
+
+    for(i=0; i<length; i++)
+    {
+        switch(buff[i])
+        {
+        case 'A':
+            flags |= MT_SSH_NET_FLAG_ACTIVE;
+            break;
+        case 'P':
+            flags |= MT_SSH_NET_FLAG_PRIVACY;
+            break;
+        case 'R':
+            flags |= MT_SSH_NET_FLAG_ROUTEROS;
+            break;
+        case 'N':
+            flags |= MT_SSH_NET_FLAG_NSTREME;
+            break;
+        case 'T':
+            flags |= MT_SSH_NET_FLAG_TDMA;
+            break;
+        case 'W':
+            flags |= MT_SSH_NET_FLAG_WDS;
+            break;
+        case 'B':
+            flags |= MT_SSH_NET_FLAG_BRIDGE;
+            break;
+        }
+    }
+    return flags;
+}
+
+static gint64
+baseline_parse_scan_address(const gchar *buff,
+                            guint        position)
+{
+    gchar addr[MAC_ADDR_HEX_LEN+1];
+    gchar *ptr;
+    gint64 value;
+    gint i;
+
+    if(strlen(buff) < position+MAC_ADDR_HEX_LEN+5)
+        return -1;
+
+    for(i=0; i<MAC_ADDR_HEX_LEN; i+=2)
+    {
+        addr[i] = buff[position+i+(i/2)];
+        addr[i+1] = buff[position+i+1+(i/2)];
+    }
+    addr[MAC_ADDR_HEX_LEN] = '\0';
+
+    for(i=0; i<MAC_ADDR_HEX_LEN; i++)
+    {
+        if(!g_ascii_isxdigit(addr[i]))
+            return -1;
+    }
+
+    value = g_ascii_strtoll(addr, &ptr, 16);
+    return (ptr != addr) ? value : -1;
+}
+
+static gint
+baseline_parse_scan_channel(const gchar  *buff,
+                            guint         position,
+                            gchar       **channel_width,
+                            gchar       **mode)
+{
+    gchar *ptr, *endptr, *endstr, *nextptr;
+    gdouble frequency = 0.0;
+
+    if(strlen(buff) > position &&
+       isdigit(buff[position]))
+    {
+        sscanf(buff + position, "%lf", &frequency);
+
+        endstr = strchr(buff + position, ' ');
+        ptr = strchr(buff + position, '/');
+        if(ptr++ && ptr < endstr)
+        {
+            endptr = strchr(ptr, '/');
+            if(endptr && endptr < endstr)
+            {
+                *channel_width = g_strndup(ptr, (endptr - ptr));
+                ptr = endptr+1;
+                endptr = strchr(ptr, ' ');
+                if(endptr)
+                {
+                    nextptr = strchr(ptr, '/');
+                    if(nextptr && nextptr < endptr)
+                        endptr = nextptr;
+                    *mode = g_strndup(ptr, (endptr - ptr));
+                }
+            }
+        }
+    }
+
+    if(*mode && (ptr = strchr(*mode, '(')))
+        *ptr = '\0';
+
+    return (gint)round(frequency*1000.0);
+}
+
+static gint
+baseline_parse_scan_int(const gchar *buff,
+                        guint        position,
+                        guint        max_left_offset)
+{
+    gint buff_length = (gint)strlen(buff);
+    gint value = 0;
+    guint i;
+
+    for(i=0; i<max_left_offset; i++)
+    {
+        if(buff_length < position+i)
+            break;
+
+        if(isdigit(buff[position+i]) ||
+           buff[position+i] == '-')
+        {
+            sscanf(buff+position+i, "%d", &value);
+            break;
+        }
+    }
+    return value;
+}
+
+static gchar*
+baseline_parse_scan_string(const gchar *buff,
+                           guint        position,
+                           guint        str_length,
+                           gboolean     left_trim)
+{
+    guint buff_length = strlen(buff);
+
+    if(position >= buff_length)
+        return NULL;
+
+    buff += position;
+    buff_length -= position;
+
+    if(buff_length < str_length)
+        str_length = buff_length;
+
+    if(left_trim)
+    {
+        while(str_length > 0 && isspace(*buff))
+        {
+            buff++;
+            str_length--;
+        }
+    }
+    else
+    {
+        while(str_length > 0 && isspace(buff[str_length-1]))
+            str_length--;
+    }
+
+    return g_strndup(buff, str_length);
+}